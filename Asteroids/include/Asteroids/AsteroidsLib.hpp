@@ -21,7 +21,8 @@ ASTEROIDS_PUBLIC_API extern const char* ASTEROIDS_CATEGORY;
 ASTEROIDS_PUBLIC_API void RegisterObjectFactories(Urho3D::Context* context);
 
 /*!
- * @brief Registers all network events that are sent remotely.
+ * @brief Registers the RemoteEventCodec subsystem, which sends and receives
+ * the events that go over the network.
  *
  * Applications must call this before being able to communicate over the
  * network.
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "Asteroids/Config.hpp"
+#include "Asteroids/Network/ShmRingBuffer.hpp"
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/IO/VectorBuffer.h>
+
+namespace Urho3D {
+    class Connection;
+}
+
+namespace Asteroids {
+
+/// How a game message is delivered, see MessageRouter.
+enum MessageChannel
+{
+    /// Unreliable and sent right away. For state that is resent regularly anyway.
+    CHANNEL_STATE,
+    /// Reliable and ordered. Things that happen in the game, e.g. players joining.
+    CHANNEL_EVENTS,
+    /// Reliable and ordered. Large messages, only get what CHANNEL_EVENTS leaves of the budget.
+    CHANNEL_BULK,
+
+    CHANNEL_COUNT
+};
+
+/*!
+ * @brief Sends game messages (MSG_* in Protocol.hpp) either through the
+ * regular UDP connection or through shared memory when both ends run on the
+ * same host.
+ *
+ * When shared memory is enabled on both sides, a client connecting to a
+ * loopback address asks for it in its identity. The server then creates a
+ * pair of ShmRingBuffer segments for that connection and tells the client
+ * their name with MSG_SHM_TRANSPORT over UDP. Once the client has attached
+ * and acknowledged, SendMessage() and BroadcastMessage() write to the ring
+ * buffer instead of the socket. Remote clients, clients that didn't ask for
+ * it and platforms without shared memory support simply keep using UDP.
+ *
+ * When the client hosts the game itself (see ServerSession), both ends are
+ * served by this same router. The client then marks its identity as coming
+ * from this process, and the server sets up the same pair of queues in
+ * ordinary memory instead of shared memory segments. Both sides use the
+ * same ShmRingBuffer objects directly, so a message is a single copy into
+ * the queue. This doesn't depend on SetSharedMemoryEnabled() or on platform
+ * support for shared memory.
+ *
+ * Reliable messages larger than the ring buffer's limit are split into
+ * MSG_SHM_FRAGMENT records followed by a record with the real ID and the
+ * last part, and put back together by the receiving router. If the other
+ * side stops reading, reliable messages queue up in a backlog until there's
+ * room again, and the connection is dropped once the backlog grows past a
+ * limit. State messages are dropped instead when the ring is full, the same
+ * as a lost UDP packet.
+ *
+ * Messages received through shared memory are re-sent as E_NETWORKMESSAGE
+ * from the Connection they belong to, so message handlers don't need to
+ * know which transport was used.
+ *
+ * Connection management, remote events and scene replication always go
+ * through UDP.
+ *
+ * Every message is sent on one of the MessageChannels. State messages are
+ * handed to the connection immediately. Reliable messages share a byte
+ * budget per connection and network tick. While there is budget left they
+ * are sent immediately too, otherwise they are queued and sent after the
+ * next network update, events before bulk data. Connections using shared
+ * memory aren't budgeted, but messages that were queued before the switch
+ * still go first. This keeps a burst of
+ * reliable messages (e.g. many players joining) from piling up in the
+ * connection's send queue ahead of the state messages. Each channel keeps
+ * its own order, there is no ordering between channels.
+ */
+class ASTEROIDS_PUBLIC_API MessageRouter : public Urho3D::Object
+{
+    URHO3D_OBJECT(MessageRouter, Urho3D::Object)
+
+public:
+    MessageRouter(Urho3D::Context* context);
+
+    /*!
+     * @brief On the client, request shared memory on the next connection.
+     * On the server, accept such requests. Disabled by default.
+     */
+    void SetSharedMemoryEnabled(bool enable);
+    bool IsSharedMemoryEnabled() const;
+
+    /*!
+     * @brief Adds what the server needs to know to the identity that is
+     * about to be passed to Network::Connect().
+     */
+    void PrepareIdentity(Urho3D::VariantMap& identity, const Urho3D::String& address) const;
+
+    /// Returns true if messages to this connection currently go through shared memory.
+    bool IsUsingSharedMemory(Urho3D::Connection* connection) const;
+
+    /// Sends a message to one connection.
+    void SendMessage(Urho3D::Connection* connection, MessageChannel channel, int msgID, const Urho3D::VectorBuffer& msg);
+    void SendMessage(Urho3D::Connection* connection, MessageChannel channel, int msgID, const unsigned char* data, unsigned size);
+
+    /// Sends a message to all client connections.
+    void BroadcastMessage(MessageChannel channel, int msgID, const Urho3D::VectorBuffer& msg);
+
+    /// Bytes of reliable messages waiting to be sent to the connection.
+    unsigned GetNumQueuedBytes(Urho3D::Connection* connection) const;
+
+private:
+    struct Rings : public Urho3D::RefCounted
+    {
+        ShmRingBuffer serverToClient_;
+        ShmRingBuffer clientToServer_;
+    };
+
+    struct Channel : public Urho3D::RefCounted
+    {
+        Urho3D::WeakPtr<Urho3D::Connection> connection_;
+        // Shared by the client's and the server's channel when both are in
+        // this process
+        Urho3D::SharedPtr<Rings> rings_;
+        ShmRingBuffer* send_ = nullptr;
+        ShmRingBuffer* receive_ = nullptr;
+        // Messages that didn't fit into send_, as msgID, size, data. Later
+        // messages queue up behind them to keep the order.
+        Urho3D::VectorBuffer backlog_;
+        unsigned backlogRead_ = 0;
+        // Received MSG_SHM_FRAGMENT parts of a message that isn't complete yet
+        Urho3D::VectorBuffer fragments_;
+        bool active_ = false;    // Sending through shared memory
+        bool loggedFull_ = false;
+    };
+
+    struct Outbox : public Urho3D::RefCounted
+    {
+        Urho3D::WeakPtr<Urho3D::Connection> connection_;
+        // Queued messages as msgID, size, data. CHANNEL_STATE is never queued.
+        Urho3D::VectorBuffer queues_[CHANNEL_COUNT];
+        unsigned read_[CHANNEL_COUNT] = {};
+        // Bytes that can still be sent this tick, negative after a large message
+        int allowance_;
+    };
+
+    bool CreateChannel(Urho3D::Connection* connection, bool inProcess);
+    bool OpenChannel(Urho3D::Connection* connection, const Urho3D::String& name);
+    void WithdrawOffer(Rings* rings);
+    void ReceiveMessages();
+    void DrainBacklogs();
+    void Enqueue(Channel* channel, int msgID, const unsigned char* data, unsigned size);
+    void Transmit(Urho3D::Connection* connection, MessageChannel channel, int msgID, const unsigned char* data, unsigned size);
+    void FlushOutboxes();
+
+    void HandleBeginFrame(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleNetworkUpdateSent(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleClientConnected(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleClientIdentity(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleClientDisconnected(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleServerDisconnected(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleNetworkMessage(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+
+private:
+    Urho3D::HashMap<Urho3D::Connection*, Urho3D::SharedPtr<Channel>> channels_;
+    Urho3D::Vector<Urho3D::SharedPtr<Channel>> receiving_;
+    Urho3D::HashMap<Urho3D::Connection*, Urho3D::SharedPtr<Outbox>> outboxes_;
+    // In-process queues offered to a client that hasn't attached yet, by name
+    Urho3D::HashMap<Urho3D::String, Urho3D::SharedPtr<Rings>> offeredRings_;
+    Urho3D::VectorBuffer msg_;
+    unsigned channelCounter_;
+    unsigned clientCount_;
+    unsigned processToken_;
+    bool sharedMemoryEnabled_;
+};
+
+}
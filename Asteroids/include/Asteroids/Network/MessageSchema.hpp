@@ -0,0 +1,201 @@
+#pragma once
+
+#include "Asteroids/Config.hpp"
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Math/Quaternion.h>
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+/*!
+ * Compile-time message layouts. A message is a plain struct that lists its
+ * fields and how each one is encoded in a MessageLayout typedef, e.g.
+ *
+ *     struct ExampleMsg
+ *     {
+ *         uint16_t guid_;
+ *         float angle_;
+ *
+ *         typedef MessageLayout<
+ *             MessageField<RawCodec<uint16_t>, ExampleMsg, &ExampleMsg::guid_>,
+ *             MessageField<AngleCodec<16>, ExampleMsg, &ExampleMsg::angle_>
+ *         > Layout;
+ *     };
+ *
+ * Every codec has a fixed size, so the size of a message is known at compile
+ * time (Layout::SIZE) and WriteMessage()/ReadMessage() check the buffer once
+ * and then encode or decode all fields with straight-line code. Values are
+ * stored in the byte order of the machine, same as Urho3D's Serializer.
+ *
+ * The messages themselves are declared in Messages.hpp.
+ */
+
+namespace Asteroids {
+
+/// Unsigned integer type with the specified number of bits.
+template <unsigned Bits> struct MessageStorage;
+template <> struct MessageStorage<8>  { typedef uint8_t Type; };
+template <> struct MessageStorage<16> { typedef uint16_t Type; };
+template <> struct MessageStorage<32> { typedef uint32_t Type; };
+
+/// Copies the value as it is.
+template <class T>
+struct RawCodec
+{
+    typedef T Type;
+    static const unsigned SIZE = sizeof(T);
+
+    static unsigned char* Encode(unsigned char* dest, const T& value)
+        { memcpy(dest, &value, SIZE); return dest + SIZE; }
+    static const unsigned char* Decode(const unsigned char* src, T* value)
+        { memcpy(value, src, SIZE); return src + SIZE; }
+};
+
+/*!
+ * @brief An angle in degrees quantized to Bits bits. Angles outside of
+ * [0, 360) wrap around, and are decoded as an angle in [0, 360).
+ */
+template <unsigned Bits>
+struct AngleCodec
+{
+    typedef float Type;
+    typedef typename MessageStorage<Bits>::Type Storage;
+    static const unsigned SIZE = sizeof(Storage);
+
+    static unsigned char* Encode(unsigned char* dest, float degrees)
+    {
+        // Truncating to the storage type is what wraps the angle around
+        Storage value = (Storage)lrintf(degrees * (float(1ull << Bits) / 360.0f));
+        return RawCodec<Storage>::Encode(dest, value);
+    }
+    static const unsigned char* Decode(const unsigned char* src, float* degrees)
+    {
+        Storage value;
+        src = RawCodec<Storage>::Decode(src, &value);
+        *degrees = value * (360.0f / float(1ull << Bits));
+        return src;
+    }
+};
+
+/*!
+ * @brief A rotation as 4 shorts, same as Serializer::WritePackedQuaternion().
+ * The quaternion is normalized before encoding and after decoding. One that
+ * is too close to zero to normalize becomes identity.
+ */
+struct PackedQuaternionCodec
+{
+    typedef Urho3D::Quaternion Type;
+    static const unsigned SIZE = 4 * sizeof(int16_t);
+
+    static unsigned char* Encode(unsigned char* dest, const Urho3D::Quaternion& value)
+    {
+        // A zero quaternion can't be normalized, send identity instead
+        float lenSquared = value.LengthSquared();
+        if (lenSquared <= Urho3D::M_EPSILON)
+            return Encode(dest, Urho3D::Quaternion::IDENTITY);
+
+        float scale = 32767.0f / sqrtf(lenSquared);
+        int16_t data[4] = {
+            (int16_t)lrintf(Urho3D::Clamp(value.w_ * scale, -32767.0f, 32767.0f)),
+            (int16_t)lrintf(Urho3D::Clamp(value.x_ * scale, -32767.0f, 32767.0f)),
+            (int16_t)lrintf(Urho3D::Clamp(value.y_ * scale, -32767.0f, 32767.0f)),
+            (int16_t)lrintf(Urho3D::Clamp(value.z_ * scale, -32767.0f, 32767.0f))
+        };
+        memcpy(dest, data, SIZE);
+        return dest + SIZE;
+    }
+    static const unsigned char* Decode(const unsigned char* src, Urho3D::Quaternion* value)
+    {
+        int16_t data[4];
+        memcpy(data, src, SIZE);
+        Urho3D::Quaternion q(data[0], data[1], data[2], data[3]);
+        float lenSquared = q.LengthSquared();
+        *value = lenSquared > Urho3D::M_EPSILON ? q * (1.0f / sqrtf(lenSquared)) : Urho3D::Quaternion::IDENTITY;
+        return src + SIZE;
+    }
+};
+
+/// Encodes the member of a message struct with a codec.
+template <class Codec, class Message, typename Codec::Type Message::*Member>
+struct MessageField
+{
+    static const unsigned SIZE = Codec::SIZE;
+
+    static unsigned char* Encode(unsigned char* dest, const Message& msg)
+        { return Codec::Encode(dest, msg.*Member); }
+    static const unsigned char* Decode(const unsigned char* src, Message& msg)
+        { return Codec::Decode(src, &(msg.*Member)); }
+};
+
+/// List of MessageFields, encoded in order.
+template <class... Fields>
+struct MessageLayout;
+
+template <>
+struct MessageLayout<>
+{
+    static const unsigned SIZE = 0;
+
+    template <class Message>
+    static unsigned char* Encode(unsigned char* dest, const Message&) { return dest; }
+    template <class Message>
+    static const unsigned char* Decode(const unsigned char* src, Message&) { return src; }
+};
+
+template <class Field, class... Rest>
+struct MessageLayout<Field, Rest...>
+{
+    static const unsigned SIZE = Field::SIZE + MessageLayout<Rest...>::SIZE;
+
+    template <class Message>
+    static unsigned char* Encode(unsigned char* dest, const Message& msg)
+        { return MessageLayout<Rest...>::Encode(Field::Encode(dest, msg), msg); }
+    template <class Message>
+    static const unsigned char* Decode(const unsigned char* src, Message& msg)
+        { return MessageLayout<Rest...>::Decode(Field::Decode(src, msg), msg); }
+};
+
+/*!
+ * @brief Makes sure the buffer can hold size bytes without reallocating.
+ * Use with the size of the largest message that is written to it.
+ */
+inline void ReserveMessage(Urho3D::VectorBuffer& buffer, unsigned size)
+{
+    unsigned oldSize = buffer.GetSize();
+    if (oldSize < size)
+    {
+        buffer.Resize(size);
+        buffer.Resize(oldSize);
+    }
+}
+
+/// Appends the message at the current position of the buffer.
+template <class Message>
+void WriteMessage(Urho3D::VectorBuffer& buffer, const Message& msg)
+{
+    typedef typename Message::Layout Layout;
+
+    unsigned position = buffer.GetPosition();
+    if (buffer.GetSize() < position + Layout::SIZE)
+        buffer.Resize(position + Layout::SIZE);
+    Layout::Encode(buffer.GetModifiableData() + position, msg);
+    buffer.Seek(position + Layout::SIZE);
+}
+
+/// Returns false and leaves msg untouched if the buffer is too short.
+template <class Message>
+bool ReadMessage(Urho3D::MemoryBuffer& buffer, Message* msg)
+{
+    typedef typename Message::Layout Layout;
+
+    unsigned position = buffer.GetPosition();
+    if (buffer.GetSize() - position < Layout::SIZE)
+        return false;
+    Layout::Decode(buffer.GetData() + position, *msg);
+    buffer.Seek(position + Layout::SIZE);
+    return true;
+}
+
+}
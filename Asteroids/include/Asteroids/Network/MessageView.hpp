@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Asteroids/Config.hpp"
+#include <Urho3D/IO/MemoryBuffer.h>
+
+namespace Urho3D {
+    class Connection;
+}
+
+namespace Asteroids {
+
+/*!
+ * @brief Read-only view of the message carried by an E_NETWORKMESSAGE event.
+ *
+ * The message handlers used to do eventData[P_MESSAGEID] and
+ * eventData[P_DATA], which is a hash lookup that inserts a new entry if the
+ * key doesn't exist. MessageView uses Find() instead and reads the payload
+ * directly from the event's buffer without copying it.
+ *
+ * The view is only valid for as long as the event data it was constructed
+ * from, i.e. don't keep it around after the handler returns.
+ */
+class ASTEROIDS_PUBLIC_API MessageView
+{
+public:
+    explicit MessageView(const Urho3D::VariantMap& eventData);
+
+    /// Returns the message ID, or -1 if the event data doesn't contain one.
+    int GetID() const { return id_; }
+
+    /// Connection the message was received from. Can be null.
+    Urho3D::Connection* GetConnection() const { return connection_; }
+
+    /// Deserializer reading directly from the message payload.
+    Urho3D::MemoryBuffer& GetBuffer() { return buffer_; }
+
+private:
+    Urho3D::Connection* connection_;
+    int id_;
+    Urho3D::MemoryBuffer buffer_;
+};
+
+}
@@ -0,0 +1,193 @@
+#pragma once
+
+#include "Asteroids/Network/MessageSchema.hpp"
+#include "Asteroids/Network/Protocol.hpp"
+
+namespace Asteroids {
+
+/*!
+ * @brief MSG_CLIENT_SHIP_STATE, followed by numTransitions_ times
+ * InputTransitionMsg.
+ */
+struct ClientShipStateMsg
+{
+    uint16_t guid_;
+    uint8_t timeStep_;
+    /// ActionState at the time the packet was written.
+    uint16_t state_;
+    uint8_t numTransitions_;
+
+    typedef MessageLayout<
+        MessageField<RawCodec<uint16_t>, ClientShipStateMsg, &ClientShipStateMsg::guid_>,
+        MessageField<RawCodec<uint8_t>,  ClientShipStateMsg, &ClientShipStateMsg::timeStep_>,
+        MessageField<RawCodec<uint16_t>, ClientShipStateMsg, &ClientShipStateMsg::state_>,
+        MessageField<RawCodec<uint8_t>,  ClientShipStateMsg, &ClientShipStateMsg::numTransitions_>
+    > Layout;
+};
+
+/// One ActionState change recorded by InputSampler.
+struct InputTransitionMsg
+{
+    uint16_t sequence_;
+    /// How long before the packet was written the transition happened.
+    uint16_t ageMs_;
+    uint16_t state_;
+
+    typedef MessageLayout<
+        MessageField<RawCodec<uint16_t>, InputTransitionMsg, &InputTransitionMsg::sequence_>,
+        MessageField<RawCodec<uint16_t>, InputTransitionMsg, &InputTransitionMsg::ageMs_>,
+        MessageField<RawCodec<uint16_t>, InputTransitionMsg, &InputTransitionMsg::state_>
+    > Layout;
+};
+
+/// The state of one ship in a MSG_SERVER_SNAPSHOT.
+struct ServerShipStateMsg
+{
+    uint16_t guid_;
+    /// Time step of the last MSG_CLIENT_SHIP_STATE received from this user.
+    uint8_t timeStep_;
+    Urho3D::Quaternion pivotRotation_;
+    float offsetFromPlanetCenter_;
+    float angle_;
+    /// Last input transition received, so the client can stop sending it.
+    uint16_t lastInputSequence_;
+
+    typedef MessageLayout<
+        MessageField<RawCodec<uint16_t>,     ServerShipStateMsg, &ServerShipStateMsg::guid_>,
+        MessageField<RawCodec<uint8_t>,      ServerShipStateMsg, &ServerShipStateMsg::timeStep_>,
+        MessageField<PackedQuaternionCodec,  ServerShipStateMsg, &ServerShipStateMsg::pivotRotation_>,
+        MessageField<RawCodec<float>,        ServerShipStateMsg, &ServerShipStateMsg::offsetFromPlanetCenter_>,
+        MessageField<AngleCodec<16>,         ServerShipStateMsg, &ServerShipStateMsg::angle_>,
+        MessageField<RawCodec<uint16_t>,     ServerShipStateMsg, &ServerShipStateMsg::lastInputSequence_>
+    > Layout;
+};
+
+/// MSG_SERVER_SNAPSHOT, followed by numShips_ times ServerShipStateMsg.
+struct SnapshotHeaderMsg
+{
+    /// Incremented for every snapshot sent to the same client.
+    uint16_t sequence_;
+    uint8_t numShips_;
+
+    typedef MessageLayout<
+        MessageField<RawCodec<uint16_t>, SnapshotHeaderMsg, &SnapshotHeaderMsg::sequence_>,
+        MessageField<RawCodec<uint8_t>,  SnapshotHeaderMsg, &SnapshotHeaderMsg::numShips_>
+    > Layout;
+};
+
+/// MSG_SNAPSHOT_FEEDBACK
+struct SnapshotFeedbackMsg
+{
+    /// Fraction of snapshots lost since the last feedback, scaled to 0-255.
+    uint8_t loss_;
+
+    typedef MessageLayout<
+        MessageField<RawCodec<uint8_t>, SnapshotFeedbackMsg, &SnapshotFeedbackMsg::loss_>
+    > Layout;
+};
+
+/// MSG_NETWORK_TIMER from the client to the server. Times are in microseconds.
+struct ClockRequestMsg
+{
+    uint64_t clientTime_;
+    /// The client's current estimate, 0 if it doesn't have one yet.
+    uint32_t roundTripTime_;
+
+    typedef MessageLayout<
+        MessageField<RawCodec<uint64_t>, ClockRequestMsg, &ClockRequestMsg::clientTime_>,
+        MessageField<RawCodec<uint32_t>, ClockRequestMsg, &ClockRequestMsg::roundTripTime_>
+    > Layout;
+};
+
+/// MSG_NETWORK_TIMER from the server back to the client. Times are in microseconds.
+struct ClockResponseMsg
+{
+    /// Copied from the request.
+    uint64_t clientTime_;
+    uint64_t serverReceiveTime_;
+    uint64_t serverSendTime_;
+
+    typedef MessageLayout<
+        MessageField<RawCodec<uint64_t>, ClockResponseMsg, &ClockResponseMsg::clientTime_>,
+        MessageField<RawCodec<uint64_t>, ClockResponseMsg, &ClockResponseMsg::serverReceiveTime_>,
+        MessageField<RawCodec<uint64_t>, ClockResponseMsg, &ClockResponseMsg::serverSendTime_>
+    > Layout;
+};
+
+/// MSG_REGISTER_SUCCEEDED, MSG_USER_LEFT and MSG_PLAYER_DESTROY
+struct UserGUIDMsg
+{
+    uint16_t guid_;
+
+    typedef MessageLayout<
+        MessageField<RawCodec<uint16_t>, UserGUIDMsg, &UserGUIDMsg::guid_>
+    > Layout;
+};
+
+/// MSG_USER_JOINED, followed by usernameLength_ characters (not null terminated).
+struct UserJoinedMsg
+{
+    uint16_t guid_;
+    uint8_t usernameLength_;
+
+    typedef MessageLayout<
+        MessageField<RawCodec<uint16_t>, UserJoinedMsg, &UserJoinedMsg::guid_>,
+        MessageField<RawCodec<uint8_t>,  UserJoinedMsg, &UserJoinedMsg::usernameLength_>
+    > Layout;
+};
+
+/// MSG_PLAYER_CREATE
+struct PlayerCreateMsg
+{
+    uint16_t guid_;
+    Urho3D::Quaternion pivotRotation_;
+
+    typedef MessageLayout<
+        MessageField<RawCodec<uint16_t>,    PlayerCreateMsg, &PlayerCreateMsg::guid_>,
+        MessageField<PackedQuaternionCodec, PlayerCreateMsg, &PlayerCreateMsg::pivotRotation_>
+    > Layout;
+};
+
+/// MSG_SHIP_HIT, followed by numHits_ times ShipHitMsg.
+struct ShipHitHeaderMsg
+{
+    uint8_t numHits_;
+
+    typedef MessageLayout<
+        MessageField<RawCodec<uint8_t>, ShipHitHeaderMsg, &ShipHitHeaderMsg::numHits_>
+    > Layout;
+};
+
+/// One hit in a MSG_SHIP_HIT.
+struct ShipHitMsg
+{
+    uint16_t guid_;
+    uint16_t attacker_;
+    /// HitDetector::Weapon, with the highest bit set if the ship was destroyed.
+    uint8_t flags_;
+    /// Health left after the hit, rounded down.
+    uint16_t health_;
+
+    typedef MessageLayout<
+        MessageField<RawCodec<uint16_t>, ShipHitMsg, &ShipHitMsg::guid_>,
+        MessageField<RawCodec<uint16_t>, ShipHitMsg, &ShipHitMsg::attacker_>,
+        MessageField<RawCodec<uint8_t>,  ShipHitMsg, &ShipHitMsg::flags_>,
+        MessageField<RawCodec<uint16_t>, ShipHitMsg, &ShipHitMsg::health_>
+    > Layout;
+};
+
+/// MSG_REGISTER_FAILED
+struct RegisterFailedMsg
+{
+    /// One of MsgRegisterFailed.
+    uint8_t reason_;
+    /// Only meaningful for USERNAME_TOO_LONG, 0 otherwise.
+    uint8_t maxLength_;
+
+    typedef MessageLayout<
+        MessageField<RawCodec<uint8_t>, RegisterFailedMsg, &RegisterFailedMsg::reason_>,
+        MessageField<RawCodec<uint8_t>, RegisterFailedMsg, &RegisterFailedMsg::maxLength_>
+    > Layout;
+};
+
+}
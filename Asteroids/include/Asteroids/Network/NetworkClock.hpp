@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Asteroids/Config.hpp"
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/IO/VectorBuffer.h>
+
+namespace Urho3D {
+    class Connection;
+}
+
+namespace Asteroids {
+
+/*!
+ * @brief Estimates the offset between the client's and the server's clock
+ * and the round trip time with MSG_NETWORK_TIMER, NTP style.
+ *
+ * The client sends its time t0, the server replies with t0, the time it
+ * received the request t1 and the time it sent the reply t2, and the client
+ * notes the time it received the reply t3. Then
+ *
+ *     rtt    = (t3 - t0) - (t2 - t1)
+ *     offset = ((t1 - t0) + (t2 - t3)) / 2
+ *
+ * The offset is only exact if both directions took equally long, which is
+ * mostly the case for the samples with the lowest RTT. Samples that were
+ * held up in a queue somewhere are rejected by only using the samples close
+ * to the lowest RTT of the last few exchanges, and the offset is smoothed
+ * so it doesn't jitter between samples. The RTT is smoothed the same way
+ * TCP does it.
+ *
+ * Requests are sent every network tick right after connecting so the
+ * estimate converges quickly, and then once per second. Requests and replies
+ * are sent in E_NETWORKUPDATE, right before Urho3D sends its packets, so the
+ * send timestamps aren't off by the time messages wait for the next packet.
+ *
+ * The client also sends its current RTT estimate along with every request,
+ * so the server knows the RTT of every connection.
+ *
+ * All times are in microseconds since the NetworkClock was created.
+ */
+class ASTEROIDS_PUBLIC_API NetworkClock : public Urho3D::Object
+{
+    URHO3D_OBJECT(NetworkClock, Urho3D::Object)
+
+public:
+    NetworkClock(Urho3D::Context* context);
+
+    /// Our own time in microseconds.
+    long long GetLocalTime() const;
+
+    /// Client only. Our estimate of the server's clock, in seconds.
+    double GetServerTime() const;
+    /// Client only. Server time minus local time, in microseconds.
+    double GetOffset() const;
+    /// Client only. Smoothed round trip time in seconds.
+    float GetRoundTripTime() const;
+    /// Client only. Mean deviation of the round trip time in seconds.
+    float GetRoundTripJitter() const;
+    /// Client only. True once enough samples were received for the estimate to be useful.
+    bool IsSynchronized() const;
+
+    /// Server only. Last RTT the client reported, in seconds. 0 if unknown.
+    float GetRoundTripTime(Urho3D::Connection* connection) const;
+
+private:
+    struct Sample
+    {
+        double roundTripTime_;
+        double offset_;
+    };
+
+    struct PendingReply
+    {
+        Urho3D::Connection* connection_;
+        uint64_t clientTime_;
+        uint64_t receiveTime_;
+    };
+
+    void Reset();
+    void AddSample(long long t0, long long t1, long long t2, long long t3);
+    void UpdateDebugHud();
+
+    void HandleNetworkMessage(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleNetworkUpdate(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleServerConnected(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleServerDisconnected(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleClientDisconnected(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+
+private:
+    mutable Urho3D::HiresTimer clock_;
+
+    // Client
+    Urho3D::PODVector<Sample> samples_;
+    Urho3D::PODVector<Sample> candidates_;
+    unsigned nextSample_;
+    unsigned numRequests_;
+    long long nextRequestTime_;
+    double offset_;
+    double roundTripTime_;
+    double roundTripJitter_;
+    unsigned numSamples_;
+
+    // Server
+    Urho3D::PODVector<PendingReply> pendingReplies_;
+    Urho3D::HashMap<Urho3D::Connection*, float> clientRoundTripTimes_;
+
+    Urho3D::VectorBuffer msg_;
+};
+
+}
@@ -5,9 +5,24 @@
 namespace Asteroids {
 
 static const int MSG_CLIENT_SHIP_STATE = 0xA0;
-static const int MSG_SERVER_SHIP_STATE = 0xA1;
+static const int MSG_SERVER_SHIP_STATE = 0xA1;  // Unused, ship states are sent in MSG_SERVER_SNAPSHOT
 static const int MSG_REGISTER_FAILED   = 0xA2;
 static const int MSG_NETWORK_TIMER     = 0xA3;
+static const int MSG_SHM_TRANSPORT     = 0xA4;
+static const int MSG_ASTEROID_SNAPSHOT = 0xA5;
+static const int MSG_ASTEROID_SPAWN    = 0xA6;
+static const int MSG_ASTEROID_DESTROY  = 0xA7;
+static const int MSG_SHIP_HIT          = 0xA8;
+static const int MSG_PHASER_SPAWN      = 0xA9;
+static const int MSG_PHASER_DESTROY    = 0xAA;
+static const int MSG_REGISTER_SUCCEEDED = 0xAB;
+static const int MSG_USER_JOINED       = 0xAC;
+static const int MSG_USER_LEFT         = 0xAD;
+static const int MSG_PLAYER_CREATE     = 0xAE;
+static const int MSG_PLAYER_DESTROY    = 0xAF;
+static const int MSG_SERVER_SNAPSHOT   = 0xB0;
+static const int MSG_SNAPSHOT_FEEDBACK = 0xB1;
+static const int MSG_SHM_FRAGMENT      = 0xB2;  // Only used inside MessageRouter's shared memory channels
 
 enum MsgRegisterFailed
 {
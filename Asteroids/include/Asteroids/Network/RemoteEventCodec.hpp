@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Asteroids/Config.hpp"
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/IO/VectorBuffer.h>
+
+namespace Urho3D {
+    class Connection;
+}
+
+namespace Asteroids {
+
+/*!
+ * @brief Sends the user and player lifecycle events (E_REGISTERSUCCEEDED,
+ * E_USERJOINED, E_USERLEFT, E_PLAYERCREATE and E_PLAYERDESTROY) to clients
+ * as game messages instead of Urho3D remote events.
+ *
+ * A remote event serializes the whole VariantMap, i.e. a StringHash and a
+ * type tag for every parameter plus the hash of the event. These events only
+ * have a GUID, a rotation and a username, so each one is encoded with a
+ * fixed layout (see Messages.hpp) and sent reliable and in order through the
+ * MessageRouter.
+ *
+ * The client decodes the messages back into the same event and sends it
+ * from the server's Connection, so handlers that check the event sender
+ * work the same way they did with remote events.
+ */
+class ASTEROIDS_PUBLIC_API RemoteEventCodec : public Urho3D::Object
+{
+    URHO3D_OBJECT(RemoteEventCodec, Urho3D::Object)
+
+public:
+    RemoteEventCodec(Urho3D::Context* context);
+
+    /// Same as Connection::SendRemoteEvent().
+    void SendRemoteEvent(Urho3D::Connection* connection, Urho3D::StringHash eventType, const Urho3D::VariantMap& eventData);
+
+    /// Same as Network::BroadcastRemoteEvent().
+    void BroadcastRemoteEvent(Urho3D::StringHash eventType, const Urho3D::VariantMap& eventData);
+
+private:
+    /// Writes the event to msg_ and returns its message ID, or -1 if the event can't be sent.
+    int Encode(Urho3D::StringHash eventType, const Urho3D::VariantMap& eventData);
+    void HandleNetworkMessage(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+
+private:
+    Urho3D::VectorBuffer msg_;
+};
+
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "Asteroids/Config.hpp"
+#include <Urho3D/Container/Str.h>
+
+namespace Asteroids {
+
+/*!
+ * @brief Single-producer/single-consumer message queue in a POSIX shared
+ * memory segment.
+ *
+ * One process creates the segment with Create() and the other attaches to it
+ * with Open(). Exactly one side may write and exactly one side may read.
+ * Messages are stored as variable length records ([size][id][payload],
+ * padded to 8 bytes) and never wrap around the end of the buffer, so a
+ * message can be read in place with Peek() without copying it out first.
+ * Messages are limited to GetMaxMessageSize(), about half the capacity,
+ * which guarantees that a message fits once the reader has caught up, no
+ * matter where in the buffer the last record ended.
+ *
+ * The head and tail counters are lock-free atomics living in the segment
+ * itself, so no syscalls are involved in sending or receiving once the
+ * segment is mapped.
+ *
+ * Only implemented on Linux. Create() and Open() fail on other platforms.
+ * Allocate() works everywhere and puts the queue in ordinary memory, for when
+ * both sides live in the same process.
+ */
+class ASTEROIDS_PUBLIC_API ShmRingBuffer
+{
+public:
+    ShmRingBuffer();
+    /// Unmaps the segment, and unlinks it if we created it and Unlink() wasn't called.
+    ~ShmRingBuffer();
+    ShmRingBuffer(const ShmRingBuffer&) = delete;
+    ShmRingBuffer& operator=(const ShmRingBuffer&) = delete;
+
+    /*!
+     * @brief Creates a new segment.
+     * @param[in] name Name of the segment. Must start with a "/".
+     * @param[in] capacity Size of the data area in bytes. Rounded up to
+     * the next power of two.
+     */
+    bool Create(const Urho3D::String& name, unsigned capacity);
+
+    /// Attaches to a segment that was created by another process.
+    bool Open(const Urho3D::String& name);
+
+    /*!
+     * @brief Creates the queue in process memory instead of a shared memory
+     * segment. Both sides then use this same object.
+     * @param[in] capacity Size of the data area in bytes. Rounded up to
+     * the next power of two.
+     */
+    bool Allocate(unsigned capacity);
+
+    /// Unmaps the segment, or frees the memory if it was allocated.
+    void Close();
+
+    /*!
+     * @brief Removes the segment's name from the system. The memory stays
+     * valid until both sides have closed it. Call this once the other side
+     * has attached, so the segment doesn't outlive a crashed process.
+     */
+    void Unlink();
+
+    bool IsOpen() const { return header_ != nullptr; }
+    const Urho3D::String& GetName() const { return name_; }
+    /// Largest message Write() accepts.
+    unsigned GetMaxMessageSize() const;
+
+    /*!
+     * @brief Appends a message. Producer side only.
+     * @return False if there isn't enough free space or the message is
+     * larger than GetMaxMessageSize(), in which case nothing is written.
+     */
+    bool Write(int msgID, const void* data, unsigned size);
+
+    /*!
+     * @brief Returns a pointer to the oldest message without removing it.
+     * Consumer side only.
+     * @return NULL if the queue is empty, closed or the next record is
+     * corrupt.
+     */
+    const unsigned char* Peek(int* msgID, unsigned* size) const;
+
+    /// Removes the message returned by the last call to Peek().
+    void Pop();
+
+private:
+    struct Header;
+
+    bool Map(int fd, unsigned mapSize);
+    void Init(unsigned capacity);
+
+    Urho3D::String name_;
+    Header* header_;
+    unsigned char* data_;
+    unsigned mapSize_;
+    unsigned capacity_;
+    bool owner_;
+    bool allocated_;
+};
+
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "Asteroids/Config.hpp"
+#include "Asteroids/Network/Messages.hpp"
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Math/Vector3.h>
+
+namespace Urho3D {
+    class Connection;
+    class Scene;
+}
+
+namespace Asteroids {
+
+class ServerShipState;
+
+/*!
+ * @brief Decides which ship states are sent to which client every network
+ * tick, so a busy server degrades gracefully instead of flooding clients
+ * that can't keep up.
+ *
+ * Every client has a byte budget per tick. Every ship has a priority
+ * accumulator per client, which grows every tick by how important the ship
+ * is to that client (closer ships are more important). Each tick the ships
+ * with the highest accumulated priority are packed into one
+ * MSG_SERVER_SNAPSHOT until the budget is used up. Their accumulators are
+ * reset, the rest carry over to the next tick, so ships that were skipped
+ * become more and more likely to be sent. A client's own ship is always sent
+ * since it carries the input acknowledgement.
+ *
+ * Clients count the snapshots they miss (the snapshots are numbered) and
+ * report the loss with MSG_SNAPSHOT_FEEDBACK twice a second. The budget
+ * grows additively while there is no loss and shrinks multiplicatively when
+ * there is loss or when the RTT reported to NetworkClock grows far beyond
+ * the lowest RTT seen, which is a sign of queues filling up. Clients only
+ * report loss once they receive something again, so if the server hears
+ * nothing from a client for two feedback intervals it treats that as total
+ * loss and keeps shrinking the budget every interval until feedback resumes.
+ *
+ * On the client, each snapshot is decoded once into states sorted by GUID,
+ * and ClientLocalShipState and ClientRemoteShipState (found through the
+ * UpdateRegistry) look up their own state with a binary search.
+ *
+ * Packing and decoding run on the main thread, in the network update and in
+ * the message handler. The socket belongs to Urho3D's Network subsystem,
+ * which is pumped on the main thread, so there is no separate network thread.
+ */
+class ASTEROIDS_PUBLIC_API SnapshotScheduler : public Urho3D::Object
+{
+    URHO3D_OBJECT(SnapshotScheduler, Urho3D::Object)
+
+public:
+    SnapshotScheduler(Urho3D::Context* context);
+
+    /// Server only. Bytes per network tick the client currently gets, 0 if it isn't known.
+    unsigned GetBudget(Urho3D::Connection* connection) const;
+
+    /*!
+     * @brief Decodes a MSG_SERVER_SNAPSHOT into states sorted by GUID.
+     * Returns false if the snapshot is truncated.
+     */
+    static bool DecodeSnapshot(const unsigned char* data, unsigned size, Urho3D::PODVector<ServerShipStateMsg>* states);
+    /// Binary search in states returned by DecodeSnapshot(). Returns null if the ship isn't there.
+    static const ServerShipStateMsg* FindShipState(const Urho3D::PODVector<ServerShipStateMsg>& states, uint16_t guid);
+
+private:
+    struct Entity
+    {
+        ServerShipState* state_;
+        Urho3D::Scene* scene_;
+        Urho3D::Connection* owner_;
+        Urho3D::Vector3 position_;
+        unsigned guid_;
+    };
+
+    struct Candidate
+    {
+        unsigned entity_;
+        float priority_;
+    };
+
+    struct Accumulator
+    {
+        float priority_;
+        unsigned lastTick_;
+    };
+
+    struct Client : public Urho3D::RefCounted
+    {
+        Urho3D::HashMap<unsigned, Accumulator> accumulators_;
+        unsigned budget_;
+        float minRoundTripTime_ = 0;
+        unsigned ticksSinceFeedback_ = 0;
+        uint16_t sequence_ = 0;
+    };
+
+    void GatherEntities();
+    void SendSnapshot(Urho3D::Connection* connection, Client* client);
+    void AdaptBudget(Urho3D::Connection* connection, Client* client, float loss);
+    void ApplyShipStates(Urho3D::Scene* scene);
+    void SendFeedback(Urho3D::Connection* server);
+
+    void HandleNetworkUpdate(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleNetworkMessage(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleServerConnected(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleClientDisconnected(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+
+private:
+    // Server
+    Urho3D::HashMap<Urho3D::Connection*, Urho3D::SharedPtr<Client>> clients_;
+    Urho3D::PODVector<Entity> entities_;
+    Urho3D::PODVector<Candidate> candidates_;
+    unsigned tick_;
+
+    // Client
+    Urho3D::PODVector<ServerShipStateMsg> shipStates_;
+    uint16_t lastSequence_;
+    bool receivedSnapshot_;
+    unsigned snapshotsReceived_;
+    unsigned snapshotsExpected_;
+    unsigned ticksSinceFeedback_;
+
+    Urho3D::VectorBuffer msg_;
+};
+
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "Asteroids/Config.hpp"
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Graphics/Drawable.h>
+#include <Urho3D/IO/VectorBuffer.h>
+
+namespace Urho3D {
+    class Connection;
+    class Material;
+    class Model;
+}
+
+namespace Asteroids {
+
+class ProceduralPlanet;
+class UpdateRegistry;
+
+/*!
+ * @brief Simulates, replicates and draws all asteroids of a scene.
+ *
+ * Asteroids move like SurfaceObjects: each one is a pivot rotation around
+ * the planet's center plus a height above the surface, and drifts in a
+ * straight line (a great circle) while tumbling. There is no node or
+ * component per asteroid. The state lives in parallel arrays and the whole
+ * field is updated in one loop, so thousands of asteroids are cheap. Hits
+ * are found through a uniform grid that is rebuilt when asteroids move, so
+ * each projectile is only tested against the asteroids near it.
+ *
+ * An asteroid's trajectory is a closed-form function of its spawn
+ * parameters and the field time, and all of its motion parameters are
+ * derived from a seed. The server therefore never sends transforms, only:
+ *   - MSG_ASTEROID_SPAWN with the seed and size of a new wave.
+ *   - MSG_ASTEROID_DESTROY when an asteroid is hit. The fragments it splits
+ *     into are derived from the parent's seed by both sides.
+ *   - MSG_ASTEROID_SNAPSHOT with the spawn parameters of every asteroid,
+ *     once, when a user joins, split into messages of a packet each.
+ * Bandwidth depends on the number of hits, not on the number of asteroids.
+ * Every message also carries the server's NetworkClock time, and clients
+ * advance their field time along the server's clock from there, so they
+ * don't lag behind by the time the message took.
+ *
+ * Asteroids come in four sizes. When hit, an asteroid splits into two of
+ * the next smaller size, and the smallest ones are simply destroyed.
+ *
+ * Both the server and the client add this as a local component to the root
+ * of their scene. The server's field is the authority: it spawns waves,
+ * detects hits from phasers and mines and tells the clients. On clients it
+ * also draws every asteroid as one instanced batch, like ProjectileRenderer.
+ */
+class ASTEROIDS_PUBLIC_API AsteroidField : public Urho3D::Drawable
+{
+    URHO3D_OBJECT(AsteroidField, Urho3D::Drawable)
+
+public:
+    enum Size
+    {
+        SIZE_HUGE,
+        SIZE_LARGE,
+        SIZE_MEDIUM,
+        SIZE_SMALL,
+
+        SIZE_COUNT
+    };
+
+    AsteroidField(Urho3D::Context* context);
+    static void RegisterObject(Urho3D::Context* context);
+
+    /// The server's field spawns waves, detects hits and replicates them. Clients wait for the server.
+    void SetAuthority(bool enable);
+    bool IsAuthority() const;
+
+    void SetModel(Urho3D::Model* model);
+    void SetMaterial(Urho3D::Material* material);
+
+    /// Authority only. Spawns count huge asteroids from the seed and tells all clients.
+    void SpawnWave(unsigned seed, unsigned count);
+    /// Authority only. Splits or removes the asteroid and tells all clients. Returns false if the ID doesn't exist.
+    bool Destroy(unsigned id);
+    /// Authority only. Sends the spawn parameters of all asteroids to a client that just joined.
+    void SendSnapshot(Urho3D::Connection* connection);
+
+    unsigned GetNumAsteroids() const;
+    double GetTime() const;
+    static float GetRadius(Size size);
+
+    /*!
+     * @brief Advances the field time and updates every asteroid's position.
+     * Called automatically (see Update()), public so it can be benchmarked.
+     */
+    void Simulate(float dt);
+
+    void UpdateBatches(const Urho3D::FrameInfo& frame) override;
+
+    Urho3D::ResourceRef GetModelAttr() const;
+    void SetModelAttr(const Urho3D::ResourceRef& value);
+    Urho3D::ResourceRef GetMaterialAttr() const;
+    void SetMaterialAttr(const Urho3D::ResourceRef& value);
+
+protected:
+    void OnSceneSet(Urho3D::Scene* scene) override;
+    void OnWorldBoundingBoxUpdate() override;
+
+private:
+    friend class UpdateRegistry;
+    void Update(float dt);
+
+    void Clear();
+    void Add(unsigned id, unsigned seed, Size size, double startTime, const Urho3D::Quaternion& startRotation);
+    void RemoveAt(unsigned index);
+    void ApplySpawnWave(unsigned seed, unsigned count, unsigned firstID, double time);
+    bool ApplyDestroy(unsigned id, unsigned firstChildID, double time);
+    void UpdateAsteroids(unsigned begin, unsigned end, ProceduralPlanet* planet);
+    void BuildGrid();
+    int FindHit(const Urho3D::Vector3& position) const;
+    template <class T>
+    void CollideProjectiles(UpdateRegistry* registry);
+    void WriteTime();
+    void Broadcast(int msgID);
+    void UpdateBatchGeometry();
+    void HandleNetworkMessage(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleServerDisconnected(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+
+private:
+    // Spawn parameters, these are all that is replicated
+    Urho3D::PODVector<unsigned> ids_;
+    Urho3D::PODVector<unsigned> seeds_;
+    Urho3D::PODVector<unsigned char> sizes_;
+    Urho3D::PODVector<double> startTimes_;
+    Urho3D::PODVector<Urho3D::Quaternion> startRotations_;
+
+    // Derived from the seed
+    Urho3D::PODVector<Urho3D::Vector3> driftAxes_;
+    Urho3D::PODVector<float> driftRates_;
+    Urho3D::PODVector<Urho3D::Vector3> tumbleAxes_;
+    Urho3D::PODVector<float> tumbleRates_;
+
+    // Current state, updated by Simulate()
+    Urho3D::PODVector<Urho3D::Quaternion> rotations_;
+    Urho3D::PODVector<Urho3D::Vector3> positions_;
+
+    // Scratch space for the batched rotations
+    Urho3D::PODVector<float> angles_;
+    Urho3D::PODVector<Urho3D::Quaternion> tumbledRotations_;
+
+    Urho3D::HashMap<unsigned, unsigned> indexByID_;
+
+    // Server. Asteroid indices sorted by hashed grid cell for hit detection,
+    // the asteroids of bucket b are gridEntries_[gridStarts_[b]] up to
+    // gridEntries_[gridStarts_[b + 1]].
+    Urho3D::PODVector<unsigned> gridStarts_;
+    Urho3D::PODVector<unsigned> gridEntries_;
+    Urho3D::PODVector<unsigned> gridBuckets_;
+
+    Urho3D::SharedPtr<Urho3D::Model> model_;
+    Urho3D::SharedPtr<Urho3D::Material> material_;
+    Urho3D::PODVector<Urho3D::Matrix3x4> worldTransforms_;
+    Urho3D::VectorBuffer msg_;
+    float modelRadius_;
+    float boundsRadius_;
+    unsigned transformsFrame_;
+
+    double time_;
+    // Client. Field time of the last message from the server and the
+    // server's NetworkClock time in seconds when it was sent.
+    double anchorTime_;
+    double anchorClock_;
+    unsigned nextID_;
+    // Index of the first asteroid in the next MSG_ASTEROID_SNAPSHOT chunk
+    unsigned snapshotNext_;
+    unsigned waveCount_;
+    bool gridDirty_;
+    int seed_;
+    int waveSize_;
+    float defaultHeight_;
+    bool authority_;
+    bool synchronized_;
+};
+
+}
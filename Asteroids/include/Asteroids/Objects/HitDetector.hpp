@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Asteroids/Config.hpp"
+#include "Asteroids/UserRegistry/User.hpp"
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Scene/Component.h>
+
+namespace Asteroids {
+
+class ServerShipState;
+class UpdateRegistry;
+
+/*!
+ * @brief Detects phasers and mines hitting ships, applies the damage and
+ * tells the clients.
+ *
+ * Projectiles have no rigid bodies. A kinematic body per projectile means a
+ * broadphase update per projectile per frame, and most of the pairs Bullet
+ * would generate are between projectiles. Instead, the server runs one batch
+ * test after all projectiles have moved: every projectile and every ship is
+ * a sphere moving along a straight line from where it was one frame ago
+ * (see SurfaceObject::GetPreviousWorldPosition(), phasers are evaluated at
+ * their previous age) to where it is now.
+ * Steps are short compared to the planet's radius, so the chord is close
+ * enough to the arc. This catches fast phasers that would jump over a ship
+ * between two frames.
+ *
+ * A projectile is removed when it hits a ship other than the one that fired
+ * it. The hits of a frame are sent to the clients in MSG_SHIP_HIT (see
+ * ShipHitMsg in Messages.hpp), up to 255 per message, which the client's
+ * detector turns into E_SHIPHIT events.
+ *
+ * Both the server and the client add this as a local component to the root
+ * of their scene. Only the server's detector is the authority.
+ */
+class ASTEROIDS_PUBLIC_API HitDetector : public Urho3D::Component
+{
+    URHO3D_OBJECT(HitDetector, Urho3D::Component)
+
+public:
+    enum Weapon
+    {
+        WEAPON_PHASER,
+        WEAPON_MINE
+    };
+
+    HitDetector(Urho3D::Context* context);
+    static void RegisterObject(Urho3D::Context* context);
+
+    /// The server's detector applies damage and broadcasts hits. Clients only receive them.
+    void SetAuthority(bool enable);
+    bool IsAuthority() const;
+
+protected:
+    void OnSceneSet(Urho3D::Scene* scene) override;
+
+private:
+    friend class UpdateRegistry;
+    void Update(float dt);
+
+    void GatherShips(UpdateRegistry* registry);
+    template <class T>
+    void SweepProjectiles(UpdateRegistry* registry, Weapon weapon, float radius, float dt);
+    void ApplyHits();
+    void HandleNetworkMessage(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+
+private:
+    struct Hit
+    {
+        Urho3D::Component* projectile_;
+        unsigned ship_;
+        User::GUID attacker_;
+        unsigned char weapon_;
+    };
+
+    // Ships of this frame
+    Urho3D::PODVector<ServerShipState*> shipStates_;
+    Urho3D::PODVector<User::GUID> shipGUIDs_;
+    Urho3D::PODVector<Urho3D::Vector3> shipStarts_;
+    Urho3D::PODVector<Urho3D::Vector3> shipEnds_;
+
+    Urho3D::PODVector<Hit> hits_;
+    Urho3D::VectorBuffer msg_;
+
+    float shipRadius_;
+    float phaserRadius_;
+    float mineRadius_;
+    float phaserDamage_;
+    float mineDamage_;
+    bool authority_;
+};
+
+}
@@ -2,9 +2,19 @@
 
 #include "Asteroids/Config.hpp"
 #include "Asteroids/Objects/SurfaceObject.hpp"
+#include "Asteroids/UserRegistry/User.hpp"
+#include "Asteroids/Util/TimerWheel.hpp"
 
 namespace Asteroids {
 
+/*!
+ * @brief A mine slides away from the ship that dropped it and decelerates
+ * until it comes to rest.
+ *
+ * Once a mine is at rest it puts itself to sleep in the UpdateRegistry and
+ * costs nothing per frame. Setting a new velocity wakes it up again. The
+ * mine's life runs out through the TimerWheel, whether it's asleep or not.
+ */
 class MineController : public SurfaceObject
 {
     URHO3D_OBJECT(MineController, SurfaceObject)
@@ -14,17 +24,33 @@ public:
     static void RegisterObject(Urho3D::Context* context);
 
     const Urho3D::Vector2& GetVelocity() const;
+    /// Wakes the mine up if it was at rest.
     void SetVelocity(const Urho3D::Vector2& velocity);
     void SetDeceleration(float deceleration);
     void SetLife(float life);
+    bool IsAtRest() const;
+
+    /// The user whose ship fired this. Projectiles never hit their owner.
+    void SetOwner(User::GUID owner);
+    User::GUID GetOwner() const;
+
+    /// Removes the mine, e.g. because it hit something.
+    void Destroy();
+
+protected:
+    virtual void OnSceneSet(Urho3D::Scene* scene) override;
 
 private:
-    void HandleUpdate(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    friend class UpdateRegistry;
+    void Update(float dt);
+    void HandleExpired();
 
 private:
     Urho3D::Vector2 velocity_;
     float deceleration_;
-    float life_;
+    TimerWheel::TimerID expiryTimer_;
+    User::GUID owner_;
+    bool atRest_;
 };
 
 }
@@ -1,28 +1,93 @@
 #pragma once
 
 #include "Asteroids/Config.hpp"
-#include "Asteroids/Objects/SurfaceObject.hpp"
+#include "Asteroids/UserRegistry/User.hpp"
+#include "Asteroids/Util/TimerWheel.hpp"
+#include <Urho3D/Scene/Component.h>
 
 namespace Asteroids {
 
-class ASTEROIDS_PUBLIC_API PhaserController : public SurfaceObject
+/*!
+ * @brief A phaser flies along a great circle at constant speed, so its
+ * position is a closed-form function of where it started, its velocity and
+ * its age.
+ *
+ * Unlike SurfaceObjects, phasers aren't integrated every frame. The node
+ * stays where the phaser was fired and the position is only evaluated when
+ * something asks for it (ProjectileRenderer, HitDetector, AsteroidField).
+ * Nothing accumulates, so every peer that knows the start rotation and the
+ * velocity computes exactly the same path. This is what PhaserReplicator
+ * sends instead of replicating the node.
+ *
+ * Age is measured in scene time (Scene::GetElapsedTime()). Phasers expire
+ * through the TimerWheel and aren't updated at all, the UpdateRegistry only
+ * tracks them.
+ */
+class ASTEROIDS_PUBLIC_API PhaserController : public Urho3D::Component
 {
-    URHO3D_OBJECT(PhaserController, SurfaceObject)
+    URHO3D_OBJECT(PhaserController, Urho3D::Component)
 
 public:
     PhaserController(Urho3D::Context* context);
     static void RegisterObject(Urho3D::Context* context);
 
-    void SetVelocity(const Urho3D::Vector2& velocity);
-    void SetLife(float life);
+    /*!
+     * @brief Fires the phaser from a ship's pivot.
+     * @param[in] pivotRotation Rotation of the ship's pivot.
+     * @param[in] velocity Velocity in the pivot's local XZ plane.
+     * @param[in] radius Distance from the planet's center, e.g. the ship's.
+     * Sets how fast the phaser goes around the planet.
+     * @param[in] offset The phaser starts this far along its path, so it
+     * doesn't appear inside the ship.
+     */
+    void Launch(const Urho3D::Quaternion& pivotRotation, const Urho3D::Vector2& velocity, float radius, float offset);
+
+    /// Sets the path and resets the age to 0. Clients use this to reproduce the server's phasers.
+    void SetTrajectory(const Urho3D::Quaternion& startRotation, const Urho3D::Vector2& velocity, float radius);
+    const Urho3D::Quaternion& GetStartRotation() const;
     const Urho3D::Vector2& GetVelocity() const;
+    float GetRadius() const;
+
+    void SetLife(float life);
+    float GetLife() const;
+    /// Moves the start of the path back in time, e.g. to account for network delay.
+    void SetAge(float age);
+    float GetAge() const;
+
+    /// The user whose ship fired this. Projectiles never hit their owner.
+    void SetOwner(User::GUID owner);
+    User::GUID GetOwner() const;
+
+    /// Identifies the phaser in PhaserReplicator's messages.
+    void SetNetworkID(unsigned id);
+    unsigned GetNetworkID() const;
+
+    Urho3D::Vector3 GetWorldPositionAt(float age) const;
+    Urho3D::Vector3 GetWorldPosition() const;
+    Urho3D::Matrix3x4 GetWorldTransform() const;
+
+    /// Removes the phaser before its life ran out, e.g. because it hit something. Tells the clients.
+    void Destroy();
+
+protected:
+    virtual void OnSceneSet(Urho3D::Scene* scene) override;
 
 private:
-    void HandleUpdate(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    Urho3D::Quaternion GetRotationAt(float age) const;
+    void ScheduleExpiry();
+    void HandleExpired();
 
 private:
+    Urho3D::Quaternion startRotation_;
+    Urho3D::Vector3 axis_;
     Urho3D::Vector2 velocity_;
+    float angularSpeed_;
+    float radius_;
+    float startTime_;
     float life_;
+    unsigned networkID_;
+    TimerWheel::TimerID expiryTimer_;
+    User::GUID owner_;
 };
 
 }
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Asteroids/Config.hpp"
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Scene/Component.h>
+
+namespace Asteroids {
+
+class PhaserController;
+class Prefab;
+
+/*!
+ * @brief Sends phasers to the clients as spawn parameters instead of
+ * replicating their nodes.
+ *
+ * A phaser's path only depends on its start rotation, velocity and radius
+ * (see PhaserController), so the server sends those once in
+ * MSG_PHASER_SPAWN and every client simulates the phaser on its own. The
+ * message also carries the server time the phaser was fired at, which
+ * clients convert with NetworkClock to start the phaser at its current age. Phasers
+ * that expire are removed by every peer independently. Only phasers that are
+ * removed early (because they hit something) need a MSG_PHASER_DESTROY.
+ *
+ * Both the server and the client add this as a local component to the root
+ * of their scene. The server's phasers are local nodes, the client creates
+ * local nodes from the same prefab when it receives a spawn message.
+ */
+class ASTEROIDS_PUBLIC_API PhaserReplicator : public Urho3D::Component
+{
+    URHO3D_OBJECT(PhaserReplicator, Urho3D::Component)
+
+public:
+    PhaserReplicator(Urho3D::Context* context);
+    static void RegisterObject(Urho3D::Context* context);
+
+    /// The server's replicator sends messages. Clients only receive them.
+    void SetAuthority(bool enable);
+    bool IsAuthority() const;
+
+    /// Authority only. Assigns the phaser an ID and tells all clients about it.
+    void SendSpawn(PhaserController* phaser);
+    /// Authority only. Tells all clients to remove the phaser.
+    void SendDestroy(PhaserController* phaser);
+
+private:
+    void HandleNetworkMessage(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+
+private:
+    Urho3D::SharedPtr<Prefab> phaserPrefab_;
+    Urho3D::VectorBuffer msg_;
+    unsigned nextID_;
+    bool authority_;
+};
+
+}
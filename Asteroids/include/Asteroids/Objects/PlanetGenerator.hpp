@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Asteroids/Config.hpp"
+#include <Urho3D/Container/RefCounted.h>
+#include <Urho3D/Container/Vector.h>
+#include <Urho3D/Math/Vector3.h>
+
+namespace Asteroids {
+
+/*!
+ * @brief Generates planet terrain from a seed.
+ *
+ * The terrain is a sphere displaced by fractal gradient noise. Everything is
+ * derived from the seed, radius and amplitude, so the server and the clients
+ * produce the same planet without having to transfer any meshes.
+ *
+ * There are three representations built from the same height function:
+ *   - A height map (a cube map of radii) that SampleRadius() reads. This is
+ *     what objects moving on the surface use instead of raycasting.
+ *   - A collision mesh, which is a subdivided icosphere.
+ *   - Render chunks. Each face of the icosahedron is split recursively into
+ *     four triangles, and every triangle can be turned into a grid mesh of
+ *     a fixed resolution. See PlanetTerrain.
+ *
+ * All directions are in the planet's local space and don't have to be
+ * normalized.
+ */
+class ASTEROIDS_PUBLIC_API PlanetGenerator : public Urho3D::RefCounted
+{
+public:
+    PlanetGenerator(unsigned seed, float radius, float amplitude);
+
+    float GetRadius() const;
+    float GetMinRadius() const;
+    float GetMaxRadius() const;
+
+    /// Evaluates the height function. This is slow, use SampleRadius() at runtime.
+    float GenerateRadius(const Urho3D::Vector3& direction) const;
+    /// Surface normal, using finite differences of the given step on the unit sphere.
+    Urho3D::Vector3 GenerateNormal(const Urho3D::Vector3& direction, float step) const;
+
+    /// Bakes the height function into a cube map with resolution x resolution samples per face.
+    void BuildHeightMap(unsigned resolution);
+    /// Returns the radius of the surface in the given direction, interpolated from the height map.
+    float SampleRadius(const Urho3D::Vector3& direction) const;
+
+    /*!
+     * @brief Builds a closed triangle mesh for physics. Every subdivision
+     * quadruples the number of triangles, starting at 20.
+     */
+    void BuildCollisionMesh(unsigned subdivisions,
+                            Urho3D::PODVector<Urho3D::Vector3>& vertices,
+                            Urho3D::PODVector<unsigned>& indices) const;
+
+    /*!
+     * @brief Builds the render mesh of the spherical triangle a, b, c.
+     *
+     * Each edge is split into resolution segments. Vertices are written as
+     * position followed by normal. The edges get a skirt that hangs
+     * skirtDepth below the surface, which hides the cracks between chunks of
+     * a different level of detail.
+     */
+    void BuildChunkMesh(const Urho3D::Vector3& a,
+                        const Urho3D::Vector3& b,
+                        const Urho3D::Vector3& c,
+                        unsigned resolution,
+                        float skirtDepth,
+                        Urho3D::PODVector<float>& vertexData,
+                        Urho3D::PODVector<unsigned short>& indexData) const;
+
+    /// Unit icosahedron. Faces are wound clockwise when seen from outside.
+    static void GetIcosahedron(Urho3D::PODVector<Urho3D::Vector3>& vertices,
+                               Urho3D::PODVector<unsigned>& faces);
+
+private:
+    float Noise(const Urho3D::Vector3& p) const;
+
+private:
+    unsigned char permutation_[512];
+    Urho3D::PODVector<float> heightMap_;
+    unsigned heightMapResolution_;
+    float radius_;
+    float amplitude_;
+};
+
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Asteroids/Config.hpp"
+#include <Urho3D/Graphics/Drawable.h>
+
+namespace Urho3D {
+    class Geometry;
+    class Material;
+}
+
+namespace Asteroids {
+
+class PlanetGenerator;
+
+/*!
+ * @brief Renders a generated planet as a quadtree of chunks.
+ *
+ * The 20 faces of an icosahedron are the roots. Every chunk is a grid mesh
+ * of the same resolution, and splitting a chunk replaces it with four
+ * children that cover a quarter of the area each, so the triangle density
+ * doubles per level. After every scene update the tree is walked with the
+ * camera of the first viewport and chunks closer than their radius times the
+ * LOD factor are split.
+ *
+ * Chunk meshes are generated on demand. To avoid hitches only a few are
+ * built per frame, and a chunk is drawn until all of its children are ready.
+ * When the camera moves away and a chunk is drawn instead of its children
+ * again, the children are kept for a few seconds in case it comes back, then
+ * their meshes are released and their slots reused.
+ *
+ * This component is created by ProceduralPlanet on clients, it isn't meant
+ * to be added manually.
+ */
+class ASTEROIDS_PUBLIC_API PlanetTerrain : public Urho3D::Drawable
+{
+    URHO3D_OBJECT(PlanetTerrain, Urho3D::Drawable)
+
+public:
+    PlanetTerrain(Urho3D::Context* context);
+    static void RegisterObject(Urho3D::Context* context);
+
+    /// Discards all chunks and builds the root chunks with the new generator.
+    void SetGenerator(PlanetGenerator* generator, unsigned lodLevels, unsigned chunkResolution);
+    void SetLodFactor(float factor);
+    void SetMaterial(Urho3D::Material* material);
+
+    /*!
+     * @brief Selects the chunks to draw for a camera at the specified world
+     * position. Called automatically after each scene update, public so it
+     * can be benchmarked.
+     */
+    void UpdateLod(const Urho3D::Vector3& cameraPosition);
+    unsigned GetNumVisibleChunks() const;
+    unsigned GetNumBuiltChunks() const;
+
+    void UpdateBatches(const Urho3D::FrameInfo& frame) override;
+
+protected:
+    void OnSceneSet(Urho3D::Scene* scene) override;
+    void OnWorldBoundingBoxUpdate() override;
+
+private:
+    struct Chunk
+    {
+        /// Corners on the unit sphere
+        Urho3D::Vector3 corners_[3];
+        /// Bounding sphere in local space
+        Urho3D::Vector3 center_;
+        float radius_;
+        unsigned depth_;
+        /// Index of the first of four children, 0 if the chunk isn't split
+        unsigned children_;
+        /// Last LOD update that selected this chunk or one of its children
+        unsigned lastUsed_;
+        Urho3D::SharedPtr<Urho3D::Geometry> geometry_;
+    };
+
+    void InitChunk(Chunk& chunk, const Urho3D::Vector3& a, const Urho3D::Vector3& b, const Urho3D::Vector3& c, unsigned depth);
+    void SplitChunk(unsigned index);
+    void ReleaseChildren(unsigned index);
+    void BuildChunk(unsigned index);
+    void SelectChunk(unsigned index, const Urho3D::Vector3& cameraPosition, unsigned* buildBudget);
+    void UpdateChunkBatches();
+    void HandleScenePostUpdate(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+
+private:
+    Urho3D::SharedPtr<PlanetGenerator> generator_;
+    Urho3D::SharedPtr<Urho3D::Material> material_;
+    Urho3D::Vector<Chunk> chunks_;
+    /// First indices of blocks of four released chunks
+    Urho3D::PODVector<unsigned> freeBlocks_;
+    Urho3D::PODVector<unsigned> visibleChunks_;
+    Urho3D::PODVector<float> vertexData_;
+    Urho3D::PODVector<unsigned short> indexData_;
+    unsigned lodLevels_;
+    unsigned chunkResolution_;
+    unsigned builtChunks_;
+    unsigned updateCount_;
+    float lodFactor_;
+};
+
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Asteroids/Config.hpp"
+#include <Urho3D/Scene/Component.h>
+
+namespace Urho3D {
+    class CollisionShape;
+    class Material;
+    class Model;
+    class RigidBody;
+}
+
+namespace Asteroids {
+
+class PlanetGenerator;
+class PlanetTerrain;
+
+/*!
+ * @brief Planet whose terrain is generated from a seed.
+ *
+ * Only the generator parameters are stored in the scene and replicated, so
+ * a new map is just a different seed. When the attributes are applied, the
+ * component builds:
+ *   - The height map. SurfaceObjects look their height up here instead of
+ *     raycasting against the terrain.
+ *   - A simplified collision mesh, which it adds to the node as a local,
+ *     temporary RigidBody + CollisionShape on the terrain layer.
+ *   - If there is a Graphics subsystem, a local PlanetTerrain for rendering.
+ *     The headless server never builds any render geometry.
+ *
+ * The planet's center is assumed to be at the origin, same as the pivots of
+ * all SurfaceObjects.
+ */
+class ASTEROIDS_PUBLIC_API ProceduralPlanet : public Urho3D::Component
+{
+    URHO3D_OBJECT(ProceduralPlanet, Urho3D::Component)
+
+public:
+    ProceduralPlanet(Urho3D::Context* context);
+    ~ProceduralPlanet();
+    static void RegisterObject(Urho3D::Context* context);
+
+    void ApplyAttributes() override;
+
+    /// Rebuilds the height map, the collision mesh and the render terrain.
+    void Generate();
+
+    /// Distance from the planet's center to the surface in the given world direction.
+    float GetSurfaceRadius(const Urho3D::Vector3& worldDirection) const;
+    PlanetGenerator* GetGenerator() const;
+
+    /// Returns the procedural planet in the specified scene, or null if it has none.
+    static ProceduralPlanet* GetScenePlanet(const Urho3D::Scene* scene);
+
+    Urho3D::ResourceRef GetMaterialAttr() const;
+    void SetMaterialAttr(const Urho3D::ResourceRef& value);
+
+protected:
+    void OnSceneSet(Urho3D::Scene* scene) override;
+
+private:
+    void MarkGeneratorDirty();
+    void CreateCollision();
+    void CreateTerrain();
+
+private:
+    Urho3D::SharedPtr<PlanetGenerator> generator_;
+    Urho3D::SharedPtr<Urho3D::Model> collisionModel_;
+    Urho3D::SharedPtr<Urho3D::Material> material_;
+    Urho3D::WeakPtr<Urho3D::RigidBody> body_;
+    Urho3D::WeakPtr<Urho3D::CollisionShape> shape_;
+    Urho3D::WeakPtr<PlanetTerrain> terrain_;
+
+    int seed_;
+    float radius_;
+    float amplitude_;
+    int heightMapResolution_;
+    int collisionSubdivisions_;
+    int lodLevels_;
+    int chunkResolution_;
+    float lodFactor_;
+    bool generatorDirty_;
+};
+
+}
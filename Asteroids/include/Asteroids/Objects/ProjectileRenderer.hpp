@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Asteroids/Config.hpp"
+#include <Urho3D/Graphics/Drawable.h>
+
+namespace Urho3D {
+    class Material;
+    class Model;
+}
+
+namespace Asteroids {
+
+/*!
+ * @brief Draws every projectile of one type in the scene as a single
+ * instanced batch.
+ *
+ * Projectiles don't have a StaticModel each. Instead, after every scene
+ * update the renderer walks the array of live controllers the UpdateRegistry
+ * already keeps for the simulation and copies their transforms into one
+ * instance buffer. That means one octree entry and one batch per projectile
+ * type instead of one per projectile, and nothing has to be reinserted into
+ * the octree when a projectile moves. If the GPU doesn't support hardware
+ * instancing, Urho falls back to drawing the instances one by one.
+ *
+ * Add one renderer per projectile type to the scene root (as a local
+ * component on clients).
+ */
+class ASTEROIDS_PUBLIC_API ProjectileRenderer : public Urho3D::Drawable
+{
+    URHO3D_OBJECT(ProjectileRenderer, Urho3D::Drawable)
+
+public:
+    enum ProjectileType
+    {
+        PHASER,
+        MINE
+    };
+
+    ProjectileRenderer(Urho3D::Context* context);
+    static void RegisterObject(Urho3D::Context* context);
+
+    void SetProjectileType(ProjectileType type);
+    ProjectileType GetProjectileType() const;
+    void SetModel(Urho3D::Model* model);
+    void SetMaterial(Urho3D::Material* material);
+
+    /*!
+     * @brief Copies the transforms of all live projectiles into the instance
+     * buffer. Called automatically after each scene update, public so it can
+     * be benchmarked.
+     */
+    void UpdateInstances();
+    unsigned GetNumInstances() const;
+
+    void UpdateBatches(const Urho3D::FrameInfo& frame) override;
+
+    Urho3D::ResourceRef GetModelAttr() const;
+    void SetModelAttr(const Urho3D::ResourceRef& value);
+    Urho3D::ResourceRef GetMaterialAttr() const;
+    void SetMaterialAttr(const Urho3D::ResourceRef& value);
+
+protected:
+    void OnSceneSet(Urho3D::Scene* scene) override;
+    void OnWorldBoundingBoxUpdate() override;
+
+private:
+    template <class T>
+    void GatherInstances();
+    void UpdateBatchGeometry();
+    void HandleScenePostUpdate(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+
+private:
+    Urho3D::SharedPtr<Urho3D::Model> model_;
+    Urho3D::SharedPtr<Urho3D::Material> material_;
+    Urho3D::PODVector<Urho3D::Matrix3x4> worldTransforms_;
+    Urho3D::BoundingBox instancesBox_;
+    float modelRadius_;
+    ProjectileType type_;
+};
+
+}
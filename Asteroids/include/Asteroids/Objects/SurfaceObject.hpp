@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Asteroids/Config.hpp"
+#include <Urho3D/Math/Quaternion.h>
 #include <Urho3D/Scene/Component.h>
 
 namespace Asteroids {
@@ -18,11 +19,21 @@ public:
     SurfaceObject(Urho3D::Context* context);
 
     float GetOffsetFromPlanetCenter() const;
+    Urho3D::Vector3 GetWorldPosition() const;
+    const Urho3D::Matrix3x4& GetWorldTransform() const;
 
     void UpdatePosition(const Urho3D::Vector2& localLinearVelocity, float dt);
     void UpdatePlanetHeight();
 
+    /*!
+     * @brief Where the object was before the last call to UpdatePosition().
+     * Together with the current world position, this is the path the object
+     * travelled during the last step (see HitDetector).
+     */
+    Urho3D::Vector3 GetPreviousWorldPosition() const;
+
 private:
+    Urho3D::Quaternion lastStep_;
     float planetHeight_;
     float surfaceOffset_;
 };
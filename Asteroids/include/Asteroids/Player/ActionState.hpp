@@ -5,6 +5,8 @@
 
 namespace Asteroids {
 
+class InputSampler;
+
 class ASTEROIDS_PUBLIC_API ActionState : public Urho3D::Component
 {
     URHO3D_OBJECT(ActionState, Urho3D::Component);
@@ -34,7 +36,24 @@ public:
     void SetWarp(bool enable);
     void SetUseItem(bool enable);
 
+    /*!
+     * @brief Returns true if fire was pressed since the last call, even if
+     * it has been released again in the meantime. Use this in addition to
+     * IsFiring() so taps shorter than a frame aren't lost.
+     */
+    bool ConsumeFirePressed();
+
+    /*!
+     * @brief If set, every change to the state is recorded in the sampler.
+     * Used on the client to send all input transitions to the server.
+     */
+    void SetInputSampler(InputSampler* sampler);
+
 private:
+    void NotifyChanged(Data oldState);
+
+    InputSampler* sampler_;
+    bool firePressed_;
 
     union InputState
     {
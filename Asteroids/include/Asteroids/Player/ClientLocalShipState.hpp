@@ -1,29 +1,50 @@
 #pragma once
 
 #include "Asteroids/Config.hpp"
+#include "Asteroids/Player/InputSampler.hpp"
 #include "Asteroids/UserRegistry/User.hpp"
 #include <Urho3D/Scene/Component.h>
 #include <Urho3D/IO/VectorBuffer.h>
 
 namespace Asteroids {
 
+class ActionState;
 class User;
-
+struct ServerShipStateMsg;
+
+/*!
+ * @brief Sends the local player's input to the server and applies the
+ * server's authoritative ship state.
+ *
+ * Every input transition is timestamped with the time SDL received the
+ * underlying event and sent to the server, see InputSampler.
+ */
 class ASTEROIDS_PUBLIC_API ClientLocalShipState : public Urho3D::Component
 {
     URHO3D_OBJECT(ClientLocalShipState, Urho3D::Component)
 
 public:
     ClientLocalShipState(Urho3D::Context* context);
+    ~ClientLocalShipState();
     static void RegisterObject(Urho3D::Context* context);
 
     void SetUser(User* user);
+    User* GetUser() const;
+
+    /// Called by SnapshotScheduler with this ship's state from the latest snapshot.
+    void ApplyState(const ServerShipStateMsg& state);
+
+protected:
+    void OnSceneSet(Urho3D::Scene* scene) override;
 
 private:
-    void HandleNetworkMessage(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
     void HandleNetworkUpdate(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleSDLRawInput(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    ActionState* AttachToActionState();
 
 private:
+    InputSampler sampler_;
+    Urho3D::WeakPtr<ActionState> actionState_;
     Urho3D::VectorBuffer msg_;
     Urho3D::WeakPtr<User> user_;
     uint8_t timeStep_;
@@ -8,6 +8,7 @@
 namespace Asteroids {
 
 class User;
+struct ServerShipStateMsg;
 
 class ASTEROIDS_PUBLIC_API ClientRemoteShipState : public Urho3D::Component
 {
@@ -18,9 +19,13 @@ public:
     static void RegisterObject(Urho3D::Context* context);
 
     void SetUser(User* user);
+    User* GetUser() const;
 
-private:
-    void HandleNetworkMessage(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    /// Called by SnapshotScheduler with this ship's state from the latest snapshot.
+    void ApplyState(const ServerShipStateMsg& state);
+
+protected:
+    void OnSceneSet(Urho3D::Scene* scene) override;
 
 private:
     Urho3D::VectorBuffer msg_;
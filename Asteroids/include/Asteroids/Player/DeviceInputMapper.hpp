@@ -9,6 +9,18 @@ namespace Urho3D {
 
 namespace Asteroids {
 
+class ActionState;
+
+/*!
+ * @brief Translates keyboard and joystick input into ActionState changes
+ * according to an XML config file.
+ *
+ * The config is parsed once when it is set (or changes on disk). The
+ * mappings of all connected devices are then compiled into a hash table keyed
+ * by (device, input type, code), so each input event is resolved with a
+ * single lookup. Connecting or disconnecting a joystick only adds or removes
+ * the entries of that device.
+ */
 class ASTEROIDS_PUBLIC_API DeviceInputMapper : public Urho3D::Component
 {
     URHO3D_OBJECT( DeviceInputMapper, Urho3D::Component)
@@ -59,17 +71,56 @@ private:
         T_HAT
     };
 
+    /// A single <action> element from the config file.
     struct Mapping
     {
-        int deviceID;
         int buttonID;
         int position;  // needed for joystick hat and axis direction
         InputType type;
         ActionID actionID;
     };
 
+    /// All mappings of a <device> element. Parsed once when the config is loaded.
+    struct DeviceMappings
+    {
+        Urho3D::String name_;
+        Urho3D::PODVector<Mapping> mappings_;
+    };
+
+    /// Identifies a single input on a single device. Keyboard is device -1.
+    struct InputKey
+    {
+        int deviceID_;
+        int type_;
+        int code_;
+
+        bool operator==(const InputKey& rhs) const
+            { return deviceID_ == rhs.deviceID_ && type_ == rhs.type_ && code_ == rhs.code_; }
+        unsigned ToHash() const
+            { return (unsigned)deviceID_ * 31u * 31u + (unsigned)type_ * 31u + (unsigned)code_; }
+    };
+
+    /// Everything bound to one input, e.g. both directions of an axis.
+    struct Binding
+    {
+        static const unsigned MAX_ACTIONS = 8;
+
+        struct Action
+        {
+            ActionID actionID;
+            int position;
+        } actions_[MAX_ACTIONS];
+        unsigned count_;
+    };
+
+    void AddDevice(int deviceID, const Urho3D::String& name);
+    void RemoveDevice(int deviceID);
+    const Binding* FindBinding(int deviceID, InputType type, int code) const;
+    static void ApplyAction(ActionState* state, ActionID actionID, float value);
+
     Urho3D::SharedPtr<Urho3D::XMLFile> configFile_;
-    Urho3D::PODVector<Mapping> mappings_;
+    Urho3D::Vector<DeviceMappings> devices_;
+    Urho3D::HashMap<InputKey, Binding> bindings_;
 };
 
 }
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Asteroids/Config.hpp"
+#include "Asteroids/Util/SpscQueue.hpp"
+#include <stdint.h>
+
+namespace Urho3D {
+    class VectorBuffer;
+}
+
+namespace Asteroids {
+
+/*!
+ * @brief Records every change of the local player's ActionState together with
+ * the time the input event happened, so the server can replay them.
+ *
+ * The network only sends a packet every tick (30 Hz by default), so sending
+ * a snapshot of the state loses any input that is pressed and released
+ * between two packets, and quantizes the rest to the tick. Instead, every
+ * transition is given a sequence number and stays queued until the server
+ * acknowledges it. All unacknowledged transitions are written to every
+ * packet, so a lost packet doesn't lose inputs.
+ *
+ * Times are in milliseconds and only have to be consistent on the client.
+ * They are sent relative to the time the packet is written.
+ */
+class ASTEROIDS_PUBLIC_API InputSampler
+{
+public:
+    typedef uint16_t Sequence;
+
+    struct Transition
+    {
+        uint32_t timeMs_;
+        Sequence sequence_;
+        uint16_t state_;
+    };
+
+    /// Transitions are dropped (oldest state is kept by the snapshot) beyond this.
+    static const unsigned MAX_PENDING = 64;
+
+    InputSampler();
+
+    /// Sets the timestamp to use for the following Record() calls.
+    void SetEventTime(uint32_t timeMs);
+
+    /// Queues a state change that happened at the current event time.
+    void Record(uint16_t state);
+
+    /// Removes all transitions up to and including the given sequence number.
+    void Acknowledge(Sequence sequence);
+
+    /// Number of transitions Write() writes.
+    unsigned GetNumPending() const;
+
+    /*!
+     * @brief Writes an InputTransitionMsg for every pending transition, with
+     * the age in ms relative to nowMs.
+     */
+    void Write(Urho3D::VectorBuffer& dest, uint32_t nowMs) const;
+
+    /// Returns true if sequence a was issued after sequence b.
+    static bool IsNewer(Sequence a, Sequence b)
+        { return (int16_t)(a - b) > 0; }
+
+private:
+    SpscQueue<Transition, MAX_PENDING> pending_;
+    uint32_t eventTimeMs_;
+    Sequence nextSequence_;
+};
+
+}
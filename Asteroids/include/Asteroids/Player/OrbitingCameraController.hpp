@@ -23,9 +23,13 @@ public:
     Urho3D::ResourceRef GetConfigAttr() const;
     void SetConfigAttr(const Urho3D::ResourceRef& value);
 
+protected:
+    virtual void OnSceneSet(Urho3D::Scene* scene) override;
+
 private:
+    friend class UpdateRegistry;
+    void Update(float dt);
     void ParseCamConfig();
-    void HandleUpdate(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
     void HandleFileChanged(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
 
 private:
@@ -15,4 +15,13 @@ URHO3D_EVENT(E_PLAYERDESTROY, PlayerDestroy)
     URHO3D_PARAM(P_GUID, GUID);                 // UShort: ID of the user to destroy
 }
 
+URHO3D_EVENT(E_SHIPHIT, ShipHit)
+{
+    URHO3D_PARAM(P_GUID, GUID);                 // UShort: ID of the user whose ship was hit
+    URHO3D_PARAM(P_ATTACKER, Attacker);         // UShort: ID of the user who fired the projectile
+    URHO3D_PARAM(P_WEAPON, Weapon);             // Int: HitDetector::Weapon
+    URHO3D_PARAM(P_HEALTH, Health);             // Float: Health left after the hit
+    URHO3D_PARAM(P_DESTROYED, Destroyed);       // Bool: Whether the hit destroyed the ship
+}
+
 }
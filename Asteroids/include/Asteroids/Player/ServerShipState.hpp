@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Asteroids/Config.hpp"
+#include "Asteroids/Player/InputSampler.hpp"
+#include "Asteroids/Util/SpscQueue.hpp"
 #include <Urho3D/Scene/Component.h>
 #include <Urho3D/IO/VectorBuffer.h>
 
@@ -8,6 +10,16 @@ namespace Asteroids {
 
 class User;
 
+/*!
+ * @brief Applies the input received from the ship's owner and broadcasts the
+ * resulting ship state.
+ *
+ * Input transitions recorded by the client's InputSampler are replayed with
+ * the same relative timing they had on the client, delayed by one network
+ * tick so the transitions of the next packet have arrived by the time they
+ * are due. They are applied in the INPUT group of the UpdateRegistry, before
+ * any ship or weapon logic runs.
+ */
 class ASTEROIDS_PUBLIC_API ServerShipState : public Urho3D::Component
 {
     URHO3D_OBJECT(ServerShipState, Urho3D::Component)
@@ -17,15 +29,43 @@ public:
     static void RegisterObject(Urho3D::Context* context);
 
     void SetUser(User* user);
+    User* GetUser() const;
+
+    float GetHealth() const;
+    /*!
+     * @brief Subtracts damage from the ship's health. If the health drops to
+     * zero, the ship is destroyed and respawns with full health.
+     * @return True if the ship was destroyed.
+     */
+    bool ApplyDamage(float damage);
+
+    /// Appends the ship's ServerShipStateMsg, see SnapshotScheduler.
+    void WriteState(Urho3D::VectorBuffer& msg) const;
+
+protected:
+    void OnSceneSet(Urho3D::Scene* scene) override;
 
 private:
+    friend class UpdateRegistry;
+    void Update(float dt);
+
     void HandleNetworkMessage(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
-    void HandleNetworkUpdate(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
 
 private:
+    struct PendingInput
+    {
+        float dueTime_;
+        uint16_t state_;
+    };
+
+    SpscQueue<PendingInput, InputSampler::MAX_PENDING> pendingInputs_;
+    InputSampler::Sequence lastInputSequence_;
+    float lastDueTime_;
+    uint16_t snapshotState_;
     uint8_t lastTimeStep_;
+    float health_;
+    float maxHealth_;
     Urho3D::WeakPtr<User> user_;
-    Urho3D::VectorBuffer msg_;
 };
 
 }
@@ -31,10 +31,13 @@ public:
 
     const Urho3D::Vector2& GetVelocity() const;
 
+protected:
+    virtual void OnSceneSet(Urho3D::Scene* scene) override;
+
 private:
-    void SubscribeToEvents();
+    friend class UpdateRegistry;
+    void Update(float dt);
     void ParseShipConfig();
-    void HandleUpdate(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
     void HandleFileChanged(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
 
 private:
@@ -1,11 +1,14 @@
 #pragma once
 
 #include "Asteroids/Config.hpp"
+#include "Asteroids/UserRegistry/User.hpp"
+#include "Asteroids/Util/TimerWheel.hpp"
 #include <Urho3D/Scene/Component.h>
 
 namespace Asteroids {
 
 class ActionState;
+class Prefab;
 
 class WeaponSpawner : public Urho3D::Component
 {
@@ -19,10 +22,17 @@ public:
     void CreateSpread();
     void CreateMine();
 
+protected:
+    virtual void OnSceneSet(Urho3D::Scene* scene) override;
+
 private:
+    friend class UpdateRegistry;
+    void Update(float dt);
+    void LaunchPhaser(const Urho3D::Vector2& direction);
     void ParseConfig();
+    User::GUID GetOwner() const;
     bool TryGetActionState();
-    void HandleUpdate(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandlePhaserCooldown();
     void HandleActionWarp(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
     void HandleActionUseItem(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
     void HandleFileChanged(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
@@ -55,7 +65,13 @@ private:
 
     Urho3D::WeakPtr<ActionState> state_;
     Urho3D::SharedPtr<Urho3D::XMLFile> configXML_;
-    float fireActionCooldown_;
+    Urho3D::SharedPtr<Prefab> phaserPrefab_;
+    Urho3D::SharedPtr<Prefab> minePrefab_;
+    Urho3D::PODVector<float> spreadAngles_;
+    Urho3D::PODVector<float> spreadSines_;
+    Urho3D::PODVector<float> spreadCosines_;
+    /// Running while the phaser is cooling down.
+    TimerWheel::TimerID phaserCooldown_;
 };
 
 }
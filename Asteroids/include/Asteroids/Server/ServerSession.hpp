@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Asteroids/Config.hpp"
+#include "Asteroids/UserRegistry/User.hpp"
+#include <Urho3D/Core/Object.h>
+
+namespace Urho3D {
+    class Node;
+    class Scene;
+    class XMLFile;
+}
+
+namespace Asteroids {
+
+class AsteroidField;
+class ServerUserRegistry;
+class UserRegistry;
+
+/*!
+ * @brief The server side of a game: owns the server scene, accepts users and
+ * spawns their ships.
+ *
+ * This is used by asteroids-server, and by the client to host a game without
+ * launching a second process. In that case, client and server live in the
+ * same context and share the ResourceCache, Network and UpdateRegistry
+ * subsystems. To keep the two sides from seeing each other's state, the
+ * session keeps its own UserRegistry instead of using the subsystem, and only
+ * reacts to events sent by objects it owns. Client code must in turn ignore
+ * events that don't come from the server connection.
+ *
+ * The session runs on the main thread like the rest of the client. Scene
+ * replication and remote events still use Urho3D's loopback connection, but
+ * game messages between the two sides go through in-memory queues set up by
+ * MessageRouter.
+ */
+class ASTEROIDS_PUBLIC_API ServerSession : public Urho3D::Object
+{
+    URHO3D_OBJECT(ServerSession, Urho3D::Object)
+
+public:
+    ServerSession(Urho3D::Context* context);
+    ~ServerSession();
+
+    /*!
+     * @brief Loads the scene and starts listening for connections.
+     * @return False if the server could not be started.
+     */
+    bool Start(unsigned short port);
+
+    /// Disconnects all clients and destroys the scene.
+    void Stop();
+
+    bool IsRunning() const;
+    unsigned short GetPort() const;
+    Urho3D::Scene* GetScene() const;
+    UserRegistry* GetUserRegistry() const;
+
+private:
+    void LoadScene();
+    void HandleUserJoined(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleUserLeft(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandlePlayerCreate(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandlePlayerDestroy(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleFileChanged(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+
+private:
+    Urho3D::SharedPtr<UserRegistry> users_;
+    Urho3D::SharedPtr<ServerUserRegistry> serverUserRegistry_;
+    Urho3D::SharedPtr<Urho3D::Scene> scene_;
+    Urho3D::SharedPtr<Urho3D::XMLFile> planetXML_;
+    Urho3D::Node* planet_;
+    AsteroidField* asteroids_;
+    Urho3D::HashMap<User::GUID, Urho3D::Node*> shipNodes_;
+    unsigned short port_;
+};
+
+}
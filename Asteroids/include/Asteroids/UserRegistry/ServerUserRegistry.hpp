@@ -1,22 +1,37 @@
 #pragma once
 
 #include "Asteroids/Config.hpp"
+#include "Asteroids/Network/Protocol.hpp"
 #include <Urho3D/Core/Object.h>
 #include <Urho3D/IO/VectorBuffer.h>
 
+namespace Urho3D {
+    class Connection;
+}
+
 namespace Asteroids {
 
+class UserRegistry;
+
+/*!
+ * @brief Accepts or rejects connecting clients and keeps the given
+ * UserRegistry up to date. E_USERJOINED and E_USERLEFT are broadcast to all
+ * clients and also sent locally, with this object as the sender.
+ */
 class ASTEROIDS_PUBLIC_API ServerUserRegistry : public Urho3D::Object
 {
     URHO3D_OBJECT(ServerUserRegistry, Urho3D::Object)
 
 public:
-    ServerUserRegistry(Urho3D::Context* context);
+    ServerUserRegistry(Urho3D::Context* context, UserRegistry* users);
 
 private:
+    /// Sends MSG_REGISTER_FAILED. maxLength is only used for USERNAME_TOO_LONG.
+    void SendRegisterFailed(Urho3D::Connection* connection, MsgRegisterFailed reason, unsigned maxLength = 0);
     void HandleClientIdentity(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
     void HandleClientDisconnected(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
 
+    Urho3D::WeakPtr<UserRegistry> users_;
     Urho3D::VectorBuffer msg_;
 };
 
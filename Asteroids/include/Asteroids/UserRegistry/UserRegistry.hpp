@@ -34,6 +34,7 @@ public:
 private:
     friend class ServerUserRegistry;
     friend class ClientUserRegistry;
+    friend class UserRegistryBenchmark;
 
     bool IsUsernameTaken(const Urho3D::String& name) const;
     User* AddUser(const Urho3D::String& name, User::GUID guid);
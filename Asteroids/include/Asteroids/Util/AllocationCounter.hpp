@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Asteroids/Config.hpp"
+
+namespace Asteroids {
+
+/*!
+ * @brief Returns true if the global operator new was replaced with one that
+ * counts allocations. This is the case when the project was configured with
+ * -DASTEROIDS_ALLOCATION_COUNTER=ON.
+ */
+ASTEROIDS_PUBLIC_API bool IsAllocationCounterEnabled();
+
+/*!
+ * @brief Returns the number of times operator new was called on the calling
+ * thread since it started. Always returns 0 if the counter is disabled.
+ *
+ * The count is per thread so allocations made by Urho's network and worker
+ * threads don't show up when measuring the main thread.
+ */
+ASTEROIDS_PUBLIC_API unsigned long long GetThreadAllocationCount();
+
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "Asteroids/Config.hpp"
+#include "Asteroids/Util/SpscQueue.hpp"
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/Core/Thread.h>
+
+#include <atomic>
+
+namespace Urho3D {
+    class File;
+}
+
+namespace Asteroids {
+
+/*!
+ * @brief Asynchronous logging backend.
+ *
+ * Urho's Log writes to the console and to the log file synchronously on the
+ * calling thread. When something logs every frame (or an error path is hit
+ * in a loop), that I/O ends up stalling the frame. AsyncLog replaces the file
+ * and console output: messages are formatted by the producer into a fixed
+ * size, lock-free multi-producer ring buffer and a single background thread
+ * does all of the I/O.
+ *
+ * The background thread also collapses consecutive identical messages into a
+ * single "repeated N times" line. A message that was already logged a
+ * moment ago with other messages in between (e.g. two errors alternating
+ * in a loop) can't be collapsed, so these and the "repeated" lines are
+ * limited to a number of lines per second instead. A message that differs
+ * from the recent ones is always written. The lines that make it through are
+ * additionally made available to the main thread via ReadLine(), which is
+ * what DebugTextScroll displays.
+ *
+ * Everything logged through URHO3D_LOG* is picked up automatically by
+ * listening to E_LOGMESSAGE. For this to replace Urho's own output, the
+ * engine parameters EP_LOG_NAME should be empty and EP_LOG_QUIET true.
+ */
+class ASTEROIDS_PUBLIC_API AsyncLog : public Urho3D::Object, public Urho3D::Thread
+{
+    URHO3D_OBJECT(AsyncLog, Urho3D::Object)
+
+public:
+    enum Limits
+    {
+        MAX_MESSAGE_LENGTH = 256,
+        RING_CAPACITY = 512,
+        DISPLAY_CAPACITY = 64,
+        /// Number of distinct lines remembered to detect repeats.
+        RECENT_LINES = 16
+    };
+
+    struct Line
+    {
+        int level_;
+        unsigned length_;
+        char text_[MAX_MESSAGE_LENGTH];
+    };
+
+    AsyncLog(Urho3D::Context* context);
+    ~AsyncLog();
+
+    /// Opens the log file and starts the background thread.
+    bool Open(const Urho3D::String& fileName);
+    /// Writes all pending messages, closes the log file and stops the background thread.
+    void Close();
+
+    /// Enables printing to stdout (errors go to stderr). Defaults to true.
+    void SetEcho(bool enable);
+    /// Maximum number of repeated lines written per second. Excess lines are counted and reported. 0 disables the limit.
+    void SetRateLimit(unsigned linesPerSecond);
+
+    /*!
+     * @brief Queues a message. Can be called from any thread and never blocks
+     * or allocates. Messages longer than MAX_MESSAGE_LENGTH are truncated. If
+     * the ring buffer is full the message is dropped and the number of
+     * dropped messages is reported later on.
+     */
+    static void Write(int level, const char* message);
+    /// Same as Write() but with printf style formatting.
+    static void WriteFormat(int level, const char* format, ...);
+
+    /// Main thread only. Retrieves the next line that was written to the log, returns false if there are none.
+    bool ReadLine(Line* line);
+
+    void ThreadFunction() override;
+
+private:
+    struct Record
+    {
+        std::atomic<unsigned> sequence_;
+        unsigned timeMs_;
+        int level_;
+        unsigned length_;
+        bool echo_;
+        char text_[MAX_MESSAGE_LENGTH];
+    };
+
+    bool Push(int level, const char* message, unsigned length, bool echo);
+    void Drain();
+    void Emit(unsigned timeMs, int level, const char* message, unsigned length, bool echo);
+    void FlushRepeats(unsigned timeMs);
+    bool SeenRecently(const Record& record);
+    bool Admit(unsigned timeMs);
+    void AdvanceWindow(unsigned timeMs);
+    void HandleLogMessage(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+
+private:
+    static AsyncLog* instance_;
+
+    // Shared between producers and the background thread
+    Record* records_;
+    alignas(64) std::atomic<unsigned> enqueuePos_;
+    alignas(64) std::atomic<unsigned> dropped_;
+    unsigned dequeuePos_;
+    unsigned startTime_;
+
+    // Background thread only
+    Urho3D::SharedPtr<Urho3D::File> file_;
+    Line last_;
+    bool lastEcho_;
+    unsigned repeatCount_;
+    unsigned repeatStart_;
+    Line recent_[RECENT_LINES];
+    unsigned recentPos_;
+    unsigned windowStart_;
+    unsigned windowCount_;
+    unsigned suppressed_;
+
+    // Filled by the background thread, read by the main thread
+    SpscQueue<Line, DISPLAY_CAPACITY> display_;
+
+    std::atomic<bool> echo_;
+    std::atomic<unsigned> rateLimit_;
+};
+
+}
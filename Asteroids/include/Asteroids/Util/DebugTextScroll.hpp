@@ -3,14 +3,11 @@
 #include "Asteroids/Config.hpp"
 #include <Urho3D/Core/Object.h>
 
+// Everything that is logged is displayed via AsyncLog, so there is no need
+// to print to the scroll directly as well
 #if defined(DEBUG)
 #   include <Urho3D/IO/Log.h>
-#   define LOG_SCROLL(msg) do {                                \
-            DebugTextScroll* debug_##__LINE__ =                \
-                    GetSubsystem<DebugTextScroll>();           \
-            if(debug_##__LINE__) debug_##__LINE__->Print(msg); \
-            URHO3D_LOGDEBUG(msg);                              \
-    } while(0)
+#   define LOG_SCROLL(msg) URHO3D_LOGDEBUG(msg)
 #else
 #   define LOG_SCROLL(msg)
 #endif
@@ -21,6 +18,14 @@ namespace Urho3D {
 
 namespace Asteroids {
 
+/*!
+ * @brief Displays the most recent log lines in the bottom left corner.
+ *
+ * The Text elements are created once by SetTextCount() and used as a ring:
+ * Print() only changes the text of the oldest element, and the elements are
+ * repositioned at most once per frame. Log lines are read from AsyncLog, so
+ * this only shows what made it past its deduplication and rate limiting.
+ */
 class ASTEROIDS_PUBLIC_API DebugTextScroll : public Urho3D::Object
 {
     URHO3D_OBJECT(DebugTextScroll, Urho3D::Object);
@@ -33,8 +38,8 @@ public:
     void Print(const Urho3D::String& str, const Urho3D::Color& color=Urho3D::Color::WHITE);
 
 private:
+    void UpdateLayout();
     void HandleUpdate(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
-    void HandleLogMessage(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
 
     struct TextItem
     {
@@ -43,8 +48,12 @@ private:
     };
 
     Urho3D::Vector<TextItem> items_;
-    Urho3D::Vector<TextItem>::Iterator insertIt_;
+    /// Index of the item that is overwritten next, i.e. the oldest line
+    unsigned insertIndex_;
     float timeoutSetting_;
+    bool layoutDirty_;
+    /// Reused for converting log lines so reading them doesn't allocate
+    Urho3D::String lineBuffer_;
 };
 
 }
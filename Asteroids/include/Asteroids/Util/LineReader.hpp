@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Asteroids/Config.hpp"
+#include <Urho3D/Container/Str.h>
+
+namespace Urho3D {
+    class Deserializer;
+}
+
+namespace Asteroids {
+
+/*!
+ * @brief Splits a stream of bytes arriving in arbitrary chunks into lines.
+ *
+ * Used to capture the output of child processes. Data is read with Drain()
+ * (or passed in with Feed()) as it becomes available, and complete lines can
+ * then be taken out with ReadLine(). Both "\n" and "\r\n" line endings are
+ * handled. Lines longer than the maximum length are split so a misbehaving
+ * process can't make the buffer grow without bounds.
+ */
+class ASTEROIDS_PUBLIC_API LineReader
+{
+public:
+    LineReader(unsigned maxLineLength=4096);
+
+    /// Appends data to the internal buffer.
+    void Feed(const void* data, unsigned size);
+
+    /*!
+     * @brief Reads everything that is currently available from the source
+     * and appends it to the internal buffer. Stops as soon as the source
+     * returns 0 bytes, so this doesn't block on non-blocking sources.
+     * @return Returns the number of bytes read.
+     */
+    unsigned Drain(Urho3D::Deserializer& source);
+
+    /*!
+     * @brief Takes the next complete line out of the buffer.
+     * @param[out] line Receives the line without its line ending.
+     * @return Returns false if there is no complete line yet.
+     */
+    bool ReadLine(Urho3D::String* line);
+
+    /*!
+     * @brief Takes whatever remains in the buffer, even if it isn't
+     * terminated by a newline. Use this after the source reached EOF.
+     * @return Returns false if the buffer was empty.
+     */
+    bool Flush(Urho3D::String* line);
+
+private:
+    Urho3D::PODVector<char> buffer_;
+    unsigned readPos_;
+    unsigned maxLineLength_;
+};
+
+}
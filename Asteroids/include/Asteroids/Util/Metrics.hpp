@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Asteroids/Config.hpp"
+#include "Asteroids/Network/Protocol.hpp"
+#include <Urho3D/Core/Object.h>
+
+#include <atomic>
+
+namespace Asteroids {
+
+/// Monotonically increasing value.
+class ASTEROIDS_PUBLIC_API MetricsCounter
+{
+public:
+    MetricsCounter() : value_(0) {}
+    void Add(unsigned long long amount = 1) { value_.fetch_add(amount, std::memory_order_relaxed); }
+    unsigned long long Get() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<unsigned long long> value_;
+};
+
+/// Value that can go up and down.
+class ASTEROIDS_PUBLIC_API MetricsGauge
+{
+public:
+    MetricsGauge() : value_(0) {}
+    void Set(long long value) { value_.store(value, std::memory_order_relaxed); }
+    void Add(long long amount) { value_.fetch_add(amount, std::memory_order_relaxed); }
+    long long Get() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<long long> value_;
+};
+
+/*!
+ * @brief Distribution of durations in fixed buckets. Observe() only ever
+ * does a handful of relaxed atomic increments.
+ */
+class ASTEROIDS_PUBLIC_API MetricsHistogram
+{
+public:
+    enum { BUCKET_COUNT = 12 };
+
+    /// Upper bounds of the buckets in microseconds. Values above the last bound only count towards +Inf.
+    static const unsigned BOUNDS_USEC[BUCKET_COUNT];
+
+    MetricsHistogram();
+    void Observe(unsigned long long usec);
+
+    unsigned long long GetBucket(unsigned index) const { return buckets_[index].load(std::memory_order_relaxed); }
+    unsigned long long GetCount() const { return count_.load(std::memory_order_relaxed); }
+    unsigned long long GetSumUsec() const { return sumUsec_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<unsigned long long> buckets_[BUCKET_COUNT];
+    std::atomic<unsigned long long> count_;
+    std::atomic<unsigned long long> sumUsec_;
+};
+
+/*!
+ * @brief Collects server statistics for monitoring.
+ *
+ * All of the recording methods are wait-free and never allocate, so they
+ * can be called from the tick without affecting it. WritePrometheus() may be
+ * called from any thread (usually an exporter thread) and formats a snapshot
+ * in the Prometheus text exposition format.
+ *
+ * The subsystem is only registered by the server. Code shared with the
+ * client looks it up with GetSubsystem<Metrics>() and does nothing if it
+ * doesn't exist.
+ */
+class ASTEROIDS_PUBLIC_API Metrics : public Urho3D::Object
+{
+    URHO3D_OBJECT(Metrics, Urho3D::Object)
+
+public:
+    Metrics(Urho3D::Context* context);
+
+    void SetUsersConnected(unsigned count);
+    void AddLiveProjectiles(int amount);
+    void ObserveTickDuration(unsigned long long usec);
+    /// Records a message of the given size being sent to the specified number of connections.
+    void CountMessageSent(int msgID, unsigned bytes, unsigned connections = 1);
+    void CountJoinRejected(MsgRegisterFailed reason);
+
+    /// Thread safe. Appends all metrics to out.
+    void WritePrometheus(Urho3D::String& out) const;
+
+private:
+    enum
+    {
+        MSG_TYPE_COUNT = MSG_SNAPSHOT_FEEDBACK - MSG_CLIENT_SHIP_STATE + 1,
+        MSG_TYPE_OTHER = MSG_TYPE_COUNT,
+        REJECT_REASON_COUNT = USERNAME_BANNED + 1
+    };
+
+    MetricsGauge usersConnected_;
+    MetricsGauge liveProjectiles_;
+    MetricsHistogram tickDuration_;
+    MetricsCounter messagesSent_[MSG_TYPE_COUNT + 1];
+    MetricsCounter bytesSent_[MSG_TYPE_COUNT + 1];
+    MetricsCounter joinsRejected_[REJECT_REASON_COUNT];
+};
+
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Asteroids/Config.hpp"
+#include <Urho3D/Resource/Resource.h>
+
+namespace Urho3D {
+    class Node;
+    class XMLElement;
+}
+
+namespace Asteroids {
+
+/*!
+ * @brief A node hierarchy that is parsed once into a compact in-memory
+ * template and can then be instantiated any number of times.
+ *
+ * Node::LoadXML() looks up every attribute by name, converts the value from
+ * its string representation and resolves resource references for every
+ * single instance. A Prefab does all of that once when the resource is loaded
+ * so instantiating only has to create the nodes and components and assign
+ * the already converted attribute values by index.
+ *
+ * The prefab can be loaded from the regular node XML files saved by the
+ * editor, or from a binary file written with Save(), which skips XML parsing
+ * entirely. The format is detected automatically. Since Prefab is a resource,
+ * it is cached and auto-reloaded by the ResourceCache like everything else.
+ */
+class ASTEROIDS_PUBLIC_API Prefab : public Urho3D::Resource
+{
+    URHO3D_OBJECT(Prefab, Urho3D::Resource)
+
+public:
+    Prefab(Urho3D::Context* context);
+    static void RegisterObject(Urho3D::Context* context);
+
+    bool BeginLoad(Urho3D::Deserializer& source) override;
+    bool EndLoad() override;
+
+    /// Save the prefab in binary format.
+    bool Save(Urho3D::Serializer& dest) const override;
+
+    /*!
+     * @brief Applies the root node's attributes to the specified node and
+     * creates all of the child nodes and components under it.
+     *
+     * This is the equivalent of calling node->LoadXML(xml->GetRoot()) with the
+     * difference that child nodes and components always receive new IDs
+     * instead of trying to reuse the IDs stored in the file. Child nodes and
+     * components are created as replicated or local depending on which range
+     * their ID was in when the prefab was saved, same as LoadXML().
+     */
+    void Instantiate(Urho3D::Node* node) const;
+
+private:
+    struct AttributeValue
+    {
+        unsigned index_;
+        Urho3D::Variant value_;
+    };
+
+    struct ComponentTemplate
+    {
+        Urho3D::StringHash type_;
+        bool replicated_;
+        Urho3D::Vector<AttributeValue> attributes_;
+    };
+
+    struct NodeTemplate
+    {
+        bool replicated_;
+        Urho3D::Vector<AttributeValue> attributes_;
+        Urho3D::Vector<ComponentTemplate> components_;
+        Urho3D::PODVector<unsigned> children_;  // Indices into nodes_
+    };
+
+    unsigned LoadXMLNode(const Urho3D::XMLElement& source);
+    bool LoadXMLAttributes(Urho3D::StringHash type, const Urho3D::XMLElement& source, Urho3D::Vector<AttributeValue>* dest);
+    bool LoadBinary(Urho3D::Deserializer& source);
+    bool LoadBinaryAttributes(Urho3D::StringHash type, Urho3D::Deserializer& source, Urho3D::Vector<AttributeValue>* dest);
+    void SaveBinaryAttributes(Urho3D::StringHash type, const Urho3D::Vector<AttributeValue>& attributes, Urho3D::Serializer& dest) const;
+    void ResolveResources(const Urho3D::Vector<AttributeValue>& attributes);
+    void InstantiateNode(Urho3D::Node* node, unsigned index) const;
+
+private:
+    /// All nodes of the hierarchy, nodes_[0] is the root.
+    Urho3D::Vector<NodeTemplate> nodes_;
+    /// Keeps the resources referenced by attributes loaded for as long as the prefab exists.
+    Urho3D::Vector<Urho3D::SharedPtr<Urho3D::Resource>> dependencies_;
+};
+
+}
@@ -16,10 +16,17 @@ public:
         STDIN  = 0x01,
         STDOUT = 0x02,
         STDERR = 0x04,
+        NOTIFY = 0x08,
         NONE = 0,
         ALL = STDIN | STDOUT | STDERR
     };
 
+    /*!
+     * @brief The file descriptor the writing end of the NOTIFY pipe has in
+     * the child process.
+     */
+    static const int NOTIFY_FD = 3;
+
     Process();
     /// Calls Close()
     ~Process();
@@ -40,6 +47,14 @@ public:
      * You can specify an OR'd combination of the flags STDIN, STDOUT and STDERR
      * which lets you read from and write to the child process' standard streams
      * via the corresponding GetStdIn(), GetStdOut() and GetStdErr() pipes.
+     * The pipes are non-blocking, see UnidirectionalPipe.
+     *
+     * Additionally, NOTIFY creates a pipe the child can use to send messages
+     * back without interfering with its standard streams (e.g. to report that
+     * it has finished initializing). In the child, the writing end is
+     * available as file descriptor NOTIFY_FD. Read it with GetNotify().
+     * NOTIFY is not supported on Windows and is ignored there, in which
+     * case GetNotify() returns NULL.
      */
     bool Open(Urho3D::StringVector args, IO options=NONE);
 
@@ -65,6 +80,37 @@ public:
      */
     void Close();
 
+    /*!
+     * @brief Checks whether the child process is still alive without
+     * blocking.
+     *
+     * If the child process exited, it is reaped and its exit code can be
+     * retrieved with GetExitCode(). Subsequent calls return false.
+     *
+     * On linux, this calls waitpid() with WNOHANG.
+     */
+    bool IsRunning();
+
+    /*!
+     * @brief Returns the exit code of the child process. Only valid after
+     * IsRunning() returned false, returns -1 otherwise.
+     */
+    int GetExitCode() const;
+
+    /*!
+     * @brief Waits up to timeoutMs milliseconds for data to become available
+     * on the stdout, stderr and notify pipes.
+     *
+     * @return An OR'd combination of STDOUT, STDERR and NOTIFY for each pipe that
+     * either has data to read or was closed by the child (in which case the
+     * next read will set the EOF flag), or NONE if the timeout expired. Pass a
+     * timeout of 0 to check without blocking.
+     *
+     * On linux, this uses poll(). On Windows, the pipes are only peeked and the
+     * timeout is ignored.
+     */
+    unsigned Poll(int timeoutMs=0);
+
     /*!
      * @brief Kills the child process immediately. You shouldn't normally have 
      * to use this.
@@ -94,10 +140,20 @@ public:
      */
     UnidirectionalPipe* GetStdErr() const;
 
+    /*!
+     * @brief Retrieves the notify pipe, if NOTIFY was specified to Open().
+     * Will be NULL otherwise.
+     * @note You can only read from this pipe.
+     */
+    UnidirectionalPipe* GetNotify() const;
+
 private:
     Urho3D::UniquePtr<UnidirectionalPipe> stdin_;
     Urho3D::UniquePtr<UnidirectionalPipe> stdout_;
     Urho3D::UniquePtr<UnidirectionalPipe> stderr_;
+    Urho3D::UniquePtr<UnidirectionalPipe> notify_;
+
+    int exitCode_ = -1;
 
 #ifdef _WIN32
     void* mainThreadHandle_ = nullptr;
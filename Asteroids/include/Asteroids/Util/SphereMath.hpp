@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Asteroids/Config.hpp"
+#include <Urho3D/Math/Quaternion.h>
+#include <Urho3D/Math/Vector2.h>
+
+/*!
+ * Math for objects moving on the surface of a sphere, i.e. what the ships,
+ * mines, phasers and asteroids do every frame.
+ *
+ * The batched functions work on arrays and use SSE2 if Urho3D was built with
+ * URHO3D_SSE, otherwise they fall back to the scalar versions. All angles are
+ * in degrees, like Urho3D's. See MathBenchmark for the measured error against
+ * Urho3D's Sin()/Cos() and Quaternion.
+ */
+
+namespace Asteroids {
+
+/// Largest angle in degrees, positive or negative, FAST_SINCOS_MAX_ERROR holds for.
+static const float FAST_SINCOS_MAX_ANGLE = 1e5f;
+/// Upper bound of the absolute error of FastSinCos() for angles within +-FAST_SINCOS_MAX_ANGLE.
+static const float FAST_SINCOS_MAX_ERROR = 1e-6f;
+
+/*!
+ * @brief Shrinks a velocity along its own direction by rate*|velocity|*dt,
+ * but never past 0.
+ *
+ * This is the same as subtracting the decay along the direction of travel
+ * (which needs Atan2, Sin and Cos), since the direction of v is v/|v|.
+ */
+inline Urho3D::Vector2 DecayVelocity(const Urho3D::Vector2& velocity, float rate, float dt)
+{
+    return velocity * Urho3D::Max(0.0f, 1.0f - rate * dt);
+}
+
+/// Polynomial sine and cosine with the range reduction done in degrees.
+ASTEROIDS_PUBLIC_API void FastSinCos(float degrees, float* sine, float* cosine);
+
+/// Direction of a heading in the pivot's XZ plane, same as Vector2(Sin(degrees), Cos(degrees)).
+inline Urho3D::Vector2 HeadingToVector(float degrees)
+{
+    Urho3D::Vector2 v;
+    FastSinCos(degrees, &v.x_, &v.y_);
+    return v;
+}
+
+/*!
+ * @brief The rotation of an object's pivot for moving it across the surface
+ * with a local velocity for dt seconds. Same as
+ * Quaternion(2*pi*v.y/radius*dt, RIGHT) * Quaternion(2*pi*v.x/radius*dt, BACK)
+ * but without building the two quaternions and multiplying them.
+ */
+ASTEROIDS_PUBLIC_API Urho3D::Quaternion SurfaceStep(const Urho3D::Vector2& velocity, float radius, float dt);
+
+/// Batched FastSinCos(). The output arrays may not overlap the input.
+ASTEROIDS_PUBLIC_API void FastSinCos(const float* degrees, float* sines, float* cosines, unsigned count);
+
+/*!
+ * @brief out[i] = (rotations[i] * Quaternion(degrees[i], axes[i])).Normalized()
+ * @note The axes must be unit length. out may be the same array as rotations.
+ */
+ASTEROIDS_PUBLIC_API void RotateAxisAngle(Urho3D::Quaternion* out, const Urho3D::Quaternion* rotations,
+                                          const Urho3D::Vector3* axes, const float* degrees, unsigned count);
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+
+namespace Asteroids {
+
+/*!
+ * @brief Fixed capacity, lock-free single-producer/single-consumer queue.
+ *
+ * One thread may call Push(), one (possibly other) thread may call Size(),
+ * Peek() and Pop(). The storage is part of the object so nothing is ever
+ * allocated. N must be a power of two.
+ */
+template <class T, unsigned N>
+class SpscQueue
+{
+    static_assert(N > 0 && (N & (N - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    SpscQueue() : head_(0), tail_(0) {}
+
+    /// Producer. Returns false if the queue is full.
+    bool Push(const T& item)
+    {
+        unsigned head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == N)
+            return false;
+        items_[head & (N - 1)] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Consumer. Number of items that can currently be peeked or popped.
+    unsigned Size() const
+        { return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_relaxed); }
+
+    bool Empty() const
+        { return Size() == 0; }
+
+    /// Consumer. Returns the index'th oldest item. Index must be less than Size().
+    const T& Peek(unsigned index = 0) const
+        { return items_[(tail_.load(std::memory_order_relaxed) + index) & (N - 1)]; }
+
+    /// Consumer. Removes the oldest item. The queue must not be empty.
+    void Pop()
+        { tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    /// Consumer. Removes the oldest item and copies it to out.
+    bool Pop(T* out)
+    {
+        if (Empty())
+            return false;
+        *out = Peek();
+        Pop();
+        return true;
+    }
+
+    static unsigned Capacity() { return N; }
+
+private:
+    // Producer and consumer counters are on separate cache lines
+    alignas(64) std::atomic<unsigned> head_;
+    alignas(64) std::atomic<unsigned> tail_;
+    T items_[N];
+};
+
+}
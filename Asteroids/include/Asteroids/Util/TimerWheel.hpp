@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Asteroids/Config.hpp"
+#include <Urho3D/Core/Object.h>
+
+namespace Asteroids {
+
+/*!
+ * @brief Calls a method on an object after a delay. Used for things that
+ * only need to happen once at a known time, like a projectile's life running
+ * out or a weapon's cooldown ending, so nothing has to count down every
+ * frame.
+ *
+ * This is a hierarchical timer wheel with a resolution of 1 ms. The first
+ * level has one slot per tick for the next 256 ms, every following level
+ * covers 256 slots of the level below. Scheduling and cancelling are O(1),
+ * advancing is O(1) per tick plus the timers that fire. Timers far in the
+ * future cascade down a level every time the level below wraps around.
+ *
+ * The wheel advances on E_UPDATE. Register it before UpdateRegistry so
+ * timers fire before objects are updated.
+ *
+ * The object must cancel its timer when it is destroyed (e.g. in
+ * OnSceneSet(nullptr)). A timer that fired can't be cancelled anymore, so it
+ * is safe to call Cancel() on it.
+ */
+class ASTEROIDS_PUBLIC_API TimerWheel : public Urho3D::Object
+{
+    URHO3D_OBJECT(TimerWheel, Urho3D::Object)
+
+public:
+    typedef unsigned TimerID;
+    static const TimerID INVALID_TIMER = 0;
+    static const unsigned TICKS_PER_SECOND = 1000;
+
+    TimerWheel(Urho3D::Context* context);
+
+    /// Calls object->Method() after delay seconds. Returns a handle for Cancel().
+    template <class T, void (T::*Method)()>
+    TimerID Schedule(T* object, float delay)
+        { return ScheduleTimer(&Call<T, Method>, static_cast<void*>(object), delay); }
+
+    /// Does nothing if the timer already fired or was cancelled.
+    void Cancel(TimerID id);
+    bool IsScheduled(TimerID id) const;
+    unsigned GetNumTimers() const;
+
+    /*!
+     * @brief Fires all timers that expire within dt. Normally called from
+     * E_UPDATE, but can be called manually (e.g. by benchmarks).
+     */
+    void Advance(float dt);
+
+private:
+    typedef void (*Callback)(void* object);
+
+    template <class T, void (T::*Method)()>
+    static void Call(void* object)
+        { (static_cast<T*>(object)->*Method)(); }
+
+    struct Timer
+    {
+        Callback callback_;
+        void* object_;
+        unsigned expires_;
+        unsigned prev_;
+        unsigned next_;
+        /// Index of the list the timer is in, NO_SLOT if it is free.
+        unsigned short slot_;
+        unsigned short generation_;
+    };
+
+    TimerID ScheduleTimer(Callback callback, void* object, float delay);
+    Timer* GetTimer(TimerID id);
+    const Timer* GetTimer(TimerID id) const;
+    void Link(unsigned index);
+    void Unlink(unsigned index);
+    void Free(unsigned index);
+    void Tick();
+    unsigned Cascade(unsigned level);
+    void HandleUpdate(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+
+private:
+    /// Pool of timers, free timers are linked through next_.
+    Urho3D::PODVector<Timer> timers_;
+    /// Heads of all slot lists, followed by the list of timers being fired.
+    Urho3D::PODVector<unsigned> heads_;
+    unsigned freeList_;
+    unsigned numTimers_;
+    unsigned currentTick_;
+    float accumulator_;
+};
+
+}
@@ -2,10 +2,18 @@
 
 #include "Asteroids/Config.hpp"
 #include <Urho3D/IO/AbstractFile.h>
-#include <stdio.h>
 
 namespace Asteroids {
 
+/*!
+ * @brief One end of a pipe to or from a child process. Created by Process.
+ *
+ * All operations are non-blocking. Read() returns 0 if no data is currently
+ * available and Write() returns the number of bytes the pipe could accept
+ * right now, which may be less than requested. IsEof() returns true once the
+ * other end of the pipe was closed (e.g. the child process exited) and all
+ * remaining data was read.
+ */
 class ASTEROIDS_PUBLIC_API UnidirectionalPipe : public Urho3D::AbstractFile
 {
 public:
@@ -18,9 +26,9 @@ public:
     unsigned Read(void* dest, unsigned size) override;
     /// Set position. No-op for pipes.
     unsigned Seek(unsigned position) override;
-    /// Write bytes to the pipe. Return number of bytes actually written.
+    /// Write bytes to the pipe without blocking. Return number of bytes actually written.
     unsigned Write(const void* data, unsigned size) override;
-    /// Return whether pipe has no data available.
+    /// Return whether the other end of the pipe was closed.
     bool IsEof() const override;
     /// Return the pipe name.
     const Urho3D::String& GetName() const override { return name_; }
@@ -29,16 +37,17 @@ private:
     friend class Process;
 
     Urho3D::String name_;
+    bool eof_;
 
 #ifdef _WIN32
     UnidirectionalPipe(void* handle);
 
     void* handle_;
 #else
-    /// Construct.
-    UnidirectionalPipe(int fd, const char* mode);
+    /// Construct and switch the file descriptor to non-blocking mode.
+    UnidirectionalPipe(int fd);
 
-    FILE* fp_;
+    int fd_;
 #endif
 };
 
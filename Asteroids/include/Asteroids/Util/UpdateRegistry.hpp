@@ -0,0 +1,143 @@
+#pragma once
+
+#include "Asteroids/Config.hpp"
+#include <Urho3D/Core/Object.h>
+
+namespace Asteroids {
+
+/*!
+ * @brief Calls Update(float dt) on all registered gameplay components once
+ * per frame, in a fixed order.
+ *
+ * Components used to subscribe to E_UPDATE individually, which means one
+ * handler invocation and one VariantMap lookup per component per frame, and
+ * an update order that depends on the order things happened to subscribe in.
+ * Instead, components add themselves here when they enter a scene and remove
+ * themselves when they leave it. Components of the same type are stored in
+ * one contiguous array and are updated in a tight, non-virtual loop.
+ *
+ * Groups are updated in the order they are listed in the Group enum. Within
+ * a group, types are updated in the order they were first added, and objects
+ * of the same type in the order they were added.
+ *
+ * Objects added during an update are updated for the first time on the
+ * next frame. Objects removed during an update (e.g. a projectile removing
+ * its own node) are not updated anymore, even if it's the current frame.
+ *
+ * Objects can be put to sleep, e.g. a mine that came to rest. Sleeping
+ * objects are kept at the back of their type's array and aren't updated at
+ * all until they are woken up again, but GetObjects() still returns them.
+ * Sleeping and waking during an update takes effect after the update.
+ *
+ * The type being added must have a method "void Update(float dt)". If it is
+ * private, the class can declare UpdateRegistry as a friend. Types that
+ * don't need updating (e.g. phasers, which are evaluated in closed form) can
+ * be added with Track() so other systems can still find them.
+ */
+class ASTEROIDS_PUBLIC_API UpdateRegistry : public Urho3D::Object
+{
+    URHO3D_OBJECT(UpdateRegistry, Urho3D::Object)
+
+public:
+    enum Group
+    {
+        INPUT,
+        SHIP,
+        WEAPONS,
+        PROJECTILES,
+        HITS,
+        ASTEROIDS,
+        CAMERA
+    };
+
+    UpdateRegistry(Urho3D::Context* context);
+
+    template <class T>
+    void Add(T* object, Group group)
+        { AddObject(T::GetTypeStatic(), group, &UpdateAll<T>, static_cast<void*>(object)); }
+
+    /// Adds an object that is never updated, only returned by GetObjects().
+    template <class T>
+    void Track(T* object)
+        { AddObject(T::GetTypeStatic(), INPUT, nullptr, static_cast<void*>(object)); }
+
+    template <class T>
+    void Remove(T* object)
+        { RemoveObject(T::GetTypeStatic(), static_cast<void*>(object)); }
+
+    /// Stops updating the object until Wake() is called.
+    template <class T>
+    void Sleep(T* object)
+        { SetObjectAwake(T::GetTypeStatic(), static_cast<void*>(object), false); }
+
+    template <class T>
+    void Wake(T* object)
+        { SetObjectAwake(T::GetTypeStatic(), static_cast<void*>(object), true); }
+
+    /*!
+     * @brief Returns all registered objects of type T, for systems that
+     * process every object of a type in one go (e.g. rendering). Entries are
+     * T* and may be null for objects that were removed during the current
+     * update.
+     */
+    template <class T>
+    const Urho3D::PODVector<void*>& GetObjects() const
+        { return GetObjectList(T::GetTypeStatic()); }
+
+    /*!
+     * @brief Updates all objects. Normally called from E_UPDATE, but can be
+     * called manually (e.g. by benchmarks).
+     */
+    void Update(float dt);
+
+private:
+    typedef void (*UpdateFunc)(Urho3D::PODVector<void*>& objects, unsigned count, float dt);
+
+    template <class T>
+    static void UpdateAll(Urho3D::PODVector<void*>& objects, unsigned count, float dt)
+    {
+        // Note: Don't hold a pointer to the buffer, objects can be added
+        // during the update and cause it to be reallocated
+        for (unsigned i = 0; i != count; ++i)
+            if (objects[i] != nullptr)
+                static_cast<T*>(objects[i])->Update(dt);
+    }
+
+    struct TypeList
+    {
+        Urho3D::StringHash type_;
+        Group group_;
+        UpdateFunc update_;
+        /// Awake objects first, then sleeping objects.
+        Urho3D::PODVector<void*> objects_;
+        unsigned numAwake_;
+        bool hasHoles_;
+    };
+
+    struct PendingWake
+    {
+        Urho3D::StringHash type_;
+        void* object_;
+        bool awake_;
+    };
+
+    void AddObject(Urho3D::StringHash type, Group group, UpdateFunc update, void* object);
+    void RemoveObject(Urho3D::StringHash type, void* object);
+    void SetObjectAwake(Urho3D::StringHash type, void* object, bool awake);
+    void MoveObject(TypeList* list, void* object, bool awake);
+    const Urho3D::PODVector<void*>& GetObjectList(Urho3D::StringHash type) const;
+    TypeList* FindTypeList(Urho3D::StringHash type);
+    void InsertTypeList(const TypeList& list);
+    void HandleUpdate(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+
+private:
+    /// Sorted by group. Every type only appears once.
+    Urho3D::Vector<TypeList> typeLists_;
+    /// Types that were added for the first time during an update.
+    Urho3D::Vector<TypeList> pendingTypeLists_;
+    /// Objects that were put to sleep or woken up during an update.
+    Urho3D::PODVector<PendingWake> pendingWakes_;
+    bool updating_;
+};
+
+}
@@ -2,25 +2,29 @@
 #include "Asteroids/Menu/ConnectPrompt.hpp"
 #include "Asteroids/Menu/HostServerPrompt.hpp"
 #include "Asteroids/Menu/MainMenu.hpp"
-#include "Asteroids/Objects/Asteroid.hpp"
+#include "Asteroids/Network/RemoteEventCodec.hpp"
+#include "Asteroids/Objects/AsteroidField.hpp"
+#include "Asteroids/Objects/HitDetector.hpp"
 #include "Asteroids/Objects/MineController.hpp"
 #include "Asteroids/Objects/PhaserController.hpp"
+#include "Asteroids/Objects/PhaserReplicator.hpp"
+#include "Asteroids/Objects/PlanetTerrain.hpp"
+#include "Asteroids/Objects/ProceduralPlanet.hpp"
+#include "Asteroids/Objects/ProjectileRenderer.hpp"
 #include "Asteroids/Player/ActionState.hpp"
 #include "Asteroids/Player/ClientLocalShipState.hpp"
 #include "Asteroids/Player/ClientRemoteShipState.hpp"
 #include "Asteroids/Player/DeviceInputMapper.hpp"
 #include "Asteroids/Player/OrbitingCameraController.hpp"
-#include "Asteroids/Player/PlayerEvents.hpp"
 #include "Asteroids/Player/ServerShipState.hpp"
 #include "Asteroids/Player/ShipController.hpp"
 #include "Asteroids/Player/WeaponSpawner.hpp"
-#include "Asteroids/UserRegistry/UserRegistryEvents.hpp"
+#include "Asteroids/Util/Prefab.hpp"
 
 #include <Urho3D/Core/Context.h>
 #include <Urho3D/Graphics/Graphics.h>
 #include <Urho3D/Graphics/Renderer.h>
 #include <Urho3D/Graphics/RenderPath.h>
-#include <Urho3D/Network/Network.h>
 #include <Urho3D/Resource/ResourceCache.h>
 
 using namespace Urho3D;
@@ -32,19 +36,23 @@ const char* ASTEROIDS_CATEGORY = "Asteroids";
 // ----------------------------------------------------------------------------
 void RegisterObjectFactories(Context* context)
 {
-    // TODO convert these to static methods
-    context->RegisterFactory<Asteroid>(ASTEROIDS_CATEGORY);
-
     ActionState::RegisterObject(context);
+    AsteroidField::RegisterObject(context);
     ClientLocalShipState::RegisterObject(context);
     ClientRemoteShipState::RegisterObject(context);
     ConnectPrompt::RegisterObject(context);
     DeviceInputMapper::RegisterObject(context);
+    HitDetector::RegisterObject(context);
     HostServerPrompt::RegisterObject(context);
     MainMenu::RegisterObject(context);
     MineController::RegisterObject(context);
     OrbitingCameraController::RegisterObject(context);
     PhaserController::RegisterObject(context);
+    PhaserReplicator::RegisterObject(context);
+    PlanetTerrain::RegisterObject(context);
+    Prefab::RegisterObject(context);
+    ProceduralPlanet::RegisterObject(context);
+    ProjectileRenderer::RegisterObject(context);
     ServerShipState::RegisterObject(context);
     ShipController::RegisterObject(context);
     WeaponSpawner::RegisterObject(context);
@@ -53,13 +61,9 @@ void RegisterObjectFactories(Context* context)
 // ----------------------------------------------------------------------------
 void RegisterRemoteNetworkEvents(Context* context)
 {
-    // Register events that can be sent over the network
-    Network* network = context->GetSubsystem<Network>();
-    network->RegisterRemoteEvent(E_REGISTERSUCCEEDED);
-    network->RegisterRemoteEvent(E_USERJOINED);
-    network->RegisterRemoteEvent(E_USERLEFT);
-    network->RegisterRemoteEvent(E_PLAYERCREATE);
-    network->RegisterRemoteEvent(E_PLAYERDESTROY);
+    // None of our events are Urho3D remote events anymore, they are encoded
+    // as game messages
+    context->RegisterSubsystem<RemoteEventCodec>();
 }
 
 // ----------------------------------------------------------------------------
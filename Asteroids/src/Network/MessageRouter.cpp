@@ -0,0 +1,599 @@
+#include "Asteroids/Network/MessageRouter.hpp"
+#include "Asteroids/Network/MessageView.hpp"
+#include "Asteroids/Network/Protocol.hpp"
+#include "Asteroids/Util/Metrics.hpp"
+
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/Network/Connection.h>
+#include <Urho3D/Network/Network.h>
+#include <Urho3D/Network/NetworkEvents.h>
+
+#include <random>
+#include <string.h>
+
+#if !defined(_WIN32)
+#   include <unistd.h>
+#endif
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+// Each direction of each connection gets its own segment. Messages are
+// small, so this is plenty even if a few frames pile up.
+static const unsigned CHANNEL_CAPACITY = 256 * 1024;
+static const char* IDENTITY_KEY = "SharedMemory";
+static const char* IN_PROCESS_KEY = "InProcess";
+// Reliable messages held back while the other side isn't reading
+static const unsigned MAX_BACKLOG = 4 * CHANNEL_CAPACITY;
+// Reliable bytes per connection and network tick, roughly 60 kB/s at 30 Hz
+static const int RELIABLE_BUDGET = 2048;
+
+// ----------------------------------------------------------------------------
+static bool IsLoopbackAddress(const String& address)
+{
+    return address == "127.0.0.1" || address == "localhost" || address == "::1";
+}
+
+// ----------------------------------------------------------------------------
+MessageRouter::MessageRouter(Context* context) :
+    Object(context),
+    channelCounter_(0),
+    clientCount_(0),
+    processToken_(std::random_device()()),
+    sharedMemoryEnabled_(false)
+{
+    SubscribeToEvent(E_BEGINFRAME, URHO3D_HANDLER(MessageRouter, HandleBeginFrame));
+    SubscribeToEvent(E_NETWORKUPDATESENT, URHO3D_HANDLER(MessageRouter, HandleNetworkUpdateSent));
+    SubscribeToEvent(E_CLIENTCONNECTED, URHO3D_HANDLER(MessageRouter, HandleClientConnected));
+    SubscribeToEvent(E_CLIENTIDENTITY, URHO3D_HANDLER(MessageRouter, HandleClientIdentity));
+    SubscribeToEvent(E_CLIENTDISCONNECTED, URHO3D_HANDLER(MessageRouter, HandleClientDisconnected));
+    SubscribeToEvent(E_SERVERDISCONNECTED, URHO3D_HANDLER(MessageRouter, HandleServerDisconnected));
+    SubscribeToEvent(E_CONNECTFAILED, URHO3D_HANDLER(MessageRouter, HandleServerDisconnected));
+    SubscribeToEvent(E_NETWORKMESSAGE, URHO3D_HANDLER(MessageRouter, HandleNetworkMessage));
+}
+
+// ----------------------------------------------------------------------------
+void MessageRouter::SetSharedMemoryEnabled(bool enable)
+{
+    sharedMemoryEnabled_ = enable;
+}
+
+// ----------------------------------------------------------------------------
+bool MessageRouter::IsSharedMemoryEnabled() const
+{
+    return sharedMemoryEnabled_;
+}
+
+// ----------------------------------------------------------------------------
+void MessageRouter::PrepareIdentity(VariantMap& identity, const String& address) const
+{
+    if (IsLoopbackAddress(address) == false)
+        return;
+
+    // If we're hosting, the server we connect to is most likely our own.
+    // The token lets it check.
+    if (GetSubsystem<Network>()->IsServerRunning())
+        identity[IN_PROCESS_KEY] = processToken_;
+    if (sharedMemoryEnabled_)
+        identity[IDENTITY_KEY] = true;
+}
+
+// ----------------------------------------------------------------------------
+bool MessageRouter::IsUsingSharedMemory(Connection* connection) const
+{
+    HashMap<Connection*, SharedPtr<Channel>>::ConstIterator it = channels_.Find(connection);
+    return it != channels_.End() && it->second_->active_;
+}
+
+// ----------------------------------------------------------------------------
+void MessageRouter::SendMessage(Connection* connection, MessageChannel channel, int msgID, const VectorBuffer& msg)
+{
+    SendMessage(connection, channel, msgID, msg.GetData(), msg.GetSize());
+}
+
+// ----------------------------------------------------------------------------
+void MessageRouter::SendMessage(Connection* connection, MessageChannel channel, int msgID, const unsigned char* data, unsigned size)
+{
+    Metrics* metrics = GetSubsystem<Metrics>();
+    if (metrics)
+        metrics->CountMessageSent(msgID, size);
+
+    if (channel == CHANNEL_STATE)
+    {
+        Transmit(connection, channel, msgID, data, size);
+        return;
+    }
+
+    SharedPtr<Outbox>& outbox = outboxes_[connection];
+    if (outbox.Null())
+    {
+        outbox = new Outbox;
+        outbox->connection_ = connection;
+        outbox->allowance_ = RELIABLE_BUDGET;
+    }
+
+    // Shared memory has no send queue to get stuck in, so it isn't budgeted.
+    // Messages still queued from before the switch have to go first though.
+    VectorBuffer& queue = outbox->queues_[channel];
+    bool sharedMemory = IsUsingSharedMemory(connection);
+    if (queue.GetSize() == 0 && (sharedMemory || outbox->allowance_ > 0))
+    {
+        if (sharedMemory == false)
+            outbox->allowance_ -= (int)size;
+        Transmit(connection, channel, msgID, data, size);
+        return;
+    }
+
+    queue.Seek(queue.GetSize());
+    queue.WriteInt(msgID);
+    queue.WriteVLE(size);
+    queue.Write(data, size);
+}
+
+// ----------------------------------------------------------------------------
+void MessageRouter::BroadcastMessage(MessageChannel channel, int msgID, const VectorBuffer& msg)
+{
+    Network* network = GetSubsystem<Network>();
+
+    // Fast path for when nobody is on shared memory. Reliable messages are
+    // budgeted per connection, so they always take the slow path.
+    if (channel == CHANNEL_STATE && channels_.Empty())
+    {
+        Metrics* metrics = GetSubsystem<Metrics>();
+        if (metrics)
+            metrics->CountMessageSent(msgID, msg.GetSize(), clientCount_);
+
+        network->BroadcastMessage(msgID, false, false, msg);
+        return;
+    }
+
+    for (const auto& connection : network->GetClientConnections())
+        SendMessage(connection, channel, msgID, msg);
+}
+
+// ----------------------------------------------------------------------------
+unsigned MessageRouter::GetNumQueuedBytes(Connection* connection) const
+{
+    HashMap<Connection*, SharedPtr<Outbox>>::ConstIterator it = outboxes_.Find(connection);
+    if (it == outboxes_.End())
+        return 0;
+
+    unsigned bytes = 0;
+    for (unsigned i = 0; i != CHANNEL_COUNT; ++i)
+        bytes += it->second_->queues_[i].GetSize() - it->second_->read_[i];
+    return bytes;
+}
+
+// ----------------------------------------------------------------------------
+void MessageRouter::Transmit(Connection* connection, MessageChannel channel, int msgID, const unsigned char* data, unsigned size)
+{
+    HashMap<Connection*, SharedPtr<Channel>>::Iterator it = channels_.Find(connection);
+    if (it != channels_.End() && it->second_->active_)
+    {
+        Channel* shm = it->second_;
+        ShmRingBuffer* ring = shm->send_;
+
+        // Nobody waits for state messages. If they don't fit, they're lost
+        // like a dropped packet.
+        if (channel == CHANNEL_STATE)
+        {
+            if (size > ring->GetMaxMessageSize())
+                URHO3D_LOGERRORF("State message %d is too large for shared memory (%u bytes)", msgID, size);
+            else if (shm->backlog_.GetSize() == 0)
+                ring->Write(msgID, data, size);
+            return;
+        }
+
+        // Split messages that can never fit into the ring. The receiver
+        // appends MSG_SHM_FRAGMENTs until the record with the real ID.
+        unsigned maxSize = ring->GetMaxMessageSize();
+        while (size > maxSize)
+        {
+            Enqueue(shm, MSG_SHM_FRAGMENT, data, maxSize);
+            data += maxSize;
+            size -= maxSize;
+        }
+        Enqueue(shm, msgID, data, size);
+        return;
+    }
+
+    if (channel == CHANNEL_STATE)
+        connection->SendMessage(msgID, false, false, data, size);
+    else
+        connection->SendMessage(msgID, true, true, data, size);
+}
+
+// ----------------------------------------------------------------------------
+void MessageRouter::Enqueue(Channel* channel, int msgID, const unsigned char* data, unsigned size)
+{
+    if (channel->active_ == false)
+        return;  // Gave up on this connection
+
+    if (channel->backlog_.GetSize() == 0 && channel->send_->Write(msgID, data, size))
+        return;
+
+    // The other side isn't keeping up. Sending this over UDP could overtake
+    // messages still in the ring, so hold on to it until there's room again.
+    Connection* connection = channel->connection_;
+    if (channel->loggedFull_ == false)
+    {
+        URHO3D_LOGWARNINGF("Shared memory channel to %s is full, queueing messages", connection->ToString().CString());
+        channel->loggedFull_ = true;
+    }
+
+    VectorBuffer& backlog = channel->backlog_;
+    if (backlog.GetSize() - channel->backlogRead_ + size > MAX_BACKLOG)
+    {
+        URHO3D_LOGERRORF("%s stopped reading from shared memory, disconnecting", connection->ToString().CString());
+        backlog.Clear();
+        channel->backlogRead_ = 0;
+        channel->active_ = false;
+        connection->Disconnect();
+        return;
+    }
+
+    backlog.Seek(backlog.GetSize());
+    backlog.WriteInt(msgID);
+    backlog.WriteVLE(size);
+    backlog.Write(data, size);
+}
+
+// ----------------------------------------------------------------------------
+void MessageRouter::DrainBacklogs()
+{
+    for (HashMap<Connection*, SharedPtr<Channel>>::Iterator it = channels_.Begin(); it != channels_.End(); ++it)
+    {
+        Channel* channel = it->second_;
+        VectorBuffer& backlog = channel->backlog_;
+        unsigned& read = channel->backlogRead_;
+        while (read < backlog.GetSize())
+        {
+            MemoryBuffer buffer(backlog.GetData() + read, backlog.GetSize() - read);
+            int msgID = buffer.ReadInt();
+            unsigned size = buffer.ReadVLE();
+            const unsigned char* data = backlog.GetData() + read + buffer.GetPosition();
+
+            if (channel->send_->Write(msgID, data, size) == false)
+                break;
+            read += buffer.GetPosition() + size;
+        }
+
+        if (read == backlog.GetSize() && read != 0)
+        {
+            backlog.Clear();
+            read = 0;
+        }
+        else if (read > backlog.GetSize() / 2)
+        {
+            // Don't let the buffer grow while the reader only partly catches up
+            unsigned remaining = backlog.GetSize() - read;
+            memmove(backlog.GetModifiableData(), backlog.GetData() + read, remaining);
+            backlog.Resize(remaining);
+            read = 0;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+void MessageRouter::FlushOutboxes()
+{
+    for (HashMap<Connection*, SharedPtr<Outbox>>::Iterator it = outboxes_.Begin(); it != outboxes_.End(); )
+    {
+        Outbox* outbox = it->second_;
+        Connection* connection = outbox->connection_;
+        if (connection == nullptr)
+        {
+            it = outboxes_.Erase(it);
+            continue;
+        }
+        ++it;
+
+        // Unused budget doesn't carry over, debt from large messages does
+        outbox->allowance_ = Min(outbox->allowance_ + RELIABLE_BUDGET, RELIABLE_BUDGET);
+        bool sharedMemory = IsUsingSharedMemory(connection);
+
+        for (unsigned channel = CHANNEL_EVENTS; channel != CHANNEL_COUNT; ++channel)
+        {
+            VectorBuffer& queue = outbox->queues_[channel];
+            unsigned& read = outbox->read_[channel];
+            while (read < queue.GetSize() && (sharedMemory || outbox->allowance_ > 0))
+            {
+                MemoryBuffer buffer(queue.GetData() + read, queue.GetSize() - read);
+                int msgID = buffer.ReadInt();
+                unsigned size = buffer.ReadVLE();
+                const unsigned char* data = queue.GetData() + read + buffer.GetPosition();
+
+                Transmit(connection, (MessageChannel)channel, msgID, data, size);
+                outbox->allowance_ -= (int)size;
+                read += buffer.GetPosition() + size;
+            }
+
+            if (read == queue.GetSize())
+            {
+                queue.Clear();
+                read = 0;
+            }
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+bool MessageRouter::CreateChannel(Connection* connection, bool inProcess)
+{
+    SharedPtr<Channel> channel(new Channel);
+    channel->connection_ = connection;
+    channel->rings_ = new Rings;
+    channel->send_ = &channel->rings_->serverToClient_;
+    channel->receive_ = &channel->rings_->clientToServer_;
+
+    String name;
+    if (inProcess)
+    {
+        // The client's end of the connection is served by this router too,
+        // it picks the queues up from offeredRings_ by name
+        name = ToString("local-%u", channelCounter_++);
+        channel->send_->Allocate(CHANNEL_CAPACITY);
+        channel->receive_->Allocate(CHANNEL_CAPACITY);
+        offeredRings_[name] = channel->rings_;
+    }
+    else
+    {
+#if defined(_WIN32)
+        name = ToString("/asteroids-%u", channelCounter_++);
+#else
+        name = ToString("/asteroids-%d-%u", (int)getpid(), channelCounter_++);
+#endif
+        if (channel->receive_->Create(name + ".c2s", CHANNEL_CAPACITY) == false)
+            return false;
+        if (channel->send_->Create(name + ".s2c", CHANNEL_CAPACITY) == false)
+            return false;
+    }
+
+    channels_[connection] = channel;
+
+    msg_.Clear();
+    msg_.WriteString(name);
+    SendMessage(connection, CHANNEL_EVENTS, MSG_SHM_TRANSPORT, msg_);
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+bool MessageRouter::OpenChannel(Connection* connection, const String& name)
+{
+    SharedPtr<Channel> channel(new Channel);
+    channel->connection_ = connection;
+
+    HashMap<String, SharedPtr<Rings>>::Iterator offered = offeredRings_.Find(name);
+    if (offered != offeredRings_.End())
+    {
+        channel->rings_ = offered->second_;
+    }
+    else
+    {
+        channel->rings_ = new Rings;
+        if (channel->rings_->serverToClient_.Open(name + ".s2c") == false)
+            return false;
+        if (channel->rings_->clientToServer_.Open(name + ".c2s") == false)
+            return false;
+    }
+
+    channel->send_ = &channel->rings_->clientToServer_;
+    channel->receive_ = &channel->rings_->serverToClient_;
+    channel->active_ = true;
+    channels_[connection] = channel;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+void MessageRouter::WithdrawOffer(Rings* rings)
+{
+    for (HashMap<String, SharedPtr<Rings>>::Iterator it = offeredRings_.Begin(); it != offeredRings_.End(); ++it)
+    {
+        if (it->second_ == rings)
+        {
+            offeredRings_.Erase(it);
+            return;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+void MessageRouter::ReceiveMessages()
+{
+    using namespace NetworkMessage;
+
+    // Message handlers may cause connections to be removed, so work on a
+    // copy of the channel list. The copy keeps the channels alive too.
+    receiving_.Clear();
+    for (HashMap<Connection*, SharedPtr<Channel>>::Iterator it = channels_.Begin(); it != channels_.End(); )
+    {
+        if (it->second_->connection_.Expired())
+            it = channels_.Erase(it);
+        else
+            receiving_.Push((it++)->second_);
+    }
+
+    for (const auto& channel : receiving_)
+    {
+        int msgID;
+        unsigned size;
+        while (channel->receive_->IsOpen())
+        {
+            Connection* connection = channel->connection_;
+            if (connection == nullptr)
+                break;
+
+            const unsigned char* data = channel->receive_->Peek(&msgID, &size);
+            if (data == nullptr)
+                break;
+
+            VectorBuffer& fragments = channel->fragments_;
+            if (msgID == MSG_SHM_FRAGMENT)
+            {
+                fragments.Write(data, size);
+                channel->receive_->Pop();
+                continue;
+            }
+
+            VariantMap& eventData = GetEventDataMap();
+            eventData[P_CONNECTION] = connection;
+            eventData[P_MESSAGEID] = msgID;
+            if (fragments.GetSize() > 0)
+            {
+                fragments.Write(data, size);
+                eventData[P_DATA].SetBuffer(fragments.GetData(), fragments.GetSize());
+                fragments.Clear();
+            }
+            else
+            {
+                eventData[P_DATA].SetBuffer(data, size);
+            }
+            channel->receive_->Pop();
+
+            connection->SendEvent(E_NETWORKMESSAGE, eventData);
+        }
+    }
+    receiving_.Clear();
+}
+
+// ----------------------------------------------------------------------------
+void MessageRouter::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
+{
+    if (channels_.Empty() == false)
+    {
+        DrainBacklogs();
+        ReceiveMessages();
+    }
+}
+
+// ----------------------------------------------------------------------------
+void MessageRouter::HandleNetworkUpdateSent(StringHash eventType, VariantMap& eventData)
+{
+    // The state messages of this tick have been queued by now
+    if (outboxes_.Empty() == false)
+        FlushOutboxes();
+}
+
+// ----------------------------------------------------------------------------
+void MessageRouter::HandleClientIdentity(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ClientIdentity;
+
+    Connection* connection = static_cast<Connection*>(eventData[P_CONNECTION].GetPtr());
+    const VariantMap& identity = connection->GetIdentity();
+
+    // Shared memory only makes sense if the client is on the same host
+    if (IsLoopbackAddress(connection->GetAddress()) == false)
+        return;
+
+    VariantMap::ConstIterator token = identity.Find(IN_PROCESS_KEY);
+    bool inProcess = (token != identity.End() && token->second_.GetUInt() == processToken_);
+    if (inProcess == false)
+    {
+        if (sharedMemoryEnabled_ == false)
+            return;
+
+        VariantMap::ConstIterator requested = identity.Find(IDENTITY_KEY);
+        if (requested == identity.End() || requested->second_.GetBool() == false)
+            return;
+    }
+
+    if (CreateChannel(connection, inProcess) == false)
+        URHO3D_LOGWARNINGF("Failed to create shared memory channel for %s, using UDP", connection->ToString().CString());
+}
+
+// ----------------------------------------------------------------------------
+void MessageRouter::HandleClientConnected(StringHash eventType, VariantMap& eventData)
+{
+    // Network::GetClientConnections() returns a copy, keep track of the
+    // count ourselves so broadcasts can be counted without allocating
+    clientCount_++;
+}
+
+// ----------------------------------------------------------------------------
+void MessageRouter::HandleClientDisconnected(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ClientDisconnected;
+
+    if (clientCount_ > 0)
+        clientCount_--;
+
+    Connection* connection = static_cast<Connection*>(eventData[P_CONNECTION].GetPtr());
+    HashMap<Connection*, SharedPtr<Channel>>::Iterator it = channels_.Find(connection);
+    if (it != channels_.End())
+    {
+        WithdrawOffer(it->second_->rings_);
+        channels_.Erase(it);
+    }
+    outboxes_.Erase(connection);
+}
+
+// ----------------------------------------------------------------------------
+void MessageRouter::HandleServerDisconnected(StringHash eventType, VariantMap& eventData)
+{
+    Connection* connection = GetSubsystem<Network>()->GetServerConnection();
+    if (connection)
+    {
+        channels_.Erase(connection);
+        outboxes_.Erase(connection);
+    }
+
+    // The server connection may already be gone at this point, in which case
+    // its channel is cleaned up in ReceiveMessages() and its outbox in
+    // FlushOutboxes()
+}
+
+// ----------------------------------------------------------------------------
+void MessageRouter::HandleNetworkMessage(StringHash eventType, VariantMap& eventData)
+{
+    MessageView message(eventData);
+    if (message.GetID() != MSG_SHM_TRANSPORT)
+        return;
+
+    Connection* connection = message.GetConnection();
+    MemoryBuffer& buffer = message.GetBuffer();
+
+    if (connection->IsClient())
+    {
+        // We're the server and the client has answered our offer
+        HashMap<Connection*, SharedPtr<Channel>>::Iterator it = channels_.Find(connection);
+        if (it == channels_.End())
+            return;
+
+        Channel* channel = it->second_;
+        WithdrawOffer(channel->rings_);
+        if (buffer.ReadBool())
+        {
+            // Both sides have the segments mapped, names are no longer needed
+            channel->receive_->Unlink();
+            channel->send_->Unlink();
+            channel->active_ = true;
+            URHO3D_LOGINFOF("Using shared memory transport for %s", connection->ToString().CString());
+        }
+        else
+        {
+            channels_.Erase(it);
+        }
+    }
+    else
+    {
+        // We're the client and the server has offered shared memory
+        bool success = OpenChannel(connection, buffer.ReadString());
+        if (success)
+            URHO3D_LOGINFO("Using shared memory transport to server");
+        else
+            URHO3D_LOGWARNING("Failed to attach to the server's shared memory channel, using UDP");
+
+        // The server only switches after this arrives, so it has to go
+        // through UDP
+        msg_.Clear();
+        msg_.WriteBool(success);
+        connection->SendMessage(MSG_SHM_TRANSPORT, true, true, msg_);
+    }
+}
+
+}
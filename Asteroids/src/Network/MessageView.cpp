@@ -0,0 +1,38 @@
+#include "Asteroids/Network/MessageView.hpp"
+
+#include <Urho3D/Network/Connection.h>
+#include <Urho3D/Network/NetworkEvents.h>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+// ----------------------------------------------------------------------------
+static const PODVector<unsigned char>& FindData(const VariantMap& eventData)
+{
+    static const PODVector<unsigned char> empty;
+
+    VariantMap::ConstIterator it = eventData.Find(NetworkMessage::P_DATA);
+    if (it == eventData.End() || it->second_.GetType() != VAR_BUFFER)
+        return empty;
+    return it->second_.GetBuffer();
+}
+
+// ----------------------------------------------------------------------------
+MessageView::MessageView(const VariantMap& eventData) :
+    connection_(nullptr),
+    id_(-1),
+    buffer_(FindData(eventData))
+{
+    using namespace NetworkMessage;
+
+    VariantMap::ConstIterator it = eventData.Find(P_MESSAGEID);
+    if (it != eventData.End())
+        id_ = it->second_.GetInt();
+
+    it = eventData.Find(P_CONNECTION);
+    if (it != eventData.End())
+        connection_ = static_cast<Connection*>(it->second_.GetPtr());
+}
+
+}
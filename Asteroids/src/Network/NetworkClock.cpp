@@ -0,0 +1,245 @@
+#include "Asteroids/Network/MessageRouter.hpp"
+#include "Asteroids/Network/MessageView.hpp"
+#include "Asteroids/Network/Messages.hpp"
+#include "Asteroids/Network/NetworkClock.hpp"
+
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Engine/DebugHud.h>
+#include <Urho3D/Network/Connection.h>
+#include <Urho3D/Network/Network.h>
+#include <Urho3D/Network/NetworkEvents.h>
+
+#include <algorithm>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+static const unsigned WINDOW_SIZE = 16;
+static const unsigned MIN_SAMPLES = 4;
+static const unsigned FAST_REQUESTS = 8;
+static const long long REQUEST_INTERVAL_USEC = 1000000;
+// Samples within this much of the lowest RTT in the window are trusted
+static const double RTT_TOLERANCE_USEC = 1000;
+static const double OFFSET_GAIN = 0.1;
+// The server restarted or something similar, don't slowly slide there
+static const double OFFSET_STEP_USEC = 100000;
+
+// ----------------------------------------------------------------------------
+NetworkClock::NetworkClock(Context* context) :
+    Object(context)
+{
+    Reset();
+
+    SubscribeToEvent(E_NETWORKMESSAGE, URHO3D_HANDLER(NetworkClock, HandleNetworkMessage));
+    SubscribeToEvent(E_NETWORKUPDATE, URHO3D_HANDLER(NetworkClock, HandleNetworkUpdate));
+    SubscribeToEvent(E_SERVERCONNECTED, URHO3D_HANDLER(NetworkClock, HandleServerConnected));
+    SubscribeToEvent(E_SERVERDISCONNECTED, URHO3D_HANDLER(NetworkClock, HandleServerDisconnected));
+    SubscribeToEvent(E_CONNECTFAILED, URHO3D_HANDLER(NetworkClock, HandleServerDisconnected));
+    SubscribeToEvent(E_CLIENTDISCONNECTED, URHO3D_HANDLER(NetworkClock, HandleClientDisconnected));
+}
+
+// ----------------------------------------------------------------------------
+long long NetworkClock::GetLocalTime() const
+{
+    return clock_.GetUSec(false);
+}
+
+// ----------------------------------------------------------------------------
+double NetworkClock::GetServerTime() const
+{
+    return (GetLocalTime() + offset_) * 1e-6;
+}
+
+// ----------------------------------------------------------------------------
+double NetworkClock::GetOffset() const
+{
+    return offset_;
+}
+
+// ----------------------------------------------------------------------------
+float NetworkClock::GetRoundTripTime() const
+{
+    return float(roundTripTime_ * 1e-6);
+}
+
+// ----------------------------------------------------------------------------
+float NetworkClock::GetRoundTripJitter() const
+{
+    return float(roundTripJitter_ * 1e-6);
+}
+
+// ----------------------------------------------------------------------------
+bool NetworkClock::IsSynchronized() const
+{
+    return numSamples_ >= MIN_SAMPLES;
+}
+
+// ----------------------------------------------------------------------------
+float NetworkClock::GetRoundTripTime(Connection* connection) const
+{
+    HashMap<Connection*, float>::ConstIterator it = clientRoundTripTimes_.Find(connection);
+    return it != clientRoundTripTimes_.End() ? it->second_ : 0.0f;
+}
+
+// ----------------------------------------------------------------------------
+void NetworkClock::Reset()
+{
+    samples_.Clear();
+    nextSample_ = 0;
+    numRequests_ = 0;
+    nextRequestTime_ = 0;
+    offset_ = 0;
+    roundTripTime_ = 0;
+    roundTripJitter_ = 0;
+    numSamples_ = 0;
+}
+
+// ----------------------------------------------------------------------------
+void NetworkClock::AddSample(long long t0, long long t1, long long t2, long long t3)
+{
+    Sample sample = {double((t3 - t0) - (t2 - t1)), ((t1 - t0) + (t2 - t3)) * 0.5};
+    if (sample.roundTripTime_ < 0)
+        return;  // The server's timestamps are garbage
+
+    if (samples_.Size() < WINDOW_SIZE)
+        samples_.Push(sample);
+    else
+        samples_[nextSample_] = sample;
+    nextSample_ = (nextSample_ + 1) % WINDOW_SIZE;
+
+    // Queuing delays are rarely the same in both directions, so samples with
+    // a higher RTT than the best ones are also the ones with the worst
+    // offset. Take the median offset of the samples close to the lowest RTT.
+    candidates_ = samples_;
+    std::sort(candidates_.Begin(), candidates_.End(), [](const Sample& a, const Sample& b) {
+        return a.roundTripTime_ < b.roundTripTime_;
+    });
+    double maxRoundTripTime = candidates_.Front().roundTripTime_ + RTT_TOLERANCE_USEC;
+    unsigned count = 1;
+    while (count < candidates_.Size() && candidates_[count].roundTripTime_ <= maxRoundTripTime)
+        ++count;
+    std::sort(candidates_.Begin(), candidates_.Begin() + count, [](const Sample& a, const Sample& b) {
+        return a.offset_ < b.offset_;
+    });
+    double offset = candidates_[count / 2].offset_;
+
+    if (numSamples_ == 0 || Abs(offset - offset_) > OFFSET_STEP_USEC)
+    {
+        offset_ = offset;
+        roundTripTime_ = sample.roundTripTime_;
+        roundTripJitter_ = sample.roundTripTime_ * 0.5;
+    }
+    else
+    {
+        offset_ += (offset - offset_) * OFFSET_GAIN;
+        roundTripJitter_ += (Abs(sample.roundTripTime_ - roundTripTime_) - roundTripJitter_) * 0.25;
+        roundTripTime_ += (sample.roundTripTime_ - roundTripTime_) * 0.125;
+    }
+    ++numSamples_;
+
+    UpdateDebugHud();
+}
+
+// ----------------------------------------------------------------------------
+void NetworkClock::UpdateDebugHud()
+{
+    DebugHud* hud = GetSubsystem<DebugHud>();
+    if (hud == nullptr)
+        return;
+
+    hud->SetAppStats("Clock offset", ToString("%.3f ms", offset_ * 1e-3));
+    hud->SetAppStats("RTT", ToString("%.2f ms (+-%.2f)", roundTripTime_ * 1e-3, roundTripJitter_ * 1e-3));
+}
+
+// ----------------------------------------------------------------------------
+void NetworkClock::HandleNetworkMessage(StringHash eventType, VariantMap& eventData)
+{
+    MessageView message(eventData);
+    if (message.GetID() != MSG_NETWORK_TIMER)
+        return;
+
+    Connection* connection = message.GetConnection();
+    if (connection == nullptr)
+        return;
+
+    long long now = GetLocalTime();
+
+    // A reply from the server
+    if (connection == GetSubsystem<Network>()->GetServerConnection())
+    {
+        ClockResponseMsg response;
+        if (ReadMessage(message.GetBuffer(), &response))
+            AddSample(response.clientTime_, response.serverReceiveTime_, response.serverSendTime_, now);
+        return;
+    }
+
+    // A request from a client. The reply is sent with the next packet.
+    ClockRequestMsg request;
+    if (ReadMessage(message.GetBuffer(), &request) == false)
+        return;
+
+    if (request.roundTripTime_ > 0)
+        clientRoundTripTimes_[connection] = request.roundTripTime_ * 1e-6f;
+    PendingReply reply = {connection, request.clientTime_, (uint64_t)now};
+    pendingReplies_.Push(reply);
+}
+
+// ----------------------------------------------------------------------------
+void NetworkClock::HandleNetworkUpdate(StringHash eventType, VariantMap& eventData)
+{
+    MessageRouter* router = GetSubsystem<MessageRouter>();
+    long long now = GetLocalTime();
+
+    for (const PendingReply& reply : pendingReplies_)
+    {
+        ClockResponseMsg response = {reply.clientTime_, reply.receiveTime_, (uint64_t)now};
+        msg_.Clear();
+        WriteMessage(msg_, response);
+        router->SendMessage(reply.connection_, CHANNEL_STATE, MSG_NETWORK_TIMER, msg_);
+    }
+    pendingReplies_.Clear();
+
+    Connection* server = GetSubsystem<Network>()->GetServerConnection();
+    if (server == nullptr || now < nextRequestTime_)
+        return;
+
+    // Lost requests are simply replaced by the next one, no need to send them reliably
+    ClockRequestMsg request = {(uint64_t)now, (uint32_t)roundTripTime_};
+    msg_.Clear();
+    WriteMessage(msg_, request);
+    router->SendMessage(server, CHANNEL_STATE, MSG_NETWORK_TIMER, msg_);
+
+    if (++numRequests_ >= FAST_REQUESTS)
+        nextRequestTime_ = now + REQUEST_INTERVAL_USEC;
+}
+
+// ----------------------------------------------------------------------------
+void NetworkClock::HandleServerConnected(StringHash eventType, VariantMap& eventData)
+{
+    Reset();
+}
+
+// ----------------------------------------------------------------------------
+void NetworkClock::HandleServerDisconnected(StringHash eventType, VariantMap& eventData)
+{
+    Reset();
+}
+
+// ----------------------------------------------------------------------------
+void NetworkClock::HandleClientDisconnected(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ClientDisconnected;
+
+    Connection* connection = static_cast<Connection*>(eventData[P_CONNECTION].GetPtr());
+    clientRoundTripTimes_.Erase(connection);
+    for (unsigned i = 0; i != pendingReplies_.Size(); )
+    {
+        if (pendingReplies_[i].connection_ == connection)
+            pendingReplies_.Erase(i);
+        else
+            ++i;
+    }
+}
+
+}
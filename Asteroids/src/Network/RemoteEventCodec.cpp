@@ -0,0 +1,168 @@
+#include "Asteroids/Network/MessageRouter.hpp"
+#include "Asteroids/Network/MessageView.hpp"
+#include "Asteroids/Network/Messages.hpp"
+#include "Asteroids/Network/RemoteEventCodec.hpp"
+#include "Asteroids/Player/PlayerEvents.hpp"
+#include "Asteroids/UserRegistry/UserRegistryEvents.hpp"
+
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Network/Connection.h>
+#include <Urho3D/Network/Network.h>
+#include <Urho3D/Network/NetworkEvents.h>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+// ----------------------------------------------------------------------------
+static const Variant& GetParam(const VariantMap& eventData, StringHash key)
+{
+    VariantMap::ConstIterator it = eventData.Find(key);
+    return it != eventData.End() ? it->second_ : Variant::EMPTY;
+}
+
+// ----------------------------------------------------------------------------
+RemoteEventCodec::RemoteEventCodec(Context* context) :
+    Object(context)
+{
+    SubscribeToEvent(E_NETWORKMESSAGE, URHO3D_HANDLER(RemoteEventCodec, HandleNetworkMessage));
+}
+
+// ----------------------------------------------------------------------------
+void RemoteEventCodec::SendRemoteEvent(Connection* connection, StringHash eventType, const VariantMap& eventData)
+{
+    int msgID = Encode(eventType, eventData);
+    if (msgID < 0)
+        return;
+
+    GetSubsystem<MessageRouter>()->SendMessage(connection, CHANNEL_EVENTS, msgID, msg_);
+}
+
+// ----------------------------------------------------------------------------
+void RemoteEventCodec::BroadcastRemoteEvent(StringHash eventType, const VariantMap& eventData)
+{
+    int msgID = Encode(eventType, eventData);
+    if (msgID < 0)
+        return;
+
+    GetSubsystem<MessageRouter>()->BroadcastMessage(CHANNEL_EVENTS, msgID, msg_);
+}
+
+// ----------------------------------------------------------------------------
+int RemoteEventCodec::Encode(StringHash eventType, const VariantMap& eventData)
+{
+    msg_.Clear();
+
+    if (eventType == E_USERJOINED)
+    {
+        const String& username = GetParam(eventData, UserJoined::P_USERNAME).GetString();
+        UserJoinedMsg msg = {
+            (uint16_t)GetParam(eventData, UserJoined::P_GUID).GetUInt(),
+            (uint8_t)Min(username.Length(), 255u)
+        };
+        WriteMessage(msg_, msg);
+        msg_.Write(username.CString(), msg.usernameLength_);
+        return MSG_USER_JOINED;
+    }
+
+    if (eventType == E_PLAYERCREATE)
+    {
+        PlayerCreateMsg msg = {
+            (uint16_t)GetParam(eventData, PlayerCreate::P_GUID).GetUInt(),
+            GetParam(eventData, PlayerCreate::P_PIVOTROTATION).GetQuaternion()
+        };
+        WriteMessage(msg_, msg);
+        return MSG_PLAYER_CREATE;
+    }
+
+    // The rest only carry the GUID. Note that the user events call the
+    // parameter "Guid" and the player events "GUID"
+    int msgID;
+    StringHash guidParam;
+    if (eventType == E_REGISTERSUCCEEDED)
+    {
+        msgID = MSG_REGISTER_SUCCEEDED;
+        guidParam = RegisterSucceeded::P_GUID;
+    }
+    else if (eventType == E_USERLEFT)
+    {
+        msgID = MSG_USER_LEFT;
+        guidParam = UserLeft::P_GUID;
+    }
+    else if (eventType == E_PLAYERDESTROY)
+    {
+        msgID = MSG_PLAYER_DESTROY;
+        guidParam = PlayerDestroy::P_GUID;
+    }
+    else
+    {
+        URHO3D_LOGERRORF("Event %s can't be sent remotely", eventType.ToString().CString());
+        return -1;
+    }
+
+    UserGUIDMsg msg = {(uint16_t)GetParam(eventData, guidParam).GetUInt()};
+    WriteMessage(msg_, msg);
+    return msgID;
+}
+
+// ----------------------------------------------------------------------------
+void RemoteEventCodec::HandleNetworkMessage(StringHash eventType, VariantMap& eventData)
+{
+    MessageView message(eventData);
+    if (message.GetID() < MSG_REGISTER_SUCCEEDED || message.GetID() > MSG_PLAYER_DESTROY)
+        return;
+
+    // Only the server sends these
+    Connection* connection = message.GetConnection();
+    if (connection == nullptr || connection != GetSubsystem<Network>()->GetServerConnection())
+        return;
+
+    MemoryBuffer& buffer = message.GetBuffer();
+    VariantMap& data = GetEventDataMap();
+    switch (message.GetID())
+    {
+        case MSG_USER_JOINED : {
+            UserJoinedMsg msg;
+            if (ReadMessage(buffer, &msg) == false || buffer.GetSize() - buffer.GetPosition() < msg.usernameLength_)
+                return;
+            data[UserJoined::P_GUID] = msg.guid_;
+            data[UserJoined::P_USERNAME] = String(reinterpret_cast<const char*>(buffer.GetData() + buffer.GetPosition()), msg.usernameLength_);
+            connection->SendEvent(E_USERJOINED, data);
+        } break;
+
+        case MSG_PLAYER_CREATE : {
+            PlayerCreateMsg msg;
+            if (ReadMessage(buffer, &msg) == false)
+                return;
+            data[PlayerCreate::P_GUID] = msg.guid_;
+            data[PlayerCreate::P_PIVOTROTATION] = msg.pivotRotation_;
+            connection->SendEvent(E_PLAYERCREATE, data);
+        } break;
+
+        default : {
+            UserGUIDMsg msg;
+            if (ReadMessage(buffer, &msg) == false)
+                return;
+
+            switch (message.GetID())
+            {
+                case MSG_REGISTER_SUCCEEDED :
+                    data[RegisterSucceeded::P_GUID] = msg.guid_;
+                    connection->SendEvent(E_REGISTERSUCCEEDED, data);
+                    break;
+
+                case MSG_USER_LEFT :
+                    data[UserLeft::P_GUID] = msg.guid_;
+                    connection->SendEvent(E_USERLEFT, data);
+                    break;
+
+                case MSG_PLAYER_DESTROY :
+                    data[PlayerDestroy::P_GUID] = msg.guid_;
+                    connection->SendEvent(E_PLAYERDESTROY, data);
+                    break;
+            }
+        } break;
+    }
+}
+
+}
@@ -0,0 +1,370 @@
+#include "Asteroids/Network/ShmRingBuffer.hpp"
+
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Math/MathDefs.h>
+
+#include <atomic>
+#include <string.h>
+
+#if defined(__linux__)
+#   include <errno.h>
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+static const uint32_t SHM_MAGIC = 0x52484D53;  // "SMHR"
+static const uint32_t SKIP_RECORD = 0xFFFFFFFF;
+static const unsigned RECORD_HEADER_SIZE = 8;  // uint32 size + int32 message ID
+
+// The producer and consumer counters live on separate cache lines so the two
+// processes don't keep invalidating each other's line on every message
+struct ShmRingBuffer::Header
+{
+    uint32_t magic_;
+    uint32_t capacity_;
+    char pad0_[56];
+    std::atomic<uint32_t> head_;  // Total bytes written, only written by the producer
+    char pad1_[60];
+    std::atomic<uint32_t> tail_;  // Total bytes read, only written by the consumer
+    char pad2_[60];
+};
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "Counters must be usable across processes");
+
+// ----------------------------------------------------------------------------
+static inline unsigned RecordSize(unsigned payloadSize)
+{
+    return (RECORD_HEADER_SIZE + payloadSize + 7u) & ~7u;
+}
+
+// ----------------------------------------------------------------------------
+ShmRingBuffer::ShmRingBuffer() :
+    header_(nullptr),
+    data_(nullptr),
+    mapSize_(0),
+    capacity_(0),
+    owner_(false),
+    allocated_(false)
+{
+}
+
+// ----------------------------------------------------------------------------
+ShmRingBuffer::~ShmRingBuffer()
+{
+    Close();
+}
+
+#if defined(__linux__)
+
+// ----------------------------------------------------------------------------
+bool ShmRingBuffer::Create(const String& name, unsigned capacity)
+{
+    Close();
+
+    capacity = NextPowerOfTwo(Max(capacity, 4096u));
+    unsigned mapSize = sizeof(Header) + capacity;
+
+    int fd = shm_open(name.CString(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    if (fd == -1)
+    {
+        URHO3D_LOGERRORF("ShmRingBuffer::Create() - shm_open(\"%s\") failed: %s", name.CString(), strerror(errno));
+        return false;
+    }
+
+    if (ftruncate(fd, mapSize) != 0)
+    {
+        URHO3D_LOGERRORF("ShmRingBuffer::Create() - ftruncate() failed: %s", strerror(errno));
+        close(fd);
+        shm_unlink(name.CString());
+        return false;
+    }
+
+    if (Map(fd, mapSize) == false)
+    {
+        shm_unlink(name.CString());
+        return false;
+    }
+
+    Init(capacity);
+
+    name_ = name;
+    owner_ = true;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+bool ShmRingBuffer::Open(const String& name)
+{
+    Close();
+
+    int fd = shm_open(name.CString(), O_RDWR, 0);
+    if (fd == -1)
+    {
+        URHO3D_LOGERRORF("ShmRingBuffer::Open() - shm_open(\"%s\") failed: %s", name.CString(), strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(Header))
+    {
+        URHO3D_LOGERRORF("ShmRingBuffer::Open() - Segment \"%s\" is too small", name.CString());
+        close(fd);
+        return false;
+    }
+
+    if (Map(fd, (unsigned)st.st_size) == false)
+        return false;
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    capacity_ = header_->capacity_;
+    if (header_->magic_ != SHM_MAGIC || IsPowerOfTwo(capacity_) == false || sizeof(Header) + capacity_ > mapSize_)
+    {
+        URHO3D_LOGERRORF("ShmRingBuffer::Open() - Segment \"%s\" is not a ring buffer", name.CString());
+        Close();
+        return false;
+    }
+
+    name_ = name;
+    owner_ = false;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+bool ShmRingBuffer::Map(int fd, unsigned mapSize)
+{
+    void* mem = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);  // The mapping keeps the segment alive
+    if (mem == MAP_FAILED)
+    {
+        URHO3D_LOGERRORF("ShmRingBuffer - mmap() failed: %s", strerror(errno));
+        return false;
+    }
+
+    header_ = static_cast<Header*>(mem);
+    data_ = static_cast<unsigned char*>(mem) + sizeof(Header);
+    mapSize_ = mapSize;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+void ShmRingBuffer::Close()
+{
+    if (header_ == nullptr)
+        return;
+
+    if (allocated_)
+    {
+        delete[] reinterpret_cast<uint64_t*>(header_);
+    }
+    else
+    {
+        if (owner_)
+            Unlink();
+        munmap(header_, mapSize_);
+    }
+
+    header_ = nullptr;
+    data_ = nullptr;
+    mapSize_ = 0;
+    capacity_ = 0;
+    allocated_ = false;
+    name_.Clear();
+}
+
+// ----------------------------------------------------------------------------
+void ShmRingBuffer::Unlink()
+{
+    if (owner_ == false)
+        return;
+
+    shm_unlink(name_.CString());
+    owner_ = false;
+}
+
+#else
+
+// ----------------------------------------------------------------------------
+bool ShmRingBuffer::Create(const String& name, unsigned capacity)
+{
+    URHO3D_LOGERROR("ShmRingBuffer::Create() - Shared memory transport is not supported on this platform");
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+bool ShmRingBuffer::Open(const String& name)
+{
+    URHO3D_LOGERROR("ShmRingBuffer::Open() - Shared memory transport is not supported on this platform");
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+bool ShmRingBuffer::Map(int fd, unsigned mapSize)
+{
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+void ShmRingBuffer::Close()
+{
+    if (header_ == nullptr)
+        return;
+
+    delete[] reinterpret_cast<uint64_t*>(header_);
+    header_ = nullptr;
+    data_ = nullptr;
+    mapSize_ = 0;
+    capacity_ = 0;
+    allocated_ = false;
+}
+
+// ----------------------------------------------------------------------------
+void ShmRingBuffer::Unlink()
+{
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+bool ShmRingBuffer::Allocate(unsigned capacity)
+{
+    Close();
+
+    capacity = NextPowerOfTwo(Max(capacity, 4096u));
+    mapSize_ = sizeof(Header) + capacity;
+
+    // Allocate as uint64_t so records stay 8 byte aligned
+    void* mem = new uint64_t[(mapSize_ + 7) / 8];
+    header_ = static_cast<Header*>(mem);
+    data_ = static_cast<unsigned char*>(mem) + sizeof(Header);
+    allocated_ = true;
+    owner_ = false;
+
+    Init(capacity);
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+void ShmRingBuffer::Init(unsigned capacity)
+{
+    capacity_ = capacity;
+    header_->capacity_ = capacity;
+    header_->head_.store(0, std::memory_order_relaxed);
+    header_->tail_.store(0, std::memory_order_relaxed);
+    // Publish the magic last so Open() never sees a half initialized header
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->magic_ = SHM_MAGIC;
+}
+
+// ----------------------------------------------------------------------------
+unsigned ShmRingBuffer::GetMaxMessageSize() const
+{
+    return capacity_ / 2 - RECORD_HEADER_SIZE;
+}
+
+// ----------------------------------------------------------------------------
+bool ShmRingBuffer::Write(int msgID, const void* data, unsigned size)
+{
+    if (IsOpen() == false)
+        return false;
+
+    if (size > GetMaxMessageSize())
+        return false;
+
+    const uint32_t capacity = capacity_;
+    const uint32_t mask = capacity - 1;
+    const unsigned recordSize = RecordSize(size);
+
+    uint32_t head = header_->head_.load(std::memory_order_relaxed);
+    uint32_t tail = header_->tail_.load(std::memory_order_acquire);
+    uint32_t free = capacity - (head - tail);
+
+    // Records never wrap. If the record doesn't fit before the end of the
+    // buffer, pad the remainder with a skip marker and start at the front.
+    // The skipped part is less than recordSize, so with records of at most
+    // half the capacity this always fits into an empty buffer.
+    uint32_t offset = head & mask;
+    uint32_t untilEnd = capacity - offset;
+    uint32_t needed = recordSize <= untilEnd ? recordSize : untilEnd + recordSize;
+    if (needed > free)
+        return false;
+
+    if (recordSize > untilEnd)
+    {
+        *reinterpret_cast<uint32_t*>(data_ + offset) = SKIP_RECORD;
+        head += untilEnd;
+        offset = 0;
+    }
+
+    unsigned char* record = data_ + offset;
+    reinterpret_cast<uint32_t*>(record)[0] = size;
+    reinterpret_cast<int32_t*>(record)[1] = msgID;
+    memcpy(record + RECORD_HEADER_SIZE, data, size);
+
+    header_->head_.store(head + recordSize, std::memory_order_release);
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+const unsigned char* ShmRingBuffer::Peek(int* msgID, unsigned* size) const
+{
+    if (IsOpen() == false)
+        return nullptr;
+
+    // Use our own copy of the capacity, the other process can write to the
+    // header at any time
+    const uint32_t capacity = capacity_;
+    const uint32_t mask = capacity - 1;
+
+    uint32_t tail = header_->tail_.load(std::memory_order_relaxed);
+    uint32_t head = header_->head_.load(std::memory_order_acquire);
+    if (tail == head)
+        return nullptr;
+
+    uint32_t offset = tail & mask;
+    if (*reinterpret_cast<const uint32_t*>(data_ + offset) == SKIP_RECORD)
+    {
+        // Skip marker always runs until the end of the buffer, so the next
+        // record is at the front. The producer wrote both before
+        // publishing head, so it's safe to look at it.
+        tail += capacity - offset;
+        header_->tail_.store(tail, std::memory_order_release);
+        if (tail == head)
+            return nullptr;
+        offset = 0;
+    }
+
+    // The size comes from the other process. Never hand out a message that
+    // would run past the end of the buffer.
+    const unsigned char* record = data_ + offset;
+    uint32_t recordSize = reinterpret_cast<const uint32_t*>(record)[0];
+    if (recordSize > capacity - offset - RECORD_HEADER_SIZE)
+    {
+        URHO3D_LOGERRORF("ShmRingBuffer::Peek() - Corrupt record of size %u in \"%s\"", recordSize, name_.CString());
+        return nullptr;
+    }
+
+    *size = recordSize;
+    *msgID = reinterpret_cast<const int32_t*>(record)[1];
+    return record + RECORD_HEADER_SIZE;
+}
+
+// ----------------------------------------------------------------------------
+void ShmRingBuffer::Pop()
+{
+    if (IsOpen() == false)
+        return;
+
+    const uint32_t mask = capacity_ - 1;
+
+    uint32_t tail = header_->tail_.load(std::memory_order_relaxed);
+    unsigned size = *reinterpret_cast<const uint32_t*>(data_ + (tail & mask));
+    header_->tail_.store(tail + RecordSize(size), std::memory_order_release);
+}
+
+}
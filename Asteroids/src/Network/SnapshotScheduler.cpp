@@ -0,0 +1,367 @@
+#include "Asteroids/Network/MessageRouter.hpp"
+#include "Asteroids/Network/MessageView.hpp"
+#include "Asteroids/Network/NetworkClock.hpp"
+#include "Asteroids/Network/SnapshotScheduler.hpp"
+#include "Asteroids/Player/ClientLocalShipState.hpp"
+#include "Asteroids/Player/ClientRemoteShipState.hpp"
+#include "Asteroids/Player/InputSampler.hpp"
+#include "Asteroids/Player/ServerShipState.hpp"
+#include "Asteroids/Player/ShipController.hpp"
+#include "Asteroids/UserRegistry/User.hpp"
+#include "Asteroids/Util/UpdateRegistry.hpp"
+
+#include <Urho3D/Core/Profiler.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/Network/Connection.h>
+#include <Urho3D/Network/Network.h>
+#include <Urho3D/Network/NetworkEvents.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <algorithm>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+// Roughly what Urho3D adds to every message (ID and length)
+static const unsigned MESSAGE_OVERHEAD = 4;
+static const unsigned MIN_BUDGET = 128;
+static const unsigned INITIAL_BUDGET = 512;
+static const unsigned MAX_BUDGET = 1200;
+static const unsigned BUDGET_INCREASE = 64;
+static const float BUDGET_DECREASE = 0.7f;
+// Loss below this is considered noise
+static const float LOSS_THRESHOLD = 0.02f;
+// RTT this much above the lowest RTT means the packets are queuing up
+static const float QUEUE_DELAY = 0.05f;
+static const unsigned FEEDBACK_TICKS = 15;
+// Feedback intervals without feedback after which the client is assumed to
+// receive nothing at all
+static const unsigned MISSED_FEEDBACK_LIMIT = 2;
+static const float SHIP_PRIORITY = 1.0f;
+// A ship this far away accumulates priority half as fast as one right next to us
+static const float PRIORITY_DISTANCE = 50.0f;
+
+// ----------------------------------------------------------------------------
+template <class T>
+static void DispatchShipStates(UpdateRegistry* registry, Scene* scene, const PODVector<ServerShipStateMsg>& states)
+{
+    const PODVector<void*>& objects = registry->GetObjects<T>();
+    for (unsigned i = 0; i != objects.Size(); ++i)
+    {
+        T* object = static_cast<T*>(objects[i]);
+        if (object == nullptr || object->GetScene() != scene || object->GetUser() == nullptr)
+            continue;
+
+        const ServerShipStateMsg* state = SnapshotScheduler::FindShipState(states, object->GetUser()->GetGUID());
+        if (state)
+            object->ApplyState(*state);
+    }
+}
+
+// ----------------------------------------------------------------------------
+SnapshotScheduler::SnapshotScheduler(Context* context) :
+    Object(context),
+    tick_(0),
+    lastSequence_(0),
+    receivedSnapshot_(false),
+    snapshotsReceived_(0),
+    snapshotsExpected_(0),
+    ticksSinceFeedback_(0)
+{
+    ReserveMessage(msg_, MAX_BUDGET);
+
+    SubscribeToEvent(E_NETWORKUPDATE, URHO3D_HANDLER(SnapshotScheduler, HandleNetworkUpdate));
+    SubscribeToEvent(E_NETWORKMESSAGE, URHO3D_HANDLER(SnapshotScheduler, HandleNetworkMessage));
+    SubscribeToEvent(E_SERVERCONNECTED, URHO3D_HANDLER(SnapshotScheduler, HandleServerConnected));
+    SubscribeToEvent(E_CLIENTDISCONNECTED, URHO3D_HANDLER(SnapshotScheduler, HandleClientDisconnected));
+}
+
+// ----------------------------------------------------------------------------
+unsigned SnapshotScheduler::GetBudget(Connection* connection) const
+{
+    HashMap<Connection*, SharedPtr<Client>>::ConstIterator it = clients_.Find(connection);
+    return it != clients_.End() ? it->second_->budget_ : 0;
+}
+
+// ----------------------------------------------------------------------------
+bool SnapshotScheduler::DecodeSnapshot(const unsigned char* data, unsigned size, PODVector<ServerShipStateMsg>* states)
+{
+    MemoryBuffer buffer(data, size);
+    SnapshotHeaderMsg header;
+    states->Clear();
+    if (ReadMessage(buffer, &header) == false)
+        return false;
+
+    states->Resize(header.numShips_);
+    for (unsigned i = 0; i != header.numShips_; ++i)
+    {
+        if (ReadMessage(buffer, &(*states)[i]) == false)
+        {
+            states->Resize(i);
+            return false;
+        }
+    }
+
+    std::sort(states->Begin(), states->End(), [](const ServerShipStateMsg& a, const ServerShipStateMsg& b) {
+        return a.guid_ < b.guid_;
+    });
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+const ServerShipStateMsg* SnapshotScheduler::FindShipState(const PODVector<ServerShipStateMsg>& states, uint16_t guid)
+{
+    const ServerShipStateMsg* begin = states.Buffer();
+    const ServerShipStateMsg* end = begin + states.Size();
+    const ServerShipStateMsg* it = std::lower_bound(begin, end, guid, [](const ServerShipStateMsg& state, uint16_t guid) {
+        return state.guid_ < guid;
+    });
+    return it != end && it->guid_ == guid ? it : nullptr;
+}
+
+// ----------------------------------------------------------------------------
+void SnapshotScheduler::GatherEntities()
+{
+    entities_.Clear();
+
+    const PODVector<void*>& states = GetSubsystem<UpdateRegistry>()->GetObjects<ServerShipState>();
+    for (unsigned i = 0; i != states.Size(); ++i)
+    {
+        ServerShipState* state = static_cast<ServerShipState*>(states[i]);
+        if (state == nullptr || state->GetUser() == nullptr)
+            continue;
+
+        ShipController* ship = state->GetComponent<ShipController>();
+        if (ship == nullptr)
+            continue;
+
+        User* user = state->GetUser();
+        Entity entity = {state, state->GetScene(), user->GetConnection(), ship->GetWorldPosition(), user->GetGUID()};
+        entities_.Push(entity);
+    }
+}
+
+// ----------------------------------------------------------------------------
+void SnapshotScheduler::SendSnapshot(Connection* connection, Client* client)
+{
+    // The registry is shared with the client when hosting, only look at the
+    // ships in the connection's scene
+    Scene* scene = connection->GetScene();
+    const Entity* viewer = nullptr;
+    for (const Entity& entity : entities_)
+        if (entity.owner_ == connection && entity.scene_ == scene)
+            viewer = &entity;
+
+    candidates_.Clear();
+    for (unsigned i = 0; i != entities_.Size(); ++i)
+    {
+        const Entity& entity = entities_[i];
+        if (entity.scene_ != scene)
+            continue;
+
+        if (&entity == viewer)
+        {
+            Candidate candidate = {i, M_INFINITY};
+            candidates_.Push(candidate);
+            continue;
+        }
+
+        float distance = viewer ? (entity.position_ - viewer->position_).Length() : 0.0f;
+        Accumulator& accumulator = client->accumulators_[entity.guid_];
+        if (accumulator.lastTick_ != tick_ - 1)
+            accumulator.priority_ = 0;  // New ship, or we left out a tick
+        accumulator.priority_ += SHIP_PRIORITY / (1.0f + distance / PRIORITY_DISTANCE);
+        accumulator.lastTick_ = tick_;
+
+        Candidate candidate = {i, accumulator.priority_};
+        candidates_.Push(candidate);
+    }
+
+    // Ships that were removed. Counting doesn't tell, the viewer's own ship
+    // is a candidate without an accumulator.
+    for (HashMap<unsigned, Accumulator>::Iterator it = client->accumulators_.Begin(); it != client->accumulators_.End(); )
+    {
+        if (it->second_.lastTick_ != tick_)
+            it = client->accumulators_.Erase(it);
+        else
+            ++it;
+    }
+
+    SnapshotHeaderMsg header = {client->sequence_++, 0};
+    unsigned available = client->budget_ - MESSAGE_OVERHEAD - SnapshotHeaderMsg::Layout::SIZE;
+    unsigned count = Min(Min(available / ServerShipStateMsg::Layout::SIZE, candidates_.Size()), 255u);
+    std::partial_sort(candidates_.Begin(), candidates_.Begin() + count, candidates_.End(), [](const Candidate& a, const Candidate& b) {
+        return a.priority_ > b.priority_;
+    });
+
+    header.numShips_ = (uint8_t)count;
+    msg_.Clear();
+    WriteMessage(msg_, header);
+    for (unsigned i = 0; i != count; ++i)
+    {
+        const Entity& entity = entities_[candidates_[i].entity_];
+        entity.state_->WriteState(msg_);
+        if (&entity != viewer)
+            client->accumulators_[entity.guid_].priority_ = 0;
+    }
+
+    // Losing a snapshot is fine, the next one has newer states anyway
+    GetSubsystem<MessageRouter>()->SendMessage(connection, CHANNEL_STATE, MSG_SERVER_SNAPSHOT, msg_);
+}
+
+// ----------------------------------------------------------------------------
+void SnapshotScheduler::AdaptBudget(Connection* connection, Client* client, float loss)
+{
+    NetworkClock* clock = GetSubsystem<NetworkClock>();
+    float roundTripTime = clock ? clock->GetRoundTripTime(connection) : 0.0f;
+    if (roundTripTime > 0)
+    {
+        if (client->minRoundTripTime_ == 0 || roundTripTime < client->minRoundTripTime_)
+            client->minRoundTripTime_ = roundTripTime;
+    }
+
+    bool queuing = roundTripTime > client->minRoundTripTime_ * 2 + QUEUE_DELAY;
+    if (loss > LOSS_THRESHOLD || queuing)
+        client->budget_ = Max(MIN_BUDGET, unsigned(client->budget_ * BUDGET_DECREASE));
+    else
+        client->budget_ = Min(MAX_BUDGET, client->budget_ + BUDGET_INCREASE);
+}
+
+// ----------------------------------------------------------------------------
+void SnapshotScheduler::ApplyShipStates(Scene* scene)
+{
+    UpdateRegistry* registry = GetSubsystem<UpdateRegistry>();
+    if (registry == nullptr || scene == nullptr)
+        return;
+
+    DispatchShipStates<ClientLocalShipState>(registry, scene, shipStates_);
+    DispatchShipStates<ClientRemoteShipState>(registry, scene, shipStates_);
+}
+
+// ----------------------------------------------------------------------------
+void SnapshotScheduler::SendFeedback(Connection* server)
+{
+    float loss = 1.0f - float(snapshotsReceived_) / snapshotsExpected_;
+    SnapshotFeedbackMsg feedback = {(uint8_t)(Clamp(loss, 0.0f, 1.0f) * 255.0f + 0.5f)};
+    msg_.Clear();
+    WriteMessage(msg_, feedback);
+    GetSubsystem<MessageRouter>()->SendMessage(server, CHANNEL_STATE, MSG_SNAPSHOT_FEEDBACK, msg_);
+
+    snapshotsReceived_ = 0;
+    snapshotsExpected_ = 0;
+}
+
+// ----------------------------------------------------------------------------
+void SnapshotScheduler::HandleNetworkUpdate(StringHash eventType, VariantMap& eventData)
+{
+    Network* network = GetSubsystem<Network>();
+
+    Connection* server = network->GetServerConnection();
+    if (server && ++ticksSinceFeedback_ >= FEEDBACK_TICKS && snapshotsExpected_ > 0)
+    {
+        SendFeedback(server);
+        ticksSinceFeedback_ = 0;
+    }
+
+    if (network->IsServerRunning() == false)
+        return;
+
+    URHO3D_PROFILE(SnapshotScheduler);
+
+    ++tick_;
+    GatherEntities();
+    for (Connection* connection : network->GetClientConnections())
+    {
+        if (connection->GetScene() == nullptr)
+            continue;  // Not in the game yet
+
+        SharedPtr<Client>& client = clients_[connection];
+        if (client.Null())
+        {
+            client = new Client;
+            client->budget_ = INITIAL_BUDGET;
+        }
+
+        // A client that doesn't receive any snapshots has nothing to report
+        if (++client->ticksSinceFeedback_ >= FEEDBACK_TICKS * MISSED_FEEDBACK_LIMIT)
+        {
+            AdaptBudget(connection, client, 1.0f);
+            client->ticksSinceFeedback_ -= FEEDBACK_TICKS;
+        }
+
+        SendSnapshot(connection, client);
+    }
+}
+
+// ----------------------------------------------------------------------------
+void SnapshotScheduler::HandleNetworkMessage(StringHash eventType, VariantMap& eventData)
+{
+    MessageView message(eventData);
+    Connection* connection = message.GetConnection();
+    if (connection == nullptr)
+        return;
+
+    // Client: keep track of how many snapshots didn't arrive and apply the
+    // rest
+    if (message.GetID() == MSG_SERVER_SNAPSHOT && connection == GetSubsystem<Network>()->GetServerConnection())
+    {
+        MemoryBuffer& buffer = message.GetBuffer();
+        SnapshotHeaderMsg header;
+        if (ReadMessage(buffer, &header) == false)
+            return;
+
+        if (receivedSnapshot_ == false)
+        {
+            snapshotsExpected_ += 1;
+            snapshotsReceived_ += 1;
+        }
+        else if (InputSampler::IsNewer(header.sequence_, lastSequence_))
+        {
+            snapshotsExpected_ += (uint16_t)(header.sequence_ - lastSequence_);
+            snapshotsReceived_ += 1;
+        }
+        else
+        {
+            return;  // Late or duplicate, it was already counted as lost
+        }
+
+        lastSequence_ = header.sequence_;
+        receivedSnapshot_ = true;
+
+        DecodeSnapshot(buffer.GetData(), buffer.GetSize(), &shipStates_);
+        ApplyShipStates(connection->GetScene());
+        return;
+    }
+
+    // Server: adapt the budget to the loss the client reported
+    if (message.GetID() == MSG_SNAPSHOT_FEEDBACK)
+    {
+        HashMap<Connection*, SharedPtr<Client>>::Iterator it = clients_.Find(connection);
+        SnapshotFeedbackMsg feedback;
+        if (it == clients_.End() || ReadMessage(message.GetBuffer(), &feedback) == false)
+            return;
+
+        it->second_->ticksSinceFeedback_ = 0;
+        AdaptBudget(connection, it->second_, feedback.loss_ / 255.0f);
+    }
+}
+
+// ----------------------------------------------------------------------------
+void SnapshotScheduler::HandleServerConnected(StringHash eventType, VariantMap& eventData)
+{
+    receivedSnapshot_ = false;
+    snapshotsReceived_ = 0;
+    snapshotsExpected_ = 0;
+    ticksSinceFeedback_ = 0;
+}
+
+// ----------------------------------------------------------------------------
+void SnapshotScheduler::HandleClientDisconnected(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ClientDisconnected;
+
+    clients_.Erase(static_cast<Connection*>(eventData[P_CONNECTION].GetPtr()));
+}
+
+}
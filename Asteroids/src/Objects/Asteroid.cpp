@@ -1,13 +0,0 @@
-#include "Asteroids/Objects/Asteroid.hpp"
-
-using namespace Urho3D;
-
-namespace Asteroids {
-
-// ----------------------------------------------------------------------------
-Asteroid::Asteroid(Context* context) :
-    SurfaceObject(context)
-{
-}
-
-}
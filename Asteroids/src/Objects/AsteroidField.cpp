@@ -0,0 +1,774 @@
+#include "Asteroids/AsteroidsLib.hpp"
+#include "Asteroids/Network/MessageRouter.hpp"
+#include "Asteroids/Network/MessageView.hpp"
+#include "Asteroids/Network/NetworkClock.hpp"
+#include "Asteroids/Network/Protocol.hpp"
+#include "Asteroids/Objects/AsteroidField.hpp"
+#include "Asteroids/Objects/MineController.hpp"
+#include "Asteroids/Objects/PhaserController.hpp"
+#include "Asteroids/Objects/ProceduralPlanet.hpp"
+#include "Asteroids/Util/SphereMath.hpp"
+#include "Asteroids/Util/UpdateRegistry.hpp"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Profiler.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/Geometry.h>
+#include <Urho3D/Graphics/Material.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/Network/Connection.h>
+#include <Urho3D/Network/Network.h>
+#include <Urho3D/Network/NetworkEvents.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Node.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <math.h>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+struct SizeInfo
+{
+    float radius_;
+    /// Drift speed range in degrees around the planet per second
+    float minDriftRate_;
+    float maxDriftRate_;
+    /// Tumble speed range in degrees per second
+    float minTumbleRate_;
+    float maxTumbleRate_;
+    /// Number of fragments of the next size the asteroid splits into
+    unsigned fragments_;
+};
+
+static const SizeInfo sizeInfos[AsteroidField::SIZE_COUNT] = {
+    {6.0f,  2,  4,  10,  30, 2},
+    {4.0f,  4,  7,  20,  60, 2},
+    {2.5f,  7, 11,  40,  90, 2},
+    {1.5f, 11, 16,  60, 150, 0}
+};
+
+/// Phasers and mines are treated as spheres of this radius
+static const float PROJECTILE_RADIUS = 0.5f;
+/// Any asteroid a projectile touches is in the projectile's grid cell or a neighbour
+static const float GRID_CELL_SIZE = sizeInfos[AsteroidField::SIZE_HUGE].radius_ + PROJECTILE_RADIUS;
+/// Asteroids per MSG_ASTEROID_SNAPSHOT, so a chunk fits into one packet
+static const unsigned SNAPSHOT_CHUNK_SIZE = 32;
+
+// ----------------------------------------------------------------------------
+// The field time is a double so trajectories don't get coarser the longer a
+// session runs. Wrapping in double precision keeps the angle small enough
+// for the float kernels.
+static inline float RotationAngle(float rate, double elapsed)
+{
+    return (float)fmod(rate * elapsed, 360.0);
+}
+
+// ----------------------------------------------------------------------------
+static inline unsigned HashCell(int x, int y, int z)
+{
+    return (unsigned)x * 73856093u ^ (unsigned)y * 19349663u ^ (unsigned)z * 83492791u;
+}
+
+// ----------------------------------------------------------------------------
+// Has to give the same results on every machine, so don't use Rand()
+static unsigned HashSeed(unsigned seed, unsigned index)
+{
+    unsigned h = seed ^ (index * 0x9E3779B9u);
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+}
+
+namespace {
+class SeedRandom
+{
+public:
+    explicit SeedRandom(unsigned seed) : state_(HashSeed(seed, 0) | 1) {}
+
+    float Next()
+    {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 17;
+        state_ ^= state_ << 5;
+        return (state_ >> 8) * (1.0f / 16777216.0f);
+    }
+
+    float Next(float min, float max) { return min + (max - min) * Next(); }
+
+    Vector3 NextAxis()
+    {
+        float z = Next(-1, 1);
+        float angle = Next(0, 360);
+        float r = sqrtf(1 - z * z);
+        return Vector3(r * Cos(angle), r * Sin(angle), z);
+    }
+
+private:
+    unsigned state_;
+};
+}
+
+// ----------------------------------------------------------------------------
+AsteroidField::AsteroidField(Context* context) :
+    Drawable(context, DRAWABLE_GEOMETRY),
+    modelRadius_(0),
+    boundsRadius_(0),
+    transformsFrame_(0),
+    time_(0),
+    anchorTime_(0),
+    anchorClock_(0),
+    nextID_(0),
+    snapshotNext_(0),
+    waveCount_(0),
+    gridDirty_(true),
+    seed_(0),
+    waveSize_(24),
+    defaultHeight_(60),
+    authority_(false),
+    synchronized_(false)
+{
+    SubscribeToEvent(E_NETWORKMESSAGE, URHO3D_HANDLER(AsteroidField, HandleNetworkMessage));
+    SubscribeToEvent(E_SERVERDISCONNECTED, URHO3D_HANDLER(AsteroidField, HandleServerDisconnected));
+}
+
+// ----------------------------------------------------------------------------
+void AsteroidField::RegisterObject(Context* context)
+{
+    context->RegisterFactory<AsteroidField>(ASTEROIDS_CATEGORY);
+
+    URHO3D_ACCESSOR_ATTRIBUTE("Is Enabled", IsEnabled, SetEnabled, bool, true, AM_DEFAULT);
+    URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Model", GetModelAttr, SetModelAttr, ResourceRef, ResourceRef(Model::GetTypeStatic()), AM_DEFAULT);
+    URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Material", GetMaterialAttr, SetMaterialAttr, ResourceRef, ResourceRef(Material::GetTypeStatic()), AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Seed", int, seed_, 0, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Wave Size", int, waveSize_, 24, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Default Height", float, defaultHeight_, 60.0f, AM_DEFAULT);
+    URHO3D_COPY_BASE_ATTRIBUTES(Drawable);
+}
+
+// ----------------------------------------------------------------------------
+void AsteroidField::SetAuthority(bool enable)
+{
+    authority_ = enable;
+    synchronized_ = enable;
+}
+
+// ----------------------------------------------------------------------------
+bool AsteroidField::IsAuthority() const
+{
+    return authority_;
+}
+
+// ----------------------------------------------------------------------------
+void AsteroidField::SetModel(Model* model)
+{
+    model_ = model;
+    modelRadius_ = 0;
+    if (model_)
+    {
+        // Same as ProjectileRenderer, instances rotate freely
+        const BoundingBox& box = model_->GetBoundingBox();
+        modelRadius_ = Max(box.min_.Length(), box.max_.Length());
+    }
+
+    UpdateBatchGeometry();
+}
+
+// ----------------------------------------------------------------------------
+void AsteroidField::SetMaterial(Material* material)
+{
+    material_ = material;
+    for (auto& batch : batches_)
+        batch.material_ = material_;
+}
+
+// ----------------------------------------------------------------------------
+void AsteroidField::SpawnWave(unsigned seed, unsigned count)
+{
+    if (authority_ == false)
+    {
+        URHO3D_LOGERROR("AsteroidField::SpawnWave() - Only the server can spawn asteroids");
+        return;
+    }
+
+    unsigned firstID = nextID_;
+    nextID_ += count;
+    ApplySpawnWave(seed, count, firstID, time_);
+
+    msg_.Clear();
+    WriteTime();
+    msg_.WriteUInt(seed);
+    msg_.WriteUInt(count);
+    msg_.WriteUInt(firstID);
+    Broadcast(MSG_ASTEROID_SPAWN);
+}
+
+// ----------------------------------------------------------------------------
+bool AsteroidField::Destroy(unsigned id)
+{
+    if (authority_ == false)
+    {
+        URHO3D_LOGERROR("AsteroidField::Destroy() - Only the server can destroy asteroids");
+        return false;
+    }
+
+    HashMap<unsigned, unsigned>::ConstIterator it = indexByID_.Find(id);
+    if (it == indexByID_.End())
+        return false;
+
+    unsigned firstChildID = nextID_;
+    nextID_ += sizeInfos[sizes_[it->second_]].fragments_;
+    ApplyDestroy(id, firstChildID, time_);
+
+    msg_.Clear();
+    WriteTime();
+    msg_.WriteUInt(id);
+    msg_.WriteUInt(firstChildID);
+    Broadcast(MSG_ASTEROID_DESTROY);
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+void AsteroidField::SendSnapshot(Connection* connection)
+{
+    if (authority_ == false)
+        return;
+
+    // Rotations are sent at full precision. Packing them would make the
+    // client's trajectories (and the fragments derived from them) drift
+    // away from the server's. That's 33 bytes per asteroid, so the field is
+    // split into chunks of a packet each. The router spreads them over
+    // several ticks, and spawns and destroys queue up behind them on the
+    // same channel.
+    MessageRouter* router = GetSubsystem<MessageRouter>();
+    unsigned total = ids_.Size();
+    unsigned begin = 0;
+    do
+    {
+        unsigned end = Min(begin + SNAPSHOT_CHUNK_SIZE, total);
+        msg_.Clear();
+        WriteTime();
+        msg_.WriteUInt(nextID_);
+        msg_.WriteUInt(total);
+        msg_.WriteUInt(begin);
+        msg_.WriteUInt(end - begin);
+        for (unsigned i = begin; i != end; ++i)
+        {
+            msg_.WriteUInt(ids_[i]);
+            msg_.WriteUInt(seeds_[i]);
+            msg_.WriteUByte(sizes_[i]);
+            msg_.WriteDouble(startTimes_[i]);
+            msg_.WriteQuaternion(startRotations_[i]);
+        }
+        router->SendMessage(connection, CHANNEL_BULK, MSG_ASTEROID_SNAPSHOT, msg_);
+        begin = end;
+    } while (begin < total);
+}
+
+// ----------------------------------------------------------------------------
+unsigned AsteroidField::GetNumAsteroids() const
+{
+    return ids_.Size();
+}
+
+// ----------------------------------------------------------------------------
+double AsteroidField::GetTime() const
+{
+    return time_;
+}
+
+// ----------------------------------------------------------------------------
+float AsteroidField::GetRadius(Size size)
+{
+    return sizeInfos[size].radius_;
+}
+
+// ----------------------------------------------------------------------------
+void AsteroidField::Simulate(float dt)
+{
+    URHO3D_PROFILE(AsteroidField);
+
+    time_ += dt;
+    UpdateAsteroids(0, ids_.Size(), ProceduralPlanet::GetScenePlanet(GetScene()));
+    gridDirty_ = true;
+
+    // Asteroids stay in a shell around the planet's center
+    float boundsRadius = 0;
+    for (unsigned i = 0; i != positions_.Size(); ++i)
+        boundsRadius = Max(boundsRadius, positions_[i].LengthSquared());
+    boundsRadius = sqrtf(boundsRadius) + sizeInfos[SIZE_HUGE].radius_;
+    if (boundsRadius != boundsRadius_)
+    {
+        boundsRadius_ = boundsRadius;
+        OnMarkedDirty(node_);
+    }
+}
+
+// ----------------------------------------------------------------------------
+void AsteroidField::UpdateBatches(const FrameInfo& frame)
+{
+    const BoundingBox& worldBoundingBox = GetWorldBoundingBox();
+    distance_ = frame.camera_->GetDistance(worldBoundingBox.Center());
+
+    // Tumbling is only visual, so it's only evaluated when drawing. Once per
+    // frame is enough even if there are several views.
+    if (transformsFrame_ != frame.frameNumber_ || worldTransforms_.Size() != ids_.Size())
+    {
+        transformsFrame_ = frame.frameNumber_;
+        unsigned count = ids_.Size();
+        worldTransforms_.Resize(count);
+        angles_.Resize(count);
+        tumbledRotations_.Resize(count);
+        for (unsigned i = 0; i != count; ++i)
+            angles_[i] = RotationAngle(tumbleRates_[i], time_ - startTimes_[i]);
+        if (count)
+            RotateAxisAngle(&tumbledRotations_[0], &rotations_[0], &tumbleAxes_[0], &angles_[0], count);
+
+        float scale = modelRadius_ > 0 ? 1.0f / modelRadius_ : 1.0f;
+        for (unsigned i = 0; i != count; ++i)
+            worldTransforms_[i] = Matrix3x4(positions_[i], tumbledRotations_[i], sizeInfos[sizes_[i]].radius_ * scale);
+    }
+
+    for (auto& batch : batches_)
+    {
+        batch.distance_ = distance_;
+        batch.worldTransform_ = worldTransforms_.Size() ? &worldTransforms_[0] : &Matrix3x4::IDENTITY;
+        batch.numWorldTransforms_ = worldTransforms_.Size();
+    }
+}
+
+// ----------------------------------------------------------------------------
+ResourceRef AsteroidField::GetModelAttr() const
+{
+    return GetResourceRef(model_, Model::GetTypeStatic());
+}
+
+// ----------------------------------------------------------------------------
+void AsteroidField::SetModelAttr(const ResourceRef& value)
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    SetModel(cache->GetResource<Model>(value.name_));
+}
+
+// ----------------------------------------------------------------------------
+ResourceRef AsteroidField::GetMaterialAttr() const
+{
+    return GetResourceRef(material_, Material::GetTypeStatic());
+}
+
+// ----------------------------------------------------------------------------
+void AsteroidField::SetMaterialAttr(const ResourceRef& value)
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    SetMaterial(cache->GetResource<Material>(value.name_));
+}
+
+// ----------------------------------------------------------------------------
+void AsteroidField::OnSceneSet(Scene* scene)
+{
+    Drawable::OnSceneSet(scene);
+
+    UpdateRegistry* registry = GetSubsystem<UpdateRegistry>();
+    if (registry == nullptr)
+        return;
+
+    if (scene)
+        registry->Add(this, UpdateRegistry::ASTEROIDS);
+    else
+        registry->Remove(this);
+}
+
+// ----------------------------------------------------------------------------
+void AsteroidField::OnWorldBoundingBoxUpdate()
+{
+    // Positions are already in world space
+    worldBoundingBox_ = BoundingBox(-Vector3::ONE * boundsRadius_, Vector3::ONE * boundsRadius_);
+}
+
+// ----------------------------------------------------------------------------
+void AsteroidField::Update(float dt)
+{
+    // Clients follow the server's clock instead of their own frame times,
+    // so their trajectories don't lag behind by the one way delay
+    NetworkClock* clock = GetSubsystem<NetworkClock>();
+    if (authority_ == false && synchronized_ && clock && clock->IsSynchronized())
+        dt = (float)Max(anchorTime_ + (clock->GetServerTime() - anchorClock_) - time_, 0.0);
+
+    Simulate(dt);
+
+    if (authority_ == false)
+        return;
+
+    UpdateRegistry* registry = GetSubsystem<UpdateRegistry>();
+    CollideProjectiles<PhaserController>(registry);
+    CollideProjectiles<MineController>(registry);
+
+    if (ids_.Size() == 0 && waveSize_ > 0)
+        SpawnWave(HashSeed((unsigned)seed_, waveCount_++), (unsigned)waveSize_);
+}
+
+// ----------------------------------------------------------------------------
+void AsteroidField::Clear()
+{
+    ids_.Clear();
+    seeds_.Clear();
+    sizes_.Clear();
+    startTimes_.Clear();
+    startRotations_.Clear();
+    driftAxes_.Clear();
+    driftRates_.Clear();
+    tumbleAxes_.Clear();
+    tumbleRates_.Clear();
+    rotations_.Clear();
+    positions_.Clear();
+    indexByID_.Clear();
+    gridDirty_ = true;
+}
+
+// ----------------------------------------------------------------------------
+void AsteroidField::Add(unsigned id, unsigned seed, Size size, double startTime, const Quaternion& startRotation)
+{
+    const SizeInfo& info = sizeInfos[size];
+    SeedRandom random(seed);
+
+    // The drift axis lies in the pivot's XZ plane, which makes the asteroid
+    // travel along a great circle in the direction of the heading
+    float heading = random.Next(0, 360);
+    Vector3 driftAxis(Cos(heading), 0, Sin(heading));
+
+    unsigned index = ids_.Size();
+    ids_.Push(id);
+    seeds_.Push(seed);
+    sizes_.Push((unsigned char)size);
+    startTimes_.Push(startTime);
+    startRotations_.Push(startRotation);
+    driftAxes_.Push(driftAxis);
+    driftRates_.Push(random.Next(info.minDriftRate_, info.maxDriftRate_));
+    tumbleAxes_.Push(random.NextAxis());
+    tumbleRates_.Push(random.Next(info.minTumbleRate_, info.maxTumbleRate_));
+    rotations_.Push(startRotation);
+    positions_.Push(Vector3::ZERO);
+    indexByID_[id] = index;
+    gridDirty_ = true;
+
+    UpdateAsteroids(index, index + 1, ProceduralPlanet::GetScenePlanet(GetScene()));
+}
+
+// ----------------------------------------------------------------------------
+void AsteroidField::RemoveAt(unsigned index)
+{
+    // Swap with the last one to keep the arrays packed
+    indexByID_.Erase(ids_[index]);
+    unsigned last = ids_.Size() - 1;
+    if (index != last)
+        indexByID_[ids_[last]] = index;
+
+    ids_.EraseSwap(index);
+    seeds_.EraseSwap(index);
+    sizes_.EraseSwap(index);
+    startTimes_.EraseSwap(index);
+    startRotations_.EraseSwap(index);
+    driftAxes_.EraseSwap(index);
+    driftRates_.EraseSwap(index);
+    tumbleAxes_.EraseSwap(index);
+    tumbleRates_.EraseSwap(index);
+    rotations_.EraseSwap(index);
+    positions_.EraseSwap(index);
+    gridDirty_ = true;
+}
+
+// ----------------------------------------------------------------------------
+void AsteroidField::ApplySpawnWave(unsigned seed, unsigned count, unsigned firstID, double time)
+{
+    for (unsigned i = 0; i != count; ++i)
+    {
+        // Uniformly distributed orientation (Shoemake)
+        unsigned asteroidSeed = HashSeed(seed, i);
+        SeedRandom random(~asteroidSeed);
+        float u1 = random.Next();
+        float u2 = random.Next(0, 360);
+        float u3 = random.Next(0, 360);
+        float a = sqrtf(1 - u1);
+        float b = sqrtf(u1);
+        Quaternion rotation(b * Cos(u3), a * Sin(u2), a * Cos(u2), b * Sin(u3));
+
+        Add(firstID + i, asteroidSeed, SIZE_HUGE, time, rotation);
+    }
+}
+
+// ----------------------------------------------------------------------------
+bool AsteroidField::ApplyDestroy(unsigned id, unsigned firstChildID, double time)
+{
+    HashMap<unsigned, unsigned>::ConstIterator it = indexByID_.Find(id);
+    if (it == indexByID_.End())
+        return false;
+
+    // Fragments start where the parent was at the time it was hit, which
+    // both sides can calculate from the parent's spawn parameters
+    unsigned index = it->second_;
+    Quaternion rotation;
+    float angle = RotationAngle(driftRates_[index], time - startTimes_[index]);
+    RotateAxisAngle(&rotation, &startRotations_[index], &driftAxes_[index], &angle, 1);
+    unsigned seed = seeds_[index];
+    unsigned size = sizes_[index];
+    RemoveAt(index);
+
+    for (unsigned i = 0; i != sizeInfos[size].fragments_; ++i)
+        Add(firstChildID + i, HashSeed(seed, i + 1), (Size)(size + 1), time, rotation);
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+void AsteroidField::UpdateAsteroids(unsigned begin, unsigned end, ProceduralPlanet* planet)
+{
+    if (begin == end)
+        return;
+
+    angles_.Resize(end - begin);
+    for (unsigned i = begin; i != end; ++i)
+        angles_[i - begin] = RotationAngle(driftRates_[i], time_ - startTimes_[i]);
+    RotateAxisAngle(&rotations_[begin], &startRotations_[begin], &driftAxes_[begin], &angles_[0], end - begin);
+
+    for (unsigned i = begin; i != end; ++i)
+    {
+        Vector3 up = rotations_[i] * Vector3::UP;
+        float height = planet ? planet->GetSurfaceRadius(up) : defaultHeight_;
+        positions_[i] = up * (height + sizeInfos[sizes_[i]].radius_);
+    }
+}
+
+// ----------------------------------------------------------------------------
+void AsteroidField::BuildGrid()
+{
+    // Counting sort of the asteroids by hashed cell. Collisions between
+    // cells only cost a few extra distance checks.
+    unsigned count = positions_.Size();
+    unsigned numBuckets = NextPowerOfTwo(Max(count, 1u));
+    unsigned mask = numBuckets - 1;
+    gridStarts_.Resize(numBuckets + 1);
+    gridEntries_.Resize(count);
+    gridBuckets_.Resize(count);
+    for (unsigned i = 0; i != numBuckets + 1; ++i)
+        gridStarts_[i] = 0;
+
+    const float scale = 1.0f / GRID_CELL_SIZE;
+    for (unsigned i = 0; i != count; ++i)
+    {
+        const Vector3& p = positions_[i];
+        unsigned bucket = HashCell(FloorToInt(p.x_ * scale), FloorToInt(p.y_ * scale), FloorToInt(p.z_ * scale)) & mask;
+        gridBuckets_[i] = bucket;
+        gridStarts_[bucket + 1]++;
+    }
+    for (unsigned i = 0; i != numBuckets; ++i)
+        gridStarts_[i + 1] += gridStarts_[i];
+
+    // Fill each bucket from the back so gridStarts_ ends up pointing at the
+    // first entry again
+    for (unsigned i = count; i-- != 0; )
+        gridEntries_[--gridStarts_[gridBuckets_[i] + 1]] = i;
+    for (unsigned i = 0; i != numBuckets; ++i)
+        gridStarts_[i] = gridStarts_[i + 1];
+    gridStarts_[numBuckets] = count;
+
+    gridDirty_ = false;
+}
+
+// ----------------------------------------------------------------------------
+int AsteroidField::FindHit(const Vector3& position) const
+{
+    const float scale = 1.0f / GRID_CELL_SIZE;
+    const unsigned mask = gridStarts_.Size() - 2;
+    int cx = FloorToInt(position.x_ * scale);
+    int cy = FloorToInt(position.y_ * scale);
+    int cz = FloorToInt(position.z_ * scale);
+
+    for (int z = cz - 1; z <= cz + 1; ++z)
+        for (int y = cy - 1; y <= cy + 1; ++y)
+            for (int x = cx - 1; x <= cx + 1; ++x)
+            {
+                unsigned bucket = HashCell(x, y, z) & mask;
+                for (unsigned e = gridStarts_[bucket]; e != gridStarts_[bucket + 1]; ++e)
+                {
+                    unsigned i = gridEntries_[e];
+                    float radius = sizeInfos[sizes_[i]].radius_ + PROJECTILE_RADIUS;
+                    if ((positions_[i] - position).LengthSquared() <= radius * radius)
+                        return (int)i;
+                }
+            }
+
+    return -1;
+}
+
+// ----------------------------------------------------------------------------
+template <class T>
+void AsteroidField::CollideProjectiles(UpdateRegistry* registry)
+{
+    if (registry == nullptr)
+        return;
+
+    Scene* scene = GetScene();
+    const PODVector<void*>& objects = registry->GetObjects<T>();
+    for (unsigned p = 0; p != objects.Size(); ++p)
+    {
+        T* projectile = static_cast<T*>(objects[p]);
+        if (projectile == nullptr || projectile->GetScene() != scene)
+            continue;
+
+        // Hits are rare, so rebuilding after one is cheap overall
+        if (gridDirty_)
+            BuildGrid();
+
+        int hit = FindHit(projectile->GetWorldPosition());
+        if (hit < 0)
+            continue;
+
+        // Removing the node leaves a hole in the registry's array, so
+        // the loop can continue safely
+        Destroy(ids_[hit]);
+        projectile->Destroy();
+    }
+}
+
+// ----------------------------------------------------------------------------
+void AsteroidField::WriteTime()
+{
+    // The server's clock tells the client how long the message was under
+    // way, see Update()
+    NetworkClock* clock = GetSubsystem<NetworkClock>();
+    msg_.WriteDouble(time_);
+    msg_.WriteInt64(clock ? clock->GetLocalTime() : 0);
+}
+
+// ----------------------------------------------------------------------------
+void AsteroidField::Broadcast(int msgID)
+{
+    // There is no router when the field is simulated offline (asteroids-bench).
+    // Spawns and destroys go on the same channel as the snapshot, because
+    // the client drops everything that arrives before the snapshot.
+    MessageRouter* router = GetSubsystem<MessageRouter>();
+    if (router)
+        router->BroadcastMessage(CHANNEL_BULK, msgID, msg_);
+}
+
+// ----------------------------------------------------------------------------
+void AsteroidField::UpdateBatchGeometry()
+{
+    batches_.Clear();
+    if (model_ == nullptr)
+        return;
+
+    const Vector<Vector<SharedPtr<Geometry>>>& geometries = model_->GetGeometries();
+    batches_.Resize(geometries.Size());
+    for (unsigned i = 0; i != geometries.Size(); ++i)
+    {
+        batches_[i].geometry_ = geometries[i][0];
+        batches_[i].material_ = material_;
+    }
+}
+
+// ----------------------------------------------------------------------------
+void AsteroidField::HandleNetworkMessage(StringHash eventType, VariantMap& eventData)
+{
+    if (authority_)
+        return;
+
+    MessageView message(eventData);
+    int id = message.GetID();
+    if (id != MSG_ASTEROID_SNAPSHOT && id != MSG_ASTEROID_SPAWN && id != MSG_ASTEROID_DESTROY)
+        return;
+
+    // When hosting from the client, the server's connections receive
+    // messages too. Only the server gets to tell us what happens.
+    Network* network = GetSubsystem<Network>();
+    if (message.GetConnection() == nullptr || message.GetConnection() != network->GetServerConnection())
+        return;
+
+    MemoryBuffer& buffer = message.GetBuffer();
+    double time = buffer.ReadDouble();
+    long long sendTime = buffer.ReadInt64();
+
+    if (id == MSG_ASTEROID_SNAPSHOT)
+    {
+        unsigned nextID = buffer.ReadUInt();
+        unsigned total = buffer.ReadUInt();
+        unsigned begin = buffer.ReadUInt();
+        unsigned count = buffer.ReadUInt();
+
+        // The first chunk starts over, the rest are appended. Nothing else
+        // arrives in between, the server sends all chunks at once.
+        if (begin == 0)
+        {
+            Clear();
+            synchronized_ = false;
+            time_ = time;
+            anchorTime_ = time;
+            anchorClock_ = sendTime * 1e-6;
+            nextID_ = nextID;
+        }
+        else if (synchronized_ || begin != snapshotNext_)
+        {
+            return;
+        }
+
+        for (unsigned i = 0; i != count && buffer.IsEof() == false; ++i)
+        {
+            unsigned asteroidID = buffer.ReadUInt();
+            unsigned seed = buffer.ReadUInt();
+            unsigned size = buffer.ReadUByte();
+            double startTime = buffer.ReadDouble();
+            Quaternion startRotation = buffer.ReadQuaternion();
+            if (size < SIZE_COUNT)
+                Add(asteroidID, seed, (Size)size, startTime, startRotation);
+        }
+
+        snapshotNext_ = begin + count;
+        if (snapshotNext_ >= total)
+            synchronized_ = true;
+        return;
+    }
+
+    // Everything before the snapshot is already part of it
+    if (synchronized_ == false)
+        return;
+
+    // Until the clock is synchronized, at least don't fall behind
+    time_ = Max(time_, time);
+    anchorTime_ = time;
+    anchorClock_ = sendTime * 1e-6;
+
+    if (id == MSG_ASTEROID_SPAWN)
+    {
+        unsigned seed = buffer.ReadUInt();
+        unsigned count = buffer.ReadUInt();
+        unsigned firstID = buffer.ReadUInt();
+        ApplySpawnWave(seed, count, firstID, time);
+        nextID_ = Max(nextID_, firstID + count);
+    }
+    else
+    {
+        unsigned asteroidID = buffer.ReadUInt();
+        unsigned firstChildID = buffer.ReadUInt();
+        if (ApplyDestroy(asteroidID, firstChildID, time) == false)
+            URHO3D_LOGWARNINGF("Server destroyed asteroid %u, which doesn't exist", asteroidID);
+    }
+}
+
+// ----------------------------------------------------------------------------
+void AsteroidField::HandleServerDisconnected(StringHash eventType, VariantMap& eventData)
+{
+    if (authority_)
+        return;
+
+    Clear();
+    synchronized_ = false;
+}
+
+}
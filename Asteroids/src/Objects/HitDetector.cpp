@@ -0,0 +1,297 @@
+#include "Asteroids/AsteroidsLib.hpp"
+#include "Asteroids/Network/MessageRouter.hpp"
+#include "Asteroids/Network/MessageView.hpp"
+#include "Asteroids/Network/Messages.hpp"
+#include "Asteroids/Objects/HitDetector.hpp"
+#include "Asteroids/Objects/MineController.hpp"
+#include "Asteroids/Objects/PhaserController.hpp"
+#include "Asteroids/Player/PlayerEvents.hpp"
+#include "Asteroids/Player/ServerShipState.hpp"
+#include "Asteroids/Player/ShipController.hpp"
+#include "Asteroids/Util/UpdateRegistry.hpp"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Profiler.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/Network/Network.h>
+#include <Urho3D/Network/NetworkEvents.h>
+#include <Urho3D/Scene/Node.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+static const unsigned char HIT_DESTROYED_FLAG = 0x80;
+static const unsigned MAX_HITS_PER_MESSAGE = 255;
+
+// ----------------------------------------------------------------------------
+/*!
+ * Both spheres move linearly from *0 to *1 during the step. Returns true and
+ * the time of first contact (0..1) if they touch at any point of the step.
+ */
+static bool SweepSpheres(const Vector3& a0, const Vector3& a1,
+                         const Vector3& b0, const Vector3& b1,
+                         float radius, float* time)
+{
+    // Solve |d + v*t| = radius, with b's motion relative to a
+    Vector3 d = b0 - a0;
+    Vector3 v = (b1 - b0) - (a1 - a0);
+    float c = d.LengthSquared() - radius * radius;
+    if (c <= 0)
+    {
+        *time = 0;
+        return true;
+    }
+
+    float b = d.DotProduct(v);
+    float a = v.LengthSquared();
+    if (b >= 0 || a < M_EPSILON)
+        return false;  // Moving apart, or not moving relative to each other
+
+    float discriminant = b * b - a * c;
+    if (discriminant < 0)
+        return false;
+
+    float t = (-b - sqrtf(discriminant)) / a;
+    if (t > 1)
+        return false;
+
+    *time = t;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+static void GetStep(const SurfaceObject* object, float dt, Vector3* start, Vector3* end)
+{
+    *start = object->GetPreviousWorldPosition();
+    *end = object->GetWorldPosition();
+}
+
+// ----------------------------------------------------------------------------
+static void GetStep(const PhaserController* phaser, float dt, Vector3* start, Vector3* end)
+{
+    float age = phaser->GetAge();
+    *start = phaser->GetWorldPositionAt(Max(age - dt, 0.0f));
+    *end = phaser->GetWorldPositionAt(age);
+}
+
+// ----------------------------------------------------------------------------
+HitDetector::HitDetector(Context* context) :
+    Component(context),
+    shipRadius_(1.5f),
+    phaserRadius_(0.3f),
+    mineRadius_(0.5f),
+    phaserDamage_(10),
+    mineDamage_(40),
+    authority_(false)
+{
+    SubscribeToEvent(E_NETWORKMESSAGE, URHO3D_HANDLER(HitDetector, HandleNetworkMessage));
+}
+
+// ----------------------------------------------------------------------------
+void HitDetector::RegisterObject(Context* context)
+{
+    context->RegisterFactory<HitDetector>(ASTEROIDS_CATEGORY);
+
+    URHO3D_ATTRIBUTE("Ship Radius", float, shipRadius_, 1.5f, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Phaser Radius", float, phaserRadius_, 0.3f, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Mine Radius", float, mineRadius_, 0.5f, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Phaser Damage", float, phaserDamage_, 10.0f, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Mine Damage", float, mineDamage_, 40.0f, AM_DEFAULT);
+}
+
+// ----------------------------------------------------------------------------
+void HitDetector::SetAuthority(bool enable)
+{
+    authority_ = enable;
+}
+
+// ----------------------------------------------------------------------------
+bool HitDetector::IsAuthority() const
+{
+    return authority_;
+}
+
+// ----------------------------------------------------------------------------
+void HitDetector::OnSceneSet(Scene* scene)
+{
+    UpdateRegistry* registry = GetSubsystem<UpdateRegistry>();
+    if (registry == nullptr)
+        return;
+
+    if (scene)
+        registry->Add(this, UpdateRegistry::HITS);
+    else
+        registry->Remove(this);
+}
+
+// ----------------------------------------------------------------------------
+void HitDetector::Update(float dt)
+{
+    if (authority_ == false)
+        return;
+
+    URHO3D_PROFILE(HitDetector);
+
+    UpdateRegistry* registry = GetSubsystem<UpdateRegistry>();
+    GatherShips(registry);
+    if (shipStates_.Size() == 0)
+        return;
+
+    hits_.Clear();
+    SweepProjectiles<PhaserController>(registry, WEAPON_PHASER, phaserRadius_, dt);
+    SweepProjectiles<MineController>(registry, WEAPON_MINE, mineRadius_, dt);
+    ApplyHits();
+}
+
+// ----------------------------------------------------------------------------
+void HitDetector::GatherShips(UpdateRegistry* registry)
+{
+    shipStates_.Clear();
+    shipGUIDs_.Clear();
+    shipStarts_.Clear();
+    shipEnds_.Clear();
+
+    // The registry is shared with the client when hosting, only look at the
+    // ships in our own scene
+    Scene* scene = GetScene();
+    const PODVector<void*>& states = registry->GetObjects<ServerShipState>();
+    for (unsigned i = 0; i != states.Size(); ++i)
+    {
+        ServerShipState* state = static_cast<ServerShipState*>(states[i]);
+        if (state == nullptr || state->GetScene() != scene || state->GetUser() == nullptr)
+            continue;
+
+        ShipController* ship = state->GetComponent<ShipController>();
+        if (ship == nullptr)
+            continue;
+
+        shipStates_.Push(state);
+        shipGUIDs_.Push(state->GetUser()->GetGUID());
+        shipStarts_.Push(ship->GetPreviousWorldPosition());
+        shipEnds_.Push(ship->GetWorldPosition());
+    }
+}
+
+// ----------------------------------------------------------------------------
+template <class T>
+void HitDetector::SweepProjectiles(UpdateRegistry* registry, Weapon weapon, float radius, float dt)
+{
+    Scene* scene = GetScene();
+    float hitRadius = radius + shipRadius_;
+    const PODVector<void*>& projectiles = registry->GetObjects<T>();
+    for (unsigned p = 0; p != projectiles.Size(); ++p)
+    {
+        T* projectile = static_cast<T*>(projectiles[p]);
+        if (projectile == nullptr || projectile->GetScene() != scene)
+            continue;
+
+        Vector3 start, end;
+        GetStep(projectile, dt, &start, &end);
+        User::GUID owner = projectile->GetOwner();
+
+        // A projectile can only hit one ship, the one it touches first
+        unsigned hitShip = M_MAX_UNSIGNED;
+        float hitTime = 2;
+        for (unsigned s = 0; s != shipStates_.Size(); ++s)
+        {
+            float time;
+            if (shipGUIDs_[s] == owner)
+                continue;
+            if (SweepSpheres(shipStarts_[s], shipEnds_[s], start, end, hitRadius, &time) && time < hitTime)
+            {
+                hitShip = s;
+                hitTime = time;
+            }
+        }
+
+        if (hitShip != M_MAX_UNSIGNED)
+        {
+            Hit hit = {projectile, hitShip, owner, (unsigned char)weapon};
+            hits_.Push(hit);
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+void HitDetector::ApplyHits()
+{
+    if (hits_.Size() == 0)
+        return;
+
+    // The count is a byte, so a busy tick takes several messages
+    MessageRouter* router = GetSubsystem<MessageRouter>();
+    for (unsigned begin = 0; begin < hits_.Size(); begin += MAX_HITS_PER_MESSAGE)
+    {
+        unsigned end = Min(begin + MAX_HITS_PER_MESSAGE, hits_.Size());
+        ShipHitHeaderMsg header = {(uint8_t)(end - begin)};
+        msg_.Clear();
+        WriteMessage(msg_, header);
+        for (unsigned i = begin; i != end; ++i)
+        {
+            const Hit& hit = hits_[i];
+            ServerShipState* state = shipStates_[hit.ship_];
+            float damage = hit.weapon_ == WEAPON_MINE ? mineDamage_ : phaserDamage_;
+            bool destroyed = state->ApplyDamage(damage);
+
+            // 7 bytes per hit
+            ShipHitMsg msg;
+            msg.guid_ = shipGUIDs_[hit.ship_];
+            msg.attacker_ = hit.attacker_;
+            msg.flags_ = (uint8_t)(hit.weapon_ | (destroyed ? HIT_DESTROYED_FLAG : 0));
+            msg.health_ = (uint16_t)Clamp(state->GetHealth(), 0.0f, 65535.0f);
+            WriteMessage(msg_, msg);
+
+            // Removing the node leaves a hole in the registry's array, which
+            // is fine while the registry is updating
+            if (hit.weapon_ == WEAPON_MINE)
+                static_cast<MineController*>(hit.projectile_)->Destroy();
+            else
+                static_cast<PhaserController*>(hit.projectile_)->Destroy();
+        }
+
+        router->BroadcastMessage(CHANNEL_EVENTS, MSG_SHIP_HIT, msg_);
+    }
+}
+
+// ----------------------------------------------------------------------------
+void HitDetector::HandleNetworkMessage(StringHash eventType, VariantMap& eventData)
+{
+    if (authority_)
+        return;
+
+    MessageView message(eventData);
+    if (message.GetID() != MSG_SHIP_HIT)
+        return;
+
+    Network* network = GetSubsystem<Network>();
+    if (message.GetConnection() == nullptr || message.GetConnection() != network->GetServerConnection())
+        return;
+
+    MemoryBuffer& buffer = message.GetBuffer();
+    ShipHitHeaderMsg header;
+    if (ReadMessage(buffer, &header) == false)
+        return;
+
+    for (unsigned i = 0; i != header.numHits_; ++i)
+    {
+        ShipHitMsg msg;
+        if (ReadMessage(buffer, &msg) == false)
+            return;
+
+        using namespace ShipHit;
+        VariantMap& data = GetEventDataMap();
+        data[P_GUID] = msg.guid_;
+        data[P_ATTACKER] = msg.attacker_;
+        data[P_WEAPON] = msg.flags_ & ~HIT_DESTROYED_FLAG;
+        data[P_HEALTH] = (float)msg.health_;
+        data[P_DESTROYED] = (msg.flags_ & HIT_DESTROYED_FLAG) != 0;
+        SendEvent(E_SHIPHIT, data);
+
+        URHO3D_LOGDEBUGF("Ship of user %d was hit by user %d, health %d", msg.guid_, msg.attacker_, msg.health_);
+    }
+}
+
+}
@@ -1,21 +1,28 @@
 #include "Asteroids/AsteroidsLib.hpp"
 #include "Asteroids/Objects/MineController.hpp"
+#include "Asteroids/Util/Metrics.hpp"
+#include "Asteroids/Util/SphereMath.hpp"
+#include "Asteroids/Util/UpdateRegistry.hpp"
 
 #include <Urho3D/Core/Context.h>
-#include <Urho3D/Core/CoreEvents.h>
 #include <Urho3D/Scene/Node.h>
 
 using namespace Urho3D;
 
 namespace Asteroids {
 
+// Below this speed (units per second) a mine is considered to be at rest.
+// Deceleration is exponential, so the velocity would never reach 0 on its own.
+static const float REST_SPEED = 0.5f;
+
 // ----------------------------------------------------------------------------
 MineController::MineController(Context* context) :
     SurfaceObject(context),
     deceleration_(0),
-    life_(std::numeric_limits<float>::max())
+    expiryTimer_(TimerWheel::INVALID_TIMER),
+    owner_(User::INVALID_GUID),
+    atRest_(false)
 {
-    SubscribeToEvent(E_UPDATE, URHO3D_HANDLER(MineController, HandleUpdate));
 }
 
 // ----------------------------------------------------------------------------
@@ -35,6 +42,11 @@ void MineController::SetVelocity(const Vector2& velocity)
 {
     velocity_ = velocity;
     node_->SetRotation(Quaternion(0, 2 * M_PI * Random(), 0));
+
+    UpdateRegistry* registry = GetSubsystem<UpdateRegistry>();
+    if (atRest_ && registry)
+        registry->Wake(this);
+    atRest_ = false;
 }
 
 // ----------------------------------------------------------------------------
@@ -46,32 +58,88 @@ void MineController::SetDeceleration(float deceleration)
 // ----------------------------------------------------------------------------
 void MineController::SetLife(float life)
 {
-    life_ = life;
+    TimerWheel* timers = GetSubsystem<TimerWheel>();
+    if (timers == nullptr || GetScene() == nullptr)
+        return;
+
+    timers->Cancel(expiryTimer_);
+    expiryTimer_ = timers->Schedule<MineController, &MineController::HandleExpired>(this, life);
+}
+
+// ----------------------------------------------------------------------------
+bool MineController::IsAtRest() const
+{
+    return atRest_;
+}
+
+// ----------------------------------------------------------------------------
+void MineController::SetOwner(User::GUID owner)
+{
+    owner_ = owner;
+}
+
+// ----------------------------------------------------------------------------
+User::GUID MineController::GetOwner() const
+{
+    return owner_;
 }
 
 // ----------------------------------------------------------------------------
-void MineController::HandleUpdate(StringHash eventType, VariantMap& eventData)
+void MineController::Destroy()
 {
-    using namespace Update;
-    float dt = eventData[P_TIMESTEP].GetFloat();
+    node_->GetParent()->Remove();
+}
 
+// ----------------------------------------------------------------------------
+void MineController::OnSceneSet(Scene* scene)
+{
+    Metrics* metrics = GetSubsystem<Metrics>();
+    if (metrics)
+        metrics->AddLiveProjectiles(scene ? 1 : -1);
+
+    TimerWheel* timers = GetSubsystem<TimerWheel>();
+    if (timers && scene == nullptr)
+    {
+        timers->Cancel(expiryTimer_);
+        expiryTimer_ = TimerWheel::INVALID_TIMER;
+    }
+
+    UpdateRegistry* registry = GetSubsystem<UpdateRegistry>();
+    if (registry == nullptr)
+        return;
+
+    atRest_ = false;
+    if (scene)
+        registry->Add(this, UpdateRegistry::PROJECTILES);
+    else
+        registry->Remove(this);
+}
+
+// ----------------------------------------------------------------------------
+void MineController::Update(float dt)
+{
     // Decelerate mine until it comes to a halt
-    float vlength = velocity_.Length();
-    float decay = vlength * dt * deceleration_;
-    decay = Min(decay, vlength);  // In case of very large timesteps
-    float angleOfTrajectory = Atan2(velocity_.y_, velocity_.x_);
-    velocity_.x_ -= Cos(angleOfTrajectory) * decay;
-    velocity_.y_ -= Sin(angleOfTrajectory) * decay;
+    velocity_ = DecayVelocity(velocity_, deceleration_, dt);
 
     UpdatePosition(velocity_, dt);
     UpdatePlanetHeight();
     node_->SetPosition(Vector3(0, GetOffsetFromPlanetCenter(), 0));
 
-    life_ -= dt;
-    if (life_ < 0)
+    // The terrain doesn't change, so a mine that stopped moving has nothing
+    // left to do until someone gives it a new velocity
+    if (velocity_.LengthSquared() < REST_SPEED * REST_SPEED)
     {
-        node_->GetParent()->Remove();
+        velocity_ = Vector2::ZERO;
+        atRest_ = true;
+        GetSubsystem<UpdateRegistry>()->Sleep(this);
     }
 }
 
+// ----------------------------------------------------------------------------
+void MineController::HandleExpired()
+{
+    expiryTimer_ = TimerWheel::INVALID_TIMER;
+    node_->GetParent()->Remove();
+}
+
 }
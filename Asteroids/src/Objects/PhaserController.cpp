@@ -1,12 +1,11 @@
 #include "Asteroids/AsteroidsLib.hpp"
 #include "Asteroids/Objects/PhaserController.hpp"
+#include "Asteroids/Objects/PhaserReplicator.hpp"
+#include "Asteroids/Objects/ProceduralPlanet.hpp"
+#include "Asteroids/Util/Metrics.hpp"
+#include "Asteroids/Util/UpdateRegistry.hpp"
 
 #include <Urho3D/Core/Context.h>
-#include <Urho3D/Core/CoreEvents.h>
-#include <Urho3D/Graphics/Model.h>
-#include <Urho3D/Graphics/Material.h>
-#include <Urho3D/Graphics/StaticModel.h>
-#include <Urho3D/Resource/ResourceCache.h>
 #include <Urho3D/Scene/Scene.h>
 #include <Urho3D/Scene/Node.h>
 #include <limits>
@@ -17,10 +16,16 @@ namespace Asteroids {
 
 // ----------------------------------------------------------------------------
 PhaserController::PhaserController(Context* context) :
-    SurfaceObject(context),
-    life_(std::numeric_limits<float>::max())
+    Component(context),
+    axis_(Vector3::RIGHT),
+    angularSpeed_(0),
+    radius_(1),
+    startTime_(0),
+    life_(std::numeric_limits<float>::max()),
+    networkID_(0),
+    expiryTimer_(TimerWheel::INVALID_TIMER),
+    owner_(User::INVALID_GUID)
 {
-    SubscribeToEvent(E_UPDATE, URHO3D_HANDLER(PhaserController, HandleUpdate));
 }
 
 // ----------------------------------------------------------------------------
@@ -30,16 +35,44 @@ void PhaserController::RegisterObject(Context* context)
 }
 
 // ----------------------------------------------------------------------------
-void PhaserController::SetVelocity(const Vector2& velocity)
+void PhaserController::Launch(const Quaternion& pivotRotation, const Vector2& velocity, float radius, float offset)
 {
+    SetTrajectory(pivotRotation, velocity, radius);
+
+    float speed = velocity.Length();
+    if (speed > 0)
+        SetTrajectory(GetRotationAt(offset / speed), velocity, radius);
+}
+
+// ----------------------------------------------------------------------------
+void PhaserController::SetTrajectory(const Quaternion& startRotation, const Vector2& velocity, float radius)
+{
+    startRotation_ = startRotation;
     velocity_ = velocity;
+    radius_ = Max(radius, 1.0f);
+
+    // Same rotation SurfaceObject::UpdatePosition() applies per frame, as an
+    // angular velocity. Note: The angles are in degrees even though they're
+    // calculated with 2*pi, this keeps the speed the same as before.
+    Vector3 angularVelocity = (Vector3::RIGHT * velocity.y_ + Vector3::BACK * velocity.x_) * (2 * M_PI / radius_);
+    angularSpeed_ = angularVelocity.Length();
+    axis_ = angularSpeed_ > 0 ? angularVelocity / angularSpeed_ : Vector3::RIGHT;
+
+    Scene* scene = GetScene();
+    startTime_ = scene ? scene->GetElapsedTime() : 0;
+
+    // The node marks where the phaser was fired and doesn't move after that
+    node_->GetParent()->SetRotation(startRotation_);
+    node_->SetPosition(Vector3(0, radius_, 0));
     node_->SetRotation(Quaternion(0, Atan2(velocity.x_, velocity.y_), 0));
+
+    ScheduleExpiry();
 }
 
 // ----------------------------------------------------------------------------
-void PhaserController::SetLife(float life)
+const Quaternion& PhaserController::GetStartRotation() const
 {
-    life_ = life;
+    return startRotation_;
 }
 
 // ----------------------------------------------------------------------------
@@ -49,21 +82,144 @@ const Vector2& PhaserController::GetVelocity() const
 }
 
 // ----------------------------------------------------------------------------
-void PhaserController::HandleUpdate(StringHash eventType, VariantMap& eventData)
+float PhaserController::GetRadius() const
+{
+    return radius_;
+}
+
+// ----------------------------------------------------------------------------
+void PhaserController::SetLife(float life)
+{
+    life_ = life;
+    ScheduleExpiry();
+}
+
+// ----------------------------------------------------------------------------
+float PhaserController::GetLife() const
+{
+    return life_;
+}
+
+// ----------------------------------------------------------------------------
+void PhaserController::SetAge(float age)
+{
+    Scene* scene = GetScene();
+    startTime_ = (scene ? scene->GetElapsedTime() : 0) - age;
+    ScheduleExpiry();
+}
+
+// ----------------------------------------------------------------------------
+float PhaserController::GetAge() const
+{
+    Scene* scene = GetScene();
+    return scene ? scene->GetElapsedTime() - startTime_ : 0;
+}
+
+// ----------------------------------------------------------------------------
+void PhaserController::SetOwner(User::GUID owner)
 {
-    using namespace Update;
+    owner_ = owner;
+}
 
-    float dt = eventData[P_TIMESTEP].GetFloat();
+// ----------------------------------------------------------------------------
+User::GUID PhaserController::GetOwner() const
+{
+    return owner_;
+}
 
-    UpdatePosition(velocity_, dt);
-    UpdatePlanetHeight();
-    node_->SetPosition(Vector3(0, GetOffsetFromPlanetCenter(), 0));
+// ----------------------------------------------------------------------------
+void PhaserController::SetNetworkID(unsigned id)
+{
+    networkID_ = id;
+}
 
-    life_ -= dt;
-    if (life_ < 0)
+// ----------------------------------------------------------------------------
+unsigned PhaserController::GetNetworkID() const
+{
+    return networkID_;
+}
+
+// ----------------------------------------------------------------------------
+Vector3 PhaserController::GetWorldPositionAt(float age) const
+{
+    // Phasers follow the terrain, same as SurfaceObjects do
+    Vector3 up = GetRotationAt(age) * Vector3::UP;
+    ProceduralPlanet* planet = ProceduralPlanet::GetScenePlanet(GetScene());
+    return up * (planet ? planet->GetSurfaceRadius(up) : radius_);
+}
+
+// ----------------------------------------------------------------------------
+Vector3 PhaserController::GetWorldPosition() const
+{
+    return GetWorldPositionAt(GetAge());
+}
+
+// ----------------------------------------------------------------------------
+Matrix3x4 PhaserController::GetWorldTransform() const
+{
+    float age = GetAge();
+    return Matrix3x4(GetWorldPositionAt(age), GetRotationAt(age) * node_->GetRotation(), node_->GetScale());
+}
+
+// ----------------------------------------------------------------------------
+void PhaserController::Destroy()
+{
+    PhaserReplicator* replicator = GetScene()->GetComponent<PhaserReplicator>();
+    if (replicator)
+        replicator->SendDestroy(this);
+
+    node_->GetParent()->Remove();
+}
+
+// ----------------------------------------------------------------------------
+void PhaserController::OnSceneSet(Scene* scene)
+{
+    Metrics* metrics = GetSubsystem<Metrics>();
+    if (metrics)
+        metrics->AddLiveProjectiles(scene ? 1 : -1);
+
+    TimerWheel* timers = GetSubsystem<TimerWheel>();
+    if (timers && scene == nullptr)
     {
-        node_->GetParent()->Remove();
+        timers->Cancel(expiryTimer_);
+        expiryTimer_ = TimerWheel::INVALID_TIMER;
     }
+
+    UpdateRegistry* registry = GetSubsystem<UpdateRegistry>();
+    if (registry == nullptr)
+        return;
+
+    if (scene)
+        registry->Track(this);
+    else
+        registry->Remove(this);
+}
+
+// ----------------------------------------------------------------------------
+Quaternion PhaserController::GetRotationAt(float age) const
+{
+    return startRotation_ * Quaternion(angularSpeed_ * age, axis_);
+}
+
+// ----------------------------------------------------------------------------
+void PhaserController::ScheduleExpiry()
+{
+    TimerWheel* timers = GetSubsystem<TimerWheel>();
+    if (timers == nullptr || GetScene() == nullptr)
+        return;
+
+    timers->Cancel(expiryTimer_);
+    expiryTimer_ = TimerWheel::INVALID_TIMER;
+    if (life_ < std::numeric_limits<float>::max())
+        expiryTimer_ = timers->Schedule<PhaserController, &PhaserController::HandleExpired>(this, life_ - GetAge());
+}
+
+// ----------------------------------------------------------------------------
+void PhaserController::HandleExpired()
+{
+    // Every peer expires its phasers on its own
+    expiryTimer_ = TimerWheel::INVALID_TIMER;
+    node_->GetParent()->Remove();
 }
 
 }
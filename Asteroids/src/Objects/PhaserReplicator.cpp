@@ -0,0 +1,152 @@
+#include "Asteroids/AsteroidsLib.hpp"
+#include "Asteroids/Network/MessageRouter.hpp"
+#include "Asteroids/Network/MessageView.hpp"
+#include "Asteroids/Network/NetworkClock.hpp"
+#include "Asteroids/Network/Protocol.hpp"
+#include "Asteroids/Objects/PhaserController.hpp"
+#include "Asteroids/Objects/PhaserReplicator.hpp"
+#include "Asteroids/Util/Prefab.hpp"
+#include "Asteroids/Util/UpdateRegistry.hpp"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/Network/Network.h>
+#include <Urho3D/Network/NetworkEvents.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Node.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+// ----------------------------------------------------------------------------
+PhaserReplicator::PhaserReplicator(Context* context) :
+    Component(context),
+    nextID_(0),
+    authority_(false)
+{
+    phaserPrefab_ = GetSubsystem<ResourceCache>()->GetResource<Prefab>("Prefabs/Phaser.xml");
+
+    SubscribeToEvent(E_NETWORKMESSAGE, URHO3D_HANDLER(PhaserReplicator, HandleNetworkMessage));
+}
+
+// ----------------------------------------------------------------------------
+void PhaserReplicator::RegisterObject(Context* context)
+{
+    context->RegisterFactory<PhaserReplicator>(ASTEROIDS_CATEGORY);
+}
+
+// ----------------------------------------------------------------------------
+void PhaserReplicator::SetAuthority(bool enable)
+{
+    authority_ = enable;
+}
+
+// ----------------------------------------------------------------------------
+bool PhaserReplicator::IsAuthority() const
+{
+    return authority_;
+}
+
+// ----------------------------------------------------------------------------
+void PhaserReplicator::SendSpawn(PhaserController* phaser)
+{
+    if (authority_ == false)
+        return;
+
+    phaser->SetNetworkID(nextID_++);
+
+    // When the phaser was fired on our clock, so clients can make up for the
+    // time the message took to arrive
+    NetworkClock* clock = GetSubsystem<NetworkClock>();
+    long long startTime = clock ? clock->GetLocalTime() - (long long)(phaser->GetAge() * 1e6f) : 0;
+
+    // The start rotation is sent at full precision, otherwise the client's
+    // phaser would end up somewhere else after flying around the planet
+    msg_.Clear();
+    msg_.WriteUInt(phaser->GetNetworkID());
+    msg_.WriteInt64(startTime);
+    msg_.WriteQuaternion(phaser->GetStartRotation());
+    msg_.WriteVector2(phaser->GetVelocity());
+    msg_.WriteFloat(phaser->GetRadius());
+    msg_.WriteFloat(phaser->GetLife());
+    msg_.WriteUShort(phaser->GetOwner());
+    GetSubsystem<MessageRouter>()->BroadcastMessage(CHANNEL_EVENTS, MSG_PHASER_SPAWN, msg_);
+}
+
+// ----------------------------------------------------------------------------
+void PhaserReplicator::SendDestroy(PhaserController* phaser)
+{
+    if (authority_ == false)
+        return;
+
+    msg_.Clear();
+    msg_.WriteUInt(phaser->GetNetworkID());
+    GetSubsystem<MessageRouter>()->BroadcastMessage(CHANNEL_EVENTS, MSG_PHASER_DESTROY, msg_);
+}
+
+// ----------------------------------------------------------------------------
+void PhaserReplicator::HandleNetworkMessage(StringHash eventType, VariantMap& eventData)
+{
+    if (authority_)
+        return;
+
+    MessageView message(eventData);
+    int msgID = message.GetID();
+    if (msgID != MSG_PHASER_SPAWN && msgID != MSG_PHASER_DESTROY)
+        return;
+
+    Network* network = GetSubsystem<Network>();
+    if (message.GetConnection() == nullptr || message.GetConnection() != network->GetServerConnection())
+        return;
+
+    MemoryBuffer& buffer = message.GetBuffer();
+    unsigned id = buffer.ReadUInt();
+
+    if (msgID == MSG_PHASER_SPAWN)
+    {
+        long long startTime = buffer.ReadInt64();
+        Quaternion startRotation = buffer.ReadQuaternion();
+        Vector2 velocity = buffer.ReadVector2();
+        float radius = buffer.ReadFloat();
+        float life = buffer.ReadFloat();
+        User::GUID owner = buffer.ReadUShort();
+        if (phaserPrefab_ == nullptr)
+            return;
+
+        Node* pivot = GetScene()->CreateChild("", LOCAL);
+        phaserPrefab_->Instantiate(pivot);
+        PhaserController* phaser = pivot->GetChild("Phaser")->GetComponent<PhaserController>();
+        phaser->SetNetworkID(id);
+        phaser->SetOwner(owner);
+        phaser->SetLife(life);
+        phaser->SetTrajectory(startRotation, velocity, radius);
+
+        // The phaser has been flying on the server since it was fired, start
+        // it where it is now. Until the clock is synchronized it starts late.
+        NetworkClock* clock = GetSubsystem<NetworkClock>();
+        if (clock && clock->IsSynchronized())
+        {
+            float age = float(clock->GetServerTime() - startTime * 1e-6);
+            phaser->SetAge(Clamp(age, 0.0f, life));
+        }
+        return;
+    }
+
+    // Hits are rare, a linear search over the live phasers is fine
+    UpdateRegistry* registry = GetSubsystem<UpdateRegistry>();
+    const PODVector<void*>& phasers = registry->GetObjects<PhaserController>();
+    for (unsigned i = 0; i != phasers.Size(); ++i)
+    {
+        PhaserController* phaser = static_cast<PhaserController*>(phasers[i]);
+        if (phaser == nullptr || phaser->GetScene() != GetScene() || phaser->GetNetworkID() != id)
+            continue;
+
+        phaser->GetNode()->GetParent()->Remove();
+        break;
+    }
+}
+
+}
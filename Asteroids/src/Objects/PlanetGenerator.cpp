@@ -0,0 +1,380 @@
+#include "Asteroids/Objects/PlanetGenerator.hpp"
+
+#include <Urho3D/Container/HashMap.h>
+
+#include <math.h>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+static const unsigned NOISE_OCTAVES = 6;
+static const float NOISE_FREQUENCY = 1.5f;
+static const float NOISE_PERSISTENCE = 0.5f;
+
+// ----------------------------------------------------------------------------
+static float Fade(float t)
+{
+    return t * t * t * (t * (t * 6 - 15) + 10);
+}
+
+// ----------------------------------------------------------------------------
+static float Grad(int hash, float x, float y, float z)
+{
+    int h = hash & 15;
+    float u = h < 8 ? x : y;
+    float v = h < 4 ? y : (h == 12 || h == 14 ? x : z);
+    return ((h & 1) ? -u : u) + ((h & 2) ? -v : v);
+}
+
+// ----------------------------------------------------------------------------
+// Cube map layout shared by BuildHeightMap() and SampleRadius(). u and v are
+// in the range [-1, 1].
+static Vector3 CubeFaceToDirection(unsigned face, float u, float v)
+{
+    switch (face)
+    {
+        case 0  : return Vector3( 1, v, u);
+        case 1  : return Vector3(-1, v, u);
+        case 2  : return Vector3(u,  1, v);
+        case 3  : return Vector3(u, -1, v);
+        case 4  : return Vector3(u, v,  1);
+        default : return Vector3(u, v, -1);
+    }
+}
+
+// ----------------------------------------------------------------------------
+static unsigned DirectionToCubeFace(const Vector3& direction, float* u, float* v)
+{
+    Vector3 a = direction.Abs();
+    if (a.x_ >= a.y_ && a.x_ >= a.z_)
+    {
+        *u = direction.z_ / a.x_;
+        *v = direction.y_ / a.x_;
+        return direction.x_ > 0 ? 0 : 1;
+    }
+    if (a.y_ >= a.z_)
+    {
+        *u = direction.x_ / a.y_;
+        *v = direction.z_ / a.y_;
+        return direction.y_ > 0 ? 2 : 3;
+    }
+    *u = direction.x_ / a.z_;
+    *v = direction.y_ / a.z_;
+    return direction.z_ > 0 ? 4 : 5;
+}
+
+// ----------------------------------------------------------------------------
+PlanetGenerator::PlanetGenerator(unsigned seed, float radius, float amplitude) :
+    heightMapResolution_(0),
+    radius_(radius),
+    amplitude_(amplitude)
+{
+    // Shuffle the permutation table with a xorshift generator. Don't use
+    // Rand(), the result has to be the same on every machine no matter what
+    // else consumed random numbers before.
+    unsigned state = seed * 747796405u + 2891336453u;
+    if (state == 0)
+        state = 1;
+
+    for (unsigned i = 0; i != 256; ++i)
+        permutation_[i] = (unsigned char)i;
+    for (unsigned i = 255; i > 0; --i)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        unsigned j = state % (i + 1);
+        unsigned char tmp = permutation_[i];
+        permutation_[i] = permutation_[j];
+        permutation_[j] = tmp;
+    }
+    for (unsigned i = 0; i != 256; ++i)
+        permutation_[i + 256] = permutation_[i];
+}
+
+// ----------------------------------------------------------------------------
+float PlanetGenerator::GetRadius() const
+{
+    return radius_;
+}
+
+// ----------------------------------------------------------------------------
+float PlanetGenerator::GetMinRadius() const
+{
+    return radius_ * (1 - amplitude_);
+}
+
+// ----------------------------------------------------------------------------
+float PlanetGenerator::GetMaxRadius() const
+{
+    return radius_ * (1 + amplitude_);
+}
+
+// ----------------------------------------------------------------------------
+float PlanetGenerator::GenerateRadius(const Vector3& direction) const
+{
+    Vector3 p = direction.Normalized() * NOISE_FREQUENCY;
+    float sum = 0;
+    float scale = 1;
+    float totalScale = 0;
+    for (unsigned i = 0; i != NOISE_OCTAVES; ++i)
+    {
+        sum += Noise(p) * scale;
+        totalScale += scale;
+        scale *= NOISE_PERSISTENCE;
+        p *= 2;
+    }
+
+    return radius_ * (1 + amplitude_ * Clamp(sum / totalScale, -1.0f, 1.0f));
+}
+
+// ----------------------------------------------------------------------------
+Vector3 PlanetGenerator::GenerateNormal(const Vector3& direction, float step) const
+{
+    Vector3 d = direction.Normalized();
+    Vector3 t1 = d.CrossProduct(Abs(d.y_) < 0.9f ? Vector3::UP : Vector3::RIGHT).Normalized() * step;
+    Vector3 t2 = d.CrossProduct(t1);
+
+    Vector3 p1 = (d + t1).Normalized() * GenerateRadius(d + t1);
+    Vector3 p2 = (d - t1).Normalized() * GenerateRadius(d - t1);
+    Vector3 p3 = (d + t2).Normalized() * GenerateRadius(d + t2);
+    Vector3 p4 = (d - t2).Normalized() * GenerateRadius(d - t2);
+
+    Vector3 normal = (p1 - p2).CrossProduct(p3 - p4).Normalized();
+    return normal.DotProduct(d) < 0 ? -normal : normal;
+}
+
+// ----------------------------------------------------------------------------
+void PlanetGenerator::BuildHeightMap(unsigned resolution)
+{
+    resolution = Max(resolution, 2u);
+    heightMapResolution_ = resolution;
+    heightMap_.Resize(6 * resolution * resolution);
+
+    float scale = 2.0f / (resolution - 1);
+    float* out = &heightMap_[0];
+    for (unsigned face = 0; face != 6; ++face)
+        for (unsigned y = 0; y != resolution; ++y)
+            for (unsigned x = 0; x != resolution; ++x)
+                *out++ = GenerateRadius(CubeFaceToDirection(face, x * scale - 1, y * scale - 1));
+}
+
+// ----------------------------------------------------------------------------
+float PlanetGenerator::SampleRadius(const Vector3& direction) const
+{
+    if (heightMapResolution_ == 0)
+        return radius_;
+
+    float u, v;
+    unsigned face = DirectionToCubeFace(direction, &u, &v);
+
+    // Bilinear interpolation between the four surrounding samples
+    unsigned last = heightMapResolution_ - 1;
+    float fx = Clamp((u + 1) * 0.5f * last, 0.0f, (float)last);
+    float fy = Clamp((v + 1) * 0.5f * last, 0.0f, (float)last);
+    unsigned x = Min((unsigned)fx, last - 1);
+    unsigned y = Min((unsigned)fy, last - 1);
+    fx -= x;
+    fy -= y;
+
+    const float* row = &heightMap_[(face * heightMapResolution_ + y) * heightMapResolution_ + x];
+    float top = Lerp(row[0], row[1], fx);
+    float bottom = Lerp(row[heightMapResolution_], row[heightMapResolution_ + 1], fx);
+    return Lerp(top, bottom, fy);
+}
+
+// ----------------------------------------------------------------------------
+void PlanetGenerator::BuildCollisionMesh(unsigned subdivisions,
+                                         PODVector<Vector3>& vertices,
+                                         PODVector<unsigned>& indices) const
+{
+    GetIcosahedron(vertices, indices);
+
+    // Split every triangle into four. Midpoints are shared between the two
+    // triangles of an edge so the mesh stays closed.
+    HashMap<unsigned long long, unsigned> midpoints;
+    PODVector<unsigned> subdivided;
+    for (unsigned level = 0; level != subdivisions; ++level)
+    {
+        midpoints.Clear();
+        subdivided.Clear();
+        for (unsigned i = 0; i != indices.Size(); i += 3)
+        {
+            unsigned corners[3] = { indices[i], indices[i + 1], indices[i + 2] };
+            unsigned mid[3];
+            for (unsigned e = 0; e != 3; ++e)
+            {
+                unsigned v0 = corners[e];
+                unsigned v1 = corners[(e + 1) % 3];
+                unsigned long long key = (unsigned long long)Min(v0, v1) << 32 | Max(v0, v1);
+                HashMap<unsigned long long, unsigned>::Iterator it = midpoints.Find(key);
+                if (it == midpoints.End())
+                {
+                    mid[e] = vertices.Size();
+                    midpoints[key] = mid[e];
+                    vertices.Push((vertices[v0] + vertices[v1]).Normalized());
+                }
+                else
+                    mid[e] = it->second_;
+            }
+
+            unsigned children[12] = {
+                corners[0], mid[0], mid[2],
+                mid[0], corners[1], mid[1],
+                mid[2], mid[1], corners[2],
+                mid[0], mid[1], mid[2]
+            };
+            for (unsigned k = 0; k != 12; ++k)
+                subdivided.Push(children[k]);
+        }
+        indices.Swap(subdivided);
+    }
+
+    for (unsigned i = 0; i != vertices.Size(); ++i)
+        vertices[i] *= GenerateRadius(vertices[i]);
+}
+
+// ----------------------------------------------------------------------------
+void PlanetGenerator::BuildChunkMesh(const Vector3& a,
+                                     const Vector3& b,
+                                     const Vector3& c,
+                                     unsigned resolution,
+                                     float skirtDepth,
+                                     PODVector<float>& vertexData,
+                                     PODVector<unsigned short>& indexData) const
+{
+    // Vertices are laid out in rows. Row i is at i/resolution along a->b and
+    // holds resolution - i + 1 vertices going towards c.
+    unsigned surfaceVertices = (resolution + 1) * (resolution + 2) / 2;
+    unsigned skirtVertices = 3 * (resolution + 1);
+    vertexData.Resize((surfaceVertices + skirtVertices) * 6);
+    indexData.Clear();
+
+    float normalStep = (b - a).Length() / resolution * 0.5f;
+    float* out = &vertexData[0];
+    for (unsigned i = 0; i <= resolution; ++i)
+        for (unsigned j = 0; j <= resolution - i; ++j)
+        {
+            Vector3 direction = (a + (b - a) * ((float)i / resolution) + (c - a) * ((float)j / resolution)).Normalized();
+            Vector3 position = direction * GenerateRadius(direction);
+            Vector3 normal = GenerateNormal(direction, normalStep);
+            *out++ = position.x_; *out++ = position.y_; *out++ = position.z_;
+            *out++ = normal.x_;   *out++ = normal.y_;   *out++ = normal.z_;
+        }
+
+    auto index = [resolution](unsigned i, unsigned j) {
+        return (unsigned short)(i * (resolution + 1) - i * (i - 1) / 2 + j);
+    };
+
+    // Both triangles of a grid cell keep the winding of a, b, c
+    for (unsigned i = 0; i != resolution; ++i)
+        for (unsigned j = 0; j != resolution - i; ++j)
+        {
+            indexData.Push(index(i, j));
+            indexData.Push(index(i + 1, j));
+            indexData.Push(index(i, j + 1));
+            if (j + 1 < resolution - i)
+            {
+                indexData.Push(index(i + 1, j));
+                indexData.Push(index(i + 1, j + 1));
+                indexData.Push(index(i, j + 1));
+            }
+        }
+
+    // Skirts. Walk the border in the order a->b->c->a and duplicate each
+    // border vertex a bit below the surface.
+    PODVector<unsigned short> border;
+    border.Reserve(skirtVertices);
+    for (unsigned k = 0; k <= resolution; ++k) border.Push(index(k, 0));
+    for (unsigned k = 0; k <= resolution; ++k) border.Push(index(resolution - k, k));
+    for (unsigned k = 0; k <= resolution; ++k) border.Push(index(0, resolution - k));
+
+    unsigned short skirtStart = (unsigned short)surfaceVertices;
+    for (unsigned k = 0; k != skirtVertices; ++k)
+    {
+        const float* top = &vertexData[border[k] * 6];
+        Vector3 position(top[0], top[1], top[2]);
+        position -= position.Normalized() * skirtDepth;
+        *out++ = position.x_; *out++ = position.y_; *out++ = position.z_;
+        *out++ = top[3];      *out++ = top[4];      *out++ = top[5];
+    }
+
+    for (unsigned edge = 0; edge != 3; ++edge)
+        for (unsigned k = 0; k != resolution; ++k)
+        {
+            unsigned s = edge * (resolution + 1) + k;
+            unsigned short p = border[s];
+            unsigned short q = border[s + 1];
+            unsigned short pl = (unsigned short)(skirtStart + s);
+            unsigned short ql = (unsigned short)(skirtStart + s + 1);
+            unsigned short quad[6] = { p, ql, q, p, pl, ql };
+            for (unsigned n = 0; n != 6; ++n)
+                indexData.Push(quad[n]);
+        }
+}
+
+// ----------------------------------------------------------------------------
+void PlanetGenerator::GetIcosahedron(PODVector<Vector3>& vertices, PODVector<unsigned>& faces)
+{
+    static const float t = 1.618033988749895f;
+    static const float positions[12][3] = {
+        {-1,  t,  0}, { 1,  t,  0}, {-1, -t,  0}, { 1, -t,  0},
+        { 0, -1,  t}, { 0,  1,  t}, { 0, -1, -t}, { 0,  1, -t},
+        { t,  0, -1}, { t,  0,  1}, {-t,  0, -1}, {-t,  0,  1}
+    };
+    static const unsigned triangles[20][3] = {
+        {0, 11, 5}, {0, 5, 1},  {0, 1, 7},   {0, 7, 10}, {0, 10, 11},
+        {1, 5, 9},  {5, 11, 4}, {11, 10, 2}, {10, 7, 6}, {7, 1, 8},
+        {3, 9, 4},  {3, 4, 2},  {3, 2, 6},   {3, 6, 8},  {3, 8, 9},
+        {4, 9, 5},  {2, 4, 11}, {6, 2, 10},  {8, 6, 7},  {9, 8, 1}
+    };
+
+    vertices.Resize(12);
+    for (unsigned i = 0; i != 12; ++i)
+        vertices[i] = Vector3(positions[i][0], positions[i][1], positions[i][2]).Normalized();
+
+    // Urho's front faces are clockwise, which means (b-a) x (c-a) has to
+    // point away from the center
+    faces.Resize(60);
+    for (unsigned i = 0; i != 20; ++i)
+    {
+        const unsigned* tri = triangles[i];
+        const Vector3& a = vertices[tri[0]];
+        const Vector3& b = vertices[tri[1]];
+        const Vector3& c = vertices[tri[2]];
+        bool flip = (b - a).CrossProduct(c - a).DotProduct(a + b + c) < 0;
+        faces[i * 3 + 0] = tri[0];
+        faces[i * 3 + 1] = flip ? tri[2] : tri[1];
+        faces[i * 3 + 2] = flip ? tri[1] : tri[2];
+    }
+}
+
+// ----------------------------------------------------------------------------
+float PlanetGenerator::Noise(const Vector3& p) const
+{
+    // Improved Perlin noise
+    float fx = floorf(p.x_);
+    float fy = floorf(p.y_);
+    float fz = floorf(p.z_);
+    int X = (int)fx & 255;
+    int Y = (int)fy & 255;
+    int Z = (int)fz & 255;
+    float x = p.x_ - fx;
+    float y = p.y_ - fy;
+    float z = p.z_ - fz;
+    float u = Fade(x);
+    float v = Fade(y);
+    float w = Fade(z);
+
+    const unsigned char* P = permutation_;
+    int A = P[X] + Y,     AA = P[A] + Z, AB = P[A + 1] + Z;
+    int B = P[X + 1] + Y, BA = P[B] + Z, BB = P[B + 1] + Z;
+
+    return Lerp(Lerp(Lerp(Grad(P[AA],     x,     y,     z),     Grad(P[BA],     x - 1, y,     z),     u),
+                     Lerp(Grad(P[AB],     x,     y - 1, z),     Grad(P[BB],     x - 1, y - 1, z),     u), v),
+                Lerp(Lerp(Grad(P[AA + 1], x,     y,     z - 1), Grad(P[BA + 1], x - 1, y,     z - 1), u),
+                     Lerp(Grad(P[AB + 1], x,     y - 1, z - 1), Grad(P[BB + 1], x - 1, y - 1, z - 1), u), v), w);
+}
+
+}
@@ -0,0 +1,330 @@
+#include "Asteroids/AsteroidsLib.hpp"
+#include "Asteroids/Objects/PlanetGenerator.hpp"
+#include "Asteroids/Objects/PlanetTerrain.hpp"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/Geometry.h>
+#include <Urho3D/Graphics/IndexBuffer.h>
+#include <Urho3D/Graphics/Material.h>
+#include <Urho3D/Graphics/Renderer.h>
+#include <Urho3D/Graphics/VertexBuffer.h>
+#include <Urho3D/Graphics/Viewport.h>
+#include <Urho3D/Scene/Node.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/Scene/SceneEvents.h>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+static const unsigned ROOT_CHUNK_COUNT = 20;
+static const unsigned MAX_CHUNK_BUILDS_PER_UPDATE = 4;
+// Children that weren't selected for this many LOD updates (roughly 5 s at
+// 60 fps) are released
+static const unsigned RELEASE_AFTER_UPDATES = 300;
+
+// ----------------------------------------------------------------------------
+PlanetTerrain::PlanetTerrain(Context* context) :
+    Drawable(context, DRAWABLE_GEOMETRY),
+    lodLevels_(1),
+    chunkResolution_(16),
+    builtChunks_(0),
+    updateCount_(0),
+    lodFactor_(3)
+{
+}
+
+// ----------------------------------------------------------------------------
+void PlanetTerrain::RegisterObject(Context* context)
+{
+    context->RegisterFactory<PlanetTerrain>(ASTEROIDS_CATEGORY);
+}
+
+// ----------------------------------------------------------------------------
+void PlanetTerrain::SetGenerator(PlanetGenerator* generator, unsigned lodLevels, unsigned chunkResolution)
+{
+    generator_ = generator;
+    lodLevels_ = Max(lodLevels, 1u);
+    chunkResolution_ = Max(chunkResolution, 1u);
+    chunks_.Clear();
+    freeBlocks_.Clear();
+    visibleChunks_.Clear();
+    builtChunks_ = 0;
+    boundingBox_.Clear();
+
+    if (generator_)
+    {
+        PODVector<Vector3> vertices;
+        PODVector<unsigned> faces;
+        PlanetGenerator::GetIcosahedron(vertices, faces);
+        chunks_.Resize(faces.Size() / 3);
+        for (unsigned i = 0; i != faces.Size(); i += 3)
+            InitChunk(chunks_[i / 3], vertices[faces[i]], vertices[faces[i + 1]], vertices[faces[i + 2]], 0);
+
+        // Roots are always built so there is something to fall back to
+        for (unsigned i = 0; i != chunks_.Size(); ++i)
+        {
+            BuildChunk(i);
+            visibleChunks_.Push(i);
+        }
+
+        float maxRadius = generator_->GetMaxRadius();
+        boundingBox_ = BoundingBox(-Vector3::ONE * maxRadius, Vector3::ONE * maxRadius);
+    }
+
+    UpdateChunkBatches();
+    OnMarkedDirty(node_);
+}
+
+// ----------------------------------------------------------------------------
+void PlanetTerrain::SetLodFactor(float factor)
+{
+    lodFactor_ = factor;
+}
+
+// ----------------------------------------------------------------------------
+void PlanetTerrain::SetMaterial(Material* material)
+{
+    material_ = material;
+    for (auto& batch : batches_)
+        batch.material_ = material_;
+}
+
+// ----------------------------------------------------------------------------
+void PlanetTerrain::UpdateLod(const Vector3& cameraPosition)
+{
+    if (generator_ == nullptr || node_ == nullptr)
+        return;
+
+    Vector3 localCamera = node_->GetWorldTransform().Inverse() * cameraPosition;
+    unsigned buildBudget = MAX_CHUNK_BUILDS_PER_UPDATE;
+
+    updateCount_++;
+    visibleChunks_.Clear();
+    for (unsigned i = 0; i != ROOT_CHUNK_COUNT; ++i)
+        SelectChunk(i, localCamera, &buildBudget);
+
+    UpdateChunkBatches();
+}
+
+// ----------------------------------------------------------------------------
+unsigned PlanetTerrain::GetNumVisibleChunks() const
+{
+    return visibleChunks_.Size();
+}
+
+// ----------------------------------------------------------------------------
+unsigned PlanetTerrain::GetNumBuiltChunks() const
+{
+    return builtChunks_;
+}
+
+// ----------------------------------------------------------------------------
+void PlanetTerrain::UpdateBatches(const FrameInfo& frame)
+{
+    const BoundingBox& worldBoundingBox = GetWorldBoundingBox();
+    distance_ = frame.camera_->GetDistance(worldBoundingBox.Center());
+
+    for (auto& batch : batches_)
+    {
+        batch.distance_ = distance_;
+        batch.worldTransform_ = &node_->GetWorldTransform();
+    }
+}
+
+// ----------------------------------------------------------------------------
+void PlanetTerrain::OnSceneSet(Scene* scene)
+{
+    Drawable::OnSceneSet(scene);
+
+    if (scene)
+        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(PlanetTerrain, HandleScenePostUpdate));
+    else
+        UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
+}
+
+// ----------------------------------------------------------------------------
+void PlanetTerrain::OnWorldBoundingBoxUpdate()
+{
+    worldBoundingBox_ = boundingBox_.Transformed(node_->GetWorldTransform());
+}
+
+// ----------------------------------------------------------------------------
+void PlanetTerrain::InitChunk(Chunk& chunk, const Vector3& a, const Vector3& b, const Vector3& c, unsigned depth)
+{
+    chunk.corners_[0] = a;
+    chunk.corners_[1] = b;
+    chunk.corners_[2] = c;
+    chunk.depth_ = depth;
+    chunk.children_ = 0;
+    chunk.lastUsed_ = updateCount_;
+    chunk.geometry_.Reset();
+
+    // The surface can be anywhere between the min and max radius, so the
+    // sphere has to enclose the corners at both
+    Vector3 direction = (a + b + c).Normalized();
+    float minRadius = generator_->GetMinRadius();
+    float maxRadius = generator_->GetMaxRadius();
+    chunk.center_ = direction * ((minRadius + maxRadius) * 0.5f);
+    chunk.radius_ = 0;
+    for (unsigned i = 0; i != 3; ++i)
+    {
+        chunk.radius_ = Max(chunk.radius_, (chunk.corners_[i] * minRadius - chunk.center_).Length());
+        chunk.radius_ = Max(chunk.radius_, (chunk.corners_[i] * maxRadius - chunk.center_).Length());
+    }
+}
+
+// ----------------------------------------------------------------------------
+void PlanetTerrain::SplitChunk(unsigned index)
+{
+    // Reuse the slots of children released by ReleaseChildren() if there are any
+    unsigned first;
+    if (freeBlocks_.Size() > 0)
+    {
+        first = freeBlocks_.Back();
+        freeBlocks_.Pop();
+    }
+    else
+    {
+        first = chunks_.Size();
+        chunks_.Resize(first + 4);
+    }
+
+    const Chunk& parent = chunks_[index];
+    Vector3 a = parent.corners_[0];
+    Vector3 b = parent.corners_[1];
+    Vector3 c = parent.corners_[2];
+    Vector3 ab = (a + b).Normalized();
+    Vector3 bc = (b + c).Normalized();
+    Vector3 ca = (c + a).Normalized();
+    unsigned depth = parent.depth_ + 1;
+
+    InitChunk(chunks_[first + 0], a, ab, ca, depth);
+    InitChunk(chunks_[first + 1], ab, b, bc, depth);
+    InitChunk(chunks_[first + 2], ca, bc, c, depth);
+    InitChunk(chunks_[first + 3], ab, bc, ca, depth);
+    chunks_[index].children_ = first;
+}
+
+// ----------------------------------------------------------------------------
+void PlanetTerrain::ReleaseChildren(unsigned index)
+{
+    unsigned first = chunks_[index].children_;
+    for (unsigned i = first; i != first + 4; ++i)
+    {
+        if (chunks_[i].children_ != 0)
+            ReleaseChildren(i);
+        if (chunks_[i].geometry_)
+        {
+            chunks_[i].geometry_.Reset();
+            builtChunks_--;
+        }
+    }
+
+    freeBlocks_.Push(first);
+    chunks_[index].children_ = 0;
+}
+
+// ----------------------------------------------------------------------------
+void PlanetTerrain::BuildChunk(unsigned index)
+{
+    Chunk& chunk = chunks_[index];
+
+    // Skirts only have to cover the gap to a neighbour one level coarser,
+    // which shrinks with the chunk
+    float skirtDepth = 2 * chunk.radius_ / chunkResolution_;
+    generator_->BuildChunkMesh(chunk.corners_[0], chunk.corners_[1], chunk.corners_[2],
+                               chunkResolution_, skirtDepth, vertexData_, indexData_);
+
+    SharedPtr<VertexBuffer> vertexBuffer(new VertexBuffer(context_));
+    vertexBuffer->SetShadowed(true);
+    vertexBuffer->SetSize(vertexData_.Size() / 6, MASK_POSITION | MASK_NORMAL);
+    vertexBuffer->SetData(vertexData_.Buffer());
+
+    SharedPtr<IndexBuffer> indexBuffer(new IndexBuffer(context_));
+    indexBuffer->SetShadowed(true);
+    indexBuffer->SetSize(indexData_.Size(), false);
+    indexBuffer->SetData(indexData_.Buffer());
+
+    chunk.geometry_ = new Geometry(context_);
+    chunk.geometry_->SetVertexBuffer(0, vertexBuffer);
+    chunk.geometry_->SetIndexBuffer(indexBuffer);
+    chunk.geometry_->SetDrawRange(TRIANGLE_LIST, 0, indexData_.Size());
+
+    builtChunks_++;
+}
+
+// ----------------------------------------------------------------------------
+void PlanetTerrain::SelectChunk(unsigned index, const Vector3& cameraPosition, unsigned* buildBudget)
+{
+    chunks_[index].lastUsed_ = updateCount_;
+
+    bool split = chunks_[index].depth_ + 1 < lodLevels_ &&
+        (cameraPosition - chunks_[index].center_).Length() < chunks_[index].radius_ * lodFactor_;
+
+    if (split)
+    {
+        if (chunks_[index].children_ == 0)
+            SplitChunk(index);
+
+        unsigned first = chunks_[index].children_;
+        bool ready = true;
+        for (unsigned i = first; i != first + 4; ++i)
+        {
+            if (chunks_[i].geometry_)
+                continue;
+            if (*buildBudget > 0)
+            {
+                BuildChunk(i);
+                (*buildBudget)--;
+            }
+            else
+                ready = false;
+        }
+
+        if (ready)
+        {
+            for (unsigned i = first; i != first + 4; ++i)
+                SelectChunk(i, cameraPosition, buildBudget);
+            return;
+        }
+    }
+    else if (chunks_[index].children_ != 0)
+    {
+        // Children are only ever selected all four at once, and only along
+        // with their parent, so the first child tells when anything below
+        // this chunk was last used
+        unsigned first = chunks_[index].children_;
+        if (updateCount_ - chunks_[first].lastUsed_ > RELEASE_AFTER_UPDATES)
+            ReleaseChildren(index);
+    }
+
+    visibleChunks_.Push(index);
+}
+
+// ----------------------------------------------------------------------------
+void PlanetTerrain::UpdateChunkBatches()
+{
+    batches_.Resize(visibleChunks_.Size());
+    for (unsigned i = 0; i != visibleChunks_.Size(); ++i)
+    {
+        batches_[i].geometry_ = chunks_[visibleChunks_[i]].geometry_;
+        batches_[i].material_ = material_;
+        batches_[i].worldTransform_ = node_ ? &node_->GetWorldTransform() : &Matrix3x4::IDENTITY;
+    }
+}
+
+// ----------------------------------------------------------------------------
+void PlanetTerrain::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+{
+    Renderer* renderer = GetSubsystem<Renderer>();
+    Viewport* viewport = renderer ? renderer->GetViewport(0) : nullptr;
+    Camera* camera = viewport ? viewport->GetCamera() : nullptr;
+    if (camera == nullptr || camera->GetScene() != GetScene())
+        return;
+
+    UpdateLod(camera->GetNode()->GetWorldPosition());
+}
+
+}
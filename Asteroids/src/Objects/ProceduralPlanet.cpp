@@ -0,0 +1,211 @@
+#include "Asteroids/AsteroidsLib.hpp"
+#include "Asteroids/Globals.hpp"
+#include "Asteroids/Objects/PlanetGenerator.hpp"
+#include "Asteroids/Objects/PlanetTerrain.hpp"
+#include "Asteroids/Objects/ProceduralPlanet.hpp"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Graphics/Geometry.h>
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/IndexBuffer.h>
+#include <Urho3D/Graphics/Material.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/VertexBuffer.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Physics/CollisionShape.h>
+#include <Urho3D/Physics/RigidBody.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Node.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+// There is rarely more than one scene, a linear search is fine
+static PODVector<ProceduralPlanet*> planets;
+
+// ----------------------------------------------------------------------------
+ProceduralPlanet::ProceduralPlanet(Context* context) :
+    Component(context),
+    seed_(0),
+    radius_(60),
+    amplitude_(0.05f),
+    heightMapResolution_(128),
+    collisionSubdivisions_(4),
+    lodLevels_(6),
+    chunkResolution_(16),
+    lodFactor_(3),
+    generatorDirty_(true)
+{
+}
+
+// ----------------------------------------------------------------------------
+ProceduralPlanet::~ProceduralPlanet()
+{
+    planets.Remove(this);
+}
+
+// ----------------------------------------------------------------------------
+void ProceduralPlanet::RegisterObject(Context* context)
+{
+    context->RegisterFactory<ProceduralPlanet>(ASTEROIDS_CATEGORY);
+
+    URHO3D_ATTRIBUTE_EX("Seed", int, seed_, MarkGeneratorDirty, 0, AM_DEFAULT);
+    URHO3D_ATTRIBUTE_EX("Radius", float, radius_, MarkGeneratorDirty, 60.0f, AM_DEFAULT);
+    URHO3D_ATTRIBUTE_EX("Amplitude", float, amplitude_, MarkGeneratorDirty, 0.05f, AM_DEFAULT);
+    URHO3D_ATTRIBUTE_EX("Height Map Resolution", int, heightMapResolution_, MarkGeneratorDirty, 128, AM_DEFAULT);
+    URHO3D_ATTRIBUTE_EX("Collision Subdivisions", int, collisionSubdivisions_, MarkGeneratorDirty, 4, AM_DEFAULT);
+    URHO3D_ATTRIBUTE_EX("LOD Levels", int, lodLevels_, MarkGeneratorDirty, 6, AM_DEFAULT);
+    URHO3D_ATTRIBUTE_EX("Chunk Resolution", int, chunkResolution_, MarkGeneratorDirty, 16, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("LOD Factor", float, lodFactor_, 3.0f, AM_DEFAULT);
+    URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Material", GetMaterialAttr, SetMaterialAttr, ResourceRef, ResourceRef(Material::GetTypeStatic()), AM_DEFAULT);
+}
+
+// ----------------------------------------------------------------------------
+void ProceduralPlanet::ApplyAttributes()
+{
+    if (generatorDirty_)
+        Generate();
+    else if (terrain_)
+        terrain_->SetLodFactor(lodFactor_);
+}
+
+// ----------------------------------------------------------------------------
+void ProceduralPlanet::Generate()
+{
+    generatorDirty_ = false;
+    if (node_ == nullptr)
+        return;
+
+    // Chunks use 16-bit indices, and every collision subdivision quadruples
+    // the number of triangles
+    heightMapResolution_ = Clamp(heightMapResolution_, 2, 1024);
+    collisionSubdivisions_ = Clamp(collisionSubdivisions_, 0, 7);
+    lodLevels_ = Clamp(lodLevels_, 1, 12);
+    chunkResolution_ = Clamp(chunkResolution_, 1, 64);
+
+    generator_ = new PlanetGenerator((unsigned)seed_, radius_, amplitude_);
+    generator_->BuildHeightMap((unsigned)heightMapResolution_);
+    CreateCollision();
+
+    if (GetSubsystem<Graphics>())
+        CreateTerrain();
+}
+
+// ----------------------------------------------------------------------------
+float ProceduralPlanet::GetSurfaceRadius(const Vector3& worldDirection) const
+{
+    if (generator_ == nullptr || node_ == nullptr)
+        return radius_;
+
+    // Planets are only ever scaled uniformly
+    Vector3 localDirection = node_->GetWorldRotation().Inverse() * worldDirection;
+    return generator_->SampleRadius(localDirection) * node_->GetWorldScale().x_;
+}
+
+// ----------------------------------------------------------------------------
+PlanetGenerator* ProceduralPlanet::GetGenerator() const
+{
+    return generator_;
+}
+
+// ----------------------------------------------------------------------------
+ProceduralPlanet* ProceduralPlanet::GetScenePlanet(const Scene* scene)
+{
+    for (unsigned i = 0; i != planets.Size(); ++i)
+        if (planets[i]->GetScene() == scene)
+            return planets[i];
+    return nullptr;
+}
+
+// ----------------------------------------------------------------------------
+ResourceRef ProceduralPlanet::GetMaterialAttr() const
+{
+    return GetResourceRef(material_, Material::GetTypeStatic());
+}
+
+// ----------------------------------------------------------------------------
+void ProceduralPlanet::SetMaterialAttr(const ResourceRef& value)
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    material_ = cache->GetResource<Material>(value.name_);
+    if (terrain_)
+        terrain_->SetMaterial(material_);
+}
+
+// ----------------------------------------------------------------------------
+void ProceduralPlanet::OnSceneSet(Scene* scene)
+{
+    planets.Remove(this);
+    if (scene)
+        planets.Push(this);
+}
+
+// ----------------------------------------------------------------------------
+void ProceduralPlanet::MarkGeneratorDirty()
+{
+    generatorDirty_ = true;
+}
+
+// ----------------------------------------------------------------------------
+void ProceduralPlanet::CreateCollision()
+{
+    PODVector<Vector3> vertices;
+    PODVector<unsigned> indices;
+    generator_->BuildCollisionMesh((unsigned)collisionSubdivisions_, vertices, indices);
+
+    // Bullet reads the triangles from the CPU side copies of the buffers
+    SharedPtr<VertexBuffer> vertexBuffer(new VertexBuffer(context_));
+    vertexBuffer->SetShadowed(true);
+    vertexBuffer->SetSize(vertices.Size(), MASK_POSITION);
+    vertexBuffer->SetData(vertices.Buffer());
+
+    SharedPtr<IndexBuffer> indexBuffer(new IndexBuffer(context_));
+    indexBuffer->SetShadowed(true);
+    indexBuffer->SetSize(indices.Size(), true);
+    indexBuffer->SetData(indices.Buffer());
+
+    SharedPtr<Geometry> geometry(new Geometry(context_));
+    geometry->SetVertexBuffer(0, vertexBuffer);
+    geometry->SetIndexBuffer(indexBuffer);
+    geometry->SetDrawRange(TRIANGLE_LIST, 0, indices.Size());
+
+    float maxRadius = generator_->GetMaxRadius();
+    collisionModel_ = new Model(context_);
+    collisionModel_->SetNumGeometries(1);
+    collisionModel_->SetGeometry(0, 0, geometry);
+    collisionModel_->SetBoundingBox(BoundingBox(-Vector3::ONE * maxRadius, Vector3::ONE * maxRadius));
+
+    // Every peer generates the same mesh, so these don't need replicating
+    if (body_ == nullptr)
+    {
+        body_ = node_->CreateComponent<RigidBody>(LOCAL);
+        body_->SetTemporary(true);
+        body_->SetCollisionLayer(COLLISION_MASK_PLANET_TERRAIN);
+    }
+    if (shape_ == nullptr)
+    {
+        shape_ = node_->CreateComponent<CollisionShape>(LOCAL);
+        shape_->SetTemporary(true);
+    }
+    shape_->SetTriangleMesh(collisionModel_);
+
+    URHO3D_LOGDEBUGF("Generated planet with seed %d, %u collision triangles", seed_, indices.Size() / 3);
+}
+
+// ----------------------------------------------------------------------------
+void ProceduralPlanet::CreateTerrain()
+{
+    if (terrain_ == nullptr)
+    {
+        terrain_ = node_->CreateComponent<PlanetTerrain>(LOCAL);
+        terrain_->SetTemporary(true);
+    }
+
+    terrain_->SetMaterial(material_);
+    terrain_->SetLodFactor(lodFactor_);
+    terrain_->SetGenerator(generator_, (unsigned)lodLevels_, (unsigned)chunkResolution_);
+}
+
+}
@@ -0,0 +1,230 @@
+#include "Asteroids/AsteroidsLib.hpp"
+#include "Asteroids/Objects/MineController.hpp"
+#include "Asteroids/Objects/PhaserController.hpp"
+#include "Asteroids/Objects/ProjectileRenderer.hpp"
+#include "Asteroids/Util/UpdateRegistry.hpp"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/Geometry.h>
+#include <Urho3D/Graphics/Material.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Node.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/Scene/SceneEvents.h>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+static const char* projectileTypeNames[] = {
+    "Phaser",
+    "Mine",
+    nullptr
+};
+
+// ----------------------------------------------------------------------------
+ProjectileRenderer::ProjectileRenderer(Context* context) :
+    Drawable(context, DRAWABLE_GEOMETRY),
+    modelRadius_(0),
+    type_(PHASER)
+{
+}
+
+// ----------------------------------------------------------------------------
+void ProjectileRenderer::RegisterObject(Context* context)
+{
+    context->RegisterFactory<ProjectileRenderer>(ASTEROIDS_CATEGORY);
+
+    URHO3D_ACCESSOR_ATTRIBUTE("Is Enabled", IsEnabled, SetEnabled, bool, true, AM_DEFAULT);
+    URHO3D_ENUM_ACCESSOR_ATTRIBUTE("Projectile Type", GetProjectileType, SetProjectileType, ProjectileType, projectileTypeNames, PHASER, AM_DEFAULT);
+    URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Model", GetModelAttr, SetModelAttr, ResourceRef, ResourceRef(Model::GetTypeStatic()), AM_DEFAULT);
+    URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Material", GetMaterialAttr, SetMaterialAttr, ResourceRef, ResourceRef(Material::GetTypeStatic()), AM_DEFAULT);
+    URHO3D_COPY_BASE_ATTRIBUTES(Drawable);
+}
+
+// ----------------------------------------------------------------------------
+void ProjectileRenderer::SetProjectileType(ProjectileType type)
+{
+    type_ = type;
+}
+
+// ----------------------------------------------------------------------------
+ProjectileRenderer::ProjectileType ProjectileRenderer::GetProjectileType() const
+{
+    return type_;
+}
+
+// ----------------------------------------------------------------------------
+void ProjectileRenderer::SetModel(Model* model)
+{
+    model_ = model;
+    modelRadius_ = 0;
+    if (model_)
+    {
+        // Instances are only translated and rotated, so a sphere around the
+        // model's origin bounds every possible orientation
+        const BoundingBox& box = model_->GetBoundingBox();
+        modelRadius_ = Max(box.min_.Length(), box.max_.Length());
+    }
+
+    UpdateBatchGeometry();
+}
+
+// ----------------------------------------------------------------------------
+void ProjectileRenderer::SetMaterial(Material* material)
+{
+    material_ = material;
+    for (auto& batch : batches_)
+        batch.material_ = material_;
+}
+
+// ----------------------------------------------------------------------------
+void ProjectileRenderer::UpdateInstances()
+{
+    bool wasEmpty = worldTransforms_.Empty();
+    worldTransforms_.Clear();
+    instancesBox_.Clear();
+
+    switch (type_)
+    {
+        case PHASER : GatherInstances<PhaserController>(); break;
+        case MINE   : GatherInstances<MineController>(); break;
+    }
+
+    // Without batches there is nothing to draw. While there are no
+    // instances there's also no point in moving us around the octree.
+    if (worldTransforms_.Empty())
+    {
+        batches_.Clear();
+        if (wasEmpty)
+            return;
+    }
+    else if (batches_.Empty())
+    {
+        UpdateBatchGeometry();
+    }
+
+    OnMarkedDirty(node_);
+}
+
+// ----------------------------------------------------------------------------
+unsigned ProjectileRenderer::GetNumInstances() const
+{
+    return worldTransforms_.Size();
+}
+
+// ----------------------------------------------------------------------------
+template <class T>
+void ProjectileRenderer::GatherInstances()
+{
+    UpdateRegistry* registry = GetSubsystem<UpdateRegistry>();
+    if (registry == nullptr)
+        return;
+
+    // The registry is shared by all scenes (the client can host a server
+    // scene in the same process), so only pick up our own projectiles
+    Scene* scene = GetScene();
+    const PODVector<void*>& objects = registry->GetObjects<T>();
+    for (unsigned i = 0; i != objects.Size(); ++i)
+    {
+        T* object = static_cast<T*>(objects[i]);
+        if (object == nullptr || object->GetScene() != scene)
+            continue;
+
+        // Phasers calculate their transform when asked, mines return their node's
+        Matrix3x4 transform = object->GetWorldTransform();
+        Vector3 position = transform.Translation();
+        worldTransforms_.Push(transform);
+        instancesBox_.Merge(BoundingBox(position - Vector3::ONE * modelRadius_, position + Vector3::ONE * modelRadius_));
+    }
+}
+
+// ----------------------------------------------------------------------------
+void ProjectileRenderer::UpdateBatches(const FrameInfo& frame)
+{
+    const BoundingBox& worldBoundingBox = GetWorldBoundingBox();
+    distance_ = frame.camera_->GetDistance(worldBoundingBox.Center());
+
+    for (auto& batch : batches_)
+    {
+        batch.distance_ = distance_;
+        batch.worldTransform_ = &worldTransforms_[0];
+        batch.numWorldTransforms_ = worldTransforms_.Size();
+    }
+}
+
+// ----------------------------------------------------------------------------
+ResourceRef ProjectileRenderer::GetModelAttr() const
+{
+    return GetResourceRef(model_, Model::GetTypeStatic());
+}
+
+// ----------------------------------------------------------------------------
+void ProjectileRenderer::SetModelAttr(const ResourceRef& value)
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    SetModel(cache->GetResource<Model>(value.name_));
+}
+
+// ----------------------------------------------------------------------------
+ResourceRef ProjectileRenderer::GetMaterialAttr() const
+{
+    return GetResourceRef(material_, Material::GetTypeStatic());
+}
+
+// ----------------------------------------------------------------------------
+void ProjectileRenderer::SetMaterialAttr(const ResourceRef& value)
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    SetMaterial(cache->GetResource<Material>(value.name_));
+}
+
+// ----------------------------------------------------------------------------
+void ProjectileRenderer::OnSceneSet(Scene* scene)
+{
+    Drawable::OnSceneSet(scene);
+
+    if (scene)
+        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(ProjectileRenderer, HandleScenePostUpdate));
+    else
+        UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
+}
+
+// ----------------------------------------------------------------------------
+void ProjectileRenderer::OnWorldBoundingBoxUpdate()
+{
+    // Transforms are already in world space. With no instances, use an empty
+    // box at our position so the octree still gets a valid one.
+    if (instancesBox_.Defined())
+        worldBoundingBox_ = instancesBox_;
+    else
+        worldBoundingBox_ = BoundingBox(node_->GetWorldPosition(), node_->GetWorldPosition());
+}
+
+// ----------------------------------------------------------------------------
+void ProjectileRenderer::UpdateBatchGeometry()
+{
+    // Batches only exist while there are instances, see UpdateInstances()
+    batches_.Clear();
+    if (model_ == nullptr || worldTransforms_.Empty())
+        return;
+
+    // Projectiles are small, always use the highest LOD
+    const Vector<Vector<SharedPtr<Geometry>>>& geometries = model_->GetGeometries();
+    batches_.Resize(geometries.Size());
+    for (unsigned i = 0; i != geometries.Size(); ++i)
+    {
+        batches_[i].geometry_ = geometries[i][0];
+        batches_[i].material_ = material_;
+    }
+}
+
+// ----------------------------------------------------------------------------
+void ProjectileRenderer::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+{
+    UpdateInstances();
+}
+
+}
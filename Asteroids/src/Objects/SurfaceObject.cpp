@@ -1,5 +1,7 @@
 #include "Asteroids/Globals.hpp"
+#include "Asteroids/Objects/ProceduralPlanet.hpp"
 #include "Asteroids/Objects/SurfaceObject.hpp"
+#include "Asteroids/Util/SphereMath.hpp"
 
 #include <Urho3D/Math/Ray.h>
 #include <Urho3D/Physics/PhysicsWorld.h>
@@ -25,24 +27,55 @@ float SurfaceObject::GetOffsetFromPlanetCenter() const
     return planetHeight_ + surfaceOffset_;
 }
 
+// ----------------------------------------------------------------------------
+Vector3 SurfaceObject::GetWorldPosition() const
+{
+    return node_->GetWorldPosition();
+}
+
+// ----------------------------------------------------------------------------
+const Matrix3x4& SurfaceObject::GetWorldTransform() const
+{
+    return node_->GetWorldTransform();
+}
+
 // ----------------------------------------------------------------------------
 void SurfaceObject::UpdatePosition(const Vector2& localLinearVelocity, float dt)
 {
     Node* pivot = node_->GetParent();
-    Quaternion xrot(2 * M_PI * localLinearVelocity.y_ / planetHeight_ * dt, Vector3::RIGHT);
-    Quaternion zrot(2 * M_PI * localLinearVelocity.x_ / planetHeight_ * dt, Vector3::BACK);
-    pivot->Rotate(xrot * zrot);
+    lastStep_ = SurfaceStep(localLinearVelocity, planetHeight_, dt);
+    pivot->Rotate(lastStep_);
+}
+
+// ----------------------------------------------------------------------------
+Vector3 SurfaceObject::GetPreviousWorldPosition() const
+{
+    // Undo the last step. The pivot sits at the planet's center.
+    Node* pivot = node_->GetParent();
+    return pivot->GetWorldRotation() * lastStep_.Inverse() * node_->GetPosition();
 }
 
 // ----------------------------------------------------------------------------
 void SurfaceObject::UpdatePlanetHeight()
 {
     Scene* scene = GetScene();
-    PhysicsWorld* phy = scene->GetComponent<PhysicsWorld>();
+
+    // Generated planets have a height map, which is a lot cheaper than
+    // raycasting against the terrain. Objects always sit on the pivot's Y
+    // axis, which also works before the object was moved into place.
+    ProceduralPlanet* planet = ProceduralPlanet::GetScenePlanet(scene);
+    if (planet)
+    {
+        Vector3 up = node_->GetParent()->GetWorldRotation() * Vector3::UP;
+        planetHeight_ = Max(1.0f, planet->GetSurfaceRadius(up));
+        return;
+    }
+
+    PhysicsWorld* phy = scene ? scene->GetComponent<PhysicsWorld>() : nullptr;
     if (scene == nullptr || phy == nullptr)
     {
         if (!scene) URHO3D_LOGWARNINGF("Scene is null");
-        if (!phy) URHO3D_LOGWARNINGF("PhysicsWorld is null");
+        else if (!phy) URHO3D_LOGWARNINGF("PhysicsWorld is null");
         planetHeight_ = 1;
         return;
     }
@@ -1,6 +1,7 @@
 #include "Asteroids/AsteroidsLib.hpp"
 #include "Asteroids/Player/ActionState.hpp"
 #include "Asteroids/Player/ActionStateEvents.hpp"
+#include "Asteroids/Player/InputSampler.hpp"
 
 #include <Urho3D/Core/Context.h>
 #include <Urho3D/IO/Deserializer.h>
@@ -13,6 +14,8 @@ namespace Asteroids {
 // ----------------------------------------------------------------------------
 ActionState::ActionState(Urho3D::Context* context) :
     Component(context),
+    sampler_(nullptr),
+    firePressed_(false),
     inputState_({{0}})
 {
 }
@@ -29,10 +32,34 @@ void ActionState::SetState(Data newState)
     VariantMap& eventData = GetEventDataMap();
     uint16_t posEdge = newState & ~inputState_.u16;
 
+    if (posEdge & 0x1000) firePressed_ = true;
     if (posEdge & 0x4000) SendEvent(E_ACTIONWARP, eventData);
     if (posEdge & 0x8000) SendEvent(E_ACTIONUSEITEM, eventData);
 
+    Data oldState = inputState_.u16;
     inputState_.u16 = newState;
+    NotifyChanged(oldState);
+}
+
+// ----------------------------------------------------------------------------
+void ActionState::SetInputSampler(InputSampler* sampler)
+{
+    sampler_ = sampler;
+}
+
+// ----------------------------------------------------------------------------
+void ActionState::NotifyChanged(Data oldState)
+{
+    if (sampler_ && oldState != inputState_.u16)
+        sampler_->Record(inputState_.u16);
+}
+
+// ----------------------------------------------------------------------------
+bool ActionState::ConsumeFirePressed()
+{
+    bool pressed = firePressed_;
+    firePressed_ = false;
+    return pressed;
 }
 
 // ----------------------------------------------------------------------------
@@ -50,7 +77,9 @@ float ActionState::GetLeft() const
 // ----------------------------------------------------------------------------
 void ActionState::SetLeft(float value)
 {
+    Data oldState = inputState_.u16;
     inputState_.data.left = unsigned(value * 0x3F);  // 6 bits of range
+    NotifyChanged(oldState);
 }
 
 // ----------------------------------------------------------------------------
@@ -62,7 +91,9 @@ float ActionState::GetRight() const
 // ----------------------------------------------------------------------------
 void ActionState::SetRight(float value)
 {
+    Data oldState = inputState_.u16;
     inputState_.data.right = unsigned(value * 0x3F);  // 6 bits of range
+    NotifyChanged(oldState);
 }
 
 // ----------------------------------------------------------------------------
@@ -74,7 +105,9 @@ bool ActionState::IsThrusting() const
 // ----------------------------------------------------------------------------
 void ActionState::SetThrusting(bool enable)
 {
+    Data oldState = inputState_.u16;
     inputState_.data.thrust = enable;
+    NotifyChanged(oldState);
 }
 
 // ----------------------------------------------------------------------------
@@ -86,7 +119,11 @@ bool ActionState::IsFiring() const
 // ----------------------------------------------------------------------------
 void ActionState::SetFiring(bool enable)
 {
+    Data oldState = inputState_.u16;
+    if (enable && inputState_.data.fire == false)
+        firePressed_ = true;
     inputState_.data.fire = enable;
+    NotifyChanged(oldState);
 }
 
 // ----------------------------------------------------------------------------
@@ -94,7 +131,9 @@ void ActionState::SetWarp(bool enable)
 {
     if (enable && inputState_.data.warp == false)
         SendEvent(E_ACTIONWARP, GetEventDataMap());
+    Data oldState = inputState_.u16;
     inputState_.data.warp = enable;
+    NotifyChanged(oldState);
 }
 
 // ----------------------------------------------------------------------------
@@ -102,7 +141,9 @@ void ActionState::SetUseItem(bool enable)
 {
     if (enable && inputState_.data.useItem == false)
         SendEvent(E_ACTIONUSEITEM, GetEventDataMap());
+    Data oldState = inputState_.u16;
     inputState_.data.useItem = enable;
+    NotifyChanged(oldState);
 }
 
 }
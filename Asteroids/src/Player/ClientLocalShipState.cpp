@@ -2,9 +2,13 @@
 #include "Asteroids/Player/ActionState.hpp"
 #include "Asteroids/Player/ClientLocalShipState.hpp"
 #include "Asteroids/Player/ShipController.hpp"
+#include "Asteroids/Network/MessageRouter.hpp"
+#include "Asteroids/Network/Messages.hpp"
 #include "Asteroids/Network/Protocol.hpp"
+#include "Asteroids/Util/UpdateRegistry.hpp"
 
 #include <Urho3D/Core/Context.h>
+#include <Urho3D/Input/InputEvents.h>
 #include <Urho3D/IO/MemoryBuffer.h>
 #include <Urho3D/Network/Network.h>
 #include <Urho3D/Network/NetworkEvents.h>
@@ -12,6 +16,9 @@
 #include <Urho3D/IO/Log.h>
 #include <Urho3D/Resource/XMLFile.h>
 
+#include <SDL/SDL_events.h>
+#include <SDL/SDL_timer.h>
+
 using namespace Urho3D;
 
 namespace Asteroids {
@@ -22,8 +29,17 @@ ClientLocalShipState::ClientLocalShipState(Context* context) :
     timeStep_(0),
     lastTimeStep_(0)
 {
-    SubscribeToEvent(E_NETWORKMESSAGE, URHO3D_HANDLER(ClientLocalShipState, HandleNetworkMessage));
+    ReserveMessage(msg_, ClientShipStateMsg::Layout::SIZE + InputSampler::MAX_PENDING * InputTransitionMsg::Layout::SIZE);
+
     SubscribeToEvent(E_NETWORKUPDATE, URHO3D_HANDLER(ClientLocalShipState, HandleNetworkUpdate));
+    SubscribeToEvent(E_SDLRAWINPUT, URHO3D_HANDLER(ClientLocalShipState, HandleSDLRawInput));
+}
+
+// ----------------------------------------------------------------------------
+ClientLocalShipState::~ClientLocalShipState()
+{
+    if (actionState_)
+        actionState_->SetInputSampler(nullptr);
 }
 
 // ----------------------------------------------------------------------------
@@ -39,42 +55,62 @@ void ClientLocalShipState::SetUser(User* user)
 }
 
 // ----------------------------------------------------------------------------
-void ClientLocalShipState::HandleNetworkMessage(StringHash eventType, VariantMap& eventData)
+User* ClientLocalShipState::GetUser() const
 {
-    using namespace NetworkMessage;
-
-    if (eventData[P_MESSAGEID].GetInt() != MSG_SERVER_SHIP_STATE)
-        return;
-    if (user_.Expired())
-        return;
-
-    MemoryBuffer buffer(eventData[P_DATA].GetBuffer());
-    User::GUID guid = buffer.ReadUShort();
-    if (guid != user_->GetGUID())
-        return;
+    return user_;
+}
 
+// ----------------------------------------------------------------------------
+void ClientLocalShipState::ApplyState(const ServerShipStateMsg& state)
+{
     // Only update action state if timestamp is newer than the last one we
     // received
-    uint8_t timeStep = buffer.ReadUByte();
-    if ((signed char)(timeStep - lastTimeStep_) <= 0)
+    if ((signed char)(state.timeStep_ - lastTimeStep_) <= 0)
         return;
 
-    lastTimeStep_ = timeStep;
-
-    Quaternion pivotRotation = buffer.ReadPackedQuaternion();
-    float planetHeight = buffer.ReadFloat();
-    float shipAngle = buffer.ReadFloat();
+    lastTimeStep_ = state.timeStep_;
 
     // TODO prediction. For now just take server state directly
     Node* pivot = node_->GetParent();
-    pivot->SetRotation(pivotRotation);
-    node_->GetComponent<ShipController>()->SetAngle(shipAngle);
+    pivot->SetRotation(state.pivotRotation_);
+    node_->GetComponent<ShipController>()->SetAngle(state.angle_);
+
+    // Server tells us which input transitions it has received, no need to
+    // send those again
+    sampler_.Acknowledge(state.lastInputSequence_);
+}
+
+// ----------------------------------------------------------------------------
+ActionState* ClientLocalShipState::AttachToActionState()
+{
+    if (actionState_.Expired())
+    {
+        actionState_ = GetComponent<ActionState>();
+        if (actionState_)
+            actionState_->SetInputSampler(&sampler_);
+    }
+
+    return actionState_;
+}
+
+// ----------------------------------------------------------------------------
+void ClientLocalShipState::HandleSDLRawInput(StringHash eventType, VariantMap& eventData)
+{
+    using namespace SDLRawInput;
+
+    // This is sent right before the input event is translated into Urho3D
+    // events, which DeviceInputMapper turns into ActionState changes. Use
+    // the time SDL received the event rather than the time the frame gets
+    // around to processing it.
+    const SDL_Event* event = static_cast<const SDL_Event*>(eventData[P_SDLEVENT].GetVoidPtr());
+    sampler_.SetEventTime(event->common.timestamp);
+    AttachToActionState();
 }
 
 // ----------------------------------------------------------------------------
 void ClientLocalShipState::HandleNetworkUpdate(StringHash eventType, VariantMap& eventData)
 {
-    ActionState* state = GetComponent<ActionState>();
+    ActionState* state = AttachToActionState();
     Network* network = GetSubsystem<Network>();
     Connection* connection = network->GetServerConnection();
 
@@ -85,11 +121,30 @@ void ClientLocalShipState::HandleNetworkUpdate(StringHash eventType, VariantMap&
     if (user_.Expired())
         return;
 
+    ClientShipStateMsg header = {
+        user_->GetGUID(),
+        timeStep_++,
+        state->GetState(),
+        (uint8_t)sampler_.GetNumPending()
+    };
     msg_.Clear();
-    msg_.WriteUShort(user_->GetGUID());
-    msg_.WriteUByte(timeStep_++);
-    msg_.WriteUShort(state->GetState());
-    connection->SendMessage(MSG_CLIENT_SHIP_STATE, false, false, msg_);
+    WriteMessage(msg_, header);
+    sampler_.Write(msg_, SDL_GetTicks());
+    GetSubsystem<MessageRouter>()->SendMessage(connection, CHANNEL_STATE, MSG_CLIENT_SHIP_STATE, msg_);
+}
+
+// ----------------------------------------------------------------------------
+void ClientLocalShipState::OnSceneSet(Scene* scene)
+{
+    UpdateRegistry* registry = GetSubsystem<UpdateRegistry>();
+    if (registry == nullptr)
+        return;
+
+    // SnapshotScheduler finds us through the registry
+    if (scene)
+        registry->Track(this);
+    else
+        registry->Remove(this);
 }
 
 }
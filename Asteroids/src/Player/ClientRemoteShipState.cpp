@@ -2,7 +2,9 @@
 #include "Asteroids/Player/ActionState.hpp"
 #include "Asteroids/Player/ClientRemoteShipState.hpp"
 #include "Asteroids/Player/ShipController.hpp"
+#include "Asteroids/Network/Messages.hpp"
 #include "Asteroids/Network/Protocol.hpp"
+#include "Asteroids/Util/UpdateRegistry.hpp"
 
 #include <Urho3D/Core/Context.h>
 #include <Urho3D/IO/MemoryBuffer.h>
@@ -22,7 +24,6 @@ ClientRemoteShipState::ClientRemoteShipState(Context* context) :
     timeStep_(0),
     lastTimeStep_(0)
 {
-    SubscribeToEvent(E_NETWORKMESSAGE, URHO3D_HANDLER(ClientRemoteShipState, HandleNetworkMessage));
 }
 
 // ----------------------------------------------------------------------------
@@ -38,37 +39,40 @@ void ClientRemoteShipState::SetUser(User* user)
 }
 
 // ----------------------------------------------------------------------------
-void ClientRemoteShipState::HandleNetworkMessage(StringHash eventType, VariantMap& eventData)
+User* ClientRemoteShipState::GetUser() const
 {
-    using namespace NetworkMessage;
-
-    if (eventData[P_MESSAGEID].GetInt() != MSG_SERVER_SHIP_STATE)
-        return;
-    if (user_.Expired())
-        return;
-
-    MemoryBuffer buffer(eventData[P_DATA].GetBuffer());
-    User::GUID guid = buffer.ReadUShort();
-    if (guid != user_->GetGUID())
-        return;
+    return user_;
+}
 
+// ----------------------------------------------------------------------------
+void ClientRemoteShipState::ApplyState(const ServerShipStateMsg& state)
+{
     // Only update action state if timestamp is newer than the last one we
     // received
-    uint8_t timeStep = buffer.ReadUByte();
-    if ((signed char)(timeStep - lastTimeStep_) <= 0)
+    if ((signed char)(state.timeStep_ - lastTimeStep_) <= 0)
         return;
 
-    lastTimeStep_ = timeStep;
-
-    Quaternion pivotRotation = buffer.ReadPackedQuaternion();
-    float planetHeight = buffer.ReadFloat();
-    float shipAngle = buffer.ReadFloat();
+    lastTimeStep_ = state.timeStep_;
 
     // TODO prediction. For now just take server state directly
     Node* pivot = node_->GetParent();
-    pivot->SetRotation(pivotRotation);
-    node_->SetPosition(Vector3(0, planetHeight, 0));
-    node_->SetRotation(Quaternion(0, shipAngle, 0));
+    pivot->SetRotation(state.pivotRotation_);
+    node_->SetPosition(Vector3(0, state.offsetFromPlanetCenter_, 0));
+    node_->SetRotation(Quaternion(0, state.angle_, 0));
+}
+
+// ----------------------------------------------------------------------------
+void ClientRemoteShipState::OnSceneSet(Scene* scene)
+{
+    UpdateRegistry* registry = GetSubsystem<UpdateRegistry>();
+    if (registry == nullptr)
+        return;
+
+    // SnapshotScheduler finds us through the registry
+    if (scene)
+        registry->Track(this);
+    else
+        registry->Remove(this);
 }
 
 }
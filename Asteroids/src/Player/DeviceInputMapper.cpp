@@ -68,37 +68,19 @@ void DeviceInputMapper::SetConfig(Urho3D::XMLFile* mappingConfig)
 // ----------------------------------------------------------------------------
 void DeviceInputMapper::UpdateMappingFromConfig()
 {
-    mappings_.Clear();
+    devices_.Clear();
 
     XMLElement devices = configFile_->GetRoot();
     for (XMLElement device = devices.GetChild("device"); device; device = device.GetNext("device"))
     {
-        Mapping mapping = {0};
-
-        // Determine the device ID by scanning all connected devices. Kind of
-        // hackish: The keyboard is considered id=-1 because joystick IDs start
-        // at ID 0.
-        mapping.deviceID = -1;
-        String deviceName = device.GetAttribute("name");
-        Input* input = GetSubsystem<Input>();
-        for (int i = 0; i != input->GetNumJoysticks(); ++i)
-        {
-            JoystickState* js = input->GetJoystickByIndex(i);
-            if (deviceName == js->name_)
-            {
-                mapping.deviceID = js->joystickID_;
-                break;
-            }
-        }
-        if (mapping.deviceID == -1 && deviceName != "keyboard")
-        {
-            URHO3D_LOGDEBUGF("Device \"%s\" is not connected, skip reading mappings", deviceName.CString());
-            continue;
-        }
+        DeviceMappings deviceMappings;
+        deviceMappings.name_ = device.GetAttribute("name");
 
         // Map all actions to buttons
         for (XMLElement action = device.GetChild("action"); action; action = action.GetNext("action"))
         {
+            Mapping mapping = {0};
+
             // Determine the action being mapped
             String actionName = action.GetAttribute("name");
             if (actionName == "Left")         mapping.actionID = A_LEFT;
@@ -120,12 +102,103 @@ void DeviceInputMapper::UpdateMappingFromConfig()
             else if (action.HasAttribute("hat") && action.HasAttribute("position")) { mapping.type = T_HAT;  mapping.buttonID = action.GetInt("hat"); mapping.position = action.GetInt("position"); }
             else
             {
-                URHO3D_LOGERRORF("Unknown input type, or no input was specified, for action \"%s\" device \"%s\" while reading config file \"%s\"", actionName.CString(), deviceName.CString(), configFile_->GetName().CString());
+                URHO3D_LOGERRORF("Unknown input type, or no input was specified, for action \"%s\" device \"%s\" while reading config file \"%s\"", actionName.CString(), deviceMappings.name_.CString(), configFile_->GetName().CString());
                 continue;
             }
 
-            mappings_.Push(mapping);
+            deviceMappings.mappings_.Push(mapping);
+        }
+
+        devices_.Push(deviceMappings);
+    }
+
+    // Compile lookup table for the keyboard and all devices that are
+    // currently connected. The keyboard is considered id=-1 because joystick
+    // IDs start at ID 0.
+    bindings_.Clear();
+    AddDevice(-1, "keyboard");
+    Input* input = GetSubsystem<Input>();
+    for (unsigned i = 0; i != input->GetNumJoysticks(); ++i)
+    {
+        JoystickState* js = input->GetJoystickByIndex(i);
+        AddDevice(js->joystickID_, js->name_);
+    }
+}
+
+// ----------------------------------------------------------------------------
+void DeviceInputMapper::AddDevice(int deviceID, const String& name)
+{
+    const DeviceMappings* device = nullptr;
+    for (const auto& candidate : devices_)
+        if (candidate.name_ == name)
+        {
+            device = &candidate;
+            break;
+        }
+
+    if (device == nullptr)
+    {
+        URHO3D_LOGDEBUGF("No mappings for device \"%s\"", name.CString());
+        return;
+    }
+
+    for (const Mapping& mapping : device->mappings_)
+    {
+        InputKey key = {deviceID, mapping.type, mapping.buttonID};
+        HashMap<InputKey, Binding>::Iterator it = bindings_.Find(key);
+        if (it == bindings_.End())
+        {
+            it = bindings_.Insert(MakePair(key, Binding()));
+            it->second_.count_ = 0;
         }
+
+        Binding& binding = it->second_;
+        if (binding.count_ == Binding::MAX_ACTIONS)
+        {
+            URHO3D_LOGERRORF("Too many actions mapped to the same input on device \"%s\", ignoring", name.CString());
+            continue;
+        }
+
+        binding.actions_[binding.count_].actionID = mapping.actionID;
+        binding.actions_[binding.count_].position = mapping.position;
+        binding.count_++;
+    }
+}
+
+// ----------------------------------------------------------------------------
+void DeviceInputMapper::RemoveDevice(int deviceID)
+{
+    for (HashMap<InputKey, Binding>::Iterator it = bindings_.Begin(); it != bindings_.End(); )
+    {
+        if (it->first_.deviceID_ == deviceID)
+            it = bindings_.Erase(it);
+        else
+            ++it;
+    }
+}
+
+// ----------------------------------------------------------------------------
+const DeviceInputMapper::Binding* DeviceInputMapper::FindBinding(int deviceID, InputType type, int code) const
+{
+    InputKey key = {deviceID, type, code};
+    HashMap<InputKey, Binding>::ConstIterator it = bindings_.Find(key);
+    return it != bindings_.End() ? &it->second_ : nullptr;
+}
+
+// ----------------------------------------------------------------------------
+void DeviceInputMapper::ApplyAction(ActionState* state, ActionID actionID, float value)
+{
+    // Digital actions are triggered by analog inputs past this point
+    const float threshold = 0.4;
+
+    switch(actionID)
+    {
+        case A_LEFT    : state->SetLeft(value);                  break;
+        case A_RIGHT   : state->SetRight(value);                 break;
+        case A_FIRE    : state->SetFiring(value > threshold);    break;
+        case A_THRUST  : state->SetThrusting(value > threshold); break;
+        case A_WARP    : state->SetWarp(value > threshold);      break;
+        case A_USEITEM : state->SetUseItem(value > threshold);   break;
     }
 }
 
@@ -137,8 +210,10 @@ void DeviceInputMapper::HandleJoystickConnected(StringHash eventType, VariantMap
     JoystickState* js = GetSubsystem<Input>()->GetJoystick(id);
     URHO3D_LOGINFOF("Connected joystick \"%s\", id: %d", js->name_.CString(), id);
 
-    if (configFile_)
-        UpdateMappingFromConfig();
+    // Make sure we don't end up with duplicates if the device was already
+    // picked up when the config was loaded
+    RemoveDevice(id);
+    AddDevice(id, js->name_);
 }
 
 // ----------------------------------------------------------------------------
@@ -148,8 +223,7 @@ void DeviceInputMapper::HandleJoystickDisconnected(StringHash eventType, Variant
     int id = eventData[P_JOYSTICKID].GetInt();
     URHO3D_LOGINFOF("Disconnected joystick id: %d", id);
 
-    if (configFile_)
-        UpdateMappingFromConfig();
+    RemoveDevice(id);
 }
 
 // ----------------------------------------------------------------------------
@@ -157,26 +231,13 @@ void DeviceInputMapper::HandleJoystickButtonDown(StringHash eventType, VariantMa
 {
     using namespace JoystickButtonDown;
 
-    int joyID = eventData[P_JOYSTICKID].GetInt();
-    int buttonID = eventData[P_BUTTON].GetInt();
+    const Binding* binding = FindBinding(eventData[P_JOYSTICKID].GetInt(), T_BUTTON, eventData[P_BUTTON].GetInt());
     ActionState* state = GetComponent<ActionState>();
-    if (state == nullptr)
+    if (binding == nullptr || state == nullptr)
         return;
 
-    for (const Mapping& mapping : mappings_)
-        if (mapping.deviceID == joyID && mapping.type == T_BUTTON && mapping.buttonID == buttonID)
-        {
-            switch(mapping.actionID)
-            {
-                case A_LEFT    : state->SetLeft(1.0);       break;
-                case A_RIGHT   : state->SetRight(1.0);      break;
-                case A_THRUST  : state->SetThrusting(true); break;
-                case A_FIRE    : state->SetFiring(true);    break;
-                case A_WARP    : state->SetWarp(true);      break;
-                case A_USEITEM : state->SetUseItem(true);   break;
-            }
-            break;
-        }
+    for (unsigned i = 0; i != binding->count_; ++i)
+        ApplyAction(state, binding->actions_[i].actionID, 1.0f);
 }
 
 // ----------------------------------------------------------------------------
@@ -184,26 +245,13 @@ void DeviceInputMapper::HandleJoystickButtonUp(StringHash eventType, VariantMap&
 {
     using namespace JoystickButtonUp;
 
-    int joyID = eventData[P_JOYSTICKID].GetInt();
-    int buttonID = eventData[P_BUTTON].GetInt();
+    const Binding* binding = FindBinding(eventData[P_JOYSTICKID].GetInt(), T_BUTTON, eventData[P_BUTTON].GetInt());
     ActionState* state = GetComponent<ActionState>();
-    if (state == nullptr)
+    if (binding == nullptr || state == nullptr)
         return;
 
-    for (const Mapping& mapping : mappings_)
-        if (mapping.deviceID == joyID && mapping.type == T_BUTTON && mapping.buttonID == buttonID)
-        {
-            switch(mapping.actionID)
-            {
-                case A_LEFT    : state->SetLeft(0.0);        break;
-                case A_RIGHT   : state->SetRight(0.0);       break;
-                case A_THRUST  : state->SetThrusting(false); break;
-                case A_FIRE    : state->SetFiring(false);    break;
-                case A_WARP    : state->SetWarp(false);      break;
-                case A_USEITEM : state->SetUseItem(false);   break;
-            }
-            break;
-        }
+    for (unsigned i = 0; i != binding->count_; ++i)
+        ApplyAction(state, binding->actions_[i].actionID, 0.0f);
 }
 
 // ----------------------------------------------------------------------------
@@ -211,27 +259,14 @@ void DeviceInputMapper::HandleJoystickAxisMove(StringHash eventType, VariantMap&
 {
     using namespace JoystickAxisMove;
 
-    int joyID = eventData[P_JOYSTICKID].GetInt();
-    int axisID = eventData[P_AXIS].GetInt();
-    float position = eventData[P_POSITION].GetFloat();
-    const float threshold = 0.4;
+    const Binding* binding = FindBinding(eventData[P_JOYSTICKID].GetInt(), T_AXIS, eventData[P_AXIS].GetInt());
     ActionState* state = GetComponent<ActionState>();
-    if (state == nullptr)
+    if (binding == nullptr || state == nullptr)
         return;
 
-    for (const Mapping& mapping : mappings_)
-        if (mapping.deviceID == joyID && mapping.type == T_AXIS && mapping.buttonID == axisID)
-        {
-            switch(mapping.actionID)
-            {
-                case A_LEFT    : state->SetLeft(Max(position * mapping.position, 0)); break;
-                case A_RIGHT   : state->SetRight(Max(position * mapping.position, 0)); break;
-                case A_FIRE    : state->SetFiring(Max(position * mapping.position, 0) > threshold); break;
-                case A_THRUST  : state->SetThrusting(Max(position * mapping.position, 0) > threshold); break;
-                case A_WARP    : state->SetWarp(Max(position * mapping.position, 0) > threshold); break;
-                case A_USEITEM : state->SetUseItem(Max(position * mapping.position, 0) > threshold); break;
-            }
-        }
+    float position = eventData[P_POSITION].GetFloat();
+    for (unsigned i = 0; i != binding->count_; ++i)
+        ApplyAction(state, binding->actions_[i].actionID, Max(position * binding->actions_[i].position, 0.0f));
 }
 
 // ----------------------------------------------------------------------------
@@ -239,26 +274,14 @@ void DeviceInputMapper::HandleJoystickHatMove(StringHash eventType, VariantMap&
 {
     using namespace JoystickHatMove;
 
-    int joyID = eventData[P_JOYSTICKID].GetInt();
-    int hatID = eventData[P_HAT].GetInt();
-    int position = eventData[P_POSITION].GetInt();
+    const Binding* binding = FindBinding(eventData[P_JOYSTICKID].GetInt(), T_HAT, eventData[P_HAT].GetInt());
     ActionState* state = GetComponent<ActionState>();
-    if (state == nullptr)
+    if (binding == nullptr || state == nullptr)
         return;
 
-    for (const Mapping& mapping : mappings_)
-        if (mapping.deviceID == joyID && mapping.type == T_HAT && mapping.buttonID == hatID)
-        {
-            switch(mapping.actionID)
-            {
-                case A_LEFT    : state->SetLeft(position & mapping.position ? 1.0 : 0.0);  break;
-                case A_RIGHT   : state->SetRight(position & mapping.position ? 1.0 : 0.0); break;
-                case A_FIRE    : state->SetFiring(position & mapping.position ? true : false); break;
-                case A_THRUST  : state->SetThrusting(position & mapping.position ? true : false); break;
-                case A_WARP    : state->SetWarp(position & mapping.position ? true : false); break;
-                case A_USEITEM : state->SetUseItem(position & mapping.position ? true : false); break;
-            }
-        }
+    int position = eventData[P_POSITION].GetInt();
+    for (unsigned i = 0; i != binding->count_; ++i)
+        ApplyAction(state, binding->actions_[i].actionID, position & binding->actions_[i].position ? 1.0f : 0.0f);
 }
 
 // ----------------------------------------------------------------------------
@@ -266,25 +289,13 @@ void DeviceInputMapper::HandleKeyDown(StringHash eventType, VariantMap& eventDat
 {
     using namespace KeyDown;
 
-    int keyID = eventData[P_KEY].GetInt();
+    const Binding* binding = FindBinding(-1, T_KEY, eventData[P_KEY].GetInt());
     ActionState* state = GetComponent<ActionState>();
-    if (state == nullptr)
+    if (binding == nullptr || state == nullptr)
         return;
 
-    for (const Mapping& mapping : mappings_)
-        if (mapping.deviceID == -1 && mapping.type == T_KEY && mapping.buttonID == keyID)
-        {
-            switch(mapping.actionID)
-            {
-                case A_LEFT    : state->SetLeft(1.0);       break;
-                case A_RIGHT   : state->SetRight(1.0);      break;
-                case A_THRUST  : state->SetThrusting(true); break;
-                case A_FIRE    : state->SetFiring(true);    break;
-                case A_WARP    : state->SetWarp(true);      break;
-                case A_USEITEM : state->SetUseItem(true);   break;
-            }
-            break;
-        }
+    for (unsigned i = 0; i != binding->count_; ++i)
+        ApplyAction(state, binding->actions_[i].actionID, 1.0f);
 }
 
 // ----------------------------------------------------------------------------
@@ -292,25 +303,13 @@ void DeviceInputMapper::HandleKeyUp(StringHash eventType, VariantMap& eventData)
 {
     using namespace KeyUp;
 
-    int keyID = eventData[P_KEY].GetInt();
+    const Binding* binding = FindBinding(-1, T_KEY, eventData[P_KEY].GetInt());
     ActionState* state = GetComponent<ActionState>();
-    if (state == nullptr)
+    if (binding == nullptr || state == nullptr)
         return;
 
-    for (const Mapping& mapping : mappings_)
-        if (mapping.deviceID == -1 && mapping.type == T_KEY && mapping.buttonID == keyID)
-        {
-            switch(mapping.actionID)
-            {
-                case A_LEFT    : state->SetLeft(0.0);        break;
-                case A_RIGHT   : state->SetRight(0.0);       break;
-                case A_THRUST  : state->SetThrusting(false); break;
-                case A_FIRE    : state->SetFiring(false);    break;
-                case A_WARP    : state->SetWarp(false);      break;
-                case A_USEITEM : state->SetUseItem(false);   break;
-            }
-            break;
-        }
+    for (unsigned i = 0; i != binding->count_; ++i)
+        ApplyAction(state, binding->actions_[i].actionID, 0.0f);
 }
 
 // ----------------------------------------------------------------------------
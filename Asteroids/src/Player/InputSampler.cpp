@@ -0,0 +1,65 @@
+#include "Asteroids/Network/Messages.hpp"
+#include "Asteroids/Player/InputSampler.hpp"
+
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Math/MathDefs.h>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+// ----------------------------------------------------------------------------
+InputSampler::InputSampler() :
+    eventTimeMs_(0),
+    nextSequence_(1)
+{
+}
+
+// ----------------------------------------------------------------------------
+void InputSampler::SetEventTime(uint32_t timeMs)
+{
+    eventTimeMs_ = timeMs;
+}
+
+// ----------------------------------------------------------------------------
+void InputSampler::Record(uint16_t state)
+{
+    Transition transition = {eventTimeMs_, nextSequence_, state};
+
+    // If the server stops acknowledging for a long time the queue fills up
+    // and further transitions are dropped. The state snapshot that is sent
+    // along with every packet still brings the server up to date.
+    if (pending_.Push(transition))
+        nextSequence_++;
+}
+
+// ----------------------------------------------------------------------------
+void InputSampler::Acknowledge(Sequence sequence)
+{
+    while (pending_.Empty() == false && IsNewer(pending_.Peek().sequence_, sequence) == false)
+        pending_.Pop();
+}
+
+// ----------------------------------------------------------------------------
+unsigned InputSampler::GetNumPending() const
+{
+    return pending_.Size();
+}
+
+// ----------------------------------------------------------------------------
+void InputSampler::Write(VectorBuffer& dest, uint32_t nowMs) const
+{
+    unsigned count = pending_.Size();
+    for (unsigned i = 0; i != count; ++i)
+    {
+        const Transition& transition = pending_.Peek(i);
+        InputTransitionMsg msg = {
+            transition.sequence_,
+            (uint16_t)Min(nowMs - transition.timeMs_, 0xFFFFu),
+            transition.state_
+        };
+        WriteMessage(dest, msg);
+    }
+}
+
+}
@@ -1,8 +1,8 @@
 #include "Asteroids/Player/OrbitingCameraController.hpp"
 #include "Asteroids/AsteroidsLib.hpp"
+#include "Asteroids/Util/UpdateRegistry.hpp"
 
 #include <Urho3D/Core/Context.h>
-#include <Urho3D/Core/CoreEvents.h>
 #include <Urho3D/Resource/ResourceCache.h>
 #include <Urho3D/Resource/ResourceEvents.h>
 #include <Urho3D/Resource/XMLFile.h>
@@ -33,7 +33,6 @@ void OrbitingCameraController::SetConfig(XMLFile* config)
 {
     if (configFile_)
     {
-        UnsubscribeFromEvent(E_UPDATE);
         UnsubscribeFromEvent(E_FILECHANGED);
     }
 
@@ -41,7 +40,6 @@ void OrbitingCameraController::SetConfig(XMLFile* config)
 
     if (configFile_)
     {
-        SubscribeToEvent(E_UPDATE, URHO3D_HANDLER(OrbitingCameraController, HandleUpdate));
         SubscribeToEvent(E_FILECHANGED, URHO3D_HANDLER(OrbitingCameraController, HandleFileChanged));
         ParseCamConfig();
     }
@@ -91,31 +89,27 @@ void OrbitingCameraController::HandleFileChanged(StringHash eventType, VariantMa
 // ----------------------------------------------------------------------------
 void OrbitingCameraController::SetTrackNode(Node* nodeToTrack)
 {
-    if (trackNode_)
-    {
-        UnsubscribeFromEvent(E_UPDATE);
-    }
-
     trackNode_ = nodeToTrack;
-
-    if (trackNode_)
-    {
-        SubscribeToEvent(E_UPDATE, URHO3D_HANDLER(OrbitingCameraController, HandleUpdate));
-    }
 }
 
 // ----------------------------------------------------------------------------
-void OrbitingCameraController::HandleUpdate(StringHash eventType, VariantMap& eventData)
+void OrbitingCameraController::OnSceneSet(Scene* scene)
 {
-    using namespace Update;
+    UpdateRegistry* registry = GetSubsystem<UpdateRegistry>();
+    if (registry == nullptr)
+        return;
 
-    float dt = eventData[P_TIMESTEP].GetFloat();
+    if (scene)
+        registry->Add(this, UpdateRegistry::CAMERA);
+    else
+        registry->Remove(this);
+}
 
-    if (trackNode_.Expired())
-    {
-        SetTrackNode(nullptr);
+// ----------------------------------------------------------------------------
+void OrbitingCameraController::Update(float dt)
+{
+    if (trackNode_.Expired() || configFile_ == nullptr)
         return;
-    }
 
     const Vector3& trackPos = trackNode_->GetWorldPosition();
     const Quaternion& trackDir = trackNode_->GetWorldRotation();
@@ -1,10 +1,14 @@
 #include "Asteroids/AsteroidsLib.hpp"
 #include "Asteroids/Player/ActionState.hpp"
 #include "Asteroids/Player/ServerShipState.hpp"
+#include "Asteroids/Network/MessageView.hpp"
+#include "Asteroids/Network/Messages.hpp"
 #include "Asteroids/Network/Protocol.hpp"
 #include "Asteroids/UserRegistry/User.hpp"
+#include "Asteroids/Util/UpdateRegistry.hpp"
 
 #include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Timer.h>
 #include <Urho3D/IO/MemoryBuffer.h>
 #include <Urho3D/Network/NetworkEvents.h>
 #include <Urho3D/Network/Connection.h>
@@ -22,16 +26,22 @@ namespace Asteroids {
 // ----------------------------------------------------------------------------
 ServerShipState::ServerShipState(Context* context) :
     Component(context),
-    lastTimeStep_(0)
+    lastInputSequence_(0),
+    lastDueTime_(0),
+    snapshotState_(0),
+    lastTimeStep_(0),
+    health_(100),
+    maxHealth_(100)
 {
     SubscribeToEvent(E_NETWORKMESSAGE, URHO3D_HANDLER(ServerShipState, HandleNetworkMessage));
-    SubscribeToEvent(E_NETWORKUPDATE, URHO3D_HANDLER(ServerShipState, HandleNetworkUpdate));
 }
 
 // ----------------------------------------------------------------------------
 void ServerShipState::RegisterObject(Context* context)
 {
     context->RegisterFactory<ServerShipState>(ASTEROIDS_CATEGORY);
+
+    URHO3D_ATTRIBUTE("Max Health", float, maxHealth_, 100.0f, AM_DEFAULT);
 }
 
 // ----------------------------------------------------------------------------
@@ -41,49 +51,123 @@ void ServerShipState::SetUser(User* user)
 }
 
 // ----------------------------------------------------------------------------
-void ServerShipState::HandleNetworkMessage(StringHash eventType, VariantMap& eventData)
+User* ServerShipState::GetUser() const
+{
+    return user_;
+}
+
+// ----------------------------------------------------------------------------
+float ServerShipState::GetHealth() const
+{
+    return health_;
+}
+
+// ----------------------------------------------------------------------------
+bool ServerShipState::ApplyDamage(float damage)
 {
-    using namespace NetworkMessage;
+    health_ -= damage;
+    if (health_ > 0)
+        return false;
+
+    // No death sequence yet, the ship just starts over
+    health_ = maxHealth_;
+    return true;
+}
 
-    if (eventData[P_MESSAGEID].GetInt() != MSG_CLIENT_SHIP_STATE)
+// ----------------------------------------------------------------------------
+void ServerShipState::WriteState(VectorBuffer& msg) const
+{
+    Node* pivot = node_->GetParent();
+    ShipController* ship = node_->GetComponent<ShipController>();
+
+    ServerShipStateMsg state = {
+        user_ ? user_->GetGUID() : User::INVALID_GUID,
+        lastTimeStep_,
+        pivot->GetRotation(),
+        ship->GetOffsetFromPlanetCenter(),
+        ship->GetAngle(),
+        lastInputSequence_
+    };
+    WriteMessage(msg, state);
+}
+
+// ----------------------------------------------------------------------------
+void ServerShipState::HandleNetworkMessage(StringHash eventType, VariantMap& eventData)
+{
+    MessageView message(eventData);
+    if (message.GetID() != MSG_CLIENT_SHIP_STATE)
         return;
     if (user_.Expired())
         return;
 
-    MemoryBuffer buffer(eventData[P_DATA].GetBuffer());
-    User::GUID userGUID = buffer.ReadUShort();
+    MemoryBuffer& buffer = message.GetBuffer();
+    ClientShipStateMsg header;
+    if (ReadMessage(buffer, &header) == false)
+        return;
 
-    if (userGUID != user_->GetGUID())
+    if (header.guid_ != user_->GetGUID())
         return;
 
     // Only update action state if timestamp is newer than the last one we
     // received
-    uint8_t timeStep = buffer.ReadUByte();
-    if ((signed char)(timeStep - lastTimeStep_) <= 0)
+    if ((signed char)(header.timeStep_ - lastTimeStep_) <= 0)
         return;
 
-    lastTimeStep_ = timeStep;
-
-    ActionState* actionState = GetComponent<ActionState>();
-    ActionState::Data state = buffer.ReadUShort();
-    actionState->SetState(state);
+    lastTimeStep_ = header.timeStep_;
+    snapshotState_ = header.state_;
+
+    // Schedule all transitions we haven't seen yet. A transition that
+    // happened ageMs before the client sent the packet is applied ageMs
+    // before one network tick from now.
+    float now = GetSubsystem<Time>()->GetElapsedTime();
+    float playbackDelay = 1.0f / GetSubsystem<Network>()->GetUpdateFps();
+    InputTransitionMsg transition;
+    for (unsigned i = 0; i != header.numTransitions_ && ReadMessage(buffer, &transition); ++i)
+    {
+        if (InputSampler::IsNewer(transition.sequence_, lastInputSequence_) == false)
+            continue;
+
+        // Keep the queue sorted even if latency changes between packets
+        PendingInput input = {Max(lastDueTime_, now + playbackDelay - transition.ageMs_ * 0.001f), transition.state_};
+        if (pendingInputs_.Push(input) == false)
+            break;  // Snapshot will catch us up
+
+        lastDueTime_ = input.dueTime_;
+        lastInputSequence_ = transition.sequence_;
+    }
 }
 
 // ----------------------------------------------------------------------------
-void ServerShipState::HandleNetworkUpdate(StringHash eventType, VariantMap& eventData)
+void ServerShipState::OnSceneSet(Scene* scene)
 {
-    Node* pivot = node_->GetParent();
+    UpdateRegistry* registry = GetSubsystem<UpdateRegistry>();
+    if (registry == nullptr)
+        return;
 
-    if (user_.Expired())
+    if (scene)
+        registry->Add(this, UpdateRegistry::INPUT);
+    else
+        registry->Remove(this);
+}
+
+// ----------------------------------------------------------------------------
+void ServerShipState::Update(float dt)
+{
+    ActionState* actionState = GetComponent<ActionState>();
+    if (actionState == nullptr)
         return;
 
-    msg_.Clear();
-    msg_.WriteUShort(user_->GetGUID());
-    msg_.WriteUByte(lastTimeStep_);
-    msg_.WritePackedQuaternion(pivot->GetRotation());
-    msg_.WriteFloat(node_->GetComponent<ShipController>()->GetOffsetFromPlanetCenter());
-    msg_.WriteFloat(node_->GetComponent<ShipController>()->GetAngle());
-    GetSubsystem<Network>()->BroadcastMessage(MSG_SERVER_SHIP_STATE, false, false, msg_);
+    float now = GetSubsystem<Time>()->GetElapsedTime();
+    while (pendingInputs_.Empty() == false && pendingInputs_.Peek().dueTime_ <= now)
+    {
+        actionState->SetState(pendingInputs_.Peek().state_);
+        pendingInputs_.Pop();
+    }
+
+    // The latest snapshot is the state after all transitions the client had
+    // made when it sent the packet. Only needed if transitions were dropped.
+    if (pendingInputs_.Empty() && actionState->GetState() != snapshotState_)
+        actionState->SetState(snapshotState_);
 }
 
 }
@@ -2,9 +2,10 @@
 #include "Asteroids/Globals.hpp"
 #include "Asteroids/Player/ShipController.hpp"
 #include "Asteroids/Player/ActionState.hpp"
+#include "Asteroids/Util/SphereMath.hpp"
+#include "Asteroids/Util/UpdateRegistry.hpp"
 
 #include <Urho3D/Core/Context.h>
-#include <Urho3D/Core/CoreEvents.h>
 #include <Urho3D/Graphics/Material.h>
 #include <Urho3D/Graphics/Model.h>
 #include <Urho3D/Resource/ResourceCache.h>
@@ -41,7 +42,6 @@ void ShipController::SetConfig(XMLFile* config)
 {
     if (configFile_)
     {
-        UnsubscribeFromEvent(E_UPDATE);
         UnsubscribeFromEvent(E_FILECHANGED);
     }
 
@@ -49,7 +49,6 @@ void ShipController::SetConfig(XMLFile* config)
 
     if (configFile_)
     {
-        SubscribeToEvent(E_UPDATE, URHO3D_HANDLER(ShipController, HandleUpdate));
         SubscribeToEvent(E_FILECHANGED, URHO3D_HANDLER(ShipController, HandleFileChanged));
         ParseShipConfig();
     }
@@ -105,11 +104,25 @@ void ShipController::ParseShipConfig()
 }
 
 // ----------------------------------------------------------------------------
-void ShipController::HandleUpdate(StringHash eventType, VariantMap& eventData)
+void ShipController::OnSceneSet(Scene* scene)
 {
-    using namespace Update;
+    UpdateRegistry* registry = GetSubsystem<UpdateRegistry>();
+    if (registry == nullptr)
+        return;
+
+    if (scene)
+        registry->Add(this, UpdateRegistry::SHIP);
+    else
+        registry->Remove(this);
+}
+
+// ----------------------------------------------------------------------------
+void ShipController::Update(float dt)
+{
+    // Config is required for the ship to move
+    if (configFile_ == nullptr)
+        return;
 
-    float dt = eventData[P_TIMESTEP].GetFloat();
     ActionState* state = GetComponent<ActionState>();
     if (state == nullptr)
         return;
@@ -123,8 +136,7 @@ void ShipController::HandleUpdate(StringHash eventType, VariantMap& eventData)
     if (state->IsThrusting())
     {
         // Update player speed
-        velocity_.x_ += Sin(angle_) * shipConfig_.acceleration_ * dt;
-        velocity_.y_ += Cos(angle_) * shipConfig_.acceleration_ * dt;
+        velocity_ += HeadingToVector(angle_) * shipConfig_.acceleration_ * dt;
 
         // Speed limit
         float currentSpeedSquared = velocity_.LengthSquared();
@@ -134,12 +146,7 @@ void ShipController::HandleUpdate(StringHash eventType, VariantMap& eventData)
     else
     {
         // Velocity decays over time
-        float vlength = velocity_.Length();
-        float decay = vlength * dt * shipConfig_.velocityDecay_;
-        decay = Min(decay, vlength);  // In case of very large timesteps
-        float angleOfTrajectory = Atan2(velocity_.y_, velocity_.x_);
-        velocity_.x_ -= Cos(angleOfTrajectory) * decay;
-        velocity_.y_ -= Sin(angleOfTrajectory) * decay;
+        velocity_ = DecayVelocity(velocity_, shipConfig_.velocityDecay_, dt);
     }
 
     UpdatePosition(velocity_, dt);
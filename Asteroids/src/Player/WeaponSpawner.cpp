@@ -1,13 +1,17 @@
 #include "Asteroids/AsteroidsLib.hpp"
 #include "Asteroids/Objects/PhaserController.hpp"
+#include "Asteroids/Objects/PhaserReplicator.hpp"
 #include "Asteroids/Objects/MineController.hpp"
 #include "Asteroids/Player/ActionState.hpp"
 #include "Asteroids/Player/ActionStateEvents.hpp"
+#include "Asteroids/Player/ServerShipState.hpp"
 #include "Asteroids/Player/ShipController.hpp"
 #include "Asteroids/Player/WeaponSpawner.hpp"
+#include "Asteroids/Util/Prefab.hpp"
+#include "Asteroids/Util/SphereMath.hpp"
+#include "Asteroids/Util/UpdateRegistry.hpp"
 
 #include <Urho3D/Core/Context.h>
-#include <Urho3D/Core/CoreEvents.h>
 #include <Urho3D/IO/Log.h>
 #include <Urho3D/Resource/ResourceCache.h>
 #include <Urho3D/Resource/ResourceEvents.h>
@@ -23,12 +27,14 @@ namespace Asteroids {
 // ----------------------------------------------------------------------------
 WeaponSpawner::WeaponSpawner(Context* context) :
     Component(context),
-    fireActionCooldown_(0)
+    phaserCooldown_(TimerWheel::INVALID_TIMER)
 {
-    configXML_ = GetSubsystem<ResourceCache>()->GetResource<XMLFile>("Config/WeaponSpawner.xml");
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    configXML_ = cache->GetResource<XMLFile>("Config/WeaponSpawner.xml");
+    phaserPrefab_ = cache->GetResource<Prefab>("Prefabs/Phaser.xml");
+    minePrefab_ = cache->GetResource<Prefab>("Prefabs/Mine.xml");
     ParseConfig();
 
-    SubscribeToEvent(E_UPDATE, URHO3D_HANDLER(WeaponSpawner, HandleUpdate));
     SubscribeToEvent(E_FILECHANGED, URHO3D_HANDLER(WeaponSpawner, HandleFileChanged));
 }
 
@@ -41,54 +47,73 @@ void WeaponSpawner::RegisterObject(Context* context)
 // ----------------------------------------------------------------------------
 void WeaponSpawner::CreatePhaser(float angleOffset)
 {
-    // Load bullet prefab
-    ResourceCache* cache = GetSubsystem<ResourceCache>();
-    Node* bullet = GetScene()->CreateChild();
-    XMLFile* bulletXML = cache->GetResource<XMLFile>("Prefabs/Phaser.xml");
-    bullet->LoadXML(bulletXML->GetRoot());
+    ShipController* shipController = GetComponent<ShipController>();
+    LaunchPhaser(HeadingToVector(shipController->GetAngle() + angleOffset));
+}
+
+// ----------------------------------------------------------------------------
+void WeaponSpawner::CreateSpread()
+{
+    // Evaluate the directions of all pellets in one go
+    ShipController* shipController = GetComponent<ShipController>();
+    spreadAngles_.Resize(config_.spread.count);
+    spreadSines_.Resize(config_.spread.count);
+    spreadCosines_.Resize(config_.spread.count);
+
+    float angle = shipController->GetAngle() - config_.spread.spread / 2;
+    float incr = config_.spread.spread / (config_.spread.count - 1);
+    for (int i = 0; i != config_.spread.count; ++i, angle += incr)
+        spreadAngles_[i] = angle;
+    FastSinCos(&spreadAngles_[0], &spreadSines_[0], &spreadCosines_[0], config_.spread.count);
+
+    for (int i = 0; i != config_.spread.count; ++i)
+        LaunchPhaser(Vector2(spreadSines_[i], spreadCosines_[i]));
+}
+
+// ----------------------------------------------------------------------------
+void WeaponSpawner::LaunchPhaser(const Vector2& direction)
+{
+    if (phaserPrefab_ == nullptr)
+        return;
+
+    // Phasers are local nodes, clients get them from the replicator
+    Node* bullet = GetScene()->CreateChild("", LOCAL);
+    phaserPrefab_->Instantiate(bullet);
 
     // Calculate the effective bullet direction, which is a combination of the
     // player's angle and player's speed
     ShipController* shipController = GetComponent<ShipController>();
-    Vector2 bulletStandingVelocity(Sin(shipController->GetAngle() + angleOffset) * config_.phaser.speed, Cos(shipController->GetAngle() + angleOffset) * config_.phaser.speed);
+    Vector2 bulletStandingVelocity = direction * config_.phaser.speed;
     Vector2 bulletVelocity = bulletStandingVelocity + shipController->GetVelocity();
 
     // Set up bullet controller with the correct speed/life parameters.
-    // Ship controller should always exist if weapon spawner exists.
+    // Ship controller should always exist if weapon spawner exists. The
+    // bullet starts at the tip of the player's ship.
     PhaserController* phaserController = bullet->GetChild("Phaser")->GetComponent<PhaserController>();
     phaserController->SetLife(config_.phaser.life);
-    phaserController->SetVelocity(bulletVelocity);
+    phaserController->SetOwner(GetOwner());
+    phaserController->Launch(node_->GetParent()->GetRotation(), bulletVelocity,
+                             shipController->GetOffsetFromPlanetCenter(), config_.phaser.initialOffset);
 
-    // Set initial bullet location to the tip of the player's ship
-    // Note: Have to update planet height before moving the bullet, as
-    // UpdatePosition takes into account the planet's radius
-    bullet->SetRotation(node_->GetParent()->GetRotation());
-    phaserController->UpdatePlanetHeight();
-    phaserController->UpdatePosition(phaserController->GetVelocity().Normalized(), config_.phaser.initialOffset);
-}
-
-// ----------------------------------------------------------------------------
-void WeaponSpawner::CreateSpread()
-{
-    float angle = -config_.spread.spread / 2;
-    float incr = config_.spread.spread / (config_.spread.count - 1);
-    for (int i = 0; i != config_.spread.count; ++i, angle += incr)
-        CreatePhaser(angle);
+    PhaserReplicator* replicator = GetScene()->GetComponent<PhaserReplicator>();
+    if (replicator)
+        replicator->SendSpawn(phaserController);
 }
 
 // ----------------------------------------------------------------------------
 void WeaponSpawner::CreateMine()
 {
-    // Load mine prefab
-    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    if (minePrefab_ == nullptr)
+        return;
+
+    // Instantiate mine prefab
     Node* mine = GetScene()->CreateChild();
-    XMLFile* mineXML = cache->GetResource<XMLFile>("Prefabs/Mine.xml");
-    mine->LoadXML(mineXML->GetRoot());
+    minePrefab_->Instantiate(mine);
 
     // Calculate the effective mine direction, which is a combination of the
     // player's angle and player's speed
     ShipController* shipController = GetComponent<ShipController>();
-    Vector2 mineStandingVelocity(-Sin(shipController->GetAngle()) * config_.mine.ejectSpeed, -Cos(shipController->GetAngle()) * config_.mine.ejectSpeed);
+    Vector2 mineStandingVelocity = HeadingToVector(shipController->GetAngle()) * -config_.mine.ejectSpeed;
     Vector2 mineVelocity = mineStandingVelocity + shipController->GetVelocity();
 
     // Set up mine controller with the correct speed/life parameters.
@@ -97,6 +122,7 @@ void WeaponSpawner::CreateMine()
     mineController->SetLife(config_.mine.life);
     mineController->SetVelocity(mineVelocity);
     mineController->SetDeceleration(config_.mine.deceleration);
+    mineController->SetOwner(GetOwner());
 
     // Set initial mine location to the back of the player's ship
     // Note: Have to update planet height before moving the mine, as
@@ -104,6 +130,7 @@ void WeaponSpawner::CreateMine()
     mine->SetRotation(node_->GetParent()->GetRotation());
     mineController->UpdatePlanetHeight();
     mineController->UpdatePosition(mineController->GetVelocity().Normalized(), config_.mine.initialOffset);
+    mineController->GetNode()->SetPosition(Vector3(0, mineController->GetOffsetFromPlanetCenter(), 0));
 }
 
 // ----------------------------------------------------------------------------
@@ -147,6 +174,15 @@ void WeaponSpawner::ParseConfig()
     }
 }
 
+// ----------------------------------------------------------------------------
+User::GUID WeaponSpawner::GetOwner() const
+{
+    // Only the server spawns weapons, so the ship always has a server state
+    ServerShipState* shipState = GetComponent<ServerShipState>();
+    User* user = shipState ? shipState->GetUser() : nullptr;
+    return user ? user->GetGUID() : User::INVALID_GUID;
+}
+
 // ----------------------------------------------------------------------------
 bool WeaponSpawner::TryGetActionState()
 {
@@ -169,23 +205,50 @@ bool WeaponSpawner::TryGetActionState()
 }
 
 // ----------------------------------------------------------------------------
-void WeaponSpawner::HandleUpdate(StringHash eventType, VariantMap& eventData)
+void WeaponSpawner::OnSceneSet(Scene* scene)
 {
-    using namespace Update;
+    TimerWheel* timers = GetSubsystem<TimerWheel>();
+    if (timers && scene == nullptr)
+    {
+        timers->Cancel(phaserCooldown_);
+        phaserCooldown_ = TimerWheel::INVALID_TIMER;
+    }
+
+    UpdateRegistry* registry = GetSubsystem<UpdateRegistry>();
+    if (registry == nullptr)
+        return;
 
-    float dt = eventData[P_TIMESTEP].GetFloat();
+    if (scene)
+        registry->Add(this, UpdateRegistry::WEAPONS);
+    else
+        registry->Remove(this);
+}
 
+// ----------------------------------------------------------------------------
+void WeaponSpawner::Update(float dt)
+{
     if (state_.Expired() && TryGetActionState() == false)
         return;
 
-    fireActionCooldown_ = Max(0.0, fireActionCooldown_ - dt);
-    if (fireActionCooldown_ == 0.0 && state_->IsFiring())
+    // Fire taps that were pressed and released within one frame (or
+    // replayed within one frame on the server) only show up in the latch
+    bool firePressed = state_->ConsumeFirePressed();
+    if (phaserCooldown_ == TimerWheel::INVALID_TIMER && (state_->IsFiring() || firePressed))
     {
-        fireActionCooldown_ = config_.phaser.cooldown;
         CreatePhaser();
+
+        TimerWheel* timers = GetSubsystem<TimerWheel>();
+        if (timers)
+            phaserCooldown_ = timers->Schedule<WeaponSpawner, &WeaponSpawner::HandlePhaserCooldown>(this, config_.phaser.cooldown);
     }
 }
 
+// ----------------------------------------------------------------------------
+void WeaponSpawner::HandlePhaserCooldown()
+{
+    phaserCooldown_ = TimerWheel::INVALID_TIMER;
+}
+
 // ----------------------------------------------------------------------------
 void WeaponSpawner::HandleActionWarp(StringHash eventType, VariantMap& eventData)
 {
@@ -0,0 +1,215 @@
+#include "Asteroids/Server/ServerSession.hpp"
+#include "Asteroids/Network/RemoteEventCodec.hpp"
+#include "Asteroids/Objects/AsteroidField.hpp"
+#include "Asteroids/Objects/HitDetector.hpp"
+#include "Asteroids/Objects/PhaserReplicator.hpp"
+#include "Asteroids/Player/PlayerEvents.hpp"
+#include "Asteroids/Player/ServerShipState.hpp"
+#include "Asteroids/UserRegistry/ServerUserRegistry.hpp"
+#include "Asteroids/UserRegistry/UserRegistry.hpp"
+#include "Asteroids/UserRegistry/UserRegistryEvents.hpp"
+#include "Asteroids/Util/Prefab.hpp"
+
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Network/Connection.h>
+#include <Urho3D/Network/Network.h>
+#include <Urho3D/Physics/PhysicsWorld.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/ResourceEvents.h>
+#include <Urho3D/Resource/XMLFile.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+// ----------------------------------------------------------------------------
+ServerSession::ServerSession(Context* context) :
+    Object(context),
+    planet_(nullptr),
+    asteroids_(nullptr),
+    port_(0)
+{
+}
+
+// ----------------------------------------------------------------------------
+ServerSession::~ServerSession()
+{
+    Stop();
+}
+
+// ----------------------------------------------------------------------------
+bool ServerSession::Start(unsigned short port)
+{
+    if (IsRunning())
+    {
+        URHO3D_LOGERROR("ServerSession::Start() - Already running");
+        return false;
+    }
+
+    users_ = new UserRegistry(context_);
+    serverUserRegistry_ = new ServerUserRegistry(context_, users_);
+    LoadScene();
+
+    // Only listen to events sent by our own objects. When hosting from the
+    // client, the client's user registry and the server connection send the
+    // same events.
+    SubscribeToEvent(serverUserRegistry_, E_USERJOINED, URHO3D_HANDLER(ServerSession, HandleUserJoined));
+    SubscribeToEvent(serverUserRegistry_, E_USERLEFT, URHO3D_HANDLER(ServerSession, HandleUserLeft));
+    SubscribeToEvent(this, E_PLAYERCREATE, URHO3D_HANDLER(ServerSession, HandlePlayerCreate));
+    SubscribeToEvent(this, E_PLAYERDESTROY, URHO3D_HANDLER(ServerSession, HandlePlayerDestroy));
+    SubscribeToEvent(E_FILECHANGED, URHO3D_HANDLER(ServerSession, HandleFileChanged));
+
+    if (GetSubsystem<Network>()->StartServer(port) == false)
+    {
+        URHO3D_LOGERRORF("ServerSession::Start() - Failed to listen on port %d", port);
+        Stop();
+        return false;
+    }
+
+    port_ = port;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+void ServerSession::Stop()
+{
+    Network* network = GetSubsystem<Network>();
+    if (port_ != 0 && network != nullptr)
+        network->StopServer();
+
+    UnsubscribeFromAllEvents();
+    shipNodes_.Clear();
+    planet_ = nullptr;
+    asteroids_ = nullptr;
+    planetXML_.Reset();
+    scene_.Reset();
+    serverUserRegistry_.Reset();
+    users_.Reset();
+    port_ = 0;
+}
+
+// ----------------------------------------------------------------------------
+bool ServerSession::IsRunning() const
+{
+    return port_ != 0;
+}
+
+// ----------------------------------------------------------------------------
+unsigned short ServerSession::GetPort() const
+{
+    return port_;
+}
+
+// ----------------------------------------------------------------------------
+Scene* ServerSession::GetScene() const
+{
+    return scene_;
+}
+
+// ----------------------------------------------------------------------------
+UserRegistry* ServerSession::GetUserRegistry() const
+{
+    return users_;
+}
+
+// ----------------------------------------------------------------------------
+void ServerSession::LoadScene()
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+
+    scene_ = new Scene(context_);
+    scene_->CreateComponent<Octree>(LOCAL);
+    scene_->CreateComponent<PhysicsWorld>(LOCAL);
+
+    planet_ = scene_->CreateChild();
+    planetXML_ = cache->GetResource<XMLFile>("Prefabs/ProceduralPlanet.xml");
+    planet_->LoadXML(planetXML_->GetRoot());
+
+    // Clients create their own copies of these and follow the server's
+    asteroids_ = scene_->CreateComponent<AsteroidField>(LOCAL);
+    asteroids_->SetAuthority(true);
+    scene_->CreateComponent<HitDetector>(LOCAL)->SetAuthority(true);
+    scene_->CreateComponent<PhaserReplicator>(LOCAL)->SetAuthority(true);
+}
+
+// ----------------------------------------------------------------------------
+void ServerSession::HandleUserJoined(StringHash eventType, VariantMap& eventData)
+{
+    using namespace UserJoined;
+
+    uint32_t guid = eventData[P_GUID].GetUInt();
+    const User* user = users_->GetUser(guid);
+
+    assert(user->GetConnection() != nullptr);
+    user->GetConnection()->SetScene(scene_);
+    asteroids_->SendSnapshot(user->GetConnection());
+
+    // Send ship create event here for now. May have a spawning subsystem later
+    // that determines where and when players are spawned
+    VariantMap& data = GetEventDataMap();
+    data[PlayerCreate::P_GUID] = user->GetGUID();
+    data[PlayerCreate::P_PIVOTROTATION] = Quaternion::IDENTITY;  // whatever lol
+    GetSubsystem<RemoteEventCodec>()->BroadcastRemoteEvent(E_PLAYERCREATE, data);
+    SendEvent(E_PLAYERCREATE, data);
+}
+
+// ----------------------------------------------------------------------------
+void ServerSession::HandleUserLeft(StringHash eventType, VariantMap& eventData)
+{
+    using namespace UserLeft;
+
+    // Send ship destroy event here for now. May have a spawning subsystem
+    // later
+    VariantMap& data = GetEventDataMap();
+    data[PlayerDestroy::P_GUID] = eventData[P_GUID].GetInt();
+    GetSubsystem<RemoteEventCodec>()->BroadcastRemoteEvent(E_PLAYERDESTROY, data);
+    SendEvent(E_PLAYERDESTROY, data);
+}
+
+// ----------------------------------------------------------------------------
+void ServerSession::HandlePlayerCreate(StringHash eventType, VariantMap& eventData)
+{
+    using namespace PlayerCreate;
+
+    User::GUID guid = eventData[P_GUID].GetUInt();
+    assert(shipNodes_.Find(guid) == shipNodes_.End());
+    User* user = users_->GetUser(guid);
+
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    Prefab* shipfab = cache->GetResource<Prefab>("Prefabs/ServerShip.xml");
+
+    Node* node = scene_->CreateChild("", LOCAL);
+    shipfab->Instantiate(node);
+    node->SetRotation(eventData[P_PIVOTROTATION].GetQuaternion());
+    node->GetChild("Ship")->GetComponent<ServerShipState>()->SetUser(user);
+
+    shipNodes_[guid] = node;
+}
+
+// ----------------------------------------------------------------------------
+void ServerSession::HandlePlayerDestroy(StringHash eventType, VariantMap& eventData)
+{
+    using namespace PlayerDestroy;
+
+    User::GUID guid = eventData[P_GUID].GetUInt();
+
+    assert(shipNodes_.Find(guid) != shipNodes_.End());
+
+    shipNodes_[guid]->Remove();
+    shipNodes_.Erase(guid);
+}
+
+// ----------------------------------------------------------------------------
+void ServerSession::HandleFileChanged(StringHash eventType, VariantMap& eventData)
+{
+    using namespace FileChanged;
+
+    if (eventData[P_RESOURCENAME].GetString() == planetXML_->GetName())
+    {
+        planet_->LoadXML(planetXML_->GetRoot());
+    }
+}
+
+}
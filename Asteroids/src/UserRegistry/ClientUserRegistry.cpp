@@ -1,10 +1,13 @@
-#include "Asteroids/Network/Protocol.hpp"
+#include "Asteroids/Network/MessageRouter.hpp"
+#include "Asteroids/Network/MessageView.hpp"
+#include "Asteroids/Network/Messages.hpp"
 #include "Asteroids/UserRegistry/ClientUserRegistry.hpp"
 #include "Asteroids/UserRegistry/UserRegistry.hpp"
 #include "Asteroids/UserRegistry/UserRegistryEvents.hpp"
 
 #include <Urho3D/IO/Log.h>
 #include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/Network/Connection.h>
 #include <Urho3D/Network/NetworkEvents.h>
 #include <Urho3D/Network/Network.h>
 
@@ -29,6 +32,8 @@ void ClientUserRegistry::TryRegister(const String& name, const String& ipAddress
 
     VariantMap identity;
     identity["Username"] = name;
+    if (MessageRouter* router = GetSubsystem<MessageRouter>())
+        router->PrepareIdentity(identity, ipAddress);
     if (GetSubsystem<Network>()->Connect(ipAddress, port, scene, identity) == false)
         NotifyRegisterFailed("Failed to initiate connection");
 }
@@ -48,18 +53,18 @@ void ClientUserRegistry::NotifyRegisterFailed(const String& reason)
 // ----------------------------------------------------------------------------
 void ClientUserRegistry::HandleNetworkMessage(StringHash eventType, VariantMap& eventData)
 {
-    using namespace NetworkMessage;
-
-    if (eventData[P_MESSAGEID].GetInt() != MSG_REGISTER_FAILED)
+    MessageView message(eventData);
+    if (message.GetID() != MSG_REGISTER_FAILED)
         return;
 
-    MemoryBuffer buffer(eventData[P_DATA].GetBuffer());
-    MsgRegisterFailed reason = static_cast<MsgRegisterFailed>(buffer.ReadUByte());
+    RegisterFailedMsg msg = {0xFF, 0};
+    ReadMessage(message.GetBuffer(), &msg);
+
     String reasonStr = "Unknown error";
-    switch (reason)
+    switch (static_cast<MsgRegisterFailed>(msg.reason_))
     {
         case USERNAME_TOO_LONG :
-            reasonStr = "Username exceeds " + String(static_cast<int>(buffer.ReadUByte())) + " characters";
+            reasonStr = "Username exceeds " + String(static_cast<int>(msg.maxLength_)) + " characters";
             break;
 
         case USERNAME_EMPTY :
@@ -95,6 +100,10 @@ void ClientUserRegistry::HandleUserJoined(StringHash eventType, VariantMap& even
 {
     using namespace UserJoined;
 
+    // When hosting a game, the server session sends the same event locally
+    if (GetEventSender() != GetSubsystem<Network>()->GetServerConnection())
+        return;
+
     UserRegistry* reg = GetSubsystem<UserRegistry>();
     if (reg == nullptr)
     {
@@ -112,6 +121,9 @@ void ClientUserRegistry::HandleUserLeft(StringHash eventType, VariantMap& eventD
 {
     using namespace UserLeft;
 
+    if (GetEventSender() != GetSubsystem<Network>()->GetServerConnection())
+        return;
+
     UserRegistry* reg = GetSubsystem<UserRegistry>();
     if (reg == nullptr)
     {
@@ -2,7 +2,10 @@
 #include "Asteroids/UserRegistry/UserRegistry.hpp"
 #include "Asteroids/UserRegistry/UserRegistryEvents.hpp"
 #include "Asteroids/Player/PlayerEvents.hpp"
-#include "Asteroids/Network/Protocol.hpp"
+#include "Asteroids/Network/MessageRouter.hpp"
+#include "Asteroids/Network/Messages.hpp"
+#include "Asteroids/Network/RemoteEventCodec.hpp"
+#include "Asteroids/Util/Metrics.hpp"
 
 #include <Urho3D/Core/Context.h>
 #include <Urho3D/Network/Network.h>
@@ -15,13 +18,27 @@ using namespace Urho3D;
 namespace Asteroids {
 
 // ----------------------------------------------------------------------------
-ServerUserRegistry::ServerUserRegistry(Context* context) :
-    Object(context)
+ServerUserRegistry::ServerUserRegistry(Context* context, UserRegistry* users) :
+    Object(context),
+    users_(users)
 {
     SubscribeToEvent(E_CLIENTIDENTITY, URHO3D_HANDLER(ServerUserRegistry, HandleClientIdentity));
     SubscribeToEvent(E_CLIENTDISCONNECTED, URHO3D_HANDLER(ServerUserRegistry, HandleClientDisconnected));
 }
 
+// ----------------------------------------------------------------------------
+void ServerUserRegistry::SendRegisterFailed(Connection* connection, MsgRegisterFailed reason, unsigned maxLength)
+{
+    RegisterFailedMsg msg = {(uint8_t)reason, (uint8_t)maxLength};
+    msg_.Clear();
+    WriteMessage(msg_, msg);
+    GetSubsystem<MessageRouter>()->SendMessage(connection, CHANNEL_EVENTS, MSG_REGISTER_FAILED, msg_);
+
+    Metrics* metrics = GetSubsystem<Metrics>();
+    if (metrics)
+        metrics->CountJoinRejected(reason);
+}
+
 // ----------------------------------------------------------------------------
 void ServerUserRegistry::HandleClientIdentity(StringHash eventType, VariantMap& eventData)
 {
@@ -36,9 +53,7 @@ void ServerUserRegistry::HandleClientIdentity(StringHash eventType, VariantMap&
         URHO3D_LOGERROR("Empty username, rejecting");
         eventData[P_ALLOW] = false;
 
-        msg_.Clear();
-        msg_.WriteUByte(USERNAME_EMPTY);
-        connection->SendMessage(MSG_REGISTER_FAILED, true, false, msg_);
+        SendRegisterFailed(connection, USERNAME_EMPTY);
 
         return;
     }
@@ -49,19 +64,16 @@ void ServerUserRegistry::HandleClientIdentity(StringHash eventType, VariantMap&
         URHO3D_LOGERROR("Username exceeds maximum length, rejecting");
         eventData[P_ALLOW] = false;
 
-        msg_.Clear();
-        msg_.WriteUByte(USERNAME_TOO_LONG);
-        msg_.WriteUByte(32);
-        connection->SendMessage(MSG_REGISTER_FAILED, true, false, msg_);
+        SendRegisterFailed(connection, USERNAME_TOO_LONG, 32);
 
         return;
     }
 
-    // User registry subsystem might not exist
-    UserRegistry* reg = GetSubsystem<UserRegistry>();
+    // User registry might have been destroyed
+    UserRegistry* reg = users_;
     if (reg == nullptr)
     {
-        URHO3D_LOGERRORF("Can't accept client with username \"%s\", UserRegistry subsystem doesn't exist", username.CString());
+        URHO3D_LOGERRORF("Can't accept client with username \"%s\", UserRegistry doesn't exist", username.CString());
         eventData[P_ALLOW] = false;
         return;
     }
@@ -72,45 +84,48 @@ void ServerUserRegistry::HandleClientIdentity(StringHash eventType, VariantMap&
         URHO3D_LOGERRORF("Username \"%s\" already exists, rejecting", username.CString());
         eventData[P_ALLOW] = false;
 
-        msg_.Clear();
-        msg_.WriteUByte(USERNAME_ALREADY_TAKEN);
-        connection->SendMessage(MSG_REGISTER_FAILED, true, false, msg_);
+        SendRegisterFailed(connection, USERNAME_ALREADY_TAKEN);
 
         return;
     }
 
     // Send join events to the newly connected client for all current users
     // so their list is in sync with ours
-    VariantMap data;
+    RemoteEventCodec* codec = GetSubsystem<RemoteEventCodec>();
+    VariantMap& data = GetEventDataMap();
     for (const auto& user : reg->GetAllUsers())
     {
         data.Clear();
         data[UserJoined::P_GUID] = user.second_->GetGUID();
         data[UserJoined::P_USERNAME] = user.second_->GetUsername();
-        connection->SendRemoteEvent(E_USERJOINED, true, data);
+        codec->SendRemoteEvent(connection, E_USERJOINED, data);
 
         // Temporary solution: Create all existing players by sending the new
         // user E_PLAYERCREATE events.
         data.Clear();
         data[PlayerCreate::P_GUID] = user.second_->GetGUID();
         data[PlayerCreate::P_PIVOTROTATION] = Quaternion::IDENTITY;
-        connection->SendRemoteEvent(E_PLAYERCREATE, true, data);
+        codec->SendRemoteEvent(connection, E_PLAYERCREATE, data);
     }
 
     // Can add the user now to our registry
     const User* user = reg->AddUser(username, connection);
 
+    Metrics* metrics = GetSubsystem<Metrics>();
+    if (metrics)
+        metrics->SetUsersConnected(reg->GetAllUsers().Size());
+
     // Let client know they were verified
     data.Clear();
     data[RegisterSucceeded::P_GUID] = user->GetGUID();
-    connection->SendRemoteEvent(E_REGISTERSUCCEEDED, true, data);
+    codec->SendRemoteEvent(connection, E_REGISTERSUCCEEDED, data);
 
     // Let everyone know a new user joined. The event must be sent
     // locally too, so the server can instantiate the player object.
     data.Clear();
     data[UserJoined::P_GUID] = user->GetGUID();
     data[UserJoined::P_USERNAME] = user->GetUsername();
-    GetSubsystem<Network>()->BroadcastRemoteEvent(E_USERJOINED, true, data);
+    codec->BroadcastRemoteEvent(E_USERJOINED, data);
     SendEvent(E_USERJOINED, data);
 }
 
@@ -121,10 +136,10 @@ void ServerUserRegistry::HandleClientDisconnected(StringHash eventType, VariantM
 
     Connection* connection = static_cast<Connection*>(eventData[P_CONNECTION].GetPtr());
 
-    UserRegistry* reg = GetSubsystem<UserRegistry>();
+    UserRegistry* reg = users_;
     if (reg == nullptr)
     {
-        URHO3D_LOGERROR("HandleClientDisconnected: UserRegistry subsystem doesn't exist");
+        URHO3D_LOGERROR("HandleClientDisconnected: UserRegistry doesn't exist");
         return;
     }
 
@@ -132,9 +147,13 @@ void ServerUserRegistry::HandleClientDisconnected(StringHash eventType, VariantM
     SharedPtr<User> user;
     if ((user = reg->RemoveUser(connection)) != nullptr)
     {
+        Metrics* metrics = GetSubsystem<Metrics>();
+        if (metrics)
+            metrics->SetUsersConnected(reg->GetAllUsers().Size());
+
         VariantMap& data = GetEventDataMap();
         data[UserLeft::P_GUID] = user->GetGUID();
-        GetSubsystem<Network>()->BroadcastRemoteEvent(E_USERLEFT, true, data);
+        GetSubsystem<RemoteEventCodec>()->BroadcastRemoteEvent(E_USERLEFT, data);
         SendEvent(E_USERLEFT, data);
     }
 }
@@ -0,0 +1,73 @@
+#include "Asteroids/Util/AllocationCounter.hpp"
+
+#if defined(ASTEROIDS_ALLOCATION_COUNTER)
+#   include <cstdlib>
+#   include <new>
+
+static thread_local unsigned long long allocationCount = 0;
+
+// ----------------------------------------------------------------------------
+void* operator new(std::size_t size)
+{
+    ++allocationCount;
+    void* p = std::malloc(size ? size : 1);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+
+// ----------------------------------------------------------------------------
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+// ----------------------------------------------------------------------------
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    ++allocationCount;
+    return std::malloc(size ? size : 1);
+}
+
+// ----------------------------------------------------------------------------
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+// ----------------------------------------------------------------------------
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+// ----------------------------------------------------------------------------
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+#endif
+
+namespace Asteroids {
+
+// ----------------------------------------------------------------------------
+bool IsAllocationCounterEnabled()
+{
+#if defined(ASTEROIDS_ALLOCATION_COUNTER)
+    return true;
+#else
+    return false;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+unsigned long long GetThreadAllocationCount()
+{
+#if defined(ASTEROIDS_ALLOCATION_COUNTER)
+    return allocationCount;
+#else
+    return 0;
+#endif
+}
+
+}
@@ -0,0 +1,362 @@
+#include "Asteroids/Util/AsyncLog.hpp"
+
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/IOEvents.h>
+#include <Urho3D/IO/Log.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+static const char* levelPrefixes[] = {
+    "TRACE",
+    "DEBUG",
+    "INFO",
+    "WARNING",
+    "ERROR"
+};
+
+AsyncLog* AsyncLog::instance_ = nullptr;
+
+// ----------------------------------------------------------------------------
+AsyncLog::AsyncLog(Context* context) :
+    Object(context),
+    records_(new Record[RING_CAPACITY]),
+    enqueuePos_(0),
+    dropped_(0),
+    dequeuePos_(0),
+    startTime_(Time::GetSystemTime()),
+    lastEcho_(false),
+    repeatCount_(0),
+    repeatStart_(0),
+    recentPos_(0),
+    windowStart_(0),
+    windowCount_(0),
+    suppressed_(0),
+    echo_(true),
+    rateLimit_(50)
+{
+    static_assert((RING_CAPACITY & (RING_CAPACITY - 1)) == 0, "Capacity must be a power of two");
+
+    for (unsigned i = 0; i != RING_CAPACITY; ++i)
+        records_[i].sequence_.store(i, std::memory_order_relaxed);
+    last_.length_ = 0;
+    last_.level_ = LOG_NONE;
+    for (unsigned i = 0; i != RECENT_LINES; ++i)
+    {
+        recent_[i].length_ = 0;
+        recent_[i].level_ = LOG_NONE;
+    }
+
+    instance_ = this;
+
+    SubscribeToEvent(E_LOGMESSAGE, URHO3D_HANDLER(AsyncLog, HandleLogMessage));
+}
+
+// ----------------------------------------------------------------------------
+AsyncLog::~AsyncLog()
+{
+    Close();
+    if (instance_ == this)
+        instance_ = nullptr;
+    delete[] records_;
+}
+
+// ----------------------------------------------------------------------------
+bool AsyncLog::Open(const String& fileName)
+{
+    Close();
+
+    file_ = new File(context_);
+    if (file_->Open(fileName, FILE_WRITE) == false)
+    {
+        file_.Reset();
+        URHO3D_LOGERRORF("Failed to open log file \"%s\"", fileName.CString());
+        return false;
+    }
+
+    return Run();
+}
+
+// ----------------------------------------------------------------------------
+void AsyncLog::Close()
+{
+    if (IsStarted())
+        Stop();
+
+    // Thread is stopped at this point, make sure nothing is left behind
+    Drain();
+    FlushRepeats(Time::GetSystemTime() - startTime_);
+
+    if (file_)
+    {
+        file_->Close();
+        file_.Reset();
+    }
+}
+
+// ----------------------------------------------------------------------------
+void AsyncLog::SetEcho(bool enable)
+{
+    echo_.store(enable, std::memory_order_relaxed);
+}
+
+// ----------------------------------------------------------------------------
+void AsyncLog::SetRateLimit(unsigned linesPerSecond)
+{
+    rateLimit_.store(linesPerSecond, std::memory_order_relaxed);
+}
+
+// ----------------------------------------------------------------------------
+void AsyncLog::Write(int level, const char* message)
+{
+    AsyncLog* log = instance_;
+    if (log == nullptr)
+        return;
+
+    log->Push(level, message, (unsigned)strlen(message), true);
+}
+
+// ----------------------------------------------------------------------------
+void AsyncLog::WriteFormat(int level, const char* format, ...)
+{
+    AsyncLog* log = instance_;
+    if (log == nullptr)
+        return;
+
+    char buffer[MAX_MESSAGE_LENGTH];
+    va_list va;
+    va_start(va, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, va);
+    va_end(va);
+    if (length < 0)
+        return;
+
+    // On truncation vsnprintf() returns the length it wanted to write
+    log->Push(level, buffer, Min((unsigned)length, (unsigned)sizeof(buffer) - 1), true);
+}
+
+// ----------------------------------------------------------------------------
+bool AsyncLog::ReadLine(Line* line)
+{
+    return display_.Pop(line);
+}
+
+// ----------------------------------------------------------------------------
+bool AsyncLog::Push(int level, const char* message, unsigned length, bool echo)
+{
+    // Bounded MPMC queue as described by Dmitry Vyukov. Each slot's sequence
+    // number tells producers whether the slot is free for the current lap
+    // and tells the consumer whether it has been published.
+    Record* record;
+    unsigned pos = enqueuePos_.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        record = &records_[pos & (RING_CAPACITY - 1)];
+        unsigned sequence = record->sequence_.load(std::memory_order_acquire);
+        int diff = (int)(sequence - pos);
+        if (diff == 0)
+        {
+            if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else
+        {
+            pos = enqueuePos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    if (length > MAX_MESSAGE_LENGTH)
+        length = MAX_MESSAGE_LENGTH;
+    memcpy(record->text_, message, length);
+    record->length_ = length;
+    record->level_ = level;
+    record->echo_ = echo;
+    record->timeMs_ = Time::GetSystemTime() - startTime_;
+    record->sequence_.store(pos + 1, std::memory_order_release);
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+void AsyncLog::ThreadFunction()
+{
+    while (shouldRun_)
+    {
+        Drain();
+        Time::Sleep(5);
+    }
+}
+
+// ----------------------------------------------------------------------------
+void AsyncLog::Drain()
+{
+    for (;;)
+    {
+        Record& record = records_[dequeuePos_ & (RING_CAPACITY - 1)];
+        if (record.sequence_.load(std::memory_order_acquire) != dequeuePos_ + 1)
+            break;
+
+        // Collapse consecutive identical messages
+        if (record.level_ == last_.level_ &&
+            record.length_ == last_.length_ &&
+            memcmp(record.text_, last_.text_, record.length_) == 0)
+        {
+            if (repeatCount_++ == 0)
+                repeatStart_ = record.timeMs_;
+        }
+        else
+        {
+            FlushRepeats(record.timeMs_);
+            if (SeenRecently(record) == false || Admit(record.timeMs_))
+                Emit(record.timeMs_, record.level_, record.text_, record.length_, record.echo_);
+
+            last_.level_ = record.level_;
+            last_.length_ = record.length_;
+            memcpy(last_.text_, record.text_, record.length_);
+            lastEcho_ = record.echo_;
+        }
+
+        record.sequence_.store(dequeuePos_ + RING_CAPACITY, std::memory_order_release);
+        dequeuePos_++;
+    }
+
+    // Don't hold on to repeats forever if nothing else is logged
+    unsigned now = Time::GetSystemTime() - startTime_;
+    if (repeatCount_ > 0 && now - repeatStart_ >= 1000)
+        FlushRepeats(now);
+    AdvanceWindow(now);
+
+    unsigned dropped = dropped_.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0)
+    {
+        char buffer[MAX_MESSAGE_LENGTH];
+        int length = snprintf(buffer, sizeof(buffer), "Log buffer full, dropped %u messages", dropped);
+        Emit(now, LOG_WARNING, buffer, (unsigned)length, true);
+    }
+
+    if (file_)
+        file_->Flush();
+}
+
+// ----------------------------------------------------------------------------
+void AsyncLog::FlushRepeats(unsigned timeMs)
+{
+    if (repeatCount_ == 0)
+        return;
+
+    char buffer[MAX_MESSAGE_LENGTH];
+    int length = snprintf(buffer, sizeof(buffer), "Last message repeated %u times", repeatCount_);
+    repeatCount_ = 0;
+    if (Admit(timeMs))
+        Emit(timeMs, last_.level_, buffer, (unsigned)length, lastEcho_);
+}
+
+// ----------------------------------------------------------------------------
+bool AsyncLog::SeenRecently(const Record& record)
+{
+    for (unsigned i = 0; i != RECENT_LINES; ++i)
+    {
+        const Line& line = recent_[i];
+        if (line.level_ == record.level_ &&
+            line.length_ == record.length_ &&
+            memcmp(line.text_, record.text_, record.length_) == 0)
+        {
+            return true;
+        }
+    }
+
+    Line& line = recent_[recentPos_++ % RECENT_LINES];
+    line.level_ = record.level_;
+    line.length_ = record.length_;
+    memcpy(line.text_, record.text_, record.length_);
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+bool AsyncLog::Admit(unsigned timeMs)
+{
+    AdvanceWindow(timeMs);
+
+    unsigned rateLimit = rateLimit_.load(std::memory_order_relaxed);
+    if (rateLimit > 0 && windowCount_ >= rateLimit)
+    {
+        suppressed_++;
+        return false;
+    }
+
+    windowCount_++;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+void AsyncLog::AdvanceWindow(unsigned timeMs)
+{
+    // Rate limit in windows of one second. The number of suppressed lines is
+    // reported at the start of the next window.
+    if (timeMs - windowStart_ < 1000)
+        return;
+
+    windowStart_ = timeMs;
+    windowCount_ = 0;
+    if (suppressed_ > 0)
+    {
+        char buffer[MAX_MESSAGE_LENGTH];
+        int length = snprintf(buffer, sizeof(buffer), "Rate limit exceeded, suppressed %u repeated messages", suppressed_);
+        suppressed_ = 0;
+        Emit(timeMs, LOG_WARNING, buffer, (unsigned)length, true);
+    }
+}
+
+// ----------------------------------------------------------------------------
+void AsyncLog::Emit(unsigned timeMs, int level, const char* message, unsigned length, bool echo)
+{
+    if (level < LOG_TRACE || level > LOG_ERROR)
+        level = LOG_INFO;
+
+    char line[MAX_MESSAGE_LENGTH + 32];
+    int lineLength = snprintf(line, sizeof(line), "[%6u.%03u] %s: %.*s\n",
+        timeMs / 1000, timeMs % 1000, levelPrefixes[level], (int)length, message);
+    if (lineLength < 0)
+        return;
+    if (lineLength >= (int)sizeof(line))
+        lineLength = sizeof(line) - 1;
+
+    if (file_)
+        file_->Write(line, (unsigned)lineLength);
+    if (echo && echo_.load(std::memory_order_relaxed))
+    {
+        FILE* stream = level == LOG_ERROR ? stderr : stdout;
+        fwrite(line, 1, (size_t)lineLength, stream);
+        fflush(stream);
+    }
+
+    Line displayLine;
+    displayLine.level_ = level;
+    displayLine.length_ = length;
+    memcpy(displayLine.text_, message, length);
+    display_.Push(displayLine);
+}
+
+// ----------------------------------------------------------------------------
+void AsyncLog::HandleLogMessage(StringHash eventType, VariantMap& eventData)
+{
+    using namespace LogMessage;
+
+    // Urho prints errors to stderr even when quiet, don't print them twice
+    int level = eventData[P_LEVEL].GetInt();
+    const String& message = eventData[P_MESSAGE].GetString();
+    Push(level, message.CString(), message.Length(), level != LOG_ERROR);
+}
+
+}
@@ -1,10 +1,9 @@
 #include "Asteroids/Util/DebugTextScroll.hpp"
+#include "Asteroids/Util/AsyncLog.hpp"
 
 #include <Urho3D/Core/Context.h>
 #include <Urho3D/Core/CoreEvents.h>
 #include <Urho3D/Resource/ResourceCache.h>
-#include <Urho3D/Input/InputEvents.h>
-#include <Urho3D/IO/IOEvents.h>
 #include <Urho3D/IO/Log.h>
 #include <Urho3D/UI/UI.h>
 #include <Urho3D/UI/Text.h>
@@ -17,10 +16,11 @@ namespace Asteroids {
 // ----------------------------------------------------------------------------
 DebugTextScroll::DebugTextScroll(Context* context) :
     Object(context),
-    timeoutSetting_(5)
+    insertIndex_(0),
+    timeoutSetting_(5),
+    layoutDirty_(false)
 {
     SubscribeToEvent(E_UPDATE, URHO3D_HANDLER(DebugTextScroll, HandleUpdate));
-    SubscribeToEvent(E_LOGMESSAGE, URHO3D_HANDLER(DebugTextScroll, HandleLogMessage));
 }
 
 // ----------------------------------------------------------------------------
@@ -46,7 +46,8 @@ void DebugTextScroll::SetTextCount(unsigned count)
         items_.Pop();
     }
 
-    insertIt_ = items_.Begin();
+    insertIndex_ = 0;
+    layoutDirty_ = true;
 }
 
 // ----------------------------------------------------------------------------
@@ -58,8 +59,24 @@ void DebugTextScroll::SetTimeout(float seconds)
 // ----------------------------------------------------------------------------
 void DebugTextScroll::Print(const String& str, const Color& color)
 {
-    if(insertIt_.ptr_ == NULL)
+    if (items_.Size() == 0)
         return;
+
+    // Overwrite the oldest line, the others are moved up in UpdateLayout()
+    TextItem& item = items_[insertIndex_];
+    item.text_->SetText(str);
+    item.text_->SetOpacity(1);
+    item.text_->SetColor(color);
+    item.timeout_ = timeoutSetting_;
+
+    if (++insertIndex_ == items_.Size())
+        insertIndex_ = 0;
+    layoutDirty_ = true;
+}
+
+// ----------------------------------------------------------------------------
+void DebugTextScroll::UpdateLayout()
+{
     UI* ui = GetSubsystem<UI>();
     if (ui == nullptr)
         return;
@@ -67,20 +84,17 @@ void DebugTextScroll::Print(const String& str, const Color& color)
     if (root == nullptr)
         return;
 
-    insertIt_->text_->SetText(str);
-    insertIt_->text_->SetOpacity(1);
-    insertIt_->text_->SetColor(color);
-    insertIt_->text_->SetPosition(0, root->GetHeight() - 40);
-    insertIt_->timeout_ = timeoutSetting_;
-
-    if(++insertIt_ == items_.End())
-        insertIt_ = items_.Begin();
-
-    for(Vector<TextItem>::Iterator it = items_.Begin(); it != items_.End(); ++it)
+    // Newest line at the bottom
+    int y = root->GetHeight() - 40;
+    for (unsigned i = 0; i != items_.Size(); ++i)
     {
-        IntVector2 pos = it->text_->GetPosition();
-        it->text_->SetPosition(pos.x_, pos.y_ - it->text_->GetHeight() - 2);
+        unsigned index = (insertIndex_ + items_.Size() - 1 - i) % items_.Size();
+        Text* text = items_[index].text_;
+        y -= text->GetHeight() + 2;
+        text->SetPosition(0, y);
     }
+
+    layoutDirty_ = false;
 }
 
 // ----------------------------------------------------------------------------
@@ -89,6 +103,21 @@ void DebugTextScroll::HandleUpdate(StringHash eventType, VariantMap& eventData)
     using namespace Update;
     float timeStep = eventData[P_TIMESTEP].GetFloat();
 
+    AsyncLog* log = GetSubsystem<AsyncLog>();
+    AsyncLog::Line line;
+    while (log && log->ReadLine(&line))
+    {
+        Color color = Color::WHITE;
+        if (line.level_ == LOG_WARNING)
+            color = Color(1, 0.5, 0.1);
+        if (line.level_ == LOG_ERROR)
+            color = Color(1, 0.1, 0.1);
+
+        lineBuffer_.Clear();
+        lineBuffer_.Append(line.text_, line.length_);
+        Print(lineBuffer_, color);
+    }
+
     for(Vector<TextItem>::Iterator it = items_.Begin(); it != items_.End(); ++it)
     {
         if((it->timeout_ -= timeStep) < 0)
@@ -96,24 +125,13 @@ void DebugTextScroll::HandleUpdate(StringHash eventType, VariantMap& eventData)
             float opacity = it->timeout_ + 1;
             if(opacity > 0)
                 it->text_->SetOpacity(opacity);
-            else
+            else if (it->text_->GetText().Empty() == false)
                 it->text_->SetText("");
         }
     }
-}
 
-// ----------------------------------------------------------------------------
-void DebugTextScroll::HandleLogMessage(StringHash eventType, VariantMap& eventData)
-{
-    using namespace LogMessage;
-    int level = eventData[P_LEVEL].GetInt();
-
-    Color color = Color::WHITE;
-    if(level == LOG_WARNING)
-        color = Color(1, 0.5, 0.1);
-    if(level == LOG_ERROR)
-        color = Color(1, 0.1, 0.1);
-    Print(eventData[P_MESSAGE].GetString(), color);
+    if (layoutDirty_)
+        UpdateLayout();
 }
 
 }
@@ -0,0 +1,102 @@
+#include "Asteroids/Util/LineReader.hpp"
+
+#include <Urho3D/IO/Deserializer.h>
+
+#include <string.h>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+// ----------------------------------------------------------------------------
+LineReader::LineReader(unsigned maxLineLength) :
+    readPos_(0),
+    maxLineLength_(maxLineLength)
+{
+}
+
+// ----------------------------------------------------------------------------
+void LineReader::Feed(const void* data, unsigned size)
+{
+    // Discard lines that were already read before growing the buffer
+    if (readPos_ > 0)
+    {
+        unsigned remaining = buffer_.Size() - readPos_;
+        if (remaining > 0)
+            memmove(&buffer_[0], &buffer_[readPos_], remaining);
+        buffer_.Resize(remaining);
+        readPos_ = 0;
+    }
+
+    unsigned offset = buffer_.Size();
+    buffer_.Resize(offset + size);
+    memcpy(&buffer_[offset], data, size);
+}
+
+// ----------------------------------------------------------------------------
+unsigned LineReader::Drain(Deserializer& source)
+{
+    char chunk[1024];
+    unsigned total = 0;
+    unsigned bytesRead;
+    while ((bytesRead = source.Read(chunk, sizeof(chunk))) > 0)
+    {
+        Feed(chunk, bytesRead);
+        total += bytesRead;
+    }
+    return total;
+}
+
+// ----------------------------------------------------------------------------
+bool LineReader::ReadLine(String* line)
+{
+    unsigned available = buffer_.Size() - readPos_;
+    if (available == 0)
+        return false;
+
+    const char* begin = &buffer_[readPos_];
+    const char* newline = static_cast<const char*>(memchr(begin, '\n', available));
+    unsigned length;
+    unsigned consumed;
+    if (newline)
+    {
+        length = (unsigned)(newline - begin);
+        consumed = length + 1;
+    }
+    else if (available >= maxLineLength_)
+    {
+        length = maxLineLength_;
+        consumed = length;
+    }
+    else
+    {
+        return false;
+    }
+
+    if (length > 0 && begin[length - 1] == '\r')
+        --length;
+
+    line->Clear();
+    line->Append(begin, length);
+    readPos_ += consumed;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+bool LineReader::Flush(String* line)
+{
+    if (ReadLine(line))
+        return true;
+
+    unsigned available = buffer_.Size() - readPos_;
+    if (available == 0)
+        return false;
+
+    line->Clear();
+    line->Append(&buffer_[readPos_], available);
+    buffer_.Clear();
+    readPos_ = 0;
+    return true;
+}
+
+}
@@ -0,0 +1,168 @@
+#include "Asteroids/Util/Metrics.hpp"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+// Up to a quarter second, with more resolution around a 60 Hz frame
+const unsigned MetricsHistogram::BOUNDS_USEC[BUCKET_COUNT] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 16667, 25000, 50000, 100000, 250000
+};
+
+// Indexed by msgID - MSG_CLIENT_SHIP_STATE, the last entry is for anything else
+static const char* MSG_TYPE_NAMES[] = {
+    "client_ship_state",
+    "server_ship_state",
+    "register_failed",
+    "network_timer",
+    "shm_transport",
+    "asteroid_snapshot",
+    "asteroid_spawn",
+    "asteroid_destroy",
+    "ship_hit",
+    "phaser_spawn",
+    "phaser_destroy",
+    "register_succeeded",
+    "user_joined",
+    "user_left",
+    "player_create",
+    "player_destroy",
+    "server_snapshot",
+    "snapshot_feedback",
+    "other"
+};
+
+// Indexed by MsgRegisterFailed
+static const char* REJECT_REASON_NAMES[] = {
+    "username_too_long",
+    "username_empty",
+    "username_already_taken",
+    "username_banned"
+};
+
+// ----------------------------------------------------------------------------
+// String::AppendWithFormat() doesn't understand long long or %g
+static void AppendFormat(String& out, const char* format, ...)
+{
+    char buffer[256];
+    va_list va;
+    va_start(va, format);
+    vsnprintf(buffer, sizeof(buffer), format, va);
+    va_end(va);
+    out.Append(buffer);
+}
+
+// ----------------------------------------------------------------------------
+MetricsHistogram::MetricsHistogram() :
+    count_(0),
+    sumUsec_(0)
+{
+    for (unsigned i = 0; i != BUCKET_COUNT; ++i)
+        buckets_[i].store(0, std::memory_order_relaxed);
+}
+
+// ----------------------------------------------------------------------------
+void MetricsHistogram::Observe(unsigned long long usec)
+{
+    // Buckets are stored non-cumulative so only one of them is touched. The
+    // exporter adds them up.
+    for (unsigned i = 0; i != BUCKET_COUNT; ++i)
+        if (usec <= BOUNDS_USEC[i])
+        {
+            buckets_[i].fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sumUsec_.fetch_add(usec, std::memory_order_relaxed);
+}
+
+// ----------------------------------------------------------------------------
+Metrics::Metrics(Context* context) :
+    Object(context)
+{
+    static_assert(sizeof(MSG_TYPE_NAMES) / sizeof(*MSG_TYPE_NAMES) == MSG_TYPE_COUNT + 1, "Update MSG_TYPE_NAMES");
+    static_assert(sizeof(REJECT_REASON_NAMES) / sizeof(*REJECT_REASON_NAMES) == REJECT_REASON_COUNT, "Update REJECT_REASON_NAMES");
+}
+
+// ----------------------------------------------------------------------------
+void Metrics::SetUsersConnected(unsigned count)
+{
+    usersConnected_.Set(count);
+}
+
+// ----------------------------------------------------------------------------
+void Metrics::AddLiveProjectiles(int amount)
+{
+    liveProjectiles_.Add(amount);
+}
+
+// ----------------------------------------------------------------------------
+void Metrics::ObserveTickDuration(unsigned long long usec)
+{
+    tickDuration_.Observe(usec);
+}
+
+// ----------------------------------------------------------------------------
+void Metrics::CountMessageSent(int msgID, unsigned bytes, unsigned connections)
+{
+    unsigned index = (unsigned)(msgID - MSG_CLIENT_SHIP_STATE);
+    if (index >= MSG_TYPE_COUNT)
+        index = MSG_TYPE_OTHER;
+
+    messagesSent_[index].Add(connections);
+    bytesSent_[index].Add((unsigned long long)bytes * connections);
+}
+
+// ----------------------------------------------------------------------------
+void Metrics::CountJoinRejected(MsgRegisterFailed reason)
+{
+    if ((unsigned)reason < REJECT_REASON_COUNT)
+        joinsRejected_[reason].Add();
+}
+
+// ----------------------------------------------------------------------------
+void Metrics::WritePrometheus(String& out) const
+{
+    out.Append("# HELP asteroids_users_connected Number of registered users.\n"
+               "# TYPE asteroids_users_connected gauge\n");
+    AppendFormat(out, "asteroids_users_connected %lld\n", usersConnected_.Get());
+
+    out.Append("# HELP asteroids_projectiles_live Number of phasers and mines in the scene.\n"
+               "# TYPE asteroids_projectiles_live gauge\n");
+    AppendFormat(out, "asteroids_projectiles_live %lld\n", liveProjectiles_.Get());
+
+    out.Append("# HELP asteroids_tick_duration_seconds Time spent processing one server frame.\n"
+               "# TYPE asteroids_tick_duration_seconds histogram\n");
+    unsigned long long cumulative = 0;
+    for (unsigned i = 0; i != MetricsHistogram::BUCKET_COUNT; ++i)
+    {
+        cumulative += tickDuration_.GetBucket(i);
+        AppendFormat(out, "asteroids_tick_duration_seconds_bucket{le=\"%g\"} %llu\n",
+            MetricsHistogram::BOUNDS_USEC[i] / 1e6, cumulative);
+    }
+    unsigned long long count = tickDuration_.GetCount();
+    AppendFormat(out, "asteroids_tick_duration_seconds_bucket{le=\"+Inf\"} %llu\n", count);
+    AppendFormat(out, "asteroids_tick_duration_seconds_sum %f\n", tickDuration_.GetSumUsec() / 1e6);
+    AppendFormat(out, "asteroids_tick_duration_seconds_count %llu\n", count);
+
+    out.Append("# HELP asteroids_messages_sent_total Game messages sent, counted once per receiving connection.\n"
+               "# TYPE asteroids_messages_sent_total counter\n");
+    for (unsigned i = 0; i != MSG_TYPE_COUNT + 1; ++i)
+        AppendFormat(out, "asteroids_messages_sent_total{type=\"%s\"} %llu\n", MSG_TYPE_NAMES[i], messagesSent_[i].Get());
+
+    out.Append("# HELP asteroids_message_bytes_sent_total Payload bytes of game messages sent.\n"
+               "# TYPE asteroids_message_bytes_sent_total counter\n");
+    for (unsigned i = 0; i != MSG_TYPE_COUNT + 1; ++i)
+        AppendFormat(out, "asteroids_message_bytes_sent_total{type=\"%s\"} %llu\n", MSG_TYPE_NAMES[i], bytesSent_[i].Get());
+
+    out.Append("# HELP asteroids_joins_rejected_total Connection attempts that were refused.\n"
+               "# TYPE asteroids_joins_rejected_total counter\n");
+    for (unsigned i = 0; i != REJECT_REASON_COUNT; ++i)
+        AppendFormat(out, "asteroids_joins_rejected_total{reason=\"%s\"} %llu\n", REJECT_REASON_NAMES[i], joinsRejected_[i].Get());
+}
+
+}
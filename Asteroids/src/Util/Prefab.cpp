@@ -0,0 +1,393 @@
+#include "Asteroids/Util/Prefab.hpp"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Profiler.h>
+#include <Urho3D/IO/Deserializer.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/IO/Serializer.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/XMLFile.h>
+#include <Urho3D/Scene/Component.h>
+#include <Urho3D/Scene/Node.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+static const char* BINARY_FILE_ID = "APFB";
+static const unsigned BINARY_VERSION = 1;
+
+// ----------------------------------------------------------------------------
+Prefab::Prefab(Context* context) :
+    Resource(context)
+{
+}
+
+// ----------------------------------------------------------------------------
+void Prefab::RegisterObject(Context* context)
+{
+    context->RegisterFactory<Prefab>();
+}
+
+// ----------------------------------------------------------------------------
+bool Prefab::BeginLoad(Deserializer& source)
+{
+    nodes_.Clear();
+    dependencies_.Clear();
+
+    unsigned start = source.GetPosition();
+    if (source.ReadFileID() == BINARY_FILE_ID)
+    {
+        if (LoadBinary(source) == false)
+        {
+            nodes_.Clear();
+            return false;
+        }
+    }
+    else
+    {
+        // Not our binary format, rewind and try to load it as a node XML file
+        source.Seek(start);
+        XMLFile xml(context_);
+        if (xml.Load(source) == false)
+            return false;
+
+        if (LoadXMLNode(xml.GetRoot()) == M_MAX_UNSIGNED)
+        {
+            nodes_.Clear();
+            return false;
+        }
+    }
+
+    unsigned memoryUse = sizeof(Prefab);
+    for (const auto& node : nodes_)
+    {
+        memoryUse += sizeof(NodeTemplate) + node.attributes_.Size() * sizeof(AttributeValue);
+        for (const auto& component : node.components_)
+            memoryUse += sizeof(ComponentTemplate) + component.attributes_.Size() * sizeof(AttributeValue);
+    }
+    SetMemoryUse(memoryUse);
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+bool Prefab::EndLoad()
+{
+    // Resource references are resolved here and not in BeginLoad() because
+    // BeginLoad() may run on a worker thread during background loading
+    for (const auto& node : nodes_)
+    {
+        ResolveResources(node.attributes_);
+        for (const auto& component : node.components_)
+            ResolveResources(component.attributes_);
+    }
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+bool Prefab::Save(Serializer& dest) const
+{
+    if (dest.WriteFileID(BINARY_FILE_ID) == false)
+        return false;
+
+    dest.WriteUInt(BINARY_VERSION);
+    dest.WriteVLE(nodes_.Size());
+    for (const auto& node : nodes_)
+    {
+        dest.WriteBool(node.replicated_);
+        SaveBinaryAttributes(Node::GetTypeStatic(), node.attributes_, dest);
+
+        dest.WriteVLE(node.components_.Size());
+        for (const auto& component : node.components_)
+        {
+            dest.WriteStringHash(component.type_);
+            dest.WriteBool(component.replicated_);
+            SaveBinaryAttributes(component.type_, component.attributes_, dest);
+        }
+
+        dest.WriteVLE(node.children_.Size());
+        for (unsigned child : node.children_)
+            dest.WriteVLE(child);
+    }
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+void Prefab::Instantiate(Node* node) const
+{
+    URHO3D_PROFILE(InstantiatePrefab);
+
+    if (nodes_.Empty())
+    {
+        URHO3D_LOGERRORF("Prefab \"%s\" is empty, can't instantiate", GetName().CString());
+        return;
+    }
+
+    InstantiateNode(node, 0);
+
+    // This recurses into all components and child nodes
+    node->ApplyAttributes();
+}
+
+// ----------------------------------------------------------------------------
+unsigned Prefab::LoadXMLNode(const XMLElement& source)
+{
+    // Note: Don't hold references into nodes_ across the recursive call, the
+    // vector may be reallocated
+    unsigned index = nodes_.Size();
+    nodes_.Resize(index + 1);
+    nodes_[index].replicated_ = Scene::IsReplicatedID(source.GetUInt("id"));
+    if (LoadXMLAttributes(Node::GetTypeStatic(), source, &nodes_[index].attributes_) == false)
+        return M_MAX_UNSIGNED;
+
+    for (XMLElement compElem = source.GetChild("component"); compElem; compElem = compElem.GetNext("component"))
+    {
+        String typeName = compElem.GetAttribute("type");
+        ComponentTemplate component;
+        component.type_ = StringHash(typeName);
+        component.replicated_ = Scene::IsReplicatedID(compElem.GetUInt("id"));
+
+        if (context_->GetObjectFactories().Contains(component.type_) == false)
+        {
+            URHO3D_LOGERRORF("Unknown component type \"%s\" in prefab \"%s\", skipping", typeName.CString(), GetName().CString());
+            continue;
+        }
+
+        if (LoadXMLAttributes(component.type_, compElem, &component.attributes_) == false)
+            return M_MAX_UNSIGNED;
+
+        nodes_[index].components_.Push(component);
+    }
+
+    for (XMLElement childElem = source.GetChild("node"); childElem; childElem = childElem.GetNext("node"))
+    {
+        unsigned child = LoadXMLNode(childElem);
+        if (child == M_MAX_UNSIGNED)
+            return M_MAX_UNSIGNED;
+        nodes_[index].children_.Push(child);
+    }
+
+    return index;
+}
+
+// ----------------------------------------------------------------------------
+bool Prefab::LoadXMLAttributes(StringHash type, const XMLElement& source, Vector<AttributeValue>* dest)
+{
+    const Vector<AttributeInfo>* attributes = context_->GetAttributes(type);
+
+    for (XMLElement attrElem = source.GetChild("attribute"); attrElem; attrElem = attrElem.GetNext("attribute"))
+    {
+        String name = attrElem.GetAttribute("name");
+        unsigned index = 0;
+        if (attributes)
+            while (index < attributes->Size() && attributes->At(index).name_ != name)
+                ++index;
+        if (attributes == nullptr || index == attributes->Size())
+        {
+            URHO3D_LOGWARNINGF("Unknown attribute \"%s\" in prefab \"%s\", skipping", name.CString(), GetName().CString());
+            continue;
+        }
+
+        const AttributeInfo& attr = attributes->At(index);
+        if ((attr.mode_ & AM_FILE) == 0)
+            continue;
+
+        // Node and component IDs would have to be remapped to the IDs of each
+        // new instance. None of our prefabs need this so it isn't supported.
+        if (attr.mode_ & (AM_NODEID | AM_COMPONENTID | AM_NODEIDVECTOR))
+        {
+            URHO3D_LOGWARNINGF("Attribute \"%s\" in prefab \"%s\" references node or component IDs, which prefabs don't support. Skipping", name.CString(), GetName().CString());
+            continue;
+        }
+
+        Variant value;
+        if (attr.enumNames_)
+        {
+            String enumName = attrElem.GetAttribute("value");
+            int enumValue = 0;
+            const char** enumPtr = attr.enumNames_;
+            while (*enumPtr && enumName.Compare(*enumPtr, false) != 0)
+            {
+                ++enumPtr;
+                ++enumValue;
+            }
+            if (*enumPtr == nullptr)
+            {
+                URHO3D_LOGWARNINGF("Unknown enum value \"%s\" for attribute \"%s\" in prefab \"%s\", skipping", enumName.CString(), name.CString(), GetName().CString());
+                continue;
+            }
+            value = enumValue;
+        }
+        else
+        {
+            value = attrElem.GetVariantValue(attr.type_);
+        }
+
+        dest->Push(AttributeValue{index, value});
+    }
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+bool Prefab::LoadBinary(Deserializer& source)
+{
+    unsigned version = source.ReadUInt();
+    if (version != BINARY_VERSION)
+    {
+        URHO3D_LOGERRORF("Prefab \"%s\" has unsupported binary version %d", GetName().CString(), version);
+        return false;
+    }
+
+    unsigned nodeCount = source.ReadVLE();
+    nodes_.Resize(nodeCount);
+    for (unsigned i = 0; i != nodeCount; ++i)
+    {
+        NodeTemplate& node = nodes_[i];
+        node.replicated_ = source.ReadBool();
+        if (LoadBinaryAttributes(Node::GetTypeStatic(), source, &node.attributes_) == false)
+            return false;
+
+        unsigned componentCount = source.ReadVLE();
+        for (unsigned c = 0; c != componentCount; ++c)
+        {
+            ComponentTemplate component;
+            component.type_ = source.ReadStringHash();
+            component.replicated_ = source.ReadBool();
+            if (LoadBinaryAttributes(component.type_, source, &component.attributes_) == false)
+                return false;
+
+            if (context_->GetObjectFactories().Contains(component.type_) == false)
+            {
+                URHO3D_LOGERRORF("Unknown component type %s in prefab \"%s\", skipping", component.type_.ToString().CString(), GetName().CString());
+                continue;
+            }
+
+            node.components_.Push(component);
+        }
+
+        // Children always come after their parent, which also guarantees the
+        // hierarchy can't contain cycles
+        unsigned childCount = source.ReadVLE();
+        for (unsigned c = 0; c != childCount; ++c)
+        {
+            unsigned child = source.ReadVLE();
+            if (child <= i || child >= nodeCount)
+            {
+                URHO3D_LOGERRORF("Prefab \"%s\" is corrupt (invalid child index)", GetName().CString());
+                return false;
+            }
+            node.children_.Push(child);
+        }
+    }
+
+    if (nodes_.Empty())
+    {
+        URHO3D_LOGERRORF("Prefab \"%s\" contains no nodes", GetName().CString());
+        return false;
+    }
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+bool Prefab::LoadBinaryAttributes(StringHash type, Deserializer& source, Vector<AttributeValue>* dest)
+{
+    // Attributes are stored by name hash rather than by index so binary files
+    // survive attributes being added to or removed from a component
+    const Vector<AttributeInfo>* attributes = context_->GetAttributes(type);
+
+    unsigned count = source.ReadVLE();
+    for (unsigned i = 0; i != count; ++i)
+    {
+        StringHash nameHash = source.ReadStringHash();
+        Variant value = source.ReadVariant();
+
+        unsigned index = 0;
+        if (attributes)
+            while (index < attributes->Size() && StringHash(attributes->At(index).name_) != nameHash)
+                ++index;
+        if (attributes == nullptr || index == attributes->Size())
+        {
+            URHO3D_LOGWARNINGF("Unknown attribute %s in prefab \"%s\", skipping", nameHash.ToString().CString(), GetName().CString());
+            continue;
+        }
+
+        if (value.GetType() != attributes->At(index).type_)
+        {
+            URHO3D_LOGWARNINGF("Attribute \"%s\" in prefab \"%s\" has the wrong type, skipping", attributes->At(index).name_.CString(), GetName().CString());
+            continue;
+        }
+
+        dest->Push(AttributeValue{index, value});
+    }
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+void Prefab::SaveBinaryAttributes(StringHash type, const Vector<AttributeValue>& values, Serializer& dest) const
+{
+    const Vector<AttributeInfo>* attributes = context_->GetAttributes(type);
+    assert(attributes || values.Empty());
+
+    dest.WriteVLE(values.Size());
+    for (const auto& value : values)
+    {
+        dest.WriteStringHash(StringHash(attributes->At(value.index_).name_));
+        dest.WriteVariant(value.value_);
+    }
+}
+
+// ----------------------------------------------------------------------------
+void Prefab::ResolveResources(const Vector<AttributeValue>& attributes)
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+
+    for (const auto& attr : attributes)
+    {
+        if (attr.value_.GetType() == VAR_RESOURCEREF)
+        {
+            const ResourceRef& ref = attr.value_.GetResourceRef();
+            if (ref.name_.Empty() == false)
+                dependencies_.Push(SharedPtr<Resource>(cache->GetResource(ref.type_, ref.name_)));
+        }
+        else if (attr.value_.GetType() == VAR_RESOURCEREFLIST)
+        {
+            const ResourceRefList& refs = attr.value_.GetResourceRefList();
+            for (const auto& name : refs.names_)
+                if (name.Empty() == false)
+                    dependencies_.Push(SharedPtr<Resource>(cache->GetResource(refs.type_, name)));
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+void Prefab::InstantiateNode(Node* node, unsigned index) const
+{
+    const NodeTemplate& nodeTemplate = nodes_[index];
+
+    for (const auto& attr : nodeTemplate.attributes_)
+        node->SetAttribute(attr.index_, attr.value_);
+
+    for (const auto& componentTemplate : nodeTemplate.components_)
+    {
+        Component* component = node->CreateComponent(componentTemplate.type_, componentTemplate.replicated_ ? REPLICATED : LOCAL);
+        if (component == nullptr)
+            continue;
+        for (const auto& attr : componentTemplate.attributes_)
+            component->SetAttribute(attr.index_, attr.value_);
+    }
+
+    for (unsigned child : nodeTemplate.children_)
+    {
+        Node* childNode = node->CreateChild(String::EMPTY, nodes_[child].replicated_ ? REPLICATED : LOCAL);
+        InstantiateNode(childNode, child);
+    }
+}
+
+}
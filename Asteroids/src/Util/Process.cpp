@@ -9,6 +9,7 @@
 #   include <unistd.h>
 #   include <stdio.h>
 #   include <sys/wait.h>
+#   include <poll.h>
 #   include <sys/prctl.h>
 #   include <errno.h>
 #   include <signal.h>
@@ -145,7 +146,11 @@ bool Process::Open(StringVector args, IO options)
     stdin_.Reset((options & STDIN) ? new UnidirectionalPipe(stdin_wr) : nullptr);
     stdout_.Reset((options & STDOUT) ? new UnidirectionalPipe(stdout_rd) : nullptr);
     stderr_.Reset((options & STDERR) ? new UnidirectionalPipe(stderr_rd) : nullptr);
+    notify_.Reset();
+    if (options & NOTIFY)
+        URHO3D_LOGWARNING("Process::Open() - NOTIFY pipes are not supported on Windows, ignoring");
     mainThreadHandle_ = piProcInfo.hThread;
+    exitCode_ = -1;
 
     return true;
 
@@ -167,6 +172,7 @@ bool Process::Open(StringVector args, IO options)
     int stdin_fd[2] = {-1, -1};
     int stdout_fd[2] = {-1, -1};
     int stderr_fd[2] = {-1, -1};
+    int notify_fd[2] = {-1, -1};
     int child_status_fd[2] = {-1, -1};
     int bytesRead;
     char status;
@@ -179,6 +185,11 @@ bool Process::Open(StringVector args, IO options)
     if ((options & STDERR) && pipe(stderr_fd) != 0)
         { URHO3D_LOGERRORF("Process::Open() - pipe() failed: %s", strerror(errno)); goto pipe_failed; }
 
+    // The notify pipe is O_CLOEXEC so other child processes we spawn don't
+    // inherit it. The child clears the flag after moving it to NOTIFY_FD.
+    if ((options & NOTIFY) && pipe2(notify_fd, O_CLOEXEC) != 0)
+        { URHO3D_LOGERRORF("Process::Open() - pipe() failed: %s", strerror(errno)); goto pipe_failed; }
+
     if (pipe2(child_status_fd, O_CLOEXEC) != 0)
         { URHO3D_LOGERRORF("Process::Open() - pipe() failed: %s", strerror(errno)); goto pipe_failed; }
 
@@ -211,6 +222,22 @@ bool Process::Open(StringVector args, IO options)
 
         close(child_status_fd[READ]);
 
+        if (options & NOTIFY)
+        {
+            close(notify_fd[READ]);
+
+            // Make sure the status pipe doesn't get overwritten when moving
+            // the notify pipe to its fixed file descriptor
+            if (child_status_fd[WRITE] == NOTIFY_FD)
+                child_status_fd[WRITE] = fcntl(child_status_fd[WRITE], F_DUPFD_CLOEXEC, NOTIFY_FD + 1);
+            if (notify_fd[WRITE] != NOTIFY_FD)
+            {
+                dup2(notify_fd[WRITE], NOTIFY_FD);
+                close(notify_fd[WRITE]);
+            }
+            fcntl(NOTIFY_FD, F_SETFD, 0);  // Clear O_CLOEXEC so it survives execv()
+        }
+
         // execv needs a specific structure to work
         char** argv = (char**)malloc(args.Size() * (sizeof(char*) + 1));
         for (int i = 0; i != args.Size(); ++i)
@@ -264,11 +291,14 @@ bool Process::Open(StringVector args, IO options)
     if (options & STDIN) close(stdin_fd[READ]);
     if (options & STDOUT) close(stdout_fd[WRITE]);
     if (options & STDERR) close(stderr_fd[WRITE]);
+    if (options & NOTIFY) close(notify_fd[WRITE]);
 
-    stdin_ = (options & STDIN) ? new UnidirectionalPipe(stdin_fd[WRITE], "w") : nullptr;
-    stdout_ = (options & STDOUT) ? new UnidirectionalPipe(stdout_fd[READ], "r") : nullptr;
-    stderr_ = (options & STDERR) ? new UnidirectionalPipe(stderr_fd[READ], "r") : nullptr;
+    stdin_ = (options & STDIN) ? new UnidirectionalPipe(stdin_fd[WRITE]) : nullptr;
+    stdout_ = (options & STDOUT) ? new UnidirectionalPipe(stdout_fd[READ]) : nullptr;
+    stderr_ = (options & STDERR) ? new UnidirectionalPipe(stderr_fd[READ]) : nullptr;
+    notify_ = (options & NOTIFY) ? new UnidirectionalPipe(notify_fd[READ]) : nullptr;
     pid_ = child_pid;
+    exitCode_ = -1;
 
     return true;
 
@@ -281,6 +311,8 @@ bool Process::Open(StringVector args, IO options)
         if (stdout_fd[WRITE] != -1)       close(stdout_fd[WRITE]);
         if (stderr_fd[READ] != -1)        close(stderr_fd[READ]);
         if (stderr_fd[WRITE] != -1)       close(stderr_fd[WRITE]);
+        if (notify_fd[READ] != -1)        close(notify_fd[READ]);
+        if (notify_fd[WRITE] != -1)       close(notify_fd[WRITE]);
         if (child_status_fd[WRITE] != -1) close(child_status_fd[WRITE]);
         if (child_status_fd[WRITE] != -1) close(child_status_fd[WRITE]);
     return false;
@@ -320,6 +352,7 @@ void Process::RequestClose()
     stdin_.Reset();
     stdout_.Reset();
     stderr_.Reset();
+    notify_.Reset();
 }
 
 // ----------------------------------------------------------------------------
@@ -345,6 +378,7 @@ void Process::Terminate()
     stdin_.Reset();
     stdout_.Reset();
     stderr_.Reset();
+    notify_.Reset();
 }
 
 // ----------------------------------------------------------------------------
@@ -373,4 +407,126 @@ void Process::Wait()
 #endif
 }
 
+// ----------------------------------------------------------------------------
+bool Process::IsRunning()
+{
+#if defined(_WIN32)
+    if (mainThreadHandle_ == nullptr)
+        return false;
+
+    if (WaitForSingleObject(mainThreadHandle_, 0) == WAIT_TIMEOUT)
+        return true;
+
+    DWORD exitCode;
+    exitCode_ = GetExitCodeThread(mainThreadHandle_, &exitCode) ? (int)exitCode : -1;
+    CloseHandle(mainThreadHandle_);
+    mainThreadHandle_ = nullptr;
+    return false;
+#else
+    if (pid_ == 0)
+        return false;
+
+    int status;
+    pid_t ret = waitpid(pid_, &status, WNOHANG);
+    if (ret == 0)
+        return true;
+
+    if (ret == -1)
+    {
+        URHO3D_LOGERRORF("Process::IsRunning() - waitpid() returned error: %s", strerror(errno));
+        exitCode_ = -1;
+    }
+    else if (WIFEXITED(status))
+        exitCode_ = WEXITSTATUS(status);
+    else
+        exitCode_ = -1;  // Killed by a signal
+
+    pid_ = 0;
+    return false;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+int Process::GetExitCode() const
+{
+    return exitCode_;
+}
+
+// ----------------------------------------------------------------------------
+unsigned Process::Poll(int timeoutMs)
+{
+    UnidirectionalPipe* pipes[3] = {stdout_.Get(), stderr_.Get(), notify_.Get()};
+    const unsigned flags[3] = {STDOUT, STDERR, NOTIFY};
+    unsigned ready = NONE;
+
+#if defined(_WIN32)
+    for (int i = 0; i != 3; ++i)
+    {
+        if (pipes[i] == nullptr || pipes[i]->handle_ == nullptr)
+            continue;
+
+        // PeekNamedPipe() fails if the writing end was closed, report that
+        // as readable so the caller reads and hits EOF
+        DWORD available = 0;
+        if (!PeekNamedPipe(pipes[i]->handle_, nullptr, 0, nullptr, &available, nullptr) || available > 0)
+            ready |= flags[i];
+    }
+#else
+    struct pollfd fds[3];
+    unsigned fdFlags[3];
+    nfds_t count = 0;
+    for (int i = 0; i != 3; ++i)
+    {
+        if (pipes[i] == nullptr || pipes[i]->fd_ == -1)
+            continue;
+        fds[count].fd = pipes[i]->fd_;
+        fds[count].events = POLLIN;
+        fds[count].revents = 0;
+        fdFlags[count] = flags[i];
+        ++count;
+    }
+
+    if (count == 0)
+        return NONE;
+
+    int ret = poll(fds, count, timeoutMs);
+    if (ret == -1)
+    {
+        if (errno != EINTR)
+            URHO3D_LOGERRORF("Process::Poll() - poll() failed: %s", strerror(errno));
+        return NONE;
+    }
+
+    for (nfds_t i = 0; i != count; ++i)
+        if (fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+            ready |= fdFlags[i];
+#endif
+
+    return ready;
+}
+
+// ----------------------------------------------------------------------------
+UnidirectionalPipe* Process::GetStdIn() const
+{
+    return stdin_.Get();
+}
+
+// ----------------------------------------------------------------------------
+UnidirectionalPipe* Process::GetStdOut() const
+{
+    return stdout_.Get();
+}
+
+// ----------------------------------------------------------------------------
+UnidirectionalPipe* Process::GetStdErr() const
+{
+    return stderr_.Get();
+}
+
+// ----------------------------------------------------------------------------
+UnidirectionalPipe* Process::GetNotify() const
+{
+    return notify_.Get();
+}
+
 }
@@ -0,0 +1,168 @@
+#include "Asteroids/Util/SphereMath.hpp"
+
+#include <Urho3D/Urho3D.h>
+
+#include <math.h>
+
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+// Minimax polynomials for sin and cos on [-pi/4, pi/4] (from Cephes' sinf/cosf)
+static const float SIN_C1 = -1.6666654611e-1f;
+static const float SIN_C2 = 8.3321608736e-3f;
+static const float SIN_C3 = -1.9515295891e-4f;
+static const float COS_C1 = 4.166664568298827e-2f;
+static const float COS_C2 = -1.388731625493765e-3f;
+static const float COS_C3 = 2.443315711809948e-5f;
+
+// ----------------------------------------------------------------------------
+void FastSinCos(float degrees, float* sine, float* cosine)
+{
+    // Reduce to [-45, 45] degrees around the nearest multiple of 90. Doing
+    // this in degrees is exact, as opposed to subtracting multiples of pi/2.
+    // lrintf() rounds ties to even like _mm_cvtps_epi32() in the SSE version,
+    // so both pick the same quadrant.
+    int quadrant = (int)lrintf(degrees * (1.0f / 90));
+    float r = (degrees - quadrant * 90.0f) * M_DEGTORAD;
+    float z = r * r;
+
+    float s = r + r * z * (SIN_C1 + z * (SIN_C2 + z * SIN_C3));
+    float c = 1.0f - 0.5f * z + z * z * (COS_C1 + z * (COS_C2 + z * COS_C3));
+
+    // sin(x + 90) = cos(x), cos(x + 90) = -sin(x)
+    if (quadrant & 1)
+    {
+        float tmp = s;
+        s = c;
+        c = -tmp;
+    }
+    if (quadrant & 2)
+    {
+        s = -s;
+        c = -c;
+    }
+
+    *sine = s;
+    *cosine = c;
+}
+
+// ----------------------------------------------------------------------------
+Quaternion SurfaceStep(const Vector2& velocity, float radius, float dt)
+{
+    // Note: The angles are in degrees even though they're calculated with
+    // 2*pi, which is what SurfaceObject always did.
+    float sx, cx, sz, cz;
+    FastSinCos(M_PI * velocity.y_ / radius * dt, &sx, &cx);  // Half of the angle around RIGHT
+    FastSinCos(M_PI * velocity.x_ / radius * dt, &sz, &cz);  // Half of the angle around BACK
+
+    // (cx, sx, 0, 0) * (cz, 0, 0, -sz), both are unit length so the product
+    // is too
+    return Quaternion(cx * cz, sx * cz, sx * sz, -cx * sz);
+}
+
+#ifdef URHO3D_SSE
+// ----------------------------------------------------------------------------
+static inline void FastSinCos4(__m128 degrees, __m128* sine, __m128* cosine)
+{
+    // Same as the scalar version. cvtps rounds to nearest, ties to even.
+    __m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(degrees, _mm_set1_ps(1.0f / 90)));
+    __m128 r = _mm_sub_ps(degrees, _mm_mul_ps(_mm_cvtepi32_ps(quadrant), _mm_set1_ps(90.0f)));
+    r = _mm_mul_ps(r, _mm_set1_ps(M_DEGTORAD));
+    __m128 z = _mm_mul_ps(r, r);
+
+    __m128 s = _mm_add_ps(_mm_set1_ps(SIN_C2), _mm_mul_ps(z, _mm_set1_ps(SIN_C3)));
+    s = _mm_add_ps(_mm_set1_ps(SIN_C1), _mm_mul_ps(z, s));
+    s = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, z), s));
+
+    __m128 c = _mm_add_ps(_mm_set1_ps(COS_C2), _mm_mul_ps(z, _mm_set1_ps(COS_C3)));
+    c = _mm_add_ps(_mm_set1_ps(COS_C1), _mm_mul_ps(z, c));
+    c = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.5f), z)), _mm_mul_ps(_mm_mul_ps(z, z), c));
+
+    // Odd quadrants swap sin and cos. Sine is negated in quadrants 2 and 3,
+    // cosine in quadrants 1 and 2.
+    __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+    __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+    __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+
+    __m128 sOut = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+    __m128 cOut = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+    *sine = _mm_xor_ps(sOut, sinSign);
+    *cosine = _mm_xor_ps(cOut, cosSign);
+}
+#endif
+
+// ----------------------------------------------------------------------------
+void FastSinCos(const float* degrees, float* sines, float* cosines, unsigned count)
+{
+    unsigned i = 0;
+#ifdef URHO3D_SSE
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 s, c;
+        FastSinCos4(_mm_loadu_ps(degrees + i), &s, &c);
+        _mm_storeu_ps(sines + i, s);
+        _mm_storeu_ps(cosines + i, c);
+    }
+#endif
+    for (; i != count; ++i)
+        FastSinCos(degrees[i], sines + i, cosines + i);
+}
+
+// ----------------------------------------------------------------------------
+void RotateAxisAngle(Quaternion* out, const Quaternion* rotations, const Vector3* axes, const float* degrees, unsigned count)
+{
+    unsigned i = 0;
+#ifdef URHO3D_SSE
+    for (; i + 4 <= count; i += 4)
+    {
+        // Quaternions are stored as w, x, y, z. Transposing 4 of them gives
+        // one register per component.
+        __m128 w1 = _mm_loadu_ps(&rotations[i + 0].w_);
+        __m128 x1 = _mm_loadu_ps(&rotations[i + 1].w_);
+        __m128 y1 = _mm_loadu_ps(&rotations[i + 2].w_);
+        __m128 z1 = _mm_loadu_ps(&rotations[i + 3].w_);
+        _MM_TRANSPOSE4_PS(w1, x1, y1, z1);
+
+        __m128 sine, w2;
+        FastSinCos4(_mm_mul_ps(_mm_loadu_ps(degrees + i), _mm_set1_ps(0.5f)), &sine, &w2);
+        __m128 x2 = _mm_mul_ps(sine, _mm_setr_ps(axes[i].x_, axes[i + 1].x_, axes[i + 2].x_, axes[i + 3].x_));
+        __m128 y2 = _mm_mul_ps(sine, _mm_setr_ps(axes[i].y_, axes[i + 1].y_, axes[i + 2].y_, axes[i + 3].y_));
+        __m128 z2 = _mm_mul_ps(sine, _mm_setr_ps(axes[i].z_, axes[i + 1].z_, axes[i + 2].z_, axes[i + 3].z_));
+
+        // Same as Quaternion::operator*
+        __m128 w = _mm_sub_ps(_mm_sub_ps(_mm_mul_ps(w1, w2), _mm_mul_ps(x1, x2)), _mm_add_ps(_mm_mul_ps(y1, y2), _mm_mul_ps(z1, z2)));
+        __m128 x = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(w1, x2), _mm_mul_ps(x1, w2)), _mm_mul_ps(y1, z2)), _mm_mul_ps(z1, y2));
+        __m128 y = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(w1, y2), _mm_mul_ps(y1, w2)), _mm_mul_ps(z1, x2)), _mm_mul_ps(x1, z2));
+        __m128 z = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(w1, z2), _mm_mul_ps(z1, w2)), _mm_mul_ps(x1, y2)), _mm_mul_ps(y1, x2));
+
+        // Normalize so the error doesn't accumulate when the result is fed
+        // back in
+        __m128 lenSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w, w), _mm_mul_ps(x, x)), _mm_add_ps(_mm_mul_ps(y, y), _mm_mul_ps(z, z)));
+        __m128 invLen = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lenSquared));
+        w = _mm_mul_ps(w, invLen);
+        x = _mm_mul_ps(x, invLen);
+        y = _mm_mul_ps(y, invLen);
+        z = _mm_mul_ps(z, invLen);
+
+        _MM_TRANSPOSE4_PS(w, x, y, z);
+        _mm_storeu_ps(&out[i + 0].w_, w);
+        _mm_storeu_ps(&out[i + 1].w_, x);
+        _mm_storeu_ps(&out[i + 2].w_, y);
+        _mm_storeu_ps(&out[i + 3].w_, z);
+    }
+#endif
+    for (; i != count; ++i)
+    {
+        float sine, cosine;
+        FastSinCos(degrees[i] * 0.5f, &sine, &cosine);
+        Quaternion step(cosine, axes[i].x_ * sine, axes[i].y_ * sine, axes[i].z_ * sine);
+        out[i] = (rotations[i] * step).Normalized();
+    }
+}
+
+}
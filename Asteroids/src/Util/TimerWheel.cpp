@@ -0,0 +1,251 @@
+#include "Asteroids/Util/TimerWheel.hpp"
+
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Core/Profiler.h>
+#include <Urho3D/IO/Log.h>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+static const unsigned SLOT_BITS = 8;
+static const unsigned SLOTS_PER_LEVEL = 1 << SLOT_BITS;
+static const unsigned SLOT_MASK = SLOTS_PER_LEVEL - 1;
+static const unsigned NUM_LEVELS = 4;
+static const unsigned FIRING_SLOT = NUM_LEVELS * SLOTS_PER_LEVEL;
+static const unsigned short NO_SLOT = 0xFFFF;
+static const unsigned NIL = M_MAX_UNSIGNED;
+
+// The lower bits of a TimerID are the index into the pool plus one, the
+// upper bits are the generation of the timer at that index
+static const unsigned INDEX_BITS = 20;
+static const unsigned INDEX_MASK = (1 << INDEX_BITS) - 1;
+static const unsigned GENERATION_MASK = (1 << (32 - INDEX_BITS)) - 1;
+static const unsigned MAX_TIMERS = INDEX_MASK;
+static const float MAX_DELAY_TICKS = float(1u << 30);
+
+// ----------------------------------------------------------------------------
+TimerWheel::TimerWheel(Context* context) :
+    Object(context),
+    freeList_(NIL),
+    numTimers_(0),
+    currentTick_(0),
+    accumulator_(0)
+{
+    heads_.Resize(FIRING_SLOT + 1);
+    for (unsigned& head : heads_)
+        head = NIL;
+
+    SubscribeToEvent(E_UPDATE, URHO3D_HANDLER(TimerWheel, HandleUpdate));
+}
+
+// ----------------------------------------------------------------------------
+TimerWheel::TimerID TimerWheel::ScheduleTimer(Callback callback, void* object, float delay)
+{
+    unsigned index = freeList_;
+    if (index != NIL)
+    {
+        freeList_ = timers_[index].next_;
+    }
+    else
+    {
+        if (timers_.Size() >= MAX_TIMERS)
+        {
+            URHO3D_LOGERRORF("Can't schedule more than %d timers", MAX_TIMERS);
+            return INVALID_TIMER;
+        }
+
+        index = timers_.Size();
+        timers_.Resize(index + 1);
+        timers_[index].generation_ = 0;
+    }
+
+    // The slot of the current tick is processed by the next Tick(), so a
+    // timer that is N ticks away fires on the Nth call
+    unsigned ticks = delay > 0 ? unsigned(Min(delay * TICKS_PER_SECOND + 0.5f, MAX_DELAY_TICKS)) : 0;
+    Timer& timer = timers_[index];
+    timer.callback_ = callback;
+    timer.object_ = object;
+    timer.expires_ = currentTick_ + (ticks > 0 ? ticks - 1 : 0);
+    Link(index);
+    ++numTimers_;
+
+    return (unsigned(timer.generation_) << INDEX_BITS) | (index + 1);
+}
+
+// ----------------------------------------------------------------------------
+void TimerWheel::Cancel(TimerID id)
+{
+    if (GetTimer(id) == nullptr)
+        return;
+
+    unsigned index = (id & INDEX_MASK) - 1;
+    Unlink(index);
+    Free(index);
+}
+
+// ----------------------------------------------------------------------------
+bool TimerWheel::IsScheduled(TimerID id) const
+{
+    return GetTimer(id) != nullptr;
+}
+
+// ----------------------------------------------------------------------------
+unsigned TimerWheel::GetNumTimers() const
+{
+    return numTimers_;
+}
+
+// ----------------------------------------------------------------------------
+void TimerWheel::Advance(float dt)
+{
+    URHO3D_PROFILE(TimerWheel);
+
+    accumulator_ += dt * TICKS_PER_SECOND;
+    unsigned ticks = unsigned(accumulator_);
+    accumulator_ -= ticks;
+
+    // Nothing to cascade or fire
+    if (numTimers_ == 0)
+    {
+        currentTick_ += ticks;
+        return;
+    }
+
+    for (unsigned i = 0; i != ticks; ++i)
+        Tick();
+}
+
+// ----------------------------------------------------------------------------
+TimerWheel::Timer* TimerWheel::GetTimer(TimerID id)
+{
+    return const_cast<Timer*>(static_cast<const TimerWheel*>(this)->GetTimer(id));
+}
+
+// ----------------------------------------------------------------------------
+const TimerWheel::Timer* TimerWheel::GetTimer(TimerID id) const
+{
+    if (id == INVALID_TIMER)
+        return nullptr;
+
+    unsigned index = (id & INDEX_MASK) - 1;
+    if (index >= timers_.Size())
+        return nullptr;
+
+    const Timer& timer = timers_[index];
+    if (timer.slot_ == NO_SLOT || timer.generation_ != (id >> INDEX_BITS))
+        return nullptr;
+
+    return &timer;
+}
+
+// ----------------------------------------------------------------------------
+void TimerWheel::Link(unsigned index)
+{
+    Timer& timer = timers_[index];
+
+    // Pick the level by how far in the future the timer expires, and the
+    // slot by the expiry tick itself. Timers that are already due go into the
+    // slot that is processed next.
+    unsigned delta = timer.expires_ - currentTick_;
+    unsigned slot;
+    if (int(delta) < 0)
+        slot = currentTick_ & SLOT_MASK;
+    else if (delta < (1u << SLOT_BITS))
+        slot = timer.expires_ & SLOT_MASK;
+    else if (delta < (1u << (2 * SLOT_BITS)))
+        slot = 1 * SLOTS_PER_LEVEL + ((timer.expires_ >> (1 * SLOT_BITS)) & SLOT_MASK);
+    else if (delta < (1u << (3 * SLOT_BITS)))
+        slot = 2 * SLOTS_PER_LEVEL + ((timer.expires_ >> (2 * SLOT_BITS)) & SLOT_MASK);
+    else
+        slot = 3 * SLOTS_PER_LEVEL + ((timer.expires_ >> (3 * SLOT_BITS)) & SLOT_MASK);
+
+    timer.slot_ = (unsigned short)slot;
+    timer.prev_ = NIL;
+    timer.next_ = heads_[slot];
+    if (timer.next_ != NIL)
+        timers_[timer.next_].prev_ = index;
+    heads_[slot] = index;
+}
+
+// ----------------------------------------------------------------------------
+void TimerWheel::Unlink(unsigned index)
+{
+    Timer& timer = timers_[index];
+    if (timer.prev_ != NIL)
+        timers_[timer.prev_].next_ = timer.next_;
+    else
+        heads_[timer.slot_] = timer.next_;
+    if (timer.next_ != NIL)
+        timers_[timer.next_].prev_ = timer.prev_;
+}
+
+// ----------------------------------------------------------------------------
+void TimerWheel::Free(unsigned index)
+{
+    // Bumping the generation invalidates all IDs handed out for this timer
+    Timer& timer = timers_[index];
+    timer.slot_ = NO_SLOT;
+    timer.generation_ = (unsigned short)((timer.generation_ + 1) & GENERATION_MASK);
+    timer.next_ = freeList_;
+    freeList_ = index;
+    --numTimers_;
+}
+
+// ----------------------------------------------------------------------------
+void TimerWheel::Tick()
+{
+    // Every time a level wraps around, the next slot of the level above is
+    // due and its timers are redistributed to the levels below
+    unsigned index = currentTick_ & SLOT_MASK;
+    if (index == 0 && Cascade(1) == 0 && Cascade(2) == 0)
+        Cascade(3);
+    ++currentTick_;
+
+    // Move the due timers to a separate list, so callbacks can schedule and
+    // cancel timers (including the ones that are about to fire) safely
+    heads_[FIRING_SLOT] = heads_[index];
+    heads_[index] = NIL;
+    for (unsigned i = heads_[FIRING_SLOT]; i != NIL; i = timers_[i].next_)
+        timers_[i].slot_ = FIRING_SLOT;
+
+    while (heads_[FIRING_SLOT] != NIL)
+    {
+        // Note: Don't hold a reference to the timer, callbacks can schedule
+        // new timers and cause the pool to be reallocated
+        unsigned i = heads_[FIRING_SLOT];
+        Callback callback = timers_[i].callback_;
+        void* object = timers_[i].object_;
+        Unlink(i);
+        Free(i);
+        callback(object);
+    }
+}
+
+// ----------------------------------------------------------------------------
+unsigned TimerWheel::Cascade(unsigned level)
+{
+    unsigned index = (currentTick_ >> (level * SLOT_BITS)) & SLOT_MASK;
+    unsigned slot = level * SLOTS_PER_LEVEL + index;
+
+    unsigned i = heads_[slot];
+    heads_[slot] = NIL;
+    while (i != NIL)
+    {
+        unsigned next = timers_[i].next_;
+        Link(i);
+        i = next;
+    }
+
+    return index;
+}
+
+// ----------------------------------------------------------------------------
+void TimerWheel::HandleUpdate(StringHash eventType, VariantMap& eventData)
+{
+    using namespace Update;
+
+    Advance(eventData[P_TIMESTEP].GetFloat());
+}
+
+}
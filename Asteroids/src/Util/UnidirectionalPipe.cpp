@@ -1,23 +1,35 @@
 #include "Asteroids/Util/UnidirectionalPipe.hpp"
 
+#include <Urho3D/IO/Log.h>
+
 #if defined(_WIN32)
 #   include <Windows.h>
 #elif defined(__linux__)
-#   include <stdio.h>
+#   include <errno.h>
+#   include <fcntl.h>
+#   include <string.h>
+#   include <unistd.h>
 #endif
 
+using namespace Urho3D;
+
 namespace Asteroids {
 
 // ----------------------------------------------------------------------------
 #if defined(_WIN32)
 UnidirectionalPipe::UnidirectionalPipe(void* handle) :
+    eof_(false),
     handle_(handle)
 {
 }
 #else
-UnidirectionalPipe::UnidirectionalPipe(int fd, const char* mode)
+UnidirectionalPipe::UnidirectionalPipe(int fd) :
+    eof_(false),
+    fd_(fd)
 {
-    fp_ = fdopen(fd, mode);
+    int flags = fcntl(fd_, F_GETFL);
+    if (flags == -1 || fcntl(fd_, F_SETFL, flags | O_NONBLOCK) == -1)
+        URHO3D_LOGERRORF("UnidirectionalPipe - Failed to set O_NONBLOCK: %s", strerror(errno));
 }
 #endif
 
@@ -36,20 +48,57 @@ void UnidirectionalPipe::Close()
 
     handle_ = nullptr;
 #else
-    if (fp_)
-        fclose(fp_);
+    if (fd_ != -1)
+        close(fd_);
 
-    fp_ = nullptr;
+    fd_ = -1;
 #endif
+    eof_ = true;
 }
 
 // ----------------------------------------------------------------------------
 unsigned UnidirectionalPipe::Read(void* dest, unsigned size)
 {
 #if defined(_WIN32)
-    return 0;
+    if (handle_ == nullptr || size == 0)
+        return 0;
+
+    // ReadFile() blocks until the requested amount of data is available, so
+    // only ask for what is already in the pipe. Failure here means the
+    // writing end was closed.
+    DWORD available = 0;
+    if (!PeekNamedPipe(handle_, nullptr, 0, nullptr, &available, nullptr))
+    {
+        eof_ = true;
+        return 0;
+    }
+    if (available == 0)
+        return 0;
+
+    DWORD bytesRead = 0;
+    if (!ReadFile(handle_, dest, Min((DWORD)size, available), &bytesRead, nullptr))
+    {
+        eof_ = true;
+        return 0;
+    }
+    return bytesRead;
 #else
-    return fread(dest, 1, size, fp_);
+    if (fd_ == -1 || size == 0)
+        return 0;
+
+    ssize_t bytesRead;
+    do
+    {
+        bytesRead = read(fd_, dest, size);
+    } while (bytesRead == -1 && errno == EINTR);
+
+    if (bytesRead == 0)  // Writing end was closed
+        eof_ = true;
+    if (bytesRead > 0)
+        return (unsigned)bytesRead;
+    if (bytesRead == -1 && errno != EAGAIN && errno != EWOULDBLOCK)
+        URHO3D_LOGERRORF("UnidirectionalPipe::Read() - read() failed: %s", strerror(errno));
+    return 0;
 #endif
 }
 
@@ -63,20 +112,40 @@ unsigned UnidirectionalPipe::Seek(unsigned position)
 unsigned UnidirectionalPipe::Write(const void* data, unsigned size)
 {
 #if defined(_WIN32)
-    return 0;
+    if (handle_ == nullptr || size == 0)
+        return 0;
+
+    DWORD bytesWritten = 0;
+    if (!WriteFile(handle_, data, size, &bytesWritten, nullptr))
+    {
+        eof_ = true;
+        return 0;
+    }
+    return bytesWritten;
 #else
-    return fwrite(data, 1, size, fp_);
+    if (fd_ == -1 || size == 0)
+        return 0;
+
+    ssize_t bytesWritten;
+    do
+    {
+        bytesWritten = write(fd_, data, size);
+    } while (bytesWritten == -1 && errno == EINTR);
+
+    if (bytesWritten >= 0)
+        return (unsigned)bytesWritten;
+    if (errno == EPIPE)  // Reading end was closed
+        eof_ = true;
+    else if (errno != EAGAIN && errno != EWOULDBLOCK)
+        URHO3D_LOGERRORF("UnidirectionalPipe::Write() - write() failed: %s", strerror(errno));
+    return 0;
 #endif
 }
 
 // ----------------------------------------------------------------------------
 bool UnidirectionalPipe::IsEof() const
 {
-#if defined(_WIN32)
-    return true;
-#else
-    return feof(fp_);
-#endif
+    return eof_;
 }
 
 }
@@ -0,0 +1,219 @@
+#include "Asteroids/Util/UpdateRegistry.hpp"
+
+#include <Urho3D/Container/Swap.h>
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Core/Profiler.h>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+// ----------------------------------------------------------------------------
+UpdateRegistry::UpdateRegistry(Context* context) :
+    Object(context),
+    updating_(false)
+{
+    SubscribeToEvent(E_UPDATE, URHO3D_HANDLER(UpdateRegistry, HandleUpdate));
+}
+
+// ----------------------------------------------------------------------------
+void UpdateRegistry::Update(float dt)
+{
+    URHO3D_PROFILE(UpdateRegistry);
+
+    // Note: typeLists_ doesn't change while updating (new types go into
+    // pendingTypeLists_), but the object arrays can grow. New objects are
+    // inserted past "count" and are skipped until the next frame.
+    updating_ = true;
+    for (auto& list : typeLists_)
+        if (list.update_ != nullptr)
+            list.update_(list.objects_, list.numAwake_, dt);
+    updating_ = false;
+
+    // Compact lists that had objects removed during the update. Order is
+    // preserved so the update order stays deterministic.
+    for (auto& list : typeLists_)
+    {
+        if (list.hasHoles_ == false)
+            continue;
+
+        unsigned count = 0, numAwake = 0;
+        for (unsigned i = 0; i != list.objects_.Size(); ++i)
+        {
+            if (list.objects_[i] == nullptr)
+                continue;
+            if (i < list.numAwake_)
+                ++numAwake;
+            list.objects_[count++] = list.objects_[i];
+        }
+        list.objects_.Resize(count);
+        list.numAwake_ = numAwake;
+        list.hasHoles_ = false;
+    }
+
+    for (const auto& list : pendingTypeLists_)
+        InsertTypeList(list);
+    pendingTypeLists_.Clear();
+
+    for (const auto& pending : pendingWakes_)
+        SetObjectAwake(pending.type_, pending.object_, pending.awake_);
+    pendingWakes_.Clear();
+}
+
+// ----------------------------------------------------------------------------
+void UpdateRegistry::AddObject(StringHash type, Group group, UpdateFunc update, void* object)
+{
+    TypeList* list = FindTypeList(type);
+    if (list)
+    {
+        list->objects_.Push(object);
+        if (list->update_ == nullptr)
+            return;
+
+        // New objects are awake. Swap the first sleeping object to the back
+        // to make room at the end of the awake range.
+        unsigned last = list->objects_.Size() - 1;
+        if (last != list->numAwake_)
+            Swap(list->objects_[last], list->objects_[list->numAwake_]);
+        ++list->numAwake_;
+        return;
+    }
+
+    TypeList newList;
+    newList.type_ = type;
+    newList.group_ = group;
+    newList.update_ = update;
+    newList.numAwake_ = update ? 1 : 0;
+    newList.hasHoles_ = false;
+    newList.objects_.Push(object);
+
+    // typeLists_ is being iterated, so hold on to the new type until the
+    // update is done
+    if (updating_)
+        pendingTypeLists_.Push(newList);
+    else
+        InsertTypeList(newList);
+}
+
+// ----------------------------------------------------------------------------
+void UpdateRegistry::RemoveObject(StringHash type, void* object)
+{
+    TypeList* list = FindTypeList(type);
+    if (list == nullptr)
+        return;
+
+    auto it = list->objects_.Find(object);
+    if (it == list->objects_.End())
+        return;
+
+    // A pending sleep/wake would otherwise apply to whatever object gets
+    // allocated at the same address next
+    for (unsigned i = 0; i != pendingWakes_.Size(); )
+    {
+        if (pendingWakes_[i].object_ == object)
+            pendingWakes_.Erase(i);
+        else
+            ++i;
+    }
+
+    // Can't change the layout of the array while it's being iterated,
+    // leave a hole and compact it after the update
+    if (updating_)
+    {
+        *it = nullptr;
+        list->hasHoles_ = true;
+    }
+    else
+    {
+        if ((unsigned)(it - list->objects_.Begin()) < list->numAwake_)
+            --list->numAwake_;
+        list->objects_.Erase(it);
+    }
+}
+
+// ----------------------------------------------------------------------------
+void UpdateRegistry::SetObjectAwake(StringHash type, void* object, bool awake)
+{
+    TypeList* list = FindTypeList(type);
+    if (list == nullptr || list->update_ == nullptr)
+        return;
+
+    // Moving objects between the awake and sleeping ranges would shuffle the
+    // array that is being iterated
+    if (updating_)
+    {
+        PendingWake pending = {type, object, awake};
+        pendingWakes_.Push(pending);
+        return;
+    }
+
+    MoveObject(list, object, awake);
+}
+
+// ----------------------------------------------------------------------------
+void UpdateRegistry::MoveObject(TypeList* list, void* object, bool awake)
+{
+    auto it = list->objects_.Find(object);
+    if (it == list->objects_.End())
+        return;
+
+    // Swap with the object on the boundary between awake and sleeping objects,
+    // then move the boundary
+    unsigned index = (unsigned)(it - list->objects_.Begin());
+    if (awake && index >= list->numAwake_)
+    {
+        Swap(list->objects_[index], list->objects_[list->numAwake_]);
+        ++list->numAwake_;
+    }
+    else if (awake == false && index < list->numAwake_)
+    {
+        --list->numAwake_;
+        Swap(list->objects_[index], list->objects_[list->numAwake_]);
+    }
+}
+
+// ----------------------------------------------------------------------------
+const PODVector<void*>& UpdateRegistry::GetObjectList(StringHash type) const
+{
+    static const PODVector<void*> empty;
+
+    for (const auto& list : typeLists_)
+        if (list.type_ == type)
+            return list.objects_;
+    for (const auto& list : pendingTypeLists_)
+        if (list.type_ == type)
+            return list.objects_;
+    return empty;
+}
+
+// ----------------------------------------------------------------------------
+UpdateRegistry::TypeList* UpdateRegistry::FindTypeList(StringHash type)
+{
+    for (auto& list : typeLists_)
+        if (list.type_ == type)
+            return &list;
+    for (auto& list : pendingTypeLists_)
+        if (list.type_ == type)
+            return &list;
+    return nullptr;
+}
+
+// ----------------------------------------------------------------------------
+void UpdateRegistry::InsertTypeList(const TypeList& list)
+{
+    // Insert after all lists of the same or earlier groups
+    auto it = typeLists_.Begin();
+    while (it != typeLists_.End() && it->group_ <= list.group_)
+        ++it;
+    typeLists_.Insert(it, list);
+}
+
+// ----------------------------------------------------------------------------
+void UpdateRegistry::HandleUpdate(StringHash eventType, VariantMap& eventData)
+{
+    using namespace Update;
+
+    Update(eventData[P_TIMESTEP].GetFloat());
+}
+
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Bench/Benchmark.hpp"
+
+namespace Urho3D {
+    class Scene;
+}
+
+namespace Asteroids {
+
+class ActionState;
+
+/*!
+ * @brief Measures ActionState::SetState() with a random stream of input
+ * states, i.e. the edge detection and the warp/use item events it sends for
+ * every replayed input transition on the server.
+ */
+class ActionStateBenchmark : public Benchmark
+{
+    URHO3D_OBJECT(ActionStateBenchmark, Benchmark)
+
+public:
+    ActionStateBenchmark(Urho3D::Context* context);
+
+    virtual void Setup() override;
+    virtual void Run(unsigned iterations) override;
+    virtual void Teardown() override;
+
+private:
+    Urho3D::SharedPtr<Urho3D::Scene> scene_;
+    ActionState* state_;
+    Urho3D::PODVector<uint16_t> states_;
+};
+
+}
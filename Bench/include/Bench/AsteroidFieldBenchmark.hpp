@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Bench/Benchmark.hpp"
+
+namespace Urho3D {
+    class Scene;
+}
+
+namespace Asteroids {
+
+class AsteroidField;
+
+/*!
+ * @brief Measures how long it takes to move every asteroid of a field by one
+ * frame. Asteroids follow the height of the procedural planet, so this
+ * includes one height map lookup per asteroid.
+ */
+class AsteroidFieldBenchmark : public Benchmark
+{
+    URHO3D_OBJECT(AsteroidFieldBenchmark, Benchmark)
+
+public:
+    AsteroidFieldBenchmark(Urho3D::Context* context, unsigned count);
+
+    virtual void Setup() override;
+    virtual void Run(unsigned iterations) override;
+    virtual void Teardown() override;
+
+private:
+    unsigned count_;
+    Urho3D::SharedPtr<Urho3D::Scene> scene_;
+    AsteroidField* field_;
+};
+
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <Urho3D/Engine/Application.h>
+#include <Urho3D/Resource/JSONValue.h>
+
+namespace Asteroids {
+
+class Benchmark;
+
+/*!
+ * @brief Headless application that runs all registered benchmarks and prints
+ * the time each operation takes.
+ *
+ * Each benchmark is first calibrated by doubling the iteration count until a
+ * single round takes at least --min-time milliseconds. Then --rounds rounds
+ * are measured and the fastest and median time per operation are printed.
+ * --filter only runs benchmarks whose name contains the specified string.
+ * --json additionally writes all results to the specified file, so the
+ * results of different builds can be compared by a script.
+ */
+class BenchApplication : public Urho3D::Application
+{
+public:
+    BenchApplication(Urho3D::Context* context);
+
+    virtual void Setup() override;
+    virtual void Start() override;
+
+private:
+    void ParseArgs();
+    void CreateBenchmarks();
+    void RunBenchmark(Benchmark* benchmark);
+    void WriteJSON() const;
+
+private:
+    struct {
+        Urho3D::String filter_;
+        Urho3D::String jsonFile_;
+        unsigned minTimeMs_;
+        unsigned rounds_;
+    } args_;
+    Urho3D::Vector<Urho3D::SharedPtr<Benchmark>> benchmarks_;
+    Urho3D::JSONArray results_;
+};
+
+}
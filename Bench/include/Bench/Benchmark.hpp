@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+
+namespace Asteroids {
+
+/*!
+ * @brief Base class for everything asteroids-bench measures.
+ *
+ * BenchApplication calls Setup() once, then repeatedly calls Reset() followed
+ * by Run(). Only the time spent in Run() is measured, so anything that isn't
+ * part of the operation being benchmarked (such as destroying the nodes that
+ * were spawned in the previous round) belongs in Reset(). Teardown() is
+ * called once at the end and should release everything Setup() created, so
+ * it doesn't stay around (e.g. in the UpdateRegistry) while the next
+ * benchmark runs.
+ */
+class Benchmark : public Urho3D::Object
+{
+    URHO3D_OBJECT(Benchmark, Urho3D::Object)
+
+public:
+    Benchmark(Urho3D::Context* context, const Urho3D::String& name);
+
+    const Urho3D::String& GetName() const { return name_; }
+    /// True if a check the benchmark does along the way failed. asteroids-bench then exits with an error.
+    bool HasFailed() const { return failed_; }
+
+    virtual void Setup() {}
+    virtual void Reset() {}
+    virtual void Teardown() {}
+
+    /*!
+     * @brief Performs the operation being measured the specified number of
+     * times.
+     */
+    virtual void Run(unsigned iterations) = 0;
+
+protected:
+    void SetFailed() { failed_ = true; }
+
+private:
+    Urho3D::String name_;
+    bool failed_;
+};
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Bench/Benchmark.hpp"
+#include <Urho3D/Math/Quaternion.h>
+
+namespace Asteroids {
+
+/*!
+ * @brief Compares the SphereMath kernels against the Urho3D math they
+ * replace.
+ *
+ * Setup() also checks the accuracy of the fast version against the Urho3D
+ * version (and against double precision for sin/cos). The maximum error is
+ * written to the log. If it exceeds the bound the kernel promises, it is
+ * logged as an error and asteroids-bench exits with a non-zero status.
+ */
+class MathBenchmark : public Benchmark
+{
+    URHO3D_OBJECT(MathBenchmark, Benchmark)
+
+public:
+    enum Kernel
+    {
+        SINCOS,
+        ROTATE_AXIS_ANGLE,
+        SURFACE_STEP
+    };
+
+    enum Method
+    {
+        URHO3D,
+        FAST
+    };
+
+    MathBenchmark(Urho3D::Context* context, Kernel kernel, Method method, unsigned count);
+
+    virtual void Setup() override;
+    virtual void Run(unsigned iterations) override;
+
+private:
+    void RunUrho3D();
+    void RunFast();
+    void CheckAccuracy();
+
+private:
+    Kernel kernel_;
+    Method method_;
+    unsigned count_;
+    Urho3D::PODVector<float> angles_;
+    Urho3D::PODVector<float> sines_;
+    Urho3D::PODVector<float> cosines_;
+    Urho3D::PODVector<Urho3D::Vector2> velocities_;
+    Urho3D::PODVector<Urho3D::Vector3> axes_;
+    Urho3D::PODVector<Urho3D::Quaternion> rotations_;
+    Urho3D::PODVector<Urho3D::Quaternion> results_;
+};
+
+}
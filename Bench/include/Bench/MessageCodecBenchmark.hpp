@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Bench/Benchmark.hpp"
+#include "Asteroids/Network/Messages.hpp"
+
+namespace Asteroids {
+
+/*!
+ * @brief Encodes and decodes ServerShipStateMsg payloads, either with the
+ * Serializer/Deserializer calls the ship states used to make or with the
+ * compiled MessageLayout. Both write the same fields, except that the schema
+ * quantizes the angle.
+ */
+class MessageCodecBenchmark : public Benchmark
+{
+    URHO3D_OBJECT(MessageCodecBenchmark, Benchmark)
+
+public:
+    enum Method
+    {
+        SERIALIZER,
+        SCHEMA
+    };
+
+    MessageCodecBenchmark(Urho3D::Context* context, Method method, unsigned count);
+
+    virtual void Setup() override;
+    virtual void Run(unsigned iterations) override;
+
+private:
+    Method method_;
+    unsigned count_;
+    Urho3D::PODVector<ServerShipStateMsg> messages_;
+    Urho3D::VectorBuffer buffer_;
+    float checksum_;
+};
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Bench/Benchmark.hpp"
+#include <Urho3D/Graphics/Drawable.h>
+
+namespace Urho3D {
+    class Camera;
+    class Octree;
+    class Scene;
+    class StaticModel;
+}
+
+namespace Asteroids {
+
+class ProjectileRenderer;
+
+/*!
+ * @brief Measures the CPU cost of preparing a frame's worth of projectiles
+ * for rendering: moving them, updating the octree and building the batches.
+ *
+ * The old way moves every projectile's node and gives it its own
+ * StaticModel, which has to be reinserted into the octree whenever it moves
+ * and produces one batch each. The instanced way only advances the scene
+ * time and draws all of them with a single ProjectileRenderer, which
+ * evaluates each phaser's position from its age. No GPU is involved, the
+ * application runs headless.
+ */
+class ProjectileRenderBenchmark : public Benchmark
+{
+    URHO3D_OBJECT(ProjectileRenderBenchmark, Benchmark)
+
+public:
+    enum Method
+    {
+        STATIC_MODELS,
+        INSTANCED
+    };
+
+    ProjectileRenderBenchmark(Urho3D::Context* context, Method method, unsigned count);
+
+    virtual void Setup() override;
+    virtual void Run(unsigned iterations) override;
+    virtual void Teardown() override;
+
+private:
+    Method method_;
+    unsigned count_;
+    Urho3D::SharedPtr<Urho3D::Scene> scene_;
+    Urho3D::Octree* octree_;
+    Urho3D::Camera* camera_;
+    ProjectileRenderer* renderer_;
+    Urho3D::PODVector<Urho3D::Node*> projectiles_;
+    Urho3D::PODVector<Urho3D::StaticModel*> models_;
+    Urho3D::FrameInfo frame_;
+};
+
+}
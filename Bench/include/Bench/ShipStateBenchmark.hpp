@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Bench/Benchmark.hpp"
+#include "Asteroids/Network/Messages.hpp"
+#include <Urho3D/IO/VectorBuffer.h>
+
+namespace Urho3D {
+    class Scene;
+}
+
+namespace Asteroids {
+
+class ClientRemoteShipState;
+class ServerShipState;
+class User;
+
+/*!
+ * @brief Measures one network tick's worth of ship states with the specified
+ * number of ships.
+ *
+ * Encode writes the state of every ship the way SnapshotScheduler does when
+ * gathering a snapshot. Decode decodes a snapshot with every ship the way
+ * SnapshotScheduler does and applies each ship's state to its
+ * ClientRemoteShipState.
+ */
+class ShipStateBenchmark : public Benchmark
+{
+    URHO3D_OBJECT(ShipStateBenchmark, Benchmark)
+
+public:
+    enum Direction
+    {
+        ENCODE,
+        DECODE
+    };
+
+    ShipStateBenchmark(Urho3D::Context* context, Direction direction, unsigned count);
+
+    virtual void Setup() override;
+    virtual void Run(unsigned iterations) override;
+
+private:
+    Direction direction_;
+    unsigned count_;
+    Urho3D::SharedPtr<Urho3D::Scene> serverScene_;
+    Urho3D::SharedPtr<Urho3D::Scene> clientScene_;
+    Urho3D::Vector<Urho3D::SharedPtr<User>> users_;
+    Urho3D::PODVector<ServerShipState*> states_;
+    Urho3D::PODVector<ClientRemoteShipState*> remoteStates_;
+    Urho3D::PODVector<ServerShipStateMsg> shipStates_;
+    Urho3D::PODVector<unsigned char> snapshot_;
+    Urho3D::VectorBuffer msg_;
+};
+
+}
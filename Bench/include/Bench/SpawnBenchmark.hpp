@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Bench/Benchmark.hpp"
+#include <Urho3D/Scene/Node.h>
+
+namespace Urho3D {
+    class Scene;
+    class XMLFile;
+}
+
+namespace Asteroids {
+
+class Prefab;
+
+/*!
+ * @brief Measures how long it takes to spawn one of the prefabs in
+ * Data/Prefabs, either by loading the XML file into a node like we used to or
+ * by instantiating it through a Prefab resource.
+ */
+class SpawnBenchmark : public Benchmark
+{
+    URHO3D_OBJECT(SpawnBenchmark, Benchmark)
+
+public:
+    enum Method
+    {
+        LOAD_XML,
+        INSTANTIATE_PREFAB
+    };
+
+    SpawnBenchmark(Urho3D::Context* context, const Urho3D::String& prefabName, Method method, Urho3D::CreateMode mode);
+
+    virtual void Setup() override;
+    virtual void Reset() override;
+    virtual void Run(unsigned iterations) override;
+    virtual void Teardown() override;
+
+private:
+    Urho3D::String prefabName_;
+    Method method_;
+    Urho3D::CreateMode mode_;
+    Urho3D::SharedPtr<Urho3D::Scene> scene_;
+    Urho3D::SharedPtr<Urho3D::XMLFile> xml_;
+    Urho3D::SharedPtr<Prefab> prefab_;
+};
+
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Bench/Benchmark.hpp"
+#include <Urho3D/Math/Vector2.h>
+
+namespace Urho3D {
+    class Scene;
+}
+
+namespace Asteroids {
+
+class SurfaceObject;
+
+/*!
+ * @brief Measures moving objects across the planet's surface the way ships
+ * and mines do every frame: one SurfaceObject::UpdatePosition() followed by
+ * one UpdatePlanetHeight() against the procedural planet.
+ */
+class SurfaceObjectBenchmark : public Benchmark
+{
+    URHO3D_OBJECT(SurfaceObjectBenchmark, Benchmark)
+
+public:
+    SurfaceObjectBenchmark(Urho3D::Context* context, unsigned count);
+
+    virtual void Setup() override;
+    virtual void Run(unsigned iterations) override;
+    virtual void Teardown() override;
+
+private:
+    unsigned count_;
+    Urho3D::SharedPtr<Urho3D::Scene> scene_;
+    Urho3D::PODVector<SurfaceObject*> objects_;
+    Urho3D::PODVector<Urho3D::Vector2> velocities_;
+};
+
+}
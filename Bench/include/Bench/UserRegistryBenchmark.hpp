@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Bench/Benchmark.hpp"
+
+namespace Asteroids {
+
+class UserRegistry;
+
+/*!
+ * @brief Measures looking up users in a UserRegistry with many users, by
+ * GUID (what the network message handlers do) and by name (what the chat
+ * and the join logic do).
+ */
+class UserRegistryBenchmark : public Benchmark
+{
+    URHO3D_OBJECT(UserRegistryBenchmark, Benchmark)
+
+public:
+    enum Lookup
+    {
+        BY_GUID,
+        BY_NAME
+    };
+
+    UserRegistryBenchmark(Urho3D::Context* context, Lookup lookup, unsigned count);
+
+    virtual void Setup() override;
+    virtual void Run(unsigned iterations) override;
+
+private:
+    Lookup lookup_;
+    unsigned count_;
+    Urho3D::SharedPtr<UserRegistry> registry_;
+    Urho3D::Vector<Urho3D::String> names_;
+};
+
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Bench/Benchmark.hpp"
+
+namespace Urho3D {
+    class Scene;
+}
+
+namespace Asteroids {
+
+class WeaponSpawner;
+
+/*!
+ * @brief Measures firing a spread shot with WeaponSpawner::CreateSpread(),
+ * i.e. instantiating and launching one phaser per pellet. The phasers are
+ * removed again in Reset().
+ */
+class WeaponSpawnerBenchmark : public Benchmark
+{
+    URHO3D_OBJECT(WeaponSpawnerBenchmark, Benchmark)
+
+public:
+    WeaponSpawnerBenchmark(Urho3D::Context* context);
+
+    virtual void Setup() override;
+    virtual void Reset() override;
+    virtual void Run(unsigned iterations) override;
+    virtual void Teardown() override;
+
+private:
+    Urho3D::SharedPtr<Urho3D::Scene> scene_;
+    WeaponSpawner* spawner_;
+    unsigned numSceneChildren_;
+};
+
+}
@@ -0,0 +1,49 @@
+#include "Bench/ActionStateBenchmark.hpp"
+#include "Asteroids/Player/ActionState.hpp"
+
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+static const unsigned NUM_STATES = 256;
+
+// ----------------------------------------------------------------------------
+ActionStateBenchmark::ActionStateBenchmark(Context* context) :
+    Benchmark(context, "input/action-state"),
+    state_(nullptr)
+{
+}
+
+// ----------------------------------------------------------------------------
+void ActionStateBenchmark::Setup()
+{
+    scene_ = new Scene(context_);
+    state_ = scene_->CreateChild("Ship", LOCAL)->CreateComponent<ActionState>(LOCAL);
+
+    // Random 16-bit states, so every call is a transition and about half of
+    // them press warp or use item
+    SetRandomSeed(1);
+    for (unsigned i = 0; i != NUM_STATES; ++i)
+        states_.Push((uint16_t)(Rand() | (Rand() << 15)));
+}
+
+// ----------------------------------------------------------------------------
+void ActionStateBenchmark::Run(unsigned iterations)
+{
+    for (unsigned i = 0; i != iterations; ++i)
+    {
+        state_->SetState(states_[i % NUM_STATES]);
+        state_->ConsumeFirePressed();
+    }
+}
+
+// ----------------------------------------------------------------------------
+void ActionStateBenchmark::Teardown()
+{
+    scene_.Reset();
+}
+
+}
@@ -0,0 +1,49 @@
+#include "Bench/AsteroidFieldBenchmark.hpp"
+#include "Asteroids/Objects/AsteroidField.hpp"
+#include "Asteroids/Objects/ProceduralPlanet.hpp"
+
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Physics/PhysicsWorld.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+// ----------------------------------------------------------------------------
+AsteroidFieldBenchmark::AsteroidFieldBenchmark(Context* context, unsigned count) :
+    Benchmark(context, ToString("sim/asteroids-%u", count)),
+    count_(count),
+    field_(nullptr)
+{
+}
+
+// ----------------------------------------------------------------------------
+void AsteroidFieldBenchmark::Setup()
+{
+    scene_ = new Scene(context_);
+    scene_->CreateComponent<Octree>(LOCAL);
+    scene_->CreateComponent<PhysicsWorld>(LOCAL);
+    scene_->CreateChild("Planet", LOCAL)->CreateComponent<ProceduralPlanet>(LOCAL)->Generate();
+
+    // Run() calls Simulate() directly, so no new waves are spawned
+    field_ = scene_->CreateChild("Asteroids", LOCAL)->CreateComponent<AsteroidField>(LOCAL);
+    field_->SetAuthority(true);
+    field_->SpawnWave(1, count_);
+}
+
+// ----------------------------------------------------------------------------
+void AsteroidFieldBenchmark::Run(unsigned iterations)
+{
+    for (unsigned i = 0; i != iterations; ++i)
+        field_->Simulate(1.0f / 60);
+}
+
+// ----------------------------------------------------------------------------
+void AsteroidFieldBenchmark::Teardown()
+{
+    scene_.Reset();
+}
+
+}
@@ -0,0 +1,266 @@
+#include "Bench/BenchApplication.hpp"
+#include "Bench/ActionStateBenchmark.hpp"
+#include "Bench/AsteroidFieldBenchmark.hpp"
+#include "Bench/MathBenchmark.hpp"
+#include "Bench/MessageCodecBenchmark.hpp"
+#include "Bench/ProjectileRenderBenchmark.hpp"
+#include "Bench/ShipStateBenchmark.hpp"
+#include "Bench/SpawnBenchmark.hpp"
+#include "Bench/SurfaceObjectBenchmark.hpp"
+#include "Bench/UserRegistryBenchmark.hpp"
+#include "Bench/WeaponSpawnerBenchmark.hpp"
+#include "Asteroids/AsteroidsLib.hpp"
+
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Engine/Engine.h>
+#include <Urho3D/Engine/EngineDefs.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Resource/JSONFile.h>
+
+#include <algorithm>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+// ----------------------------------------------------------------------------
+BenchApplication::BenchApplication(Context* context) :
+    Application(context),
+    args_({"", "", 100, 5})
+{
+}
+
+// ----------------------------------------------------------------------------
+void BenchApplication::Setup()
+{
+    ParseArgs();
+
+    engineParameters_[EP_LOG_NAME] = "asteroids-bench.log";
+    engineParameters_[EP_LOG_QUIET] = true;
+    engineParameters_[EP_HEADLESS] = true;
+}
+
+// ----------------------------------------------------------------------------
+void BenchApplication::Start()
+{
+    RegisterObjectFactories(context_);
+
+    CreateBenchmarks();
+
+    PrintLine(ToString("%-48s %12s %12s %12s", "benchmark", "iterations", "best ns/op", "median ns/op"));
+    String failed;
+    for (auto& benchmark : benchmarks_)
+    {
+        if (args_.filter_.Empty() == false && benchmark->GetName().Contains(args_.filter_) == false)
+            continue;
+        RunBenchmark(benchmark);
+        if (benchmark->HasFailed())
+            failed += " " + benchmark->GetName();
+    }
+
+    if (args_.jsonFile_.Empty() == false)
+        WriteJSON();
+
+    // So scripts running the benchmarks notice broken kernels
+    if (failed.Empty() == false)
+    {
+        ErrorExit("Checks failed in:" + failed);
+        return;
+    }
+
+    engine_->Exit();
+}
+
+// ----------------------------------------------------------------------------
+void BenchApplication::ParseArgs()
+{
+    enum Expect
+    {
+        EXPECT_NONE,
+        EXPECT_FILTER,
+        EXPECT_JSON,
+        EXPECT_MIN_TIME,
+        EXPECT_ROUNDS
+    } expected = EXPECT_NONE;
+
+    for (const auto& arg : GetArguments())
+    {
+        switch (expected)
+        {
+            case EXPECT_FILTER : {
+                args_.filter_ = arg;
+                expected = EXPECT_NONE;
+            } break;
+
+            case EXPECT_JSON : {
+                args_.jsonFile_ = arg;
+                expected = EXPECT_NONE;
+            } break;
+
+            case EXPECT_MIN_TIME : {
+                args_.minTimeMs_ = Max(1u, ToUInt(arg));
+                expected = EXPECT_NONE;
+            } break;
+
+            case EXPECT_ROUNDS : {
+                args_.rounds_ = Max(1u, ToUInt(arg));
+                expected = EXPECT_NONE;
+            } break;
+
+            case EXPECT_NONE : {
+                if      (arg == "--filter")   expected = EXPECT_FILTER;
+                else if (arg == "--json")     expected = EXPECT_JSON;
+                else if (arg == "--min-time") expected = EXPECT_MIN_TIME;
+                else if (arg == "--rounds")   expected = EXPECT_ROUNDS;
+                else
+                {
+                    ErrorExit("Unknown option " + arg);
+                }
+            } break;
+        }
+    }
+
+    if (expected != EXPECT_NONE)
+    {
+        ErrorExit("Missing argument to command line option");
+    }
+}
+
+// ----------------------------------------------------------------------------
+void BenchApplication::CreateBenchmarks()
+{
+    static const char* weaponPrefabs[] = {
+        "Prefabs/Phaser.xml",
+        "Prefabs/Mine.xml"
+    };
+    static const char* shipPrefabs[] = {
+        "Prefabs/ServerShip.xml",
+        "Prefabs/ClientLocalShip.xml",
+        "Prefabs/ClientRemoteShip.xml"
+    };
+
+    // Weapons are spawned as replicated nodes, ships as local nodes. Keep it
+    // the same as the game does it
+    for (const char* prefab : weaponPrefabs)
+    {
+        benchmarks_.Push(SharedPtr<Benchmark>(new SpawnBenchmark(context_, prefab, SpawnBenchmark::LOAD_XML, REPLICATED)));
+        benchmarks_.Push(SharedPtr<Benchmark>(new SpawnBenchmark(context_, prefab, SpawnBenchmark::INSTANTIATE_PREFAB, REPLICATED)));
+    }
+    for (const char* prefab : shipPrefabs)
+    {
+        benchmarks_.Push(SharedPtr<Benchmark>(new SpawnBenchmark(context_, prefab, SpawnBenchmark::LOAD_XML, LOCAL)));
+        benchmarks_.Push(SharedPtr<Benchmark>(new SpawnBenchmark(context_, prefab, SpawnBenchmark::INSTANTIATE_PREFAB, LOCAL)));
+    }
+
+    for (unsigned count : {1000u, 10000u})
+    {
+        benchmarks_.Push(SharedPtr<Benchmark>(new ProjectileRenderBenchmark(context_, ProjectileRenderBenchmark::STATIC_MODELS, count)));
+        benchmarks_.Push(SharedPtr<Benchmark>(new ProjectileRenderBenchmark(context_, ProjectileRenderBenchmark::INSTANCED, count)));
+    }
+
+    for (unsigned count : {1000u, 10000u})
+        benchmarks_.Push(SharedPtr<Benchmark>(new AsteroidFieldBenchmark(context_, count)));
+
+    for (unsigned count : {16u, 256u})
+        benchmarks_.Push(SharedPtr<Benchmark>(new SurfaceObjectBenchmark(context_, count)));
+
+    benchmarks_.Push(SharedPtr<Benchmark>(new ActionStateBenchmark(context_)));
+
+    for (unsigned count : {64u, 4096u})
+    {
+        benchmarks_.Push(SharedPtr<Benchmark>(new UserRegistryBenchmark(context_, UserRegistryBenchmark::BY_GUID, count)));
+        benchmarks_.Push(SharedPtr<Benchmark>(new UserRegistryBenchmark(context_, UserRegistryBenchmark::BY_NAME, count)));
+    }
+
+    for (unsigned count : {16u, 64u})
+    {
+        benchmarks_.Push(SharedPtr<Benchmark>(new ShipStateBenchmark(context_, ShipStateBenchmark::ENCODE, count)));
+        benchmarks_.Push(SharedPtr<Benchmark>(new ShipStateBenchmark(context_, ShipStateBenchmark::DECODE, count)));
+    }
+
+    for (unsigned count : {16u, 64u})
+    {
+        benchmarks_.Push(SharedPtr<Benchmark>(new MessageCodecBenchmark(context_, MessageCodecBenchmark::SERIALIZER, count)));
+        benchmarks_.Push(SharedPtr<Benchmark>(new MessageCodecBenchmark(context_, MessageCodecBenchmark::SCHEMA, count)));
+    }
+
+    benchmarks_.Push(SharedPtr<Benchmark>(new WeaponSpawnerBenchmark(context_)));
+
+    for (MathBenchmark::Kernel kernel : {MathBenchmark::SINCOS, MathBenchmark::ROTATE_AXIS_ANGLE, MathBenchmark::SURFACE_STEP})
+    {
+        benchmarks_.Push(SharedPtr<Benchmark>(new MathBenchmark(context_, kernel, MathBenchmark::URHO3D, 10000)));
+        benchmarks_.Push(SharedPtr<Benchmark>(new MathBenchmark(context_, kernel, MathBenchmark::FAST, 10000)));
+    }
+}
+
+// ----------------------------------------------------------------------------
+void BenchApplication::RunBenchmark(Benchmark* benchmark)
+{
+    HiresTimer timer;
+    long long minTimeUs = args_.minTimeMs_ * 1000ll;
+
+    benchmark->Setup();
+
+    // Find an iteration count where one round takes long enough for the
+    // timer resolution to not matter
+    unsigned iterations = 1;
+    while (true)
+    {
+        benchmark->Reset();
+        timer.Reset();
+        benchmark->Run(iterations);
+        if (timer.GetUSec(false) >= minTimeUs || iterations >= (1u << 30))
+            break;
+        iterations *= 2;
+    }
+
+    PODVector<double> nsPerOp;
+    for (unsigned round = 0; round != args_.rounds_; ++round)
+    {
+        benchmark->Reset();
+        timer.Reset();
+        benchmark->Run(iterations);
+        nsPerOp.Push(timer.GetUSec(false) * 1000.0 / iterations);
+    }
+    benchmark->Reset();
+    benchmark->Teardown();
+
+    std::sort(nsPerOp.Begin(), nsPerOp.End());
+    PrintLine(ToString("%-48s %12u %12.1f %12.1f",
+        benchmark->GetName().CString(),
+        iterations,
+        nsPerOp.Front(),
+        nsPerOp[nsPerOp.Size() / 2]));
+
+    JSONArray rounds;
+    for (double ns : nsPerOp)
+        rounds.Push(ns);
+
+    JSONValue result;
+    result["name"] = benchmark->GetName();
+    result["iterations"] = iterations;
+    result["best_ns_per_op"] = nsPerOp.Front();
+    result["median_ns_per_op"] = nsPerOp[nsPerOp.Size() / 2];
+    result["rounds_ns_per_op"] = rounds;
+    results_.Push(result);
+}
+
+// ----------------------------------------------------------------------------
+void BenchApplication::WriteJSON() const
+{
+    JSONFile json(context_);
+    JSONValue& root = json.GetRoot();
+    root["min_time_ms"] = args_.minTimeMs_;
+    root["rounds"] = args_.rounds_;
+    root["filter"] = args_.filter_;
+    root["benchmarks"] = results_;
+
+    File file(context_, args_.jsonFile_, FILE_WRITE);
+    if (file.IsOpen() == false || json.Save(file, "  ") == false)
+        ErrorExit("Failed to write results to " + args_.jsonFile_);
+}
+
+}
@@ -0,0 +1,15 @@
+#include "Bench/Benchmark.hpp"
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+// ----------------------------------------------------------------------------
+Benchmark::Benchmark(Context* context, const String& name) :
+    Object(context),
+    name_(name),
+    failed_(false)
+{
+}
+
+}
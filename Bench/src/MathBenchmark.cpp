@@ -0,0 +1,188 @@
+#include "Bench/MathBenchmark.hpp"
+#include "Asteroids/Util/SphereMath.hpp"
+
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Math/Random.h>
+#include <cmath>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+static const char* kernelNames[] = {
+    "sincos",
+    "rotate",
+    "surface-step"
+};
+
+// Both versions round differently, the results are compared per component
+static const float QUATERNION_MAX_ERROR = 1e-5f;
+static const float SURFACE_RADIUS = 100;
+static const float TIME_STEP = 1.0f / 60;
+
+// ----------------------------------------------------------------------------
+static float QuaternionError(const Quaternion& a, const Quaternion& b)
+{
+    return Max(Max(Abs(a.w_ - b.w_), Abs(a.x_ - b.x_)), Max(Abs(a.y_ - b.y_), Abs(a.z_ - b.z_)));
+}
+
+// ----------------------------------------------------------------------------
+MathBenchmark::MathBenchmark(Context* context, Kernel kernel, Method method, unsigned count) :
+    Benchmark(context, ToString("math/%s-%u", kernelNames[kernel], count) + (method == URHO3D ? "/Urho3D" : "/Fast")),
+    kernel_(kernel),
+    method_(method),
+    count_(count)
+{
+}
+
+// ----------------------------------------------------------------------------
+void MathBenchmark::Setup()
+{
+    // Same ranges the game uses: headings wrap at 360 but phaser and
+    // asteroid ages make the angles grow, velocities are up to ~600 units/s
+    SetRandomSeed(1);
+    angles_.Resize(count_);
+    sines_.Resize(count_);
+    cosines_.Resize(count_);
+    velocities_.Resize(count_);
+    axes_.Resize(count_);
+    rotations_.Resize(count_);
+    results_.Resize(count_);
+    for (unsigned i = 0; i != count_; ++i)
+    {
+        angles_[i] = Random(-3600.0f, 3600.0f);
+        velocities_[i] = Vector2(Random(-600.0f, 600.0f), Random(-600.0f, 600.0f));
+        axes_[i] = Vector3(Random(-1.0f, 1.0f), Random(-1.0f, 1.0f), Random(-1.0f, 1.0f)).Normalized();
+        rotations_[i] = Quaternion(Random(360.0f), Vector3(Random(-1.0f, 1.0f), Random(-1.0f, 1.0f), Random(-1.0f, 1.0f)).Normalized());
+    }
+
+    if (method_ == FAST)
+        CheckAccuracy();
+}
+
+// ----------------------------------------------------------------------------
+void MathBenchmark::Run(unsigned iterations)
+{
+    for (unsigned i = 0; i != iterations; ++i)
+    {
+        if (method_ == URHO3D)
+            RunUrho3D();
+        else
+            RunFast();
+    }
+}
+
+// ----------------------------------------------------------------------------
+void MathBenchmark::RunUrho3D()
+{
+    switch (kernel_)
+    {
+        case SINCOS:
+            for (unsigned i = 0; i != count_; ++i)
+            {
+                sines_[i] = Sin(angles_[i]);
+                cosines_[i] = Cos(angles_[i]);
+            }
+            break;
+
+        case ROTATE_AXIS_ANGLE:
+            for (unsigned i = 0; i != count_; ++i)
+                results_[i] = (rotations_[i] * Quaternion(angles_[i], axes_[i])).Normalized();
+            break;
+
+        case SURFACE_STEP:
+            for (unsigned i = 0; i != count_; ++i)
+            {
+                Quaternion xrot(2 * M_PI * velocities_[i].y_ / SURFACE_RADIUS * TIME_STEP, Vector3::RIGHT);
+                Quaternion zrot(2 * M_PI * velocities_[i].x_ / SURFACE_RADIUS * TIME_STEP, Vector3::BACK);
+                results_[i] = xrot * zrot;
+            }
+            break;
+    }
+}
+
+// ----------------------------------------------------------------------------
+void MathBenchmark::RunFast()
+{
+    switch (kernel_)
+    {
+        case SINCOS:
+            FastSinCos(&angles_[0], &sines_[0], &cosines_[0], count_);
+            break;
+
+        case ROTATE_AXIS_ANGLE:
+            RotateAxisAngle(&results_[0], &rotations_[0], &axes_[0], &angles_[0], count_);
+            break;
+
+        case SURFACE_STEP:
+            for (unsigned i = 0; i != count_; ++i)
+                results_[i] = SurfaceStep(velocities_[i], SURFACE_RADIUS, TIME_STEP);
+            break;
+    }
+}
+
+// ----------------------------------------------------------------------------
+void MathBenchmark::CheckAccuracy()
+{
+    // Check sin/cos over the whole range the bound is promised for, not just
+    // the range that is timed. Include both ends and odd multiples of 45,
+    // where the quadrant is a tie between two multiples of 90.
+    PODVector<float> timedAngles = angles_;
+    if (kernel_ == SINCOS && count_ >= 2)
+    {
+        int maxQuarterTurns = (int)(FAST_SINCOS_MAX_ANGLE / 90);
+        for (unsigned i = 0; i != count_; ++i)
+        {
+            if (i % 8 == 0)
+                angles_[i] = 45.0f * (2 * Random(-maxQuarterTurns, maxQuarterTurns) + 1);
+            else
+                angles_[i] = Random(-FAST_SINCOS_MAX_ANGLE, FAST_SINCOS_MAX_ANGLE);
+        }
+        angles_[count_ - 1] = FAST_SINCOS_MAX_ANGLE;
+        angles_[count_ - 2] = -FAST_SINCOS_MAX_ANGLE;
+    }
+
+    RunUrho3D();
+    PODVector<float> sines = sines_;
+    PODVector<float> cosines = cosines_;
+    PODVector<Quaternion> results = results_;
+    RunFast();
+
+    float maxError = 0;
+    float maxErrorUrho3D = 0;
+    float bound = QUATERNION_MAX_ERROR;
+    for (unsigned i = 0; i != count_; ++i)
+    {
+        if (kernel_ == SINCOS)
+        {
+            // Urho3D's Sin() and Cos() aren't exact either, compare both
+            // against double precision
+            double radians = angles_[i] * (M_PI / 180.0);
+            double sine = std::sin(radians);
+            double cosine = std::cos(radians);
+            maxError = Max(maxError, (float)Max(Abs(sines_[i] - sine), Abs(cosines_[i] - cosine)));
+            maxErrorUrho3D = Max(maxErrorUrho3D, (float)Max(Abs(sines[i] - sine), Abs(cosines[i] - cosine)));
+            bound = FAST_SINCOS_MAX_ERROR;
+        }
+        else
+        {
+            maxError = Max(maxError, QuaternionError(results_[i], results[i]));
+        }
+    }
+
+    if (kernel_ == SINCOS)
+        URHO3D_LOGINFOF("%s: max error %g (Urho3D: %g)", GetName().CString(), maxError, maxErrorUrho3D);
+    else
+        URHO3D_LOGINFOF("%s: max difference to Urho3D %g", GetName().CString(), maxError);
+
+    if (maxError > bound)
+    {
+        URHO3D_LOGERRORF("%s: error %g exceeds the bound of %g", GetName().CString(), maxError, bound);
+        SetFailed();
+    }
+
+    angles_ = timedAngles;
+}
+
+}
@@ -0,0 +1,88 @@
+#include "Bench/MessageCodecBenchmark.hpp"
+
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Math/Random.h>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+// ----------------------------------------------------------------------------
+MessageCodecBenchmark::MessageCodecBenchmark(Context* context, Method method, unsigned count) :
+    Benchmark(context, ToString("net/codec-%u", count) + (method == SERIALIZER ? "/Serializer" : "/Schema")),
+    method_(method),
+    count_(count),
+    checksum_(0)
+{
+}
+
+// ----------------------------------------------------------------------------
+void MessageCodecBenchmark::Setup()
+{
+    SetRandomSeed(1);
+    for (unsigned i = 0; i != count_; ++i)
+    {
+        ServerShipStateMsg msg = {
+            (uint16_t)i,
+            (uint8_t)Rand(),
+            Quaternion(Random(360.0f), Random(360.0f), Random(360.0f)),
+            Random(190.0f, 210.0f),
+            Random(360.0f),
+            (uint16_t)Rand()
+        };
+        messages_.Push(msg);
+    }
+
+    ReserveMessage(buffer_, count_ * ServerShipStateMsg::Layout::SIZE);
+}
+
+// ----------------------------------------------------------------------------
+void MessageCodecBenchmark::Run(unsigned iterations)
+{
+    // Every iteration encodes all messages into one buffer and decodes them
+    // again, the checksum keeps the compiler from dropping the decode
+    for (unsigned i = 0; i != iterations; ++i)
+    {
+        buffer_.Clear();
+        if (method_ == SERIALIZER)
+        {
+            for (const ServerShipStateMsg& msg : messages_)
+            {
+                buffer_.WriteUShort(msg.guid_);
+                buffer_.WriteUByte(msg.timeStep_);
+                buffer_.WritePackedQuaternion(msg.pivotRotation_);
+                buffer_.WriteFloat(msg.offsetFromPlanetCenter_);
+                buffer_.WriteFloat(msg.angle_);
+                buffer_.WriteUShort(msg.lastInputSequence_);
+            }
+
+            MemoryBuffer reader(buffer_.GetData(), buffer_.GetSize());
+            for (unsigned m = 0; m != count_; ++m)
+            {
+                reader.ReadUShort();
+                reader.ReadUByte();
+                checksum_ += reader.ReadPackedQuaternion().w_;
+                checksum_ += reader.ReadFloat();
+                checksum_ += reader.ReadFloat();
+                reader.ReadUShort();
+            }
+        }
+        else
+        {
+            for (const ServerShipStateMsg& msg : messages_)
+                WriteMessage(buffer_, msg);
+
+            MemoryBuffer reader(buffer_.GetData(), buffer_.GetSize());
+            ServerShipStateMsg msg;
+            for (unsigned m = 0; m != count_; ++m)
+            {
+                ReadMessage(reader, &msg);
+                checksum_ += msg.pivotRotation_.w_;
+                checksum_ += msg.offsetFromPlanetCenter_;
+                checksum_ += msg.angle_;
+            }
+        }
+    }
+}
+
+}
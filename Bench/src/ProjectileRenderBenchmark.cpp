@@ -0,0 +1,132 @@
+#include "Bench/ProjectileRenderBenchmark.hpp"
+#include "Asteroids/Objects/PhaserController.hpp"
+#include "Asteroids/Objects/ProjectileRenderer.hpp"
+#include "Asteroids/Util/Prefab.hpp"
+#include "Asteroids/Util/UpdateRegistry.hpp"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/Material.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/StaticModel.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Physics/PhysicsWorld.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+// ----------------------------------------------------------------------------
+ProjectileRenderBenchmark::ProjectileRenderBenchmark(Context* context, Method method, unsigned count) :
+    Benchmark(context, ToString("render/phaser-%u", count) + (method == STATIC_MODELS ? "/StaticModel" : "/Instanced")),
+    method_(method),
+    count_(count),
+    octree_(nullptr),
+    camera_(nullptr),
+    renderer_(nullptr)
+{
+}
+
+// ----------------------------------------------------------------------------
+void ProjectileRenderBenchmark::Setup()
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    Model* model = cache->GetResource<Model>("Models/PHPhaser.mdl");
+    Material* material = cache->GetResource<Material>("Materials/Phaser.xml");
+    Prefab* prefab = cache->GetResource<Prefab>("Prefabs/Phaser.xml");
+    if (prefab == nullptr)
+        return;
+
+    // The renderer reads projectiles from the registry
+    if (GetSubsystem<UpdateRegistry>() == nullptr)
+        context_->RegisterSubsystem<UpdateRegistry>();
+
+    scene_ = new Scene(context_);
+    octree_ = scene_->CreateComponent<Octree>(LOCAL);
+    scene_->CreateComponent<PhysicsWorld>(LOCAL);
+    camera_ = scene_->CreateChild("Camera", LOCAL)->CreateComponent<Camera>();
+    camera_->GetNode()->SetPosition(Vector3(0, 160, 0));
+
+    if (method_ == INSTANCED)
+    {
+        renderer_ = scene_->CreateComponent<ProjectileRenderer>(LOCAL);
+        renderer_->SetProjectileType(ProjectileRenderer::PHASER);
+        renderer_->SetModel(model);
+        renderer_->SetMaterial(material);
+    }
+
+    // Spread the projectiles over the planet like a busy game would
+    SetRandomSeed(1);
+    for (unsigned i = 0; i != count_; ++i)
+    {
+        Node* pivot = scene_->CreateChild("", LOCAL);
+        prefab->Instantiate(pivot);
+
+        Node* phaser = pivot->GetChild("Phaser");
+        Quaternion rotation(Random(360.0f), Random(360.0f), Random(360.0f));
+        phaser->GetComponent<PhaserController>()->SetTrajectory(rotation, Vector2(0, 600), 100);
+        projectiles_.Push(phaser);
+
+        if (method_ == STATIC_MODELS)
+        {
+            StaticModel* staticModel = phaser->CreateComponent<StaticModel>();
+            staticModel->SetModel(model);
+            staticModel->SetMaterial(material);
+            models_.Push(staticModel);
+        }
+    }
+
+    frame_.frameNumber_ = 0;
+    frame_.timeStep_ = 1.0f / 60;
+    frame_.viewSize_ = IntVector2(1920, 1080);
+    frame_.camera_ = camera_;
+}
+
+// ----------------------------------------------------------------------------
+void ProjectileRenderBenchmark::Run(unsigned iterations)
+{
+    if (scene_ == nullptr)
+        return;
+
+    Quaternion step(0.1f, Vector3::RIGHT);
+    for (unsigned i = 0; i != iterations; ++i)
+    {
+        frame_.frameNumber_++;
+
+        if (method_ == STATIC_MODELS)
+        {
+            // Every projectile node moves every frame
+            for (Node* projectile : projectiles_)
+                projectile->GetParent()->Rotate(step);
+
+            octree_->Update(frame_);
+            for (StaticModel* model : models_)
+                model->UpdateBatches(frame_);
+        }
+        else
+        {
+            // Phasers are evaluated from their age when gathered
+            scene_->SetElapsedTime(scene_->GetElapsedTime() + frame_.timeStep_);
+            renderer_->UpdateInstances();
+            octree_->Update(frame_);
+            renderer_->UpdateBatches(frame_);
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+void ProjectileRenderBenchmark::Teardown()
+{
+    projectiles_.Clear();
+    models_.Clear();
+    octree_ = nullptr;
+    camera_ = nullptr;
+    renderer_ = nullptr;
+    scene_.Reset();
+}
+
+}
@@ -0,0 +1,110 @@
+#include "Bench/ShipStateBenchmark.hpp"
+#include "Asteroids/Network/Messages.hpp"
+#include "Asteroids/Network/SnapshotScheduler.hpp"
+#include "Asteroids/Player/ClientRemoteShipState.hpp"
+#include "Asteroids/Player/ServerShipState.hpp"
+#include "Asteroids/UserRegistry/User.hpp"
+#include "Asteroids/Util/Prefab.hpp"
+
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Physics/PhysicsWorld.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+// ----------------------------------------------------------------------------
+ShipStateBenchmark::ShipStateBenchmark(Context* context, Direction direction, unsigned count) :
+    Benchmark(context, ToString("net/ship-state-%u", count) + (direction == ENCODE ? "/Encode" : "/Decode")),
+    direction_(direction),
+    count_(count)
+{
+}
+
+// ----------------------------------------------------------------------------
+void ShipStateBenchmark::Setup()
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    Prefab* serverShip = cache->GetResource<Prefab>("Prefabs/ServerShip.xml");
+    Prefab* remoteShip = cache->GetResource<Prefab>("Prefabs/ClientRemoteShip.xml");
+    if (serverShip == nullptr || remoteShip == nullptr)
+        return;
+
+    serverScene_ = new Scene(context_);
+    serverScene_->CreateComponent<Octree>(LOCAL);
+    serverScene_->CreateComponent<PhysicsWorld>(LOCAL);
+    clientScene_ = new Scene(context_);
+    clientScene_->CreateComponent<Octree>(LOCAL);
+
+    SetRandomSeed(1);
+    for (unsigned i = 0; i != count_; ++i)
+    {
+        SharedPtr<User> user(new User(ToString("player-%u", i), (User::GUID)i));
+        users_.Push(user);
+
+        Node* pivot = serverScene_->CreateChild("", LOCAL);
+        pivot->SetRotation(Quaternion(Random(360.0f), Random(360.0f), Random(360.0f)));
+        serverShip->Instantiate(pivot);
+        ServerShipState* state = pivot->GetComponent<ServerShipState>(true);
+        state->SetUser(user);
+        states_.Push(state);
+
+        pivot = clientScene_->CreateChild("", LOCAL);
+        remoteShip->Instantiate(pivot);
+        ClientRemoteShipState* remoteState = pivot->GetComponent<ClientRemoteShipState>(true);
+        remoteState->SetUser(user);
+        remoteStates_.Push(remoteState);
+    }
+
+    // Decode replays the same snapshot over and over
+    SnapshotHeaderMsg header = {0, (uint8_t)count_};
+    msg_.Clear();
+    WriteMessage(msg_, header);
+    for (ServerShipState* state : states_)
+        state->WriteState(msg_);
+    snapshot_ = msg_.GetBuffer();
+}
+
+// ----------------------------------------------------------------------------
+void ShipStateBenchmark::Run(unsigned iterations)
+{
+    if (states_.Size() == 0)
+        return;
+
+    if (direction_ == ENCODE)
+    {
+        for (unsigned i = 0; i != iterations; ++i)
+        {
+            for (ServerShipState* state : states_)
+            {
+                msg_.Clear();
+                state->WriteState(msg_);
+            }
+        }
+        return;
+    }
+
+    for (unsigned i = 0; i != iterations; ++i)
+    {
+        // Clients drop states that aren't newer than the last one they got.
+        // Advancing every time step (byte 2 of each state) by half of its
+        // range makes every replayed state newer.
+        for (unsigned ship = 0; ship != count_; ++ship)
+            snapshot_[SnapshotHeaderMsg::Layout::SIZE + ship * ServerShipStateMsg::Layout::SIZE + 2] += 127;
+
+        // Same as SnapshotScheduler
+        SnapshotScheduler::DecodeSnapshot(snapshot_.Buffer(), snapshot_.Size(), &shipStates_);
+        for (ClientRemoteShipState* remoteState : remoteStates_)
+        {
+            const ServerShipStateMsg* state = SnapshotScheduler::FindShipState(shipStates_, remoteState->GetUser()->GetGUID());
+            if (state)
+                remoteState->ApplyState(*state);
+        }
+    }
+}
+
+}
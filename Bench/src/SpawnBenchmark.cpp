@@ -0,0 +1,75 @@
+#include "Bench/SpawnBenchmark.hpp"
+#include "Asteroids/Util/Prefab.hpp"
+
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/Physics/PhysicsWorld.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/XMLFile.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+// ----------------------------------------------------------------------------
+SpawnBenchmark::SpawnBenchmark(Context* context, const String& prefabName, Method method, CreateMode mode) :
+    Benchmark(context, "spawn/" + GetFileName(prefabName) + (method == LOAD_XML ? "/LoadXML" : "/Prefab")),
+    prefabName_(prefabName),
+    method_(method),
+    mode_(mode)
+{
+}
+
+// ----------------------------------------------------------------------------
+void SpawnBenchmark::Setup()
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+
+    scene_ = new Scene(context_);
+    scene_->CreateComponent<Octree>(LOCAL);
+    scene_->CreateComponent<PhysicsWorld>(LOCAL);
+
+    // Both methods get their resource from the cache so neither of them pays
+    // for reading the file from disk during the measurement
+    if (method_ == LOAD_XML)
+        xml_ = cache->GetResource<XMLFile>(prefabName_);
+    else
+        prefab_ = cache->GetResource<Prefab>(prefabName_);
+}
+
+// ----------------------------------------------------------------------------
+void SpawnBenchmark::Reset()
+{
+    scene_->RemoveAllChildren();
+}
+
+// ----------------------------------------------------------------------------
+void SpawnBenchmark::Run(unsigned iterations)
+{
+    if (method_ == LOAD_XML)
+    {
+        if (xml_ == nullptr)
+            return;
+
+        XMLElement root = xml_->GetRoot();
+        for (unsigned i = 0; i != iterations; ++i)
+            scene_->CreateChild("", mode_)->LoadXML(root);
+    }
+    else
+    {
+        if (prefab_ == nullptr)
+            return;
+
+        for (unsigned i = 0; i != iterations; ++i)
+            prefab_->Instantiate(scene_->CreateChild("", mode_));
+    }
+}
+
+// ----------------------------------------------------------------------------
+void SpawnBenchmark::Teardown()
+{
+    scene_.Reset();
+}
+
+}
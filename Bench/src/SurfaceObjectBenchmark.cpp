@@ -0,0 +1,66 @@
+#include "Bench/SurfaceObjectBenchmark.hpp"
+#include "Asteroids/Objects/ProceduralPlanet.hpp"
+#include "Asteroids/Objects/SurfaceObject.hpp"
+
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Physics/PhysicsWorld.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+// ----------------------------------------------------------------------------
+SurfaceObjectBenchmark::SurfaceObjectBenchmark(Context* context, unsigned count) :
+    Benchmark(context, ToString("sim/surface-object-%u", count)),
+    count_(count)
+{
+}
+
+// ----------------------------------------------------------------------------
+void SurfaceObjectBenchmark::Setup()
+{
+    scene_ = new Scene(context_);
+    scene_->CreateComponent<Octree>(LOCAL);
+    scene_->CreateComponent<PhysicsWorld>(LOCAL);
+    scene_->CreateChild("Planet", LOCAL)->CreateComponent<ProceduralPlanet>(LOCAL)->Generate();
+
+    // SurfaceObject isn't registered as a factory, it's only a base class.
+    // Create it directly so no subclass's logic gets in the way.
+    SetRandomSeed(1);
+    for (unsigned i = 0; i != count_; ++i)
+    {
+        Node* pivot = scene_->CreateChild("", LOCAL);
+        pivot->SetRotation(Quaternion(Random(360.0f), Random(360.0f), Random(360.0f)));
+
+        SharedPtr<SurfaceObject> object(new SurfaceObject(context_));
+        pivot->CreateChild("", LOCAL)->AddComponent(object, 0, LOCAL);
+        object->UpdatePlanetHeight();
+
+        objects_.Push(object);
+        velocities_.Push(Vector2(Random(-60.0f, 60.0f), Random(-60.0f, 60.0f)));
+    }
+}
+
+// ----------------------------------------------------------------------------
+void SurfaceObjectBenchmark::Run(unsigned iterations)
+{
+    for (unsigned i = 0; i != iterations; ++i)
+    {
+        for (unsigned o = 0; o != objects_.Size(); ++o)
+        {
+            objects_[o]->UpdatePosition(velocities_[o], 1.0f / 60);
+            objects_[o]->UpdatePlanetHeight();
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+void SurfaceObjectBenchmark::Teardown()
+{
+    scene_.Reset();
+}
+
+}
@@ -0,0 +1,51 @@
+#include "Bench/UserRegistryBenchmark.hpp"
+#include "Asteroids/UserRegistry/UserRegistry.hpp"
+
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/IO/Log.h>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+// ----------------------------------------------------------------------------
+UserRegistryBenchmark::UserRegistryBenchmark(Context* context, Lookup lookup, unsigned count) :
+    Benchmark(context, ToString("users/lookup-%u", count) + (lookup == BY_GUID ? "/GUID" : "/Name")),
+    lookup_(lookup),
+    count_(count)
+{
+}
+
+// ----------------------------------------------------------------------------
+void UserRegistryBenchmark::Setup()
+{
+    // A registry of our own, so the benchmark doesn't depend on whatever
+    // the application registered
+    registry_ = new UserRegistry(context_);
+    for (unsigned i = 0; i != count_; ++i)
+    {
+        names_.Push(ToString("player-%u", i));
+        registry_->AddUser(names_.Back(), (User::GUID)i);
+    }
+}
+
+// ----------------------------------------------------------------------------
+void UserRegistryBenchmark::Run(unsigned iterations)
+{
+    // Spread the lookups over all users, a name lookup's cost depends on
+    // where the user is
+    unsigned found = 0;
+    for (unsigned i = 0; i != iterations; ++i)
+    {
+        unsigned index = (i * 7919) % count_;
+        if (lookup_ == BY_GUID)
+            found += registry_->GetUser((User::GUID)index) != nullptr;
+        else
+            found += registry_->FindUser(names_[index]) != nullptr;
+    }
+
+    if (found != iterations)
+        URHO3D_LOGERRORF("%s: only found %u of %u users", GetName().CString(), found, iterations);
+}
+
+}
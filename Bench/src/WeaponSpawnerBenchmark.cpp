@@ -0,0 +1,69 @@
+#include "Bench/WeaponSpawnerBenchmark.hpp"
+#include "Asteroids/Objects/ProceduralPlanet.hpp"
+#include "Asteroids/Player/WeaponSpawner.hpp"
+#include "Asteroids/Util/Prefab.hpp"
+
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Physics/PhysicsWorld.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+// ----------------------------------------------------------------------------
+WeaponSpawnerBenchmark::WeaponSpawnerBenchmark(Context* context) :
+    Benchmark(context, "weapons/spread"),
+    spawner_(nullptr),
+    numSceneChildren_(0)
+{
+}
+
+// ----------------------------------------------------------------------------
+void WeaponSpawnerBenchmark::Setup()
+{
+    Prefab* prefab = GetSubsystem<ResourceCache>()->GetResource<Prefab>("Prefabs/ServerShip.xml");
+    if (prefab == nullptr)
+        return;
+
+    scene_ = new Scene(context_);
+    scene_->CreateComponent<Octree>(LOCAL);
+    scene_->CreateComponent<PhysicsWorld>(LOCAL);
+    scene_->CreateChild("Planet", LOCAL)->CreateComponent<ProceduralPlanet>(LOCAL)->Generate();
+
+    Node* pivot = scene_->CreateChild("", LOCAL);
+    prefab->Instantiate(pivot);
+    spawner_ = pivot->GetComponent<WeaponSpawner>(true);
+
+    // Everything created after this is a phaser
+    numSceneChildren_ = scene_->GetNumChildren();
+}
+
+// ----------------------------------------------------------------------------
+void WeaponSpawnerBenchmark::Reset()
+{
+    if (scene_ == nullptr)
+        return;
+
+    while (scene_->GetNumChildren() > numSceneChildren_)
+        scene_->GetChildren().Back()->Remove();
+}
+
+// ----------------------------------------------------------------------------
+void WeaponSpawnerBenchmark::Run(unsigned iterations)
+{
+    if (spawner_ == nullptr)
+        return;
+
+    for (unsigned i = 0; i != iterations; ++i)
+        spawner_->CreateSpread();
+}
+
+// ----------------------------------------------------------------------------
+void WeaponSpawnerBenchmark::Teardown()
+{
+    scene_.Reset();
+}
+
+}
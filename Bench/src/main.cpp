@@ -0,0 +1,3 @@
+#include "Bench/BenchApplication.hpp"
+
+URHO3D_DEFINE_APPLICATION_MAIN(Asteroids::BenchApplication)
@@ -14,7 +14,7 @@ namespace Urho3D {
 
 namespace Asteroids {
 
-class Process;
+class ServerSession;
 
 class ClientApplication : public Urho3D::Application
 {
@@ -34,7 +34,10 @@ private:
     void HandleConnectPromptRequestCancel(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
     void HandleHostServerPromptRequestConnect(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
     void HandleHostServerPromptRequestCancel(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    bool IsFromServer() const;
     void HandleKeyDown(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleLocalServerReady(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleLocalServerFailed(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
     void HandleMainMenuQuit(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
     void HandlePlayerCreate(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
     void HandlePlayerDestroy(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
@@ -49,10 +52,14 @@ private:
     Urho3D::HashMap<User::GUID, Urho3D::Node*> shipNodes_;
     bool drawPhyGeometry_;
     User::GUID myGuid_;
+    Urho3D::String hostUsername_;
+    Urho3D::SharedPtr<ServerSession> hostSession_;
 
     struct Args
     {
         Urho3D::String username_;
+        bool hostInSeparateProcess_;
+        bool sharedMemory_;
     } args_;
 };
 
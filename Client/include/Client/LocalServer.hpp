@@ -1,12 +1,29 @@
 #pragma once
 
 #include "Asteroids/Config.hpp"
+#include "Asteroids/Util/LineReader.hpp"
 #include <Urho3D/Core/Object.h>
+#include <Urho3D/Core/Timer.h>
 
 namespace Asteroids {
 
 class Process;
 
+/*!
+ * @brief Runs asteroids-server as a child process so the player can host a
+ * game from the client.
+ *
+ * The server's stdout and stderr are captured and drained once per frame
+ * without blocking. Every line the server prints is forwarded to the client's
+ * log (and therefore DebugTextScroll) prefixed with "[server]".
+ *
+ * The server is also handed a notify pipe (see Process::NOTIFY) which it
+ * writes "ready <port>" to once it is listening. LocalServer sends
+ * E_LOCALSERVERREADY when that line arrives, or E_LOCALSERVERFAILED if the
+ * server exits or doesn't report back within the ready timeout. Connect to
+ * the server in response to E_LOCALSERVERREADY rather than right after
+ * Start(), otherwise the connection attempt races with server startup.
+ */
 class LocalServer : public Urho3D::Object
 {
     URHO3D_OBJECT(LocalServer, Urho3D::Object)
@@ -14,13 +31,50 @@ class LocalServer : public Urho3D::Object
 public:
     LocalServer(Urho3D::Context* context);
 
+    /*!
+     * @brief Launches the server.
+     * @param[in] port The port to listen on. Pass 0 to let the server pick
+     * a free port, which is then reported through E_LOCALSERVERREADY.
+     * @return False if the process could not be started.
+     */
     bool Start(int port);
     void Stop();
     void ForceStop();
     bool IsRunning() const;
 
+    /// Returns true once the server has reported that it is listening.
+    bool IsReady() const;
+
+    /// Returns the port the server is listening on, or 0 if it isn't ready yet.
+    int GetPort() const;
+
+    /// How long to wait for the server to become ready before giving up.
+    void SetReadyTimeout(unsigned timeoutMs);
+
 private:
+    void DrainOutput();
+    void FlushOutput();
+    void CheckReady();
+    void SendReady(int port);
+    void SendFailed(const Urho3D::String& reason);
+    void HandleUpdate(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+
+private:
+    enum State
+    {
+        STOPPED,
+        STARTING,
+        READY
+    };
+
     Urho3D::UniquePtr<Process> serverProcess_;
+    LineReader stdoutReader_;
+    LineReader stderrReader_;
+    LineReader notifyReader_;
+    Urho3D::Timer startTimer_;
+    unsigned readyTimeout_;
+    State state_;
+    int port_;
 };
 
 }
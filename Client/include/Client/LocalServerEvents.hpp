@@ -0,0 +1,20 @@
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+
+namespace Asteroids {
+
+// Gets sent when the local server reports that it is accepting connections
+URHO3D_EVENT(E_LOCALSERVERREADY, LocalServerReady)
+{
+    URHO3D_PARAM(P_PORT, Port);            // int
+}
+
+// Gets sent when the local server exits, fails to start or doesn't report
+// back in time. The server process is stopped.
+URHO3D_EVENT(E_LOCALSERVERFAILED, LocalServerFailed)
+{
+    URHO3D_PARAM(P_REASON, Reason);        // String
+}
+
+}
@@ -1,18 +1,31 @@
 #include "Client/ClientApplication.hpp"
 #include "Client/LocalServer.hpp"
+#include "Client/LocalServerEvents.hpp"
 #include "Asteroids/AsteroidsLib.hpp"
 #include "Asteroids/Menu/Menu.hpp"
 #include "Asteroids/Menu/MenuEvents.hpp"
+#include "Asteroids/Objects/AsteroidField.hpp"
+#include "Asteroids/Objects/HitDetector.hpp"
+#include "Asteroids/Objects/PhaserReplicator.hpp"
+#include "Asteroids/Objects/ProjectileRenderer.hpp"
+#include "Asteroids/Network/MessageRouter.hpp"
+#include "Asteroids/Network/NetworkClock.hpp"
+#include "Asteroids/Network/SnapshotScheduler.hpp"
 #include "Asteroids/Player/PlayerEvents.hpp"
 #include "Asteroids/Player/DeviceInputMapper.hpp"
 #include "Asteroids/Player/OrbitingCameraController.hpp"
 #include "Asteroids/Player/ClientLocalShipState.hpp"
 #include "Asteroids/Player/ClientRemoteShipState.hpp"
 #include "Asteroids/Player/ShipController.hpp"
+#include "Asteroids/Server/ServerSession.hpp"
 #include "Asteroids/UserRegistry/UserRegistry.hpp"
 #include "Asteroids/UserRegistry/UserRegistryEvents.hpp"
 #include "Asteroids/UserRegistry/ClientUserRegistry.hpp"
+#include "Asteroids/Util/AsyncLog.hpp"
 #include "Asteroids/Util/DebugTextScroll.hpp"
+#include "Asteroids/Util/Prefab.hpp"
+#include "Asteroids/Util/TimerWheel.hpp"
+#include "Asteroids/Util/UpdateRegistry.hpp"
 
 #include <Urho3D/Core/CoreEvents.h>
 #include <Urho3D/Engine/DebugHud.h>
@@ -20,6 +33,7 @@
 #include <Urho3D/Graphics/Camera.h>
 #include <Urho3D/Graphics/DebugRenderer.h>
 #include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/Material.h>
 #include <Urho3D/Graphics/Model.h>
 #include <Urho3D/Graphics/Octree.h>
 #include <Urho3D/Graphics/Renderer.h>
@@ -29,6 +43,7 @@
 #include <Urho3D/Input/Input.h>
 #include <Urho3D/Input/InputEvents.h>
 #include <Urho3D/IO/Log.h>
+#include <Urho3D/Network/Connection.h>
 #include <Urho3D/Network/Network.h>
 #include <Urho3D/Network/NetworkEvents.h>
 #include <Urho3D/Physics/CollisionShape.h>
@@ -49,6 +64,8 @@ ClientApplication::ClientApplication(Context* context) :
     Application(context),
     drawPhyGeometry_(false)
 {
+    args_.hostInSeparateProcess_ = false;
+    args_.sharedMemory_ = false;
 }
 
 // ----------------------------------------------------------------------------
@@ -56,7 +73,11 @@ void ClientApplication::Setup()
 {
     ParseArgs();
 
-    engineParameters_[EP_LOG_NAME]         = "asteroids-client.log";
+    // Urho's log writes synchronously on the calling thread. Disable its
+    // output and let AsyncLog do the I/O on a background thread instead.
+    context_->RegisterSubsystem<AsyncLog>()->Open("asteroids-client.log");
+    engineParameters_[EP_LOG_NAME]         = "";
+    engineParameters_[EP_LOG_QUIET]        = true;
     engineParameters_[EP_FULL_SCREEN]      = false;
     engineParameters_[EP_WINDOW_RESIZABLE] = true;
     engineParameters_[EP_VSYNC]            = true;
@@ -73,6 +94,12 @@ void ClientApplication::Start()
     context_->RegisterSubsystem<Menu>();
     context_->RegisterSubsystem<UserRegistry>();
     context_->RegisterSubsystem<LocalServer>();
+    context_->RegisterSubsystem<TimerWheel>();
+    context_->RegisterSubsystem<UpdateRegistry>();
+    context_->RegisterSubsystem<MessageRouter>();
+    GetSubsystem<MessageRouter>()->SetSharedMemoryEnabled(args_.sharedMemory_);
+    context_->RegisterSubsystem<NetworkClock>();
+    context_->RegisterSubsystem<SnapshotScheduler>();
 
 #if defined(DEBUG)
     context_->RegisterSubsystem<DebugTextScroll>();
@@ -100,6 +127,22 @@ void ClientApplication::Start()
     scene_->CreateComponent<Octree>(LOCAL);
     scene_->CreateComponent<PhysicsWorld>(LOCAL);
 
+    // Projectiles don't have a model of their own, all projectiles of a type
+    // are drawn in one instanced batch
+    ProjectileRenderer* phaserRenderer = scene_->CreateComponent<ProjectileRenderer>(LOCAL);
+    phaserRenderer->SetProjectileType(ProjectileRenderer::PHASER);
+    phaserRenderer->SetModel(cache->GetResource<Model>("Models/PHPhaser.mdl"));
+    phaserRenderer->SetMaterial(cache->GetResource<Material>("Materials/Phaser.xml"));
+    ProjectileRenderer* mineRenderer = scene_->CreateComponent<ProjectileRenderer>(LOCAL);
+    mineRenderer->SetProjectileType(ProjectileRenderer::MINE);
+    mineRenderer->SetModel(cache->GetResource<Model>("Models/PHMine.mdl"));
+    mineRenderer->SetMaterial(cache->GetResource<Material>("Materials/Mine.xml"));
+    AsteroidField* asteroids = scene_->CreateComponent<AsteroidField>(LOCAL);
+    asteroids->SetModel(cache->GetResource<Model>("Models/Icosphere.mdl"));
+    asteroids->SetMaterial(cache->GetResource<Material>("Materials/Asteroid.xml"));
+    scene_->CreateComponent<HitDetector>(LOCAL);
+    scene_->CreateComponent<PhaserReplicator>(LOCAL);
+
 #if defined(DEBUG)
     scene_->CreateComponent<DebugRenderer>();
 #endif
@@ -130,6 +173,8 @@ void ClientApplication::Start()
 void ClientApplication::Stop()
 {
     GetSubsystem<Network>()->Disconnect();
+    if (hostSession_)
+        hostSession_->Stop();
 }
 
 // ----------------------------------------------------------------------------
@@ -151,7 +196,9 @@ void ClientApplication::ParseArgs()
             } break;
 
             case EXPECT_NONE : {
-                if (arg == "--username") expected = EXPECT_NAME;
+                if      (arg == "--username")     expected = EXPECT_NAME;
+                else if (arg == "--host-process") args_.hostInSeparateProcess_ = true;
+                else if (arg == "--shm")          args_.sharedMemory_ = true;
                 else
                 {
                     ErrorExit("Unknown option " + arg);
@@ -176,6 +223,15 @@ void ClientApplication::CreateDebugHud()
         debugHud_->SetDefaultStyle(style);
 }
 
+// ----------------------------------------------------------------------------
+bool ClientApplication::IsFromServer() const
+{
+    // When hosting a game, the server session lives in this process and
+    // sends some of the same events locally. Only the ones arriving through
+    // the server connection are meant for us.
+    return GetEventSender() == GetSubsystem<Network>()->GetServerConnection();
+}
+
 // ----------------------------------------------------------------------------
 void ClientApplication::SubscribeToEvents()
 {
@@ -186,6 +242,8 @@ void ClientApplication::SubscribeToEvents()
     SubscribeToEvent(E_CONNECTPROMPTREQUESTCANCEL, URHO3D_HANDLER(ClientApplication, HandleConnectPromptRequestCancel));
     SubscribeToEvent(E_HOSTSERVERPROMPTREQUESTCONNECT, URHO3D_HANDLER(ClientApplication, HandleHostServerPromptRequestConnect));
     SubscribeToEvent(E_HOSTSERVERPROMPTREQUESTCANCEL, URHO3D_HANDLER(ClientApplication, HandleHostServerPromptRequestCancel));
+    SubscribeToEvent(E_LOCALSERVERREADY, URHO3D_HANDLER(ClientApplication, HandleLocalServerReady));
+    SubscribeToEvent(E_LOCALSERVERFAILED, URHO3D_HANDLER(ClientApplication, HandleLocalServerFailed));
     SubscribeToEvent(E_PLAYERCREATE, URHO3D_HANDLER(ClientApplication, HandlePlayerCreate));
     SubscribeToEvent(E_PLAYERDESTROY, URHO3D_HANDLER(ClientApplication, HandlePlayerDestroy));
     SubscribeToEvent(E_REGISTERSUCCEEDED, URHO3D_HANDLER(ClientApplication, HandleRegisterSucceeded));
@@ -258,8 +316,27 @@ void ClientApplication::HandleHostServerPromptRequestConnect(StringHash eventTyp
 {
     using namespace HostServerPromptRequestConnect;
 
-    if (GetSubsystem<LocalServer>()->Start(eventData[P_PORT].GetInt()) == false)
+    if (args_.hostInSeparateProcess_)
+    {
+        if (GetSubsystem<LocalServer>()->Start(eventData[P_PORT].GetInt()) == false)
+        {
+            eventData[P_SUCCESS] = false;
+            return;
+        }
+
+        // Connecting right away would race with the server starting up. Wait
+        // for LocalServer to tell us it's listening.
+        hostUsername_ = eventData[P_USERNAME].GetString();
+        return;
+    }
+
+    // Run the server in this process. It shares our resource cache, so the
+    // only thing left to load is the server scene, and it is listening as
+    // soon as Start() returns.
+    hostSession_ = new ServerSession(context_);
+    if (hostSession_->Start(eventData[P_PORT].GetInt()) == false)
     {
+        hostSession_.Reset();
         eventData[P_SUCCESS] = false;
         return;
     }
@@ -267,7 +344,7 @@ void ClientApplication::HandleHostServerPromptRequestConnect(StringHash eventTyp
     GetSubsystem<ClientUserRegistry>()->TryRegister(
         eventData[P_USERNAME].GetString(),
         "127.0.0.1",
-        eventData[P_PORT].GetInt(),
+        hostSession_->GetPort(),
         scene_
     );
 }
@@ -276,7 +353,38 @@ void ClientApplication::HandleHostServerPromptRequestConnect(StringHash eventTyp
 void ClientApplication::HandleHostServerPromptRequestCancel(StringHash eventType, VariantMap& eventData)
 {
     GetSubsystem<Network>()->Disconnect();
-    GetSubsystem<LocalServer>()->Stop();
+    if (hostSession_)
+    {
+        hostSession_->Stop();
+        hostSession_.Reset();
+    }
+    else
+    {
+        GetSubsystem<LocalServer>()->Stop();
+    }
+}
+
+// ----------------------------------------------------------------------------
+void ClientApplication::HandleLocalServerReady(StringHash eventType, VariantMap& eventData)
+{
+    using namespace LocalServerReady;
+
+    GetSubsystem<ClientUserRegistry>()->TryRegister(
+        hostUsername_,
+        "127.0.0.1",
+        eventData[P_PORT].GetInt(),
+        scene_
+    );
+}
+
+// ----------------------------------------------------------------------------
+void ClientApplication::HandleLocalServerFailed(StringHash eventType, VariantMap& eventData)
+{
+    // The host server prompt listens for registration failures, so report
+    // it the same way a failed connection would be
+    VariantMap& data = GetEventDataMap();
+    data[RegisterFailed::P_REASON] = eventData[LocalServerFailed::P_REASON].GetString();
+    SendEvent(E_REGISTERFAILED, data);
 }
 
 // ----------------------------------------------------------------------------
@@ -284,6 +392,9 @@ void ClientApplication::HandlePlayerCreate(StringHash eventType, VariantMap& eve
 {
     using namespace PlayerCreate;
 
+    if (IsFromServer() == false)
+        return;
+
     // Get associated User for this player
     User::GUID guid = eventData[P_GUID].GetUInt();
     assert(shipNodes_.Find(guid) == shipNodes_.End());
@@ -292,10 +403,10 @@ void ClientApplication::HandlePlayerCreate(StringHash eventType, VariantMap& eve
     // Load either the "remote" ship, if this user is someone on another
     // machine, or the "local" ship if this user is us
     ResourceCache* cache = GetSubsystem<ResourceCache>();
-    XMLFile* shipfab = cache->GetResource<XMLFile>(
+    Prefab* shipfab = cache->GetResource<Prefab>(
         guid == myGuid_ ? "Prefabs/ClientLocalShip.xml" : "Prefabs/ClientRemoteShip.xml");
     Node* node = scene_->CreateChild("", LOCAL);
-    node->LoadXML(shipfab->GetRoot());
+    shipfab->Instantiate(node);
     node->SetRotation(eventData[P_PIVOTROTATION].GetQuaternion());
 
     shipNodes_[guid] = node;
@@ -316,6 +427,9 @@ void ClientApplication::HandlePlayerDestroy(StringHash eventType, VariantMap& ev
 {
     using namespace PlayerDestroy;
 
+    if (IsFromServer() == false)
+        return;
+
     User::GUID guid = eventData[P_GUID].GetUInt();
 
     assert(shipNodes_.Find(guid) != shipNodes_.End());
@@ -1,7 +1,13 @@
 #include "Client/LocalServer.hpp"
+#include "Client/LocalServerEvents.hpp"
+#include "Asteroids/Network/MessageRouter.hpp"
 #include "Asteroids/Util/Process.hpp"
+#include "Asteroids/Util/UnidirectionalPipe.hpp"
 
 #include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/IO/Log.h>
 
 using namespace Urho3D;
 
@@ -10,7 +16,10 @@ namespace Asteroids {
 // ----------------------------------------------------------------------------
 LocalServer::LocalServer(Context* context) :
     Object(context),
-    serverProcess_(new Process)
+    serverProcess_(new Process),
+    readyTimeout_(10000),
+    state_(STOPPED),
+    port_(0)
 {
 }
 
@@ -29,25 +38,204 @@ bool LocalServer::Start(int port)
 #endif
     args.Push("--port");
     args.Push(String(port));
-    return serverProcess_->Open(args);
+    MessageRouter* router = GetSubsystem<MessageRouter>();
+    if (router && router->IsSharedMemoryEnabled())
+        args.Push("--shm");
+#if !defined(_WIN32)
+    args.Push("--ready-fd");
+    args.Push(String(Process::NOTIFY_FD));
+#endif
+    if (serverProcess_->Open(args, Process::IO(Process::STDOUT | Process::STDERR | Process::NOTIFY)) == false)
+        return false;
+
+    notifyReader_ = LineReader();
+    startTimer_.Reset();
+    state_ = STARTING;
+    port_ = port;
+
+    SubscribeToEvent(E_UPDATE, URHO3D_HANDLER(LocalServer, HandleUpdate));
+    return true;
 }
 
 // ----------------------------------------------------------------------------
 void LocalServer::Stop()
 {
+    DrainOutput();
     serverProcess_->Close();
+    FlushOutput();
+    UnsubscribeFromEvent(E_UPDATE);
+    state_ = STOPPED;
 }
 
 // ----------------------------------------------------------------------------
 void LocalServer::ForceStop()
 {
     serverProcess_->Terminate();
+    FlushOutput();
+    UnsubscribeFromEvent(E_UPDATE);
+    state_ = STOPPED;
 }
 
 // ----------------------------------------------------------------------------
 bool LocalServer::IsRunning() const
 {
-    return false;
+    return serverProcess_->IsRunning();
+}
+
+// ----------------------------------------------------------------------------
+bool LocalServer::IsReady() const
+{
+    return state_ == READY;
+}
+
+// ----------------------------------------------------------------------------
+int LocalServer::GetPort() const
+{
+    return state_ == READY ? port_ : 0;
+}
+
+// ----------------------------------------------------------------------------
+void LocalServer::SetReadyTimeout(unsigned timeoutMs)
+{
+    readyTimeout_ = timeoutMs;
+}
+
+// ----------------------------------------------------------------------------
+void LocalServer::DrainOutput()
+{
+    unsigned ready = serverProcess_->Poll(0);
+    String line;
+
+    if (ready & Process::STDOUT)
+    {
+        stdoutReader_.Drain(*serverProcess_->GetStdOut());
+        while (stdoutReader_.ReadLine(&line))
+            URHO3D_LOGINFOF("[server] %s", line.CString());
+    }
+
+    if (ready & Process::STDERR)
+    {
+        stderrReader_.Drain(*serverProcess_->GetStdErr());
+        while (stderrReader_.ReadLine(&line))
+            URHO3D_LOGERRORF("[server] %s", line.CString());
+    }
+}
+
+// ----------------------------------------------------------------------------
+void LocalServer::FlushOutput()
+{
+    String line;
+    while (stdoutReader_.Flush(&line))
+        URHO3D_LOGINFOF("[server] %s", line.CString());
+    while (stderrReader_.Flush(&line))
+        URHO3D_LOGERRORF("[server] %s", line.CString());
+}
+
+// ----------------------------------------------------------------------------
+void LocalServer::CheckReady()
+{
+    UnidirectionalPipe* notify = serverProcess_->GetNotify();
+
+    // No notify pipe on this platform. The best we can do is assume the
+    // server is ready and let the client retry connecting.
+    if (notify == nullptr)
+    {
+        SendReady(port_);
+        return;
+    }
+
+    if (serverProcess_->Poll(0) & Process::NOTIFY)
+        notifyReader_.Drain(*notify);
+
+    String line;
+    if (notifyReader_.ReadLine(&line) || (notify->IsEof() && notifyReader_.Flush(&line)))
+    {
+        if (line.StartsWith("ready "))
+        {
+            SendReady(ToInt(line.Substring(6)));
+            return;
+        }
+
+        if (line.StartsWith("failed"))
+        {
+            ForceStop();
+            SendFailed(line.Substring(6).Trimmed());
+            return;
+        }
+
+        URHO3D_LOGWARNINGF("Unexpected readiness notification from local server: %s", line.CString());
+    }
+
+    if (notify->IsEof())
+    {
+        // Let the exit code handling in HandleUpdate() report this if the
+        // server is exiting anyway
+        if (serverProcess_->IsRunning() == false)
+            return;
+
+        ForceStop();
+        SendFailed("Server closed the notify pipe without becoming ready");
+        return;
+    }
+
+    if (startTimer_.GetMSec(false) > readyTimeout_)
+    {
+        ForceStop();
+        SendFailed("Timed out waiting for the server to start");
+    }
+}
+
+// ----------------------------------------------------------------------------
+void LocalServer::SendReady(int port)
+{
+    using namespace LocalServerReady;
+
+    state_ = READY;
+    port_ = port;
+    URHO3D_LOGINFOF("Local server is listening on port %d", port);
+
+    VariantMap& eventData = GetEventDataMap();
+    eventData[P_PORT] = port;
+    SendEvent(E_LOCALSERVERREADY, eventData);
+}
+
+// ----------------------------------------------------------------------------
+void LocalServer::SendFailed(const String& reason)
+{
+    using namespace LocalServerFailed;
+
+    URHO3D_LOGERRORF("Failed to start local server: %s", reason.CString());
+
+    VariantMap& eventData = GetEventDataMap();
+    eventData[P_REASON] = reason;
+    SendEvent(E_LOCALSERVERFAILED, eventData);
+}
+
+// ----------------------------------------------------------------------------
+void LocalServer::HandleUpdate(StringHash eventType, VariantMap& eventData)
+{
+    DrainOutput();
+
+    if (state_ == STARTING)
+        CheckReady();
+    if (state_ == STOPPED || serverProcess_->IsRunning())
+        return;
+
+    // Server exited on its own. Pick up anything it printed before exiting.
+    DrainOutput();
+    FlushOutput();
+    UnsubscribeFromEvent(E_UPDATE);
+
+    bool wasStarting = (state_ == STARTING);
+    state_ = STOPPED;
+
+    if (serverProcess_->GetExitCode() == 0)
+        URHO3D_LOGINFO("Local server exited");
+    else
+        URHO3D_LOGERRORF("Local server exited with code %d", serverProcess_->GetExitCode());
+
+    if (wasStarting)
+        SendFailed(ToString("Server exited with code %d", serverProcess_->GetExitCode()));
 }
 
 }
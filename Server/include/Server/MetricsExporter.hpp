@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/Core/Thread.h>
+
+namespace Asteroids {
+
+class Metrics;
+
+/*!
+ * @brief Periodically writes the Metrics subsystem in Prometheus text format
+ * from a background thread, so the tick never waits on I/O.
+ *
+ * The target is one of:
+ *   - "stdout"          Printed every interval.
+ *   - "file:<path>"     Rewritten every interval. The file is replaced
+ *                       atomically so readers never see a partial snapshot.
+ *   - "unix:<path>"     A Unix domain socket. Every connecting client is
+ *                       sent the current metrics and disconnected.
+ */
+class MetricsExporter : public Urho3D::Object, public Urho3D::Thread
+{
+    URHO3D_OBJECT(MetricsExporter, Urho3D::Object);
+
+public:
+    MetricsExporter(Urho3D::Context* context);
+    ~MetricsExporter();
+
+    bool Open(const Urho3D::String& target, float intervalSeconds);
+    void Close();
+
+    void ThreadFunction() override;
+
+private:
+    enum Target
+    {
+        TARGET_NONE,
+        TARGET_STDOUT,
+        TARGET_FILE,
+        TARGET_SOCKET
+    };
+
+    void Export();
+    void ServeSocket();
+
+private:
+    Urho3D::SharedPtr<Metrics> metrics_;
+    Urho3D::String text_;
+    Urho3D::String path_;
+    Target target_;
+    int socket_;
+    unsigned intervalMs_;
+};
+
+}
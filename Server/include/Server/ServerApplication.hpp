@@ -1,17 +1,12 @@
 #pragma once
 
+#include <Urho3D/Core/Timer.h>
 #include <Urho3D/Engine/Application.h>
-#include "Asteroids/UserRegistry/User.hpp"
-
-namespace Urho3D {
-    class DebugHud;
-    class Scene;
-    class Node;
-    class XMLFile;
-}
 
 namespace Asteroids {
 
+class ServerSession;
+
 class ServerApplication : public Urho3D::Application
 {
 public:
@@ -23,22 +18,24 @@ public:
 
 private:
     void ParseArgs();
-    void SubscribeToEvents();
-    void LoadScene();
-    void HandleUserJoined(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
-    void HandleUserLeft(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
-    void HandlePlayerCreate(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
-    void HandlePlayerDestroy(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
-    void HandleFileChanged(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void NotifyReady(const Urho3D::String& message);
+    void HandleBeginFrame(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandlePostRenderUpdate(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleEndFrame(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
 
 private:
     struct {
         int port_;
+        int assertNoAllocAfterFrames_;  // -1 = disabled
+        int readyFd_;                   // -1 = disabled
+        bool sharedMemory_;             // Offer shared memory transport to local clients
+        Urho3D::String metricsTarget_;  // Empty = disabled
+        float metricsInterval_;         // Seconds between exports
     } args_;
-    Urho3D::SharedPtr<Urho3D::Scene> scene_;
-    Urho3D::SharedPtr<Urho3D::XMLFile> planetXML_;
-    Urho3D::Node* planet_;
-    Urho3D::HashMap<User::GUID, Urho3D::Node*> shipNodes_;
+    Urho3D::SharedPtr<ServerSession> session_;
+    Urho3D::HiresTimer tickTimer_;
+    unsigned long long lastAllocationCount_;
+    unsigned frameNumber_;
 };
 
 }
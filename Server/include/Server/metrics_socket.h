@@ -0,0 +1,35 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * @brief Creates a non-blocking Unix domain stream socket listening on the
+ * specified path. A stale socket file left behind by a previous run is
+ * removed first.
+ * @return The socket, or -1 on failure.
+ */
+int metrics_socket_listen(const char* path);
+
+/*!
+ * @brief Accepts a pending connection without blocking.
+ * @return The client socket, or -1 if nobody is waiting.
+ */
+int metrics_socket_accept(int fd);
+
+/*!
+ * @brief Writes the data to a client returned by metrics_socket_accept()
+ * and closes the connection.
+ * @return 0 on success, -1 on failure.
+ */
+int metrics_socket_send(int client, const char* data, int len);
+
+/*!
+ * @brief Closes the listening socket and removes the socket file.
+ */
+void metrics_socket_close(int fd, const char* path);
+
+#ifdef __cplusplus
+}
+#endif
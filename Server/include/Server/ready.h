@@ -0,0 +1,29 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Returned by ready_notify() on platforms where it isn't implemented.
+#define READY_NOT_SUPPORTED -2
+
+/*!
+ * @brief Asks the OS for a UDP port that is currently free by binding a
+ * temporary socket to port 0.
+ * @note The socket is closed again before returning, so another process can
+ * take the port before we listen on it. Be prepared to try again.
+ * @return The port number, or -1 on failure.
+ */
+int ready_find_free_udp_port(void);
+
+/*!
+ * @brief Writes the message to the file descriptor passed to us by the
+ * parent process and closes it.
+ * @return 0 on success, -1 on failure, READY_NOT_SUPPORTED if the platform
+ * has no implementation.
+ */
+int ready_notify(int fd, const char* message);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,154 @@
+#include "Server/MetricsExporter.hpp"
+#include "Server/metrics_socket.h"
+#include "Asteroids/Util/Metrics.hpp"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/IO/Log.h>
+
+#include <stdio.h>
+
+using namespace Urho3D;
+
+namespace Asteroids {
+
+// ----------------------------------------------------------------------------
+MetricsExporter::MetricsExporter(Context* context) :
+    Object(context),
+    target_(TARGET_NONE),
+    socket_(-1),
+    intervalMs_(10000)
+{
+}
+
+// ----------------------------------------------------------------------------
+MetricsExporter::~MetricsExporter()
+{
+    Close();
+}
+
+// ----------------------------------------------------------------------------
+bool MetricsExporter::Open(const String& target, float intervalSeconds)
+{
+    Close();
+
+    // Context isn't thread safe, so look up the subsystem here instead of
+    // from the export thread
+    metrics_ = GetSubsystem<Metrics>();
+    if (metrics_ == nullptr)
+    {
+        URHO3D_LOGERROR("Can't export metrics, Metrics subsystem doesn't exist");
+        return false;
+    }
+
+    intervalMs_ = (unsigned)(Max(intervalSeconds, 0.1f) * 1000);
+
+    if (target == "stdout")
+    {
+        target_ = TARGET_STDOUT;
+    }
+    else if (target.StartsWith("file:"))
+    {
+        target_ = TARGET_FILE;
+        path_ = target.Substring(5);
+    }
+    else if (target.StartsWith("unix:"))
+    {
+        path_ = target.Substring(5);
+        socket_ = metrics_socket_listen(path_.CString());
+        if (socket_ < 0)
+        {
+            URHO3D_LOGERRORF("Failed to listen on Unix socket \"%s\"", path_.CString());
+            return false;
+        }
+        target_ = TARGET_SOCKET;
+    }
+    else
+    {
+        URHO3D_LOGERRORF("Unknown metrics target \"%s\", expected stdout, file:<path> or unix:<path>", target.CString());
+        return false;
+    }
+
+    URHO3D_LOGINFOF("Exporting metrics to %s", target.CString());
+    return Run();
+}
+
+// ----------------------------------------------------------------------------
+void MetricsExporter::Close()
+{
+    if (IsStarted())
+        Stop();
+
+    if (socket_ >= 0)
+    {
+        metrics_socket_close(socket_, path_.CString());
+        socket_ = -1;
+    }
+
+    target_ = TARGET_NONE;
+}
+
+// ----------------------------------------------------------------------------
+void MetricsExporter::ThreadFunction()
+{
+    unsigned nextExport = Time::GetSystemTime();
+    while (shouldRun_)
+    {
+        if (target_ == TARGET_SOCKET)
+        {
+            ServeSocket();
+        }
+        else if ((int)(Time::GetSystemTime() - nextExport) >= 0)
+        {
+            Export();
+            nextExport += intervalMs_;
+        }
+
+        Time::Sleep(50);
+    }
+}
+
+// ----------------------------------------------------------------------------
+void MetricsExporter::Export()
+{
+    text_.Clear();
+    metrics_->WritePrometheus(text_);
+
+    if (target_ == TARGET_STDOUT)
+    {
+        fwrite(text_.CString(), 1, text_.Length(), stdout);
+        fflush(stdout);
+    }
+    else if (target_ == TARGET_FILE)
+    {
+        // Write to a temporary file and rename it so whoever reads the file
+        // never sees it half written
+        String tempPath = path_ + ".tmp";
+        FILE* fp = fopen(tempPath.CString(), "wb");
+        if (fp == nullptr)
+            return;
+        bool success = fwrite(text_.CString(), 1, text_.Length(), fp) == text_.Length();
+        success = (fclose(fp) == 0) && success;
+        if (success)
+        {
+#if defined(_WIN32)
+            remove(path_.CString());  // rename() doesn't replace existing files
+#endif
+            rename(tempPath.CString(), path_.CString());
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+void MetricsExporter::ServeSocket()
+{
+    int client;
+    while ((client = metrics_socket_accept(socket_)) >= 0)
+    {
+        text_.Clear();
+        metrics_->WritePrometheus(text_);
+        metrics_socket_send(client, text_.CString(), (int)text_.Length());
+    }
+}
+
+}
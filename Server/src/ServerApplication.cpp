@@ -1,34 +1,41 @@
 #include "Server/ServerApplication.hpp"
+#include "Server/MetricsExporter.hpp"
 #include "Server/SignalHandler.hpp"
+#include "Server/ready.h"
 #include "Asteroids/Globals.hpp"
 #include "Asteroids/AsteroidsLib.hpp"
-#include "Asteroids/Player/PlayerEvents.hpp"
-#include "Asteroids/Player/ServerShipState.hpp"
-#include "Asteroids/Util/DebugTextScroll.hpp"
-#include "Asteroids/UserRegistry/ServerUserRegistry.hpp"
-#include "Asteroids/UserRegistry/UserRegistry.hpp"
-#include "Asteroids/UserRegistry/UserRegistryEvents.hpp"
+#include "Asteroids/Network/MessageRouter.hpp"
+#include "Asteroids/Network/NetworkClock.hpp"
+#include "Asteroids/Network/SnapshotScheduler.hpp"
+#include "Asteroids/Server/ServerSession.hpp"
+#include "Asteroids/Util/AllocationCounter.hpp"
+#include "Asteroids/Util/AsyncLog.hpp"
+#include "Asteroids/Util/Metrics.hpp"
+#include "Asteroids/Util/TimerWheel.hpp"
+#include "Asteroids/Util/UpdateRegistry.hpp"
 
 #include <Urho3D/Core/CoreEvents.h>
 #include <Urho3D/Engine/EngineDefs.h>
-#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/IO/Log.h>
 #include <Urho3D/Network/Network.h>
-#include <Urho3D/Network/NetworkEvents.h>
-#include <Urho3D/Physics/PhysicsWorld.h>
 #include <Urho3D/Resource/ResourceCache.h>
-#include <Urho3D/Resource/ResourceEvents.h>
-#include <Urho3D/Resource/XMLFile.h>
-#include <Urho3D/Scene/Scene.h>
 #include <Urho3D/Core/StringUtils.h>
 
+#include <stdio.h>
+
 using namespace Urho3D;
 
 namespace Asteroids {
 
+/// How often to try listening on a free port before giving up.
+static const int MAX_PORT_ATTEMPTS = 5;
+
 // ----------------------------------------------------------------------------
 ServerApplication::ServerApplication(Context* context) :
     Application(context),
-    args_({DEFAULT_PORT})
+    args_({DEFAULT_PORT, -1, -1, false, String(), 10.0f}),
+    lastAllocationCount_(0),
+    frameNumber_(0)
 {
 }
 
@@ -37,7 +44,16 @@ void ServerApplication::Setup()
 {
     ParseArgs();
 
-    engineParameters_[EP_LOG_NAME] = "asteroids-server.log";
+    // When the client hosts a game, our output goes through a pipe, which
+    // would otherwise be fully buffered and only arrive in chunks of several
+    // kilobytes
+    setvbuf(stdout, nullptr, _IOLBF, BUFSIZ);
+
+    // Urho's log writes synchronously on the calling thread. Disable its
+    // output and let AsyncLog do the I/O on a background thread instead.
+    context_->RegisterSubsystem<AsyncLog>()->Open("asteroids-server.log");
+    engineParameters_[EP_LOG_NAME] = "";
+    engineParameters_[EP_LOG_QUIET] = true;
     engineParameters_[EP_HEADLESS] = true;
 }
 
@@ -48,8 +64,12 @@ void ServerApplication::Start()
     RegisterRemoteNetworkEvents(context_);
 
     context_->RegisterSubsystem<SignalHandler>();
-    context_->RegisterSubsystem<UserRegistry>();
-    context_->RegisterSubsystem<ServerUserRegistry>();
+    context_->RegisterSubsystem<TimerWheel>();
+    context_->RegisterSubsystem<UpdateRegistry>();
+    context_->RegisterSubsystem<MessageRouter>();
+    GetSubsystem<MessageRouter>()->SetSharedMemoryEnabled(args_.sharedMemory_);
+    context_->RegisterSubsystem<NetworkClock>();
+    context_->RegisterSubsystem<SnapshotScheduler>();
 
 #if defined(DEBUG)
     GetSubsystem<Log>()->SetLevel(LOG_DEBUG);
@@ -60,23 +80,87 @@ void ServerApplication::Start()
     ResourceCache* cache = GetSubsystem<ResourceCache>();
     cache->SetAutoReloadResources(true);
 
-    SubscribeToEvents();
-    LoadScene();
+    // Used to verify that a running server doesn't touch the heap once it
+    // has warmed up. Each frame is measured from the end of the previous
+    // frame so it includes the network update at the start of the frame.
+    if (args_.assertNoAllocAfterFrames_ >= 0 && IsAllocationCounterEnabled() == false)
+    {
+        ErrorExit("--assert-no-alloc requires a build configured with -DASTEROIDS_ALLOCATION_COUNTER=ON");
+        return;
+    }
+
+    // Metrics are collected on the main thread and exported from a
+    // background thread
+    if (args_.metricsTarget_.Empty() == false)
+    {
+        context_->RegisterSubsystem<Metrics>();
+        context_->RegisterSubsystem<MetricsExporter>();
+        if (GetSubsystem<MetricsExporter>()->Open(args_.metricsTarget_, args_.metricsInterval_) == false)
+        {
+            ErrorExit("Failed to start exporting metrics to " + args_.metricsTarget_);
+            return;
+        }
+        // E_POSTRENDERUPDATE is the last event before the engine sleeps to
+        // limit the frame rate, and comes after the network update
+        SubscribeToEvent(E_BEGINFRAME, URHO3D_HANDLER(ServerApplication, HandleBeginFrame));
+        SubscribeToEvent(E_POSTRENDERUPDATE, URHO3D_HANDLER(ServerApplication, HandlePostRenderUpdate));
+    }
+
+    if (args_.assertNoAllocAfterFrames_ >= 0)
+        SubscribeToEvent(E_ENDFRAME, URHO3D_HANDLER(ServerApplication, HandleEndFrame));
 
     // Start server
-    Network* network = GetSubsystem<Network>();
 #if defined(DEBUG) && 0
+    Network* network = GetSubsystem<Network>();
     network->SetSimulatedLatency(200);
     network->SetSimulatedPacketLoss(0.1);
 #endif
-    network->StartServer(args_.port_);
+    session_ = new ServerSession(context_);
+
+    // Port 0 means "any free port". This lets several servers run side by
+    // side (e.g. for tests) with the parent learning the actual port through
+    // the ready notification. The port is only free at the time we ask for
+    // it, so if someone else grabbed it in the meantime, ask for another one.
+    bool anyPort = (args_.port_ == 0);
+    for (int attempt = 1; ; ++attempt)
+    {
+        if (anyPort)
+        {
+            args_.port_ = ready_find_free_udp_port();
+            if (args_.port_ < 0)
+            {
+                NotifyReady("failed Could not find a free port\n");
+                ErrorExit("Could not find a free port");
+                return;
+            }
+        }
+
+        if (session_->Start(args_.port_))
+            break;
+
+        if (anyPort == false || attempt >= MAX_PORT_ATTEMPTS)
+        {
+            NotifyReady("failed Could not listen on port " + String(args_.port_) + "\n");
+            ErrorExit("Failed to start server on port " + String(args_.port_));
+            return;
+        }
+
+        URHO3D_LOGWARNINGF("Port %d was taken, trying another one", args_.port_);
+    }
+
+    URHO3D_LOGINFOF("Listening on port %d", args_.port_);
+    NotifyReady("ready " + String(args_.port_) + "\n");
 }
 
 // ----------------------------------------------------------------------------
 void ServerApplication::Stop()
 {
-    Network* network = GetSubsystem<Network>();
-    network->StopServer();
+    if (session_)
+        session_->Stop();
+
+    MetricsExporter* exporter = GetSubsystem<MetricsExporter>();
+    if (exporter)
+        exporter->Close();
 }
 
 // ----------------------------------------------------------------------------
@@ -85,7 +169,11 @@ void ServerApplication::ParseArgs()
     enum Expect
     {
         EXPECT_NONE,
-        EXPECT_PORT_NUMBER
+        EXPECT_PORT_NUMBER,
+        EXPECT_WARMUP_FRAMES,
+        EXPECT_READY_FD,
+        EXPECT_METRICS_TARGET,
+        EXPECT_METRICS_INTERVAL
     } expected = EXPECT_NONE;
 
     for (const auto& arg : GetArguments())
@@ -97,8 +185,33 @@ void ServerApplication::ParseArgs()
                 expected = EXPECT_NONE;
             } break;
 
+            case EXPECT_WARMUP_FRAMES : {
+                args_.assertNoAllocAfterFrames_ = Max(0, ToInt(arg));
+                expected = EXPECT_NONE;
+            } break;
+
+            case EXPECT_READY_FD : {
+                args_.readyFd_ = ToInt(arg);
+                expected = EXPECT_NONE;
+            } break;
+
+            case EXPECT_METRICS_TARGET : {
+                args_.metricsTarget_ = arg;
+                expected = EXPECT_NONE;
+            } break;
+
+            case EXPECT_METRICS_INTERVAL : {
+                args_.metricsInterval_ = ToFloat(arg);
+                expected = EXPECT_NONE;
+            } break;
+
             case EXPECT_NONE : {
-                if (arg == "--port") expected = EXPECT_PORT_NUMBER;
+                if      (arg == "--port")             expected = EXPECT_PORT_NUMBER;
+                else if (arg == "--assert-no-alloc")  expected = EXPECT_WARMUP_FRAMES;
+                else if (arg == "--ready-fd")         expected = EXPECT_READY_FD;
+                else if (arg == "--metrics")          expected = EXPECT_METRICS_TARGET;
+                else if (arg == "--metrics-interval") expected = EXPECT_METRICS_INTERVAL;
+                else if (arg == "--shm")              args_.sharedMemory_ = true;
                 else
                 {
                     ErrorExit("Unknown option " + arg);
@@ -114,104 +227,46 @@ void ServerApplication::ParseArgs()
 }
 
 // ----------------------------------------------------------------------------
-void ServerApplication::LoadScene()
-{
-    ResourceCache* cache = GetSubsystem<ResourceCache>();
-
-    scene_ = new Scene(context_);
-    scene_->CreateComponent<Octree>(LOCAL);
-    scene_->CreateComponent<PhysicsWorld>(LOCAL);
-
-    planet_ = scene_->CreateChild();
-    planetXML_ = cache->GetResource<XMLFile>("Prefabs/ShizzlePlanet.xml");
-    planet_->LoadXML(planetXML_->GetRoot());
-}
-
-// ----------------------------------------------------------------------------
-void ServerApplication::SubscribeToEvents()
-{
-    SubscribeToEvent(E_USERJOINED, URHO3D_HANDLER(ServerApplication, HandleUserJoined));
-    SubscribeToEvent(E_USERLEFT, URHO3D_HANDLER(ServerApplication, HandleUserLeft));
-    SubscribeToEvent(E_PLAYERCREATE, URHO3D_HANDLER(ServerApplication, HandlePlayerCreate));
-    SubscribeToEvent(E_PLAYERDESTROY, URHO3D_HANDLER(ServerApplication, HandlePlayerDestroy));
-    SubscribeToEvent(E_FILECHANGED, URHO3D_HANDLER(ServerApplication, HandleFileChanged));
-}
-
-// ----------------------------------------------------------------------------
-void ServerApplication::HandleUserJoined(StringHash eventType, VariantMap& eventData)
+void ServerApplication::NotifyReady(const String& message)
 {
-    using namespace UserJoined;
-
-    uint32_t guid = eventData[P_GUID].GetUInt();
-    const User* user = GetSubsystem<UserRegistry>()->GetUser(guid);
-
-    assert(user->GetConnection() != nullptr);
-    user->GetConnection()->SetScene(scene_);
-
-    // Send ship create event here for now. May have a spawning subsystem later
-    // that determines where and when players are spawned
-    VariantMap data;
-    data[PlayerCreate::P_GUID] = user->GetGUID();
-    data[PlayerCreate::P_PIVOTROTATION] = Quaternion::IDENTITY;  // whatever lol
-    GetSubsystem<Network>()->BroadcastRemoteEvent(E_PLAYERCREATE, true, data);
-    SendEvent(E_PLAYERCREATE, data);
+    // The parent process (usually the client hosting a game) passes us the
+    // write end of a pipe and waits for a single line telling it whether we
+    // are accepting connections.
+    if (args_.readyFd_ < 0)
+        return;
+
+    int result = ready_notify(args_.readyFd_, message.CString());
+    if (result != 0 && result != READY_NOT_SUPPORTED)
+        URHO3D_LOGERRORF("Failed to write readiness notification to fd %d", args_.readyFd_);
+    args_.readyFd_ = -1;
 }
 
 // ----------------------------------------------------------------------------
-void ServerApplication::HandleUserLeft(StringHash eventType, VariantMap& eventData)
+void ServerApplication::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
 {
-    using namespace UserLeft;
-
-    // Send ship destroy event here for now. May have a spawning subsystem
-    // later
-    VariantMap data;
-    data[PlayerDestroy::P_GUID] = eventData[P_GUID].GetInt();
-    GetSubsystem<Network>()->BroadcastRemoteEvent(E_PLAYERDESTROY, true, data);
-    SendEvent(E_PLAYERDESTROY, data);
+    tickTimer_.Reset();
 }
 
 // ----------------------------------------------------------------------------
-void ServerApplication::HandlePlayerCreate(StringHash eventType, VariantMap& eventData)
+void ServerApplication::HandlePostRenderUpdate(StringHash eventType, VariantMap& eventData)
 {
-    using namespace PlayerCreate;
-
-    User::GUID guid = eventData[P_GUID].GetUInt();
-    assert(shipNodes_.Find(guid) == shipNodes_.End());
-    User* user = GetSubsystem<UserRegistry>()->GetUser(guid);
-
-    ResourceCache* cache = GetSubsystem<ResourceCache>();
-    XMLFile* config = cache->GetResource<XMLFile>("Prefabs/ServerShip.xml");
-
-    Node* node = scene_->CreateChild("", LOCAL);
-    node->LoadXML(config->GetRoot());
-    node->SetRotation(eventData[P_PIVOTROTATION].GetQuaternion());
-    node->GetChild("Ship")->GetComponent<ServerShipState>()->SetUser(user);
-
-    shipNodes_[guid] = node;
+    Metrics* metrics = GetSubsystem<Metrics>();
+    if (metrics)
+        metrics->ObserveTickDuration(tickTimer_.GetUSec(false));
 }
 
 // ----------------------------------------------------------------------------
-void ServerApplication::HandlePlayerDestroy(StringHash eventType, VariantMap& eventData)
+void ServerApplication::HandleEndFrame(StringHash eventType, VariantMap& eventData)
 {
-    using namespace PlayerDestroy;
+    unsigned long long count = GetThreadAllocationCount();
+    unsigned long long allocations = count - lastAllocationCount_;
+    lastAllocationCount_ = count;
 
-    User::GUID guid = eventData[P_GUID].GetUInt();
+    if (frameNumber_++ < (unsigned)args_.assertNoAllocAfterFrames_)
+        return;
 
-    assert(shipNodes_.Find(guid) != shipNodes_.End());
-
-    shipNodes_[guid]->Remove();
-    shipNodes_.Erase(guid);
-}
-
-// ----------------------------------------------------------------------------
-void ServerApplication::HandleFileChanged(StringHash eventType, VariantMap& eventData)
-{
-    using namespace FileChanged;
-
-    if (eventData[P_RESOURCENAME].GetString() == planetXML_->GetName())
-    {
-        planet_->LoadXML(planetXML_->GetRoot());
-    }
+    if (allocations > 0)
+        ErrorExit(ToString("Server tick allocated %llu times on frame %u", allocations, frameNumber_ - 1));
 }
 
 }
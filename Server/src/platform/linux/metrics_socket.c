@@ -0,0 +1,86 @@
+#include "Server/metrics_socket.h"
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+// ----------------------------------------------------------------------------
+int metrics_socket_listen(const char* path)
+{
+    struct sockaddr_un addr;
+    int fd;
+
+    if (strlen(path) >= sizeof(addr.sun_path))
+        return -1;
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1)
+        return -1;
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path);
+
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(fd, 8) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+// ----------------------------------------------------------------------------
+int metrics_socket_accept(int fd)
+{
+    struct timeval timeout = { 1, 0 };
+    int client = accept(fd, NULL, NULL);
+    if (client == -1)
+        return -1;
+    fcntl(client, F_SETFD, FD_CLOEXEC);
+    fcntl(client, F_SETFL, fcntl(client, F_GETFL) & ~O_NONBLOCK);
+
+    // Scrapers are expected to read everything at once. Don't let a stuck
+    // one block the exporter forever.
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    return client;
+}
+
+// ----------------------------------------------------------------------------
+int metrics_socket_send(int client, const char* data, int len)
+{
+    while (len > 0)
+    {
+#if defined(MSG_NOSIGNAL)
+        ssize_t written = send(client, data, (size_t)len, MSG_NOSIGNAL);
+#else
+        ssize_t written = send(client, data, (size_t)len, 0);
+#endif
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            close(client);
+            return -1;
+        }
+        data += written;
+        len -= (int)written;
+    }
+
+    close(client);
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+void metrics_socket_close(int fd, const char* path)
+{
+    close(fd);
+    unlink(path);
+}
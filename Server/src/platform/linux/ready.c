@@ -0,0 +1,53 @@
+#include "Server/ready.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+// ----------------------------------------------------------------------------
+int ready_find_free_udp_port(void)
+{
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    int port = -1;
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock == -1)
+        return -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = 0;
+    if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) == 0 &&
+        getsockname(sock, (struct sockaddr*)&addr, &len) == 0)
+    {
+        port = ntohs(addr.sin_port);
+    }
+
+    close(sock);
+    return port;
+}
+
+// ----------------------------------------------------------------------------
+int ready_notify(int fd, const char* message)
+{
+    size_t len = strlen(message);
+    while (len > 0)
+    {
+        ssize_t written = write(fd, message, len);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            close(fd);
+            return -1;
+        }
+        message += written;
+        len -= (size_t)written;
+    }
+
+    close(fd);
+    return 0;
+}
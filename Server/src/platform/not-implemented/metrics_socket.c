@@ -0,0 +1,24 @@
+#include "Server/metrics_socket.h"
+
+// ----------------------------------------------------------------------------
+int metrics_socket_listen(const char* path)
+{
+    return -1;
+}
+
+// ----------------------------------------------------------------------------
+int metrics_socket_accept(int fd)
+{
+    return -1;
+}
+
+// ----------------------------------------------------------------------------
+int metrics_socket_send(int client, const char* data, int len)
+{
+    return -1;
+}
+
+// ----------------------------------------------------------------------------
+void metrics_socket_close(int fd, const char* path)
+{
+}
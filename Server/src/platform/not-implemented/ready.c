@@ -0,0 +1,13 @@
+#include "Server/ready.h"
+
+// ----------------------------------------------------------------------------
+int ready_find_free_udp_port(void)
+{
+    return -1;
+}
+
+// ----------------------------------------------------------------------------
+int ready_notify(int fd, const char* message)
+{
+    return READY_NOT_SUPPORTED;
+}